@@ -174,4 +174,20 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_VM_EXT_F64_ENABLE 0
 #endif  // !IREE_VM_EXT_F64_ENABLE
 
+#if !defined(IREE_VM_BYTECODE_VERIFICATION_ENABLE)
+// Verifies all bytecode function bodies when a module is loaded. Verified
+// bytecode is dispatched without masking each register access. Disabling
+// verification saves the verifier code size and the load-time cost at the
+// expense of masking every register operand during dispatch.
+#define IREE_VM_BYTECODE_VERIFICATION_ENABLE 1
+#endif  // !IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
+#if !defined(IREE_VM_EXECUTION_PROFILING_ENABLE)
+// Counts calls, executed ops, and inclusive wall time of each bytecode function
+// in a per-context table that can be queried or exported as JSON without a
+// tracing server (see iree_vm_bytecode_module_fprint_profile). Adds a counter
+// increment per op and a clock query per call when enabled.
+#define IREE_VM_EXECUTION_PROFILING_ENABLE 0
+#endif  // !IREE_VM_EXECUTION_PROFILING_ENABLE
+
 #endif  // IREE_BASE_CONFIG_H_
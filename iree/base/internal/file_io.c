@@ -22,6 +22,14 @@
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#define IREE_FILE_IO_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_*
+
 iree_status_t iree_file_exists(const char* path) {
   IREE_ASSERT_ARGUMENT(path);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -100,6 +108,146 @@ iree_status_t iree_file_read_contents(const char* path,
   return status;
 }
 
+// Bookkeeping for mapped file contents used as the self pointer of the
+// deallocator returned from iree_file_map_contents.
+typedef struct {
+  iree_allocator_t host_allocator;
+  void* base_address;
+  iree_host_size_t length;
+} iree_file_mapping_t;
+
+static iree_status_t iree_file_mapping_alloc(void* self,
+                                             iree_allocation_mode_t mode,
+                                             iree_host_size_t byte_length,
+                                             void** out_ptr) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "file mappings cannot allocate memory");
+}
+
+// Releases the entire mapping regardless of which address within it is freed.
+static void iree_file_mapping_free(void* self, void* ptr) {
+  iree_file_mapping_t* mapping = (iree_file_mapping_t*)self;
+#if defined(IREE_FILE_IO_HAVE_MMAP)
+  munmap(mapping->base_address, mapping->length);
+#else
+  iree_allocator_free(mapping->host_allocator, mapping->base_address);
+#endif  // IREE_FILE_IO_HAVE_MMAP
+  iree_allocator_free(mapping->host_allocator, mapping);
+}
+
+#if defined(IREE_FILE_IO_HAVE_MMAP)
+
+static iree_status_t iree_file_map_contents_impl(const char* path,
+                                                 iree_file_mapping_t* mapping) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open file '%s'", path);
+  }
+
+  iree_status_t status = iree_ok_status();
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) == -1) {
+    status = iree_make_status(iree_status_code_from_errno(errno), "size query");
+  }
+  if (iree_status_is_ok(status)) {
+    // Zero-length mappings are not allowed so use an empty allocation.
+    mapping->length = (iree_host_size_t)stat_buf.st_size;
+    mapping->base_address =
+        mapping->length ? mmap(NULL, mapping->length, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE, fd, 0)
+                        : NULL;
+    if (mapping->base_address == MAP_FAILED) {
+      mapping->base_address = NULL;
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "unable to map %zu file bytes of '%s'",
+                                mapping->length, path);
+    }
+  }
+
+  // The mapping remains valid after the file is closed.
+  close(fd);
+  return status;
+}
+
+#else
+
+static iree_status_t iree_file_map_contents_impl(const char* path,
+                                                 iree_file_mapping_t* mapping) {
+  iree_byte_span_t contents;
+  IREE_RETURN_IF_ERROR(
+      iree_file_read_contents(path, mapping->host_allocator, &contents));
+  mapping->base_address = contents.data;
+  mapping->length = contents.data_length;
+  return iree_ok_status();
+}
+
+#endif  // IREE_FILE_IO_HAVE_MMAP
+
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_allocator_t host_allocator,
+                                     iree_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator) {
+  IREE_ASSERT_ARGUMENT(path);
+  IREE_ASSERT_ARGUMENT(out_contents);
+  IREE_ASSERT_ARGUMENT(out_deallocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  *out_contents = iree_make_byte_span(NULL, 0);
+  *out_deallocator = iree_allocator_null();
+
+  iree_file_mapping_t* mapping = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*mapping),
+                                (void**)&mapping));
+  mapping->host_allocator = host_allocator;
+
+  iree_status_t status = iree_file_map_contents_impl(path, mapping);
+  if (iree_status_is_ok(status)) {
+    *out_contents = iree_make_byte_span(mapping->base_address, mapping->length);
+    out_deallocator->self = mapping;
+    out_deallocator->alloc = iree_file_mapping_alloc;
+    out_deallocator->free = iree_file_mapping_free;
+  } else {
+    iree_allocator_free(host_allocator, mapping);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Stride used when touching pages. Smaller than (or equal to) the page size
+// on all supported platforms so that no page is skipped.
+#define IREE_FILE_PREFAULT_STRIDE 4096
+
+void iree_file_prefault_contents(iree_const_byte_span_t contents) {
+  if (!contents.data_length) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)contents.data_length);
+
+#if defined(IREE_FILE_IO_HAVE_MMAP)
+  // madvise requires a page-aligned address; round down to cover the range.
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (page_size > 0) {
+    uintptr_t base = (uintptr_t)contents.data & ~((uintptr_t)page_size - 1);
+    uintptr_t end = (uintptr_t)contents.data + contents.data_length;
+    // Advisory only; failures (such as for non-mapped heap memory) are benign.
+    madvise((void*)base, end - base, MADV_WILLNEED);
+  }
+#endif  // IREE_FILE_IO_HAVE_MMAP
+
+  // Read one byte from each page. The volatile accumulator keeps the reads from
+  // being optimized away.
+  volatile uint8_t sink = 0;
+  for (iree_host_size_t offset = 0; offset < contents.data_length;
+       offset += IREE_FILE_PREFAULT_STRIDE) {
+    sink ^= contents.data[offset];
+  }
+  sink ^= contents.data[contents.data_length - 1];
+  (void)sink;
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
 iree_status_t iree_file_write_contents(const char* path,
                                        iree_const_byte_span_t content) {
   IREE_ASSERT_ARGUMENT(path);
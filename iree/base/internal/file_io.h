@@ -37,6 +37,31 @@ iree_status_t iree_file_read_contents(const char* path,
                                       iree_allocator_t allocator,
                                       iree_byte_span_t* out_contents);
 
+// Maps a file's contents into memory without reading it.
+//
+// Returns the contents of the file in |out_contents| and an allocator in
+// |out_deallocator| that must be used to free them with iree_allocator_free.
+// Freeing any address within the contents releases the entire mapping so that
+// a subrange (such as the payload following a file header) can be passed along
+// to APIs that take ownership of memory, like iree_hal_allocator_wrap_buffer.
+// The mapping is private to the process: writes to the contents are allowed
+// but are never written back to the file.
+//
+// On platforms without file mapping support the contents are read into memory
+// allocated from |host_allocator| instead. |host_allocator| is also used for
+// any bookkeeping required by the mapping.
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_allocator_t host_allocator,
+                                     iree_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator);
+
+// Makes |contents| resident in memory so that the first accesses to it do not
+// page fault. Intended for file contents mapped with iree_file_map_contents
+// that are about to be used on a latency-sensitive path; the kernel is asked
+// to read ahead where supported and each page is then touched. Has no effect
+// beyond the touches on contents that are already resident.
+void iree_file_prefault_contents(iree_const_byte_span_t contents);
+
 // Synchronously writes a byte buffer into a file.
 // Existing contents are overwritten.
 iree_status_t iree_file_write_contents(const char* path,
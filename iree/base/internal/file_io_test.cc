@@ -14,9 +14,14 @@
 
 #include "iree/base/internal/file_io.h"
 
+#include "iree/base/target_platform.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
+#if defined(IREE_PLATFORM_LINUX)
+#include <sys/resource.h>
+#endif  // IREE_PLATFORM_LINUX
+
 namespace iree {
 namespace file_io {
 namespace {
@@ -39,6 +44,15 @@ std::string GetUniqueContents(const char* unique_name) {
   return std::string("Test with name ") + unique_name + "\n";
 }
 
+#if defined(IREE_PLATFORM_LINUX)
+// Returns the number of page faults the process has taken so far.
+long GetPageFaultCount() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+#endif  // IREE_PLATFORM_LINUX
+
 TEST(FileIO, ReadWriteContents) {
   constexpr const char* kUniqueName = "ReadWriteContents";
   auto path = GetUniquePath(kUniqueName);
@@ -69,6 +83,88 @@ TEST(FileIO, ReadWriteContents) {
   iree_allocator_free(iree_allocator_system(), read_contents.data);
 }
 
+TEST(FileIO, MapContents) {
+  constexpr const char* kUniqueName = "MapContents";
+  auto path = GetUniquePath(kUniqueName);
+
+  // Write the contents to disk.
+  auto write_contents = GetUniqueContents(kUniqueName);
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(write_contents.data(), write_contents.size())));
+
+  // Map the contents and expect they are equal.
+  iree_byte_span_t mapped_contents;
+  iree_allocator_t deallocator;
+  IREE_ASSERT_OK(iree_file_map_contents(path.c_str(), iree_allocator_system(),
+                                        &mapped_contents, &deallocator));
+  EXPECT_EQ(write_contents.size(), mapped_contents.data_length);
+  EXPECT_EQ(memcmp(write_contents.data(), mapped_contents.data,
+                   mapped_contents.data_length),
+            0);
+
+  // Writes to the mapping must not change the file.
+  mapped_contents.data[0] = '!';
+  iree_byte_span_t read_contents;
+  IREE_ASSERT_OK(iree_file_read_contents(path.c_str(), iree_allocator_system(),
+                                         &read_contents));
+  EXPECT_EQ(write_contents[0], read_contents.data[0]);
+  iree_allocator_free(iree_allocator_system(), read_contents.data);
+
+  iree_allocator_free(deallocator, mapped_contents.data);
+}
+
+TEST(FileIO, PrefaultMappedContents) {
+  constexpr const char* kUniqueName = "PrefaultMappedContents";
+  auto path = GetUniquePath(kUniqueName);
+
+  // Span many pages with a length that is not a multiple of the page size.
+  const iree_host_size_t kPageSize = 4096;
+  std::string write_contents(256 * kPageSize + 17, 'x');
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(write_contents.data(), write_contents.size())));
+
+  iree_byte_span_t mapped_contents;
+  iree_allocator_t deallocator;
+  IREE_ASSERT_OK(iree_file_map_contents(path.c_str(), iree_allocator_system(),
+                                        &mapped_contents, &deallocator));
+
+  // Unaligned subranges and empty spans are allowed.
+  iree_file_prefault_contents(iree_make_const_byte_span(
+      mapped_contents.data + 1, mapped_contents.data_length - 1));
+  iree_file_prefault_contents(iree_make_const_byte_span(NULL, 0));
+
+#if defined(IREE_PLATFORM_LINUX)
+  // Every page, including the partial ones at either end, is now mapped in so
+  // reading them takes no page faults.
+  volatile uint8_t sink = 0;
+  long fault_count = GetPageFaultCount();
+  for (iree_host_size_t offset = 0; offset < mapped_contents.data_length;
+       offset += kPageSize) {
+    sink ^= mapped_contents.data[offset];
+  }
+  sink ^= mapped_contents.data[mapped_contents.data_length - 1];
+  EXPECT_EQ(fault_count, GetPageFaultCount());
+#endif  // IREE_PLATFORM_LINUX
+
+  // Contents are unchanged.
+  EXPECT_EQ(0, memcmp(write_contents.data(), mapped_contents.data,
+                      mapped_contents.data_length));
+
+  iree_allocator_free(deallocator, mapped_contents.data);
+}
+
+TEST(FileIO, MapMissingFile) {
+  auto path = GetUniquePath("MapMissingFile");
+  iree_byte_span_t mapped_contents;
+  iree_allocator_t deallocator;
+  EXPECT_THAT(Status(iree_file_map_contents(path.c_str(),
+                                            iree_allocator_system(),
+                                            &mapped_contents, &deallocator)),
+              StatusIs(StatusCode::kNotFound));
+}
+
 }  // namespace
 }  // namespace file_io
 }  // namespace iree
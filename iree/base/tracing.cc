@@ -19,9 +19,9 @@
 // Textually include the Tracy implementation.
 // We do this here instead of relying on an external build target so that we can
 // ensure our configuration specified in tracing.h is picked up.
-#if IREE_TRACING_FEATURES != 0
+#if defined(TRACY_ENABLE)
 #include "third_party/tracy/TracyClient.cpp"
-#endif  // IREE_TRACING_FEATURES
+#endif  // TRACY_ENABLE
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,7 +38,7 @@ void IREEDbgHelpLock(void) {
 void IREEDbgHelpUnlock(void) { ReleaseMutex(iree_dbghelp_mutex); }
 #endif  // TRACY_ENABLE && IREE_PLATFORM_WINDOWS
 
-#if IREE_TRACING_FEATURES != 0
+#if defined(TRACY_ENABLE)
 
 void iree_tracing_set_thread_name_impl(const char* name) {
   tracy::SetThreadName(name);
@@ -206,7 +206,7 @@ void iree_tracing_mutex_after_unlock(uint32_t lock_id) {
   tracy::Profiler::QueueSerialFinish();
 }
 
-#endif  // IREE_TRACING_FEATURES
+#endif  // TRACY_ENABLE
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -21,13 +21,19 @@
 // set on IREE_TRACING_FEATURES when a more custom set of features is
 // required. Exact feature support may vary on platform and toolchain.
 //
-// The tracing infrastructure is currently designed to target the Tracy
-// profiler: https://github.com/wolfpld/tracy
+// The tracing infrastructure primarily targets the Tracy profiler:
+// https://github.com/wolfpld/tracy
 // Tracy's profiler UI allowing for streaming captures and analysis can be
 // downloaded from: https://github.com/wolfpld/tracy/releases
 // The manual provided on the releases page contains more information about how
 // Tracy works, its limitations, and how to operate the UI.
 //
+// For headless environments where a live Tracy connection is not possible a
+// built-in backend can be selected with
+// IREE_TRACING_BACKEND=IREE_TRACING_BACKEND_CHROME. It buffers events in memory
+// and writes them as Chrome trace-event JSON that can be loaded in
+// chrome://tracing or https://ui.perfetto.dev. See tracing_chrome.c.
+//
 // NOTE: this header is used both from C and C++ code and only conditionally
 // enables the C++ when in a valid context. Do not use C++ features or include
 // other files that are not C-compatible.
@@ -36,6 +42,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "iree/base/attributes.h"
 #include "iree/base/config.h"
@@ -134,13 +141,35 @@
 #endif  // IREE_TRACING_MODE
 #endif  // !IREE_TRACING_FEATURES
 
+//===----------------------------------------------------------------------===//
+// IREE_TRACING_BACKEND selection
+//===----------------------------------------------------------------------===//
+
+// Streams events to the Tracy profiler. Supports all features.
+#define IREE_TRACING_BACKEND_TRACY 1
+
+// Buffers events in bounded per-thread ring buffers and writes them as Chrome
+// trace-event JSON on demand. Supports only instrumentation and log messages.
+#define IREE_TRACING_BACKEND_CHROME 2
+
+#if !defined(IREE_TRACING_BACKEND)
+#define IREE_TRACING_BACKEND IREE_TRACING_BACKEND_TRACY
+#endif  // !IREE_TRACING_BACKEND
+
+#if IREE_TRACING_BACKEND == IREE_TRACING_BACKEND_CHROME && \
+    (IREE_TRACING_FEATURES & ~(IREE_TRACING_FEATURE_INSTRUMENTATION | \
+                               IREE_TRACING_FEATURE_LOG_MESSAGES))
+#error "the chrome tracing backend only supports instrumentation and messages"
+#endif  // IREE_TRACING_BACKEND_CHROME
+
 //===----------------------------------------------------------------------===//
 // Tracy configuration
 //===----------------------------------------------------------------------===//
 // NOTE: order matters here as we are including files that require/define.
 
 // Enable Tracy only when we are using tracing features.
-#if IREE_TRACING_FEATURES != 0
+#if IREE_TRACING_FEATURES != 0 && \
+    IREE_TRACING_BACKEND == IREE_TRACING_BACKEND_TRACY
 #define TRACY_ENABLE 1
 #endif  // IREE_TRACING_FEATURES
 
@@ -203,6 +232,8 @@ extern "C" {
 
 void iree_tracing_set_thread_name_impl(const char* name);
 
+#if defined(TRACY_ENABLE)
+
 typedef struct ___tracy_source_location_data iree_tracing_location_t;
 
 #ifdef __cplusplus
@@ -213,6 +244,50 @@ typedef struct ___tracy_source_location_data iree_tracing_location_t;
   (TracyCZoneCtx) { zone_id, 1 }
 #endif  // __cplusplus
 
+#else
+
+// Static source location of an instrumented zone. Layout-compatible with
+// Tracy's ___tracy_source_location_data so that instrumentation is source
+// compatible between backends.
+typedef struct {
+  const char* name;
+  const char* function;
+  const char* file;
+  uint32_t line;
+  uint32_t color;
+} iree_tracing_location_t;
+
+void iree_tracing_set_app_info_impl(const char* value, size_t value_length);
+void iree_tracing_zone_end_impl(iree_zone_id_t zone_id);
+void iree_tracing_zone_append_value_impl(iree_zone_id_t zone_id,
+                                         uint64_t value);
+void iree_tracing_zone_append_text_impl(iree_zone_id_t zone_id,
+                                        const char* value, size_t value_length);
+void iree_tracing_frame_mark_impl(const char* name_literal);
+void iree_tracing_frame_mark_begin_impl(const char* name_literal);
+void iree_tracing_frame_mark_end_impl(const char* name_literal);
+void iree_tracing_message_impl(const char* value, size_t value_length,
+                               uint32_t color);
+
+// Enables or disables capturing events at runtime. Capture is enabled by
+// default; while disabled each instrumentation point costs a single relaxed
+// load so binaries can ship with tracing compiled in and enable it on a subset
+// of processes.
+void iree_tracing_chrome_set_enabled(bool enabled);
+
+// Returns true if events are currently being captured.
+bool iree_tracing_chrome_is_enabled(void);
+
+// Drops all events captured so far on all threads.
+void iree_tracing_chrome_reset(void);
+
+// Writes the events currently buffered on all threads to |path| as Chrome
+// trace-event JSON. Buffers are not cleared and capture continues while
+// writing. Returns false if the file could not be written.
+bool iree_tracing_chrome_write_file(const char* path);
+
+#endif  // TRACY_ENABLE
+
 IREE_MUST_USE_RESULT iree_zone_id_t
 iree_tracing_zone_begin_impl(const iree_tracing_location_t* src_loc,
                              const char* name, size_t name_length);
@@ -264,7 +339,84 @@ enum {
   IREE_TRACING_MESSAGE_LEVEL_DEBUG = 0x00FF00u,
 };
 
-#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+#define IREE_TRACE_IMPL_CONCAT_INNER_(x, y) x##y
+#define IREE_TRACE_IMPL_CONCAT_(x, y) IREE_TRACE_IMPL_CONCAT_INNER_(x, y)
+
+#if (IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION) && \
+    IREE_TRACING_BACKEND == IREE_TRACING_BACKEND_CHROME
+
+// See the Tracy variants below for documentation.
+#define IREE_TRACE_SET_APP_INFO(value, value_length) \
+  iree_tracing_set_app_info_impl(value, value_length)
+#define IREE_TRACE_SET_THREAD_NAME(name) iree_tracing_set_thread_name_impl(name)
+#define IREE_TRACE(expr) expr
+#define IREE_TRACE_ZONE_BEGIN(zone_id) \
+  IREE_TRACE_ZONE_BEGIN_NAMED(zone_id, NULL)
+#define IREE_TRACE_ZONE_BEGIN_NAMED(zone_id, name_literal)                  \
+  static const iree_tracing_location_t IREE_TRACE_IMPL_CONCAT_(             \
+      __iree_tracing_location, __LINE__) = {name_literal, __FUNCTION__,     \
+                                            __FILE__, (uint32_t)__LINE__, \
+                                            0};                             \
+  iree_zone_id_t zone_id = iree_tracing_zone_begin_impl(                    \
+      &IREE_TRACE_IMPL_CONCAT_(__iree_tracing_location, __LINE__), NULL, 0);
+#define IREE_TRACE_ZONE_BEGIN_NAMED_DYNAMIC(zone_id, name, name_length)      \
+  static const iree_tracing_location_t IREE_TRACE_IMPL_CONCAT_(              \
+      __iree_tracing_location, __LINE__) = {0, __FUNCTION__, __FILE__,       \
+                                            (uint32_t)__LINE__, 0};          \
+  iree_zone_id_t zone_id = iree_tracing_zone_begin_impl(                     \
+      &IREE_TRACE_IMPL_CONCAT_(__iree_tracing_location, __LINE__), (name), \
+      (name_length));
+#define IREE_TRACE_ZONE_BEGIN_EXTERNAL(                                       \
+    zone_id, file_name, file_name_length, line, function_name,                \
+    function_name_length, name, name_length)                                  \
+  iree_zone_id_t zone_id = iree_tracing_zone_begin_external_impl(             \
+      file_name, file_name_length, line, function_name, function_name_length, \
+      name, name_length)
+#define IREE_TRACE_ZONE_SET_COLOR(zone_id, color_xbgr)
+#define IREE_TRACE_ZONE_APPEND_VALUE(zone_id, value) \
+  iree_tracing_zone_append_value_impl(zone_id, (uint64_t)(value));
+#define IREE_TRACE_ZONE_APPEND_TEXT(...)                                  \
+  IREE_TRACE_IMPL_GET_VARIADIC_((__VA_ARGS__,                             \
+                                 IREE_TRACE_ZONE_APPEND_TEXT_STRING_VIEW, \
+                                 IREE_TRACE_ZONE_APPEND_TEXT_CSTRING))    \
+  (__VA_ARGS__)
+#define IREE_TRACE_ZONE_APPEND_TEXT_CSTRING(zone_id, value) \
+  IREE_TRACE_ZONE_APPEND_TEXT_STRING_VIEW(zone_id, value, strlen(value))
+#define IREE_TRACE_ZONE_APPEND_TEXT_STRING_VIEW(zone_id, value, value_length) \
+  iree_tracing_zone_append_text_impl(zone_id, value, value_length)
+#define IREE_TRACE_ZONE_END(zone_id) iree_tracing_zone_end_impl(zone_id)
+#define IREE_RETURN_AND_END_ZONE_IF_ERROR(zone_id, ...) \
+  IREE_RETURN_AND_EVAL_IF_ERROR(IREE_TRACE_ZONE_END(zone_id), __VA_ARGS__)
+#define IREE_TRACE_SET_PLOT_TYPE(name_literal, plot_type)
+#define IREE_TRACE_PLOT_VALUE_I64(name_literal, value) \
+  iree_tracing_plot_value_i64_impl(name_literal, value)
+#define IREE_TRACE_PLOT_VALUE_F32(name_literal, value) \
+  iree_tracing_plot_value_f32_impl(name_literal, value)
+#define IREE_TRACE_PLOT_VALUE_F64(name_literal, value) \
+  iree_tracing_plot_value_f64_impl(name_literal, value)
+#define IREE_TRACE_FRAME_MARK() iree_tracing_frame_mark_impl(NULL)
+#define IREE_TRACE_FRAME_MARK_NAMED(name_literal) \
+  iree_tracing_frame_mark_impl(name_literal)
+#define IREE_TRACE_FRAME_MARK_BEGIN_NAMED(name_literal) \
+  iree_tracing_frame_mark_begin_impl(name_literal)
+#define IREE_TRACE_FRAME_MARK_END_NAMED(name_literal) \
+  iree_tracing_frame_mark_end_impl(name_literal)
+#define IREE_TRACE_MESSAGE(level, value_literal)                     \
+  iree_tracing_message_impl(value_literal, strlen(value_literal), \
+                            IREE_TRACING_MESSAGE_LEVEL_##level)
+#define IREE_TRACE_MESSAGE_COLORED(color, value_literal) \
+  iree_tracing_message_impl(value_literal, strlen(value_literal), color)
+#define IREE_TRACE_MESSAGE_DYNAMIC(level, value, value_length) \
+  iree_tracing_message_impl(value, value_length,              \
+                            IREE_TRACING_MESSAGE_LEVEL_##level)
+#define IREE_TRACE_MESSAGE_DYNAMIC_COLORED(color, value, value_length) \
+  iree_tracing_message_impl(value, value_length, color)
+
+#define IREE_TRACE_IMPL_GET_VARIADIC_HELPER_(_1, _2, _3, NAME, ...) NAME
+#define IREE_TRACE_IMPL_GET_VARIADIC_(args) \
+  IREE_TRACE_IMPL_GET_VARIADIC_HELPER_ args
+
+#elif IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
 // Sets an application-specific payload that will be stored in the trace.
 // This can be used to fingerprint traces to particular versions and denote
@@ -490,7 +642,42 @@ void operator delete(void* ptr) noexcept;
 #include "third_party/tracy/Tracy.hpp"  // IWYU pragma: export
 #endif
 
-#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+#if (IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION) && \
+    IREE_TRACING_BACKEND == IREE_TRACING_BACKEND_CHROME
+
+// RAII zone for the C++ scope macros.
+class iree_tracing_scoped_zone_t {
+ public:
+  iree_tracing_scoped_zone_t(const iree_tracing_location_t* src_loc,
+                             const char* name)
+      : zone_id_(iree_tracing_zone_begin_impl(src_loc, name,
+                                              name ? strlen(name) : 0)) {}
+  ~iree_tracing_scoped_zone_t() { iree_tracing_zone_end_impl(zone_id_); }
+  iree_tracing_scoped_zone_t(const iree_tracing_scoped_zone_t&) = delete;
+  iree_tracing_scoped_zone_t& operator=(const iree_tracing_scoped_zone_t&) =
+      delete;
+
+ private:
+  iree_zone_id_t zone_id_;
+};
+
+#define IREE_TRACE_IMPL_SCOPE_(name_literal, dynamic_name)                    \
+  static const iree_tracing_location_t IREE_TRACE_IMPL_CONCAT_(               \
+      __iree_tracing_location, __LINE__) = {name_literal, __FUNCTION__,       \
+                                            __FILE__, (uint32_t)__LINE__, 0}; \
+  iree_tracing_scoped_zone_t IREE_TRACE_IMPL_CONCAT_(__iree_tracing_zone,     \
+                                                     __LINE__)(               \
+      &IREE_TRACE_IMPL_CONCAT_(__iree_tracing_location, __LINE__), dynamic_name)
+
+#define IREE_TRACE_SCOPE() IREE_TRACE_IMPL_SCOPE_(NULL, NULL)
+#define IREE_TRACE_SCOPE_DYNAMIC(name_cstr) \
+  IREE_TRACE_IMPL_SCOPE_(NULL, name_cstr)
+#define IREE_TRACE_SCOPE0(name_literal) \
+  IREE_TRACE_IMPL_SCOPE_(name_literal, NULL)
+#define IREE_TRACE_EVENT
+#define IREE_TRACE_EVENT0
+
+#elif IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
 // TODO(#1886): update these to tracy and drop the 0.
 #define IREE_TRACE_SCOPE() ZoneScoped
@@ -0,0 +1,844 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Built-in tracing backend that records IREE_TRACE_* events into per-thread
+// ring buffers and writes them as Chrome trace-event JSON on demand:
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+// The output loads in chrome://tracing and https://ui.perfetto.dev.
+//
+// Each thread lazily allocates a fixed-size ring of events the first time it
+// records anything. Only the owning thread writes to its ring and publishes
+// new events by bumping the head index, so recording is wait-free and never
+// takes a lock. Once full the oldest events are overwritten: memory is bounded
+// at IREE_TRACING_CHROME_EVENT_CAPACITY events per thread and the export always
+// contains the most recent activity. When a thread exits its ring is retired
+// but kept in the list so that its events are still available for export.
+// Threads registering later reuse retired rings before allocating new ones, so
+// the total memory is bounded by the peak number of live threads rather than
+// by the number of threads ever created.
+//
+// Dynamic strings (zone names, text annotations, messages) are copied inline
+// into the event and truncated to IREE_TRACING_CHROME_MAX_TEXT_LENGTH bytes
+// without splitting UTF-8 code points. Static strings and source locations are
+// stored by pointer.
+//
+// Setting the IREE_TRACING_CHROME_OUTPUT environment variable to a file path
+// writes the trace to that path when the process exits.
+
+#include "iree/base/tracing.h"
+
+#if IREE_TRACING_FEATURES != 0 && \
+    IREE_TRACING_BACKEND == IREE_TRACING_BACKEND_CHROME
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/target_platform.h"
+
+#if defined(IREE_PLATFORM_WINDOWS)
+// windows.h is included by target_platform.h.
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_WINDOWS
+
+// Maximum number of events retained per thread. Must be a power of two.
+// Events are 64 bytes so the default retains 1MiB per thread.
+#if !defined(IREE_TRACING_CHROME_EVENT_CAPACITY)
+#define IREE_TRACING_CHROME_EVENT_CAPACITY 16384
+#endif  // !IREE_TRACING_CHROME_EVENT_CAPACITY
+
+// Maximum number of characters of dynamic strings stored per event.
+#define IREE_TRACING_CHROME_MAX_TEXT_LENGTH 40
+
+// Maximum zone nesting depth tracked during export. Deeper zones are dropped.
+#define IREE_TRACING_CHROME_MAX_ZONE_DEPTH 128
+
+// Maximum length of the annotations gathered for a single zone during export.
+#define IREE_TRACING_CHROME_MAX_ARGS_LENGTH 256
+
+#if (IREE_TRACING_CHROME_EVENT_CAPACITY & \
+     (IREE_TRACING_CHROME_EVENT_CAPACITY - 1)) != 0
+#error "IREE_TRACING_CHROME_EVENT_CAPACITY must be a power of two"
+#endif  // IREE_TRACING_CHROME_EVENT_CAPACITY
+
+#if defined(IREE_COMPILER_MSVC)
+#define IREE_TRACING_CHROME_THREAD_LOCAL __declspec(thread)
+#else
+#define IREE_TRACING_CHROME_THREAD_LOCAL _Thread_local
+#endif  // IREE_COMPILER_MSVC
+
+//===----------------------------------------------------------------------===//
+// Event storage
+//===----------------------------------------------------------------------===//
+
+typedef enum {
+  // Begins a zone at |ptr| (iree_tracing_location_t*) with an optional
+  // dynamic name in |payload.text|.
+  IREE_TRACING_CHROME_EVENT_ZONE_BEGIN = 0,
+  // Ends the innermost open zone.
+  IREE_TRACING_CHROME_EVENT_ZONE_END,
+  // Appends |payload.text| to the innermost open zone.
+  IREE_TRACING_CHROME_EVENT_ZONE_TEXT,
+  // Appends |payload.u64| to the innermost open zone.
+  IREE_TRACING_CHROME_EVENT_ZONE_VALUE,
+  // Sets the plot named |ptr| to |payload.i64| or |payload.f64|.
+  IREE_TRACING_CHROME_EVENT_PLOT_I64,
+  IREE_TRACING_CHROME_EVENT_PLOT_F64,
+  // Frame markers with an optional static name in |ptr|.
+  IREE_TRACING_CHROME_EVENT_FRAME_MARK,
+  IREE_TRACING_CHROME_EVENT_FRAME_BEGIN,
+  IREE_TRACING_CHROME_EVENT_FRAME_END,
+  // A message with |payload.text| and |color|.
+  IREE_TRACING_CHROME_EVENT_MESSAGE,
+} iree_tracing_chrome_event_type_t;
+
+typedef struct {
+  // Monotonic time the event was recorded at.
+  uint64_t timestamp_ns;
+  // iree_tracing_chrome_event_type_t.
+  uint8_t type;
+  // Length of |payload.text| for events carrying text.
+  uint8_t text_length;
+  uint16_t reserved;
+  uint32_t color;
+  // Static string or source location, depending on |type|.
+  const void* ptr;
+  union {
+    int64_t i64;
+    uint64_t u64;
+    double f64;
+    char text[IREE_TRACING_CHROME_MAX_TEXT_LENGTH];
+  } payload;
+} iree_tracing_chrome_event_t;
+static_assert(sizeof(iree_tracing_chrome_event_t) == 64,
+              "events are expected to be exactly one cache line");
+
+typedef struct iree_tracing_chrome_thread_s {
+  // Next thread in the global list. Immutable once published.
+  struct iree_tracing_chrome_thread_s* next;
+  // Sequential ID assigned at registration.
+  uint32_t thread_id;
+  // Thread name as set by IREE_TRACE_SET_THREAD_NAME, if any.
+  char name[64];
+  // Total number of events ever recorded on the thread. The event with index
+  // i lives in events[i % IREE_TRACING_CHROME_EVENT_CAPACITY].
+  iree_atomic_int64_t head;
+  // Events with an index lower than this were dropped by a reset.
+  iree_atomic_int64_t floor;
+  // Nonzero once the owning thread has exited and the ring can be claimed by
+  // a newly registering thread.
+  iree_atomic_int32_t retired;
+  iree_tracing_chrome_event_t events[IREE_TRACING_CHROME_EVENT_CAPACITY];
+} iree_tracing_chrome_thread_t;
+
+static struct {
+  // Nonzero when capture has been disabled with
+  // iree_tracing_chrome_set_enabled. Zero-initialized so capture is enabled
+  // by default.
+  iree_atomic_int32_t disabled;
+  // 0 before the process-wide initialization, 1 while it is running and 2
+  // once it has completed.
+  iree_atomic_int32_t initialized;
+  // Nonzero if thread exit notifications were registered with |exit_key|.
+  bool has_exit_key;
+#if defined(IREE_PLATFORM_WINDOWS)
+  DWORD exit_key;
+#else
+  pthread_key_t exit_key;
+#endif  // IREE_PLATFORM_WINDOWS
+  // Number of threads registered so far; used to assign thread IDs.
+  iree_atomic_int32_t thread_count;
+  // iree_tracing_chrome_thread_t* head of the list of all registered threads.
+  iree_atomic_intptr_t thread_list;
+  // Application info set by IREE_TRACE_SET_APP_INFO.
+  char app_info[256];
+} iree_tracing_chrome_state_;
+
+static IREE_TRACING_CHROME_THREAD_LOCAL iree_tracing_chrome_thread_t*
+    iree_tracing_chrome_current_thread_ = NULL;
+static IREE_TRACING_CHROME_THREAD_LOCAL char
+    iree_tracing_chrome_thread_name_[64] = {0};
+
+// NOTE: iree_time_now lives in iree/base/time.h, which itself depends on
+// tracing, so we query the clock directly.
+static uint64_t iree_tracing_chrome_now_ns(void) {
+#if defined(IREE_PLATFORM_WINDOWS)
+  static LARGE_INTEGER frequency = {0};
+  if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (uint64_t)((double)counter.QuadPart * 1e9 /
+                    (double)frequency.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif  // IREE_PLATFORM_WINDOWS
+}
+
+static uint32_t iree_tracing_chrome_process_id(void) {
+#if defined(IREE_PLATFORM_WINDOWS)
+  return (uint32_t)GetCurrentProcessId();
+#else
+  return (uint32_t)getpid();
+#endif  // IREE_PLATFORM_WINDOWS
+}
+
+static void iree_tracing_chrome_write_at_exit(void) {
+  const char* path = getenv("IREE_TRACING_CHROME_OUTPUT");
+  if (path && path[0] != '\0' && !iree_tracing_chrome_write_file(path)) {
+    fprintf(stderr, "failed to write chrome trace to '%s'\n", path);
+  }
+}
+
+// Returns the length of the longest prefix of |value| no longer than
+// |max_length| bytes that does not split a UTF-8 encoded code point.
+static size_t iree_tracing_chrome_utf8_truncate(const char* value,
+                                                size_t value_length,
+                                                size_t max_length) {
+  if (value_length <= max_length) return value_length;
+  // Back up over continuation bytes so the byte following the prefix starts
+  // a new code point.
+  size_t length = max_length;
+  while (length > 0 && ((unsigned char)value[length] & 0xC0) == 0x80) {
+    --length;
+  }
+  return length;
+}
+
+// Copies |value| into |buffer| truncated to fit with a NUL terminator.
+static void iree_tracing_chrome_copy_cstring(char* buffer,
+                                             size_t buffer_capacity,
+                                             const char* value) {
+  size_t value_length = iree_tracing_chrome_utf8_truncate(
+      value, strlen(value), buffer_capacity - 1);
+  memcpy(buffer, value, value_length);
+  buffer[value_length] = 0;
+}
+
+// Called on the owning thread when it exits.
+#if defined(IREE_PLATFORM_WINDOWS)
+static void NTAPI iree_tracing_chrome_thread_exit(void* value) {
+#else
+static void iree_tracing_chrome_thread_exit(void* value) {
+#endif  // IREE_PLATFORM_WINDOWS
+  iree_tracing_chrome_thread_t* thread = (iree_tracing_chrome_thread_t*)value;
+  if (!thread) return;
+  // Any events recorded after this point (such as from other thread exit
+  // handlers) will register a new ring instead of racing with the next owner.
+  if (iree_tracing_chrome_current_thread_ == thread) {
+    iree_tracing_chrome_current_thread_ = NULL;
+  }
+  iree_atomic_store_int32(&thread->retired, 1, iree_memory_order_release);
+}
+
+static void iree_tracing_chrome_initialize(void) {
+  int32_t expected = 0;
+  if (!iree_atomic_compare_exchange_strong_int32(
+          &iree_tracing_chrome_state_.initialized, &expected, 1,
+          iree_memory_order_acq_rel, iree_memory_order_acquire)) {
+    // Wait for the thread performing the initialization to finish.
+    while (expected != 2) {
+      expected = iree_atomic_load_int32(&iree_tracing_chrome_state_.initialized,
+                                        iree_memory_order_acquire);
+    }
+    return;
+  }
+#if defined(IREE_PLATFORM_WINDOWS)
+  iree_tracing_chrome_state_.exit_key =
+      FlsAlloc(iree_tracing_chrome_thread_exit);
+  iree_tracing_chrome_state_.has_exit_key =
+      iree_tracing_chrome_state_.exit_key != FLS_OUT_OF_INDEXES;
+#else
+  iree_tracing_chrome_state_.has_exit_key =
+      pthread_key_create(&iree_tracing_chrome_state_.exit_key,
+                         iree_tracing_chrome_thread_exit) == 0;
+#endif  // IREE_PLATFORM_WINDOWS
+  const char* path = getenv("IREE_TRACING_CHROME_OUTPUT");
+  if (path && path[0] != '\0') atexit(iree_tracing_chrome_write_at_exit);
+  iree_atomic_store_int32(&iree_tracing_chrome_state_.initialized, 2,
+                          iree_memory_order_release);
+}
+
+static iree_tracing_chrome_thread_t* iree_tracing_chrome_thread_list(void) {
+  return (iree_tracing_chrome_thread_t*)iree_atomic_load_intptr(
+      &iree_tracing_chrome_state_.thread_list, iree_memory_order_acquire);
+}
+
+// Claims the ring of a thread that has exited, if any. The events of the
+// previous owner are dropped.
+static iree_tracing_chrome_thread_t* iree_tracing_chrome_claim_retired_thread(
+    void) {
+  for (iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_thread_list();
+       thread != NULL; thread = thread->next) {
+    int32_t expected = 1;
+    if (iree_atomic_load_int32(&thread->retired, iree_memory_order_relaxed) &&
+        iree_atomic_compare_exchange_strong_int32(
+            &thread->retired, &expected, 0, iree_memory_order_acq_rel,
+            iree_memory_order_relaxed)) {
+      iree_atomic_store_int64(
+          &thread->floor,
+          iree_atomic_load_int64(&thread->head, iree_memory_order_relaxed),
+          iree_memory_order_relaxed);
+      return thread;
+    }
+  }
+  return NULL;
+}
+
+// Allocates and registers the ring for the calling thread.
+// Returns NULL if the ring could not be allocated.
+static iree_tracing_chrome_thread_t* iree_tracing_chrome_register_thread(void) {
+  iree_tracing_chrome_initialize();
+
+  // Rings are only recycled when we are notified of thread exits.
+  iree_tracing_chrome_thread_t* thread =
+      iree_tracing_chrome_state_.has_exit_key
+          ? iree_tracing_chrome_claim_retired_thread()
+          : NULL;
+  if (thread) {
+    memcpy(thread->name, iree_tracing_chrome_thread_name_,
+           sizeof(thread->name));
+  } else {
+    thread = (iree_tracing_chrome_thread_t*)malloc(sizeof(*thread));
+    if (!thread) return NULL;
+    memset(thread, 0, offsetof(iree_tracing_chrome_thread_t, events));
+    thread->thread_id = (uint32_t)iree_atomic_fetch_add_int32(
+        &iree_tracing_chrome_state_.thread_count, 1, iree_memory_order_relaxed);
+    memcpy(thread->name, iree_tracing_chrome_thread_name_,
+           sizeof(thread->name));
+
+    intptr_t list_head = iree_atomic_load_intptr(
+        &iree_tracing_chrome_state_.thread_list, iree_memory_order_relaxed);
+    do {
+      thread->next = (iree_tracing_chrome_thread_t*)list_head;
+    } while (!iree_atomic_compare_exchange_weak_intptr(
+        &iree_tracing_chrome_state_.thread_list, &list_head, (intptr_t)thread,
+        iree_memory_order_release, iree_memory_order_relaxed));
+  }
+
+  if (iree_tracing_chrome_state_.has_exit_key) {
+#if defined(IREE_PLATFORM_WINDOWS)
+    FlsSetValue(iree_tracing_chrome_state_.exit_key, thread);
+#else
+    pthread_setspecific(iree_tracing_chrome_state_.exit_key, thread);
+#endif  // IREE_PLATFORM_WINDOWS
+  }
+
+  iree_tracing_chrome_current_thread_ = thread;
+  return thread;
+}
+
+// Returns the ring of the calling thread if capture is enabled.
+static inline iree_tracing_chrome_thread_t* iree_tracing_chrome_acquire_thread(
+    void) {
+  if (IREE_UNLIKELY(iree_atomic_load_int32(
+          &iree_tracing_chrome_state_.disabled, iree_memory_order_relaxed))) {
+    return NULL;
+  }
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_current_thread_;
+  if (IREE_LIKELY(thread)) return thread;
+  return iree_tracing_chrome_register_thread();
+}
+
+// Returns the next event slot of |thread| initialized with |type|.
+// The event is not visible to readers until iree_tracing_chrome_commit.
+static inline iree_tracing_chrome_event_t* iree_tracing_chrome_reserve(
+    iree_tracing_chrome_thread_t* thread, uint8_t type, const void* ptr) {
+  int64_t index =
+      iree_atomic_load_int64(&thread->head, iree_memory_order_relaxed);
+  iree_tracing_chrome_event_t* event =
+      &thread->events[index & (IREE_TRACING_CHROME_EVENT_CAPACITY - 1)];
+  event->timestamp_ns = iree_tracing_chrome_now_ns();
+  event->type = type;
+  event->text_length = 0;
+  event->color = 0;
+  event->ptr = ptr;
+  return event;
+}
+
+static inline void iree_tracing_chrome_commit(
+    iree_tracing_chrome_thread_t* thread) {
+  int64_t index =
+      iree_atomic_load_int64(&thread->head, iree_memory_order_relaxed);
+  iree_atomic_store_int64(&thread->head, index + 1, iree_memory_order_release);
+}
+
+static inline void iree_tracing_chrome_set_text(
+    iree_tracing_chrome_event_t* event, const char* value,
+    size_t value_length) {
+  if (!value) return;
+  value_length = iree_tracing_chrome_utf8_truncate(
+      value, value_length, IREE_TRACING_CHROME_MAX_TEXT_LENGTH);
+  memcpy(event->payload.text, value, value_length);
+  event->text_length = (uint8_t)value_length;
+}
+
+//===----------------------------------------------------------------------===//
+// Instrumentation
+//===----------------------------------------------------------------------===//
+
+void iree_tracing_set_app_info_impl(const char* value, size_t value_length) {
+  value_length = iree_tracing_chrome_utf8_truncate(
+      value, value_length, sizeof(iree_tracing_chrome_state_.app_info) - 1);
+  memcpy(iree_tracing_chrome_state_.app_info, value, value_length);
+  iree_tracing_chrome_state_.app_info[value_length] = 0;
+}
+
+void iree_tracing_set_thread_name_impl(const char* name) {
+  iree_tracing_chrome_copy_cstring(iree_tracing_chrome_thread_name_,
+                                   sizeof(iree_tracing_chrome_thread_name_),
+                                   name);
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_current_thread_;
+  if (thread) {
+    memcpy(thread->name, iree_tracing_chrome_thread_name_,
+           sizeof(thread->name));
+  }
+}
+
+iree_zone_id_t iree_tracing_zone_begin_impl(
+    const iree_tracing_location_t* src_loc, const char* name,
+    size_t name_length) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_acquire_thread();
+  if (!thread) return 0;
+  iree_tracing_chrome_event_t* event = iree_tracing_chrome_reserve(
+      thread, IREE_TRACING_CHROME_EVENT_ZONE_BEGIN, src_loc);
+  iree_tracing_chrome_set_text(event, name, name_length);
+  iree_tracing_chrome_commit(thread);
+  return 1;
+}
+
+iree_zone_id_t iree_tracing_zone_begin_external_impl(
+    const char* file_name, size_t file_name_length, uint32_t line,
+    const char* function_name, size_t function_name_length, const char* name,
+    size_t name_length) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_acquire_thread();
+  if (!thread) return 0;
+  iree_tracing_chrome_event_t* event = iree_tracing_chrome_reserve(
+      thread, IREE_TRACING_CHROME_EVENT_ZONE_BEGIN, NULL);
+  if (name && name_length > 0) {
+    iree_tracing_chrome_set_text(event, name, name_length);
+  } else {
+    iree_tracing_chrome_set_text(event, function_name, function_name_length);
+  }
+  iree_tracing_chrome_commit(thread);
+  return 1;
+}
+
+// Zones that began while capture was enabled are always ended so that the
+// begin/end pairs stay balanced when capture is toggled mid-zone.
+void iree_tracing_zone_end_impl(iree_zone_id_t zone_id) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_current_thread_;
+  if (!zone_id || !thread) return;
+  iree_tracing_chrome_reserve(thread, IREE_TRACING_CHROME_EVENT_ZONE_END, NULL);
+  iree_tracing_chrome_commit(thread);
+}
+
+void iree_tracing_zone_append_value_impl(iree_zone_id_t zone_id,
+                                         uint64_t value) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_current_thread_;
+  if (!zone_id || !thread) return;
+  iree_tracing_chrome_event_t* event = iree_tracing_chrome_reserve(
+      thread, IREE_TRACING_CHROME_EVENT_ZONE_VALUE, NULL);
+  event->payload.u64 = value;
+  iree_tracing_chrome_commit(thread);
+}
+
+void iree_tracing_zone_append_text_impl(iree_zone_id_t zone_id,
+                                        const char* value,
+                                        size_t value_length) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_current_thread_;
+  if (!zone_id || !thread) return;
+  iree_tracing_chrome_event_t* event = iree_tracing_chrome_reserve(
+      thread, IREE_TRACING_CHROME_EVENT_ZONE_TEXT, NULL);
+  iree_tracing_chrome_set_text(event, value, value_length);
+  iree_tracing_chrome_commit(thread);
+}
+
+void iree_tracing_set_plot_type_impl(const char* name_literal,
+                                     uint8_t plot_type) {
+  // Chrome counters have no display format.
+}
+
+void iree_tracing_plot_value_i64_impl(const char* name_literal, int64_t value) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_acquire_thread();
+  if (!thread) return;
+  iree_tracing_chrome_event_t* event = iree_tracing_chrome_reserve(
+      thread, IREE_TRACING_CHROME_EVENT_PLOT_I64, name_literal);
+  event->payload.i64 = value;
+  iree_tracing_chrome_commit(thread);
+}
+
+void iree_tracing_plot_value_f32_impl(const char* name_literal, float value) {
+  iree_tracing_plot_value_f64_impl(name_literal, value);
+}
+
+void iree_tracing_plot_value_f64_impl(const char* name_literal, double value) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_acquire_thread();
+  if (!thread) return;
+  iree_tracing_chrome_event_t* event = iree_tracing_chrome_reserve(
+      thread, IREE_TRACING_CHROME_EVENT_PLOT_F64, name_literal);
+  event->payload.f64 = value;
+  iree_tracing_chrome_commit(thread);
+}
+
+static void iree_tracing_chrome_record_frame(uint8_t type,
+                                             const char* name_literal) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_acquire_thread();
+  if (!thread) return;
+  iree_tracing_chrome_reserve(thread, type, name_literal);
+  iree_tracing_chrome_commit(thread);
+}
+
+void iree_tracing_frame_mark_impl(const char* name_literal) {
+  iree_tracing_chrome_record_frame(IREE_TRACING_CHROME_EVENT_FRAME_MARK,
+                                   name_literal);
+}
+
+void iree_tracing_frame_mark_begin_impl(const char* name_literal) {
+  iree_tracing_chrome_record_frame(IREE_TRACING_CHROME_EVENT_FRAME_BEGIN,
+                                   name_literal);
+}
+
+void iree_tracing_frame_mark_end_impl(const char* name_literal) {
+  iree_tracing_chrome_record_frame(IREE_TRACING_CHROME_EVENT_FRAME_END,
+                                   name_literal);
+}
+
+void iree_tracing_message_impl(const char* value, size_t value_length,
+                               uint32_t color) {
+  iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_acquire_thread();
+  if (!thread) return;
+  iree_tracing_chrome_event_t* event = iree_tracing_chrome_reserve(
+      thread, IREE_TRACING_CHROME_EVENT_MESSAGE, NULL);
+  iree_tracing_chrome_set_text(event, value, value_length);
+  event->color = color;
+  iree_tracing_chrome_commit(thread);
+}
+
+//===----------------------------------------------------------------------===//
+// Control
+//===----------------------------------------------------------------------===//
+
+void iree_tracing_chrome_set_enabled(bool enabled) {
+  iree_atomic_store_int32(&iree_tracing_chrome_state_.disabled,
+                          enabled ? 0 : 1, iree_memory_order_relaxed);
+}
+
+bool iree_tracing_chrome_is_enabled(void) {
+  return iree_atomic_load_int32(&iree_tracing_chrome_state_.disabled,
+                                iree_memory_order_relaxed) == 0;
+}
+
+void iree_tracing_chrome_reset(void) {
+  for (iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_thread_list();
+       thread != NULL; thread = thread->next) {
+    iree_atomic_store_int64(
+        &thread->floor,
+        iree_atomic_load_int64(&thread->head, iree_memory_order_acquire),
+        iree_memory_order_relaxed);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Export
+//===----------------------------------------------------------------------===//
+
+// Copies the events currently retained by |thread| into |out_events|.
+// The owning thread may keep recording while this runs: any event that may
+// have been overwritten during the copy is dropped from the snapshot.
+static void iree_tracing_chrome_snapshot(
+    iree_tracing_chrome_thread_t* thread,
+    iree_tracing_chrome_event_t* out_events, iree_host_size_t* out_offset,
+    iree_host_size_t* out_count) {
+  int64_t head =
+      iree_atomic_load_int64(&thread->head, iree_memory_order_acquire);
+  int64_t begin = head - IREE_TRACING_CHROME_EVENT_CAPACITY;
+  int64_t floor =
+      iree_atomic_load_int64(&thread->floor, iree_memory_order_relaxed);
+  if (begin < floor) begin = floor;
+  if (begin < 0) begin = 0;
+  for (int64_t i = begin; i < head; ++i) {
+    out_events[i - begin] =
+        thread->events[i & (IREE_TRACING_CHROME_EVENT_CAPACITY - 1)];
+  }
+  iree_atomic_thread_fence(iree_memory_order_acquire);
+
+  // The writer fills the slot of index |new_head| before publishing it so
+  // that slot may be torn as well.
+  int64_t new_head =
+      iree_atomic_load_int64(&thread->head, iree_memory_order_relaxed);
+  int64_t valid_begin = new_head - IREE_TRACING_CHROME_EVENT_CAPACITY + 1;
+  if (valid_begin > head) valid_begin = head;
+  int64_t offset = valid_begin > begin ? valid_begin - begin : 0;
+  *out_offset = (iree_host_size_t)offset;
+  *out_count = (iree_host_size_t)(head - begin - offset);
+}
+
+static void iree_tracing_chrome_write_string(FILE* file, const char* value,
+                                             size_t value_length) {
+  fputc('"', file);
+  for (size_t i = 0; i < value_length; ++i) {
+    unsigned char c = (unsigned char)value[i];
+    if (c == '"' || c == '\\') {
+      fputc('\\', file);
+      fputc(c, file);
+    } else if (c < 0x20) {
+      fprintf(file, "\\u%04x", c);
+    } else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+static void iree_tracing_chrome_write_cstring(FILE* file, const char* value) {
+  iree_tracing_chrome_write_string(file, value, strlen(value));
+}
+
+// Writes the separator and fields common to all events.
+static void iree_tracing_chrome_write_event_header(
+    FILE* file, bool* first, const char* phase, uint32_t pid, uint32_t tid,
+    uint64_t timestamp_ns) {
+  fputs(*first ? "\n" : ",\n", file);
+  *first = false;
+  fprintf(file,
+          "{\"ph\":\"%s\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32
+          ",\"ts\":%" PRIu64 ".%03" PRIu32,
+          phase, pid, tid, timestamp_ns / 1000,
+          (uint32_t)(timestamp_ns % 1000));
+}
+
+typedef struct {
+  const iree_tracing_chrome_event_t* begin;
+  iree_host_size_t args_length;
+  char args[IREE_TRACING_CHROME_MAX_ARGS_LENGTH];
+} iree_tracing_chrome_open_zone_t;
+
+static void iree_tracing_chrome_append_arg(
+    iree_tracing_chrome_open_zone_t* zone, const char* value,
+    size_t value_length) {
+  iree_host_size_t capacity = sizeof(zone->args) - zone->args_length;
+  if (zone->args_length > 0 && capacity > 2) {
+    memcpy(&zone->args[zone->args_length], ", ", 2);
+    zone->args_length += 2;
+    capacity -= 2;
+  }
+  value_length = iree_tracing_chrome_utf8_truncate(value, value_length, capacity);
+  memcpy(&zone->args[zone->args_length], value, value_length);
+  zone->args_length += value_length;
+}
+
+static void iree_tracing_chrome_write_zone(
+    FILE* file, bool* first, uint32_t pid, uint32_t tid,
+    const iree_tracing_chrome_open_zone_t* zone,
+    const iree_tracing_chrome_event_t* end) {
+  const iree_tracing_chrome_event_t* begin = zone->begin;
+  iree_tracing_chrome_write_event_header(file, first, end ? "X" : "B", pid, tid,
+                                         begin->timestamp_ns);
+  if (end) {
+    uint64_t duration_ns = end->timestamp_ns - begin->timestamp_ns;
+    fprintf(file, ",\"dur\":%" PRIu64 ".%03" PRIu32, duration_ns / 1000,
+            (uint32_t)(duration_ns % 1000));
+  }
+  fputs(",\"name\":", file);
+  const iree_tracing_location_t* src_loc =
+      (const iree_tracing_location_t*)begin->ptr;
+  if (begin->text_length > 0) {
+    iree_tracing_chrome_write_string(file, begin->payload.text,
+                                     begin->text_length);
+  } else if (src_loc && src_loc->name) {
+    iree_tracing_chrome_write_cstring(file, src_loc->name);
+  } else if (src_loc && src_loc->function) {
+    iree_tracing_chrome_write_cstring(file, src_loc->function);
+  } else {
+    iree_tracing_chrome_write_cstring(file, "unknown");
+  }
+  if (src_loc || zone->args_length > 0) {
+    fputs(",\"args\":{", file);
+    if (src_loc) {
+      fputs("\"file\":", file);
+      iree_tracing_chrome_write_cstring(file, src_loc->file);
+      fprintf(file, ",\"line\":%" PRIu32, src_loc->line);
+    }
+    if (zone->args_length > 0) {
+      fputs(src_loc ? ",\"text\":" : "\"text\":", file);
+      iree_tracing_chrome_write_string(file, zone->args, zone->args_length);
+    }
+    fputc('}', file);
+  }
+  fputc('}', file);
+}
+
+// Writes the events of a single thread. Zone begin/end pairs are combined
+// into complete ("X") events. Ends whose begin was overwritten are dropped and
+// zones still open at the time of the snapshot are written as begin ("B")
+// events.
+static void iree_tracing_chrome_write_thread_events(
+    FILE* file, bool* first, uint32_t pid, uint32_t tid,
+    const iree_tracing_chrome_event_t* events, iree_host_size_t event_count,
+    iree_tracing_chrome_open_zone_t* zone_stack) {
+  iree_host_size_t depth = 0;
+  for (iree_host_size_t i = 0; i < event_count; ++i) {
+    const iree_tracing_chrome_event_t* event = &events[i];
+    iree_tracing_chrome_open_zone_t* zone =
+        depth > 0 && depth <= IREE_TRACING_CHROME_MAX_ZONE_DEPTH
+            ? &zone_stack[depth - 1]
+            : NULL;
+    switch (event->type) {
+      case IREE_TRACING_CHROME_EVENT_ZONE_BEGIN: {
+        if (depth < IREE_TRACING_CHROME_MAX_ZONE_DEPTH) {
+          zone_stack[depth].begin = event;
+          zone_stack[depth].args_length = 0;
+        }
+        ++depth;
+        break;
+      }
+      case IREE_TRACING_CHROME_EVENT_ZONE_END: {
+        if (depth == 0) break;
+        if (zone) {
+          iree_tracing_chrome_write_zone(file, first, pid, tid, zone, event);
+        }
+        --depth;
+        break;
+      }
+      case IREE_TRACING_CHROME_EVENT_ZONE_TEXT: {
+        if (zone) {
+          iree_tracing_chrome_append_arg(zone, event->payload.text,
+                                         event->text_length);
+        }
+        break;
+      }
+      case IREE_TRACING_CHROME_EVENT_ZONE_VALUE: {
+        if (zone) {
+          char value[24];
+          int value_length = snprintf(value, sizeof(value), "%" PRIu64,
+                                      event->payload.u64);
+          iree_tracing_chrome_append_arg(zone, value, (size_t)value_length);
+        }
+        break;
+      }
+      case IREE_TRACING_CHROME_EVENT_PLOT_I64:
+      case IREE_TRACING_CHROME_EVENT_PLOT_F64: {
+        iree_tracing_chrome_write_event_header(file, first, "C", pid, tid,
+                                               event->timestamp_ns);
+        fputs(",\"name\":", file);
+        iree_tracing_chrome_write_cstring(file, (const char*)event->ptr);
+        if (event->type == IREE_TRACING_CHROME_EVENT_PLOT_I64) {
+          fprintf(file, ",\"args\":{\"value\":%" PRIi64 "}}",
+                  event->payload.i64);
+        } else {
+          fprintf(file, ",\"args\":{\"value\":%.17g}}", event->payload.f64);
+        }
+        break;
+      }
+      case IREE_TRACING_CHROME_EVENT_FRAME_MARK: {
+        iree_tracing_chrome_write_event_header(file, first, "i", pid, tid,
+                                               event->timestamp_ns);
+        fputs(",\"s\":\"g\",\"name\":", file);
+        iree_tracing_chrome_write_cstring(
+            file, event->ptr ? (const char*)event->ptr : "frame");
+        fputc('}', file);
+        break;
+      }
+      case IREE_TRACING_CHROME_EVENT_FRAME_BEGIN:
+      case IREE_TRACING_CHROME_EVENT_FRAME_END: {
+        // Discontinuous frames need not nest with zones so they are emitted
+        // as async events keyed by name.
+        iree_tracing_chrome_write_event_header(
+            file, first,
+            event->type == IREE_TRACING_CHROME_EVENT_FRAME_BEGIN ? "b" : "e",
+            pid, tid, event->timestamp_ns);
+        fputs(",\"cat\":\"frame\",\"name\":", file);
+        iree_tracing_chrome_write_cstring(file, (const char*)event->ptr);
+        fputs(",\"id\":", file);
+        iree_tracing_chrome_write_cstring(file, (const char*)event->ptr);
+        fputc('}', file);
+        break;
+      }
+      case IREE_TRACING_CHROME_EVENT_MESSAGE: {
+        iree_tracing_chrome_write_event_header(file, first, "i", pid, tid,
+                                               event->timestamp_ns);
+        fputs(",\"s\":\"t\",\"name\":", file);
+        iree_tracing_chrome_write_string(file, event->payload.text,
+                                         event->text_length);
+        fprintf(file, ",\"args\":{\"color\":\"#%06" PRIx32 "\"}}",
+                event->color & 0xFFFFFFu);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  if (depth > IREE_TRACING_CHROME_MAX_ZONE_DEPTH) {
+    depth = IREE_TRACING_CHROME_MAX_ZONE_DEPTH;
+  }
+  for (iree_host_size_t i = 0; i < depth; ++i) {
+    iree_tracing_chrome_write_zone(file, first, pid, tid, &zone_stack[i],
+                                   NULL);
+  }
+}
+
+bool iree_tracing_chrome_write_file(const char* path) {
+  iree_tracing_chrome_event_t* events = (iree_tracing_chrome_event_t*)malloc(
+      IREE_TRACING_CHROME_EVENT_CAPACITY * sizeof(*events));
+  iree_tracing_chrome_open_zone_t* zone_stack =
+      (iree_tracing_chrome_open_zone_t*)malloc(
+          IREE_TRACING_CHROME_MAX_ZONE_DEPTH * sizeof(*zone_stack));
+  FILE* file = events && zone_stack ? fopen(path, "wb") : NULL;
+  if (!file) {
+    free(zone_stack);
+    free(events);
+    return false;
+  }
+
+  const uint32_t pid = iree_tracing_chrome_process_id();
+  fputs("{\"displayTimeUnit\":\"ns\",\"otherData\":{\"app_info\":", file);
+  iree_tracing_chrome_write_cstring(file, iree_tracing_chrome_state_.app_info);
+  fputs("},\"traceEvents\":[", file);
+  bool first = true;
+  for (iree_tracing_chrome_thread_t* thread = iree_tracing_chrome_thread_list();
+       thread != NULL; thread = thread->next) {
+    if (thread->name[0] != 0) {
+      fputs(first ? "\n" : ",\n", file);
+      first = false;
+      fprintf(file,
+              "{\"ph\":\"M\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32
+              ",\"name\":\"thread_name\",\"args\":{\"name\":",
+              pid, thread->thread_id);
+      iree_tracing_chrome_write_string(
+          file, thread->name, strnlen(thread->name, sizeof(thread->name)));
+      fputs("}}", file);
+    }
+    iree_host_size_t offset = 0;
+    iree_host_size_t count = 0;
+    iree_tracing_chrome_snapshot(thread, events, &offset, &count);
+    iree_tracing_chrome_write_thread_events(file, &first, pid,
+                                            thread->thread_id, events + offset,
+                                            count, zone_stack);
+  }
+  fputs("\n]}\n", file);
+
+  bool succeeded = !ferror(file);
+  succeeded = fclose(file) == 0 && succeeded;
+  free(zone_stack);
+  free(events);
+  return succeeded;
+}
+
+#endif  // IREE_TRACING_FEATURES && IREE_TRACING_BACKEND_CHROME
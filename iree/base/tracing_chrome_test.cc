@@ -0,0 +1,271 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "iree/base/tracing.h"
+#include "iree/testing/gtest.h"
+
+namespace {
+
+#if (IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION) && \
+    IREE_TRACING_BACKEND == IREE_TRACING_BACKEND_CHROME
+
+// Minimal recursive descent JSON validator. Strings must be valid UTF-8.
+class JsonValidator {
+ public:
+  explicit JsonValidator(const std::string& text) : text_(text) {}
+
+  bool Validate() {
+    if (!ParseValue()) return false;
+    SkipWhitespace();
+    return pos_ == text_.size();
+  }
+
+ private:
+  void SkipWhitespace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' ||
+            text_[pos_] == '\t')) {
+      ++pos_;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (pos_ >= text_.size() || text_[pos_] != c) return false;
+    ++pos_;
+    return true;
+  }
+
+  bool ConsumeLiteral(const char* literal) {
+    size_t length = strlen(literal);
+    if (text_.compare(pos_, length, literal) != 0) return false;
+    pos_ += length;
+    return true;
+  }
+
+  bool ParseValue() {
+    SkipWhitespace();
+    if (pos_ >= text_.size()) return false;
+    switch (text_[pos_]) {
+      case '{':
+        return ParseObject();
+      case '[':
+        return ParseArray();
+      case '"':
+        return ParseString();
+      case 't':
+        return ConsumeLiteral("true");
+      case 'f':
+        return ConsumeLiteral("false");
+      case 'n':
+        return ConsumeLiteral("null");
+      default:
+        return ParseNumber();
+    }
+  }
+
+  bool ParseObject() {
+    if (!Consume('{')) return false;
+    if (Consume('}')) return true;
+    do {
+      SkipWhitespace();
+      if (!ParseString() || !Consume(':') || !ParseValue()) return false;
+    } while (Consume(','));
+    return Consume('}');
+  }
+
+  bool ParseArray() {
+    if (!Consume('[')) return false;
+    if (Consume(']')) return true;
+    do {
+      if (!ParseValue()) return false;
+    } while (Consume(','));
+    return Consume(']');
+  }
+
+  bool ParseString() {
+    if (pos_ >= text_.size() || text_[pos_] != '"') return false;
+    ++pos_;
+    while (pos_ < text_.size()) {
+      unsigned char c = static_cast<unsigned char>(text_[pos_]);
+      if (c == '"') {
+        ++pos_;
+        return true;
+      } else if (c == '\\') {
+        if (++pos_ >= text_.size()) return false;
+        char escape = text_[pos_++];
+        if (escape == 'u') {
+          for (int i = 0; i < 4; ++i, ++pos_) {
+            if (pos_ >= text_.size() || !isxdigit(text_[pos_])) return false;
+          }
+        } else if (!strchr("\"\\/bfnrt", escape)) {
+          return false;
+        }
+      } else if (c < 0x20) {
+        return false;
+      } else if (c < 0x80) {
+        ++pos_;
+      } else {
+        int continuation_count = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+        if (c < 0xC2 || c > 0xF4) return false;
+        ++pos_;
+        for (int i = 0; i < continuation_count; ++i, ++pos_) {
+          if (pos_ >= text_.size() ||
+              (static_cast<unsigned char>(text_[pos_]) & 0xC0) != 0x80) {
+            return false;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  bool ParseNumber() {
+    size_t begin = pos_;
+    if (pos_ < text_.size() && text_[pos_] == '-') ++pos_;
+    while (pos_ < text_.size() &&
+           (isdigit(text_[pos_]) || strchr(".eE+-", text_[pos_]))) {
+      ++pos_;
+    }
+    return pos_ > begin && isdigit(text_[pos_ - 1]);
+  }
+
+  const std::string& text_;
+  size_t pos_ = 0;
+};
+
+bool IsValidJson(const std::string& text) {
+  return JsonValidator(text).Validate();
+}
+
+class TracingChromeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_tracing_chrome_set_enabled(true);
+    iree_tracing_chrome_reset();
+  }
+
+  // Writes the current trace and returns its contents.
+  std::string WriteTrace() {
+    std::string path = ::testing::TempDir() + "/tracing_chrome_test.json";
+    EXPECT_TRUE(iree_tracing_chrome_write_file(path.c_str()));
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::remove(path.c_str());
+    return contents.str();
+  }
+};
+
+bool Contains(const std::string& text, const std::string& substring) {
+  return text.find(substring) != std::string::npos;
+}
+
+TEST_F(TracingChromeTest, RecordsZonesAndMessages) {
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "outer_zone");
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, "some \"quoted\" text");
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, 42);
+  IREE_TRACE_ZONE_BEGIN_NAMED(z1, "inner_zone");
+  IREE_TRACE_ZONE_END(z1);
+  IREE_TRACE_MESSAGE(INFO, "hello message");
+  IREE_TRACE_ZONE_END(z0);
+  IREE_TRACE_PLOT_VALUE_I64("test_plot", 7);
+
+  std::string trace = WriteTrace();
+  EXPECT_TRUE(IsValidJson(trace)) << trace;
+  EXPECT_TRUE(Contains(trace, "\"ph\":\"X\"")) << trace;
+  EXPECT_TRUE(Contains(trace, "\"name\":\"outer_zone\"")) << trace;
+  EXPECT_TRUE(Contains(trace, "\"name\":\"inner_zone\"")) << trace;
+  EXPECT_TRUE(Contains(trace, "\"text\":\"some \\\"quoted\\\" text, 42\""))
+      << trace;
+  EXPECT_TRUE(Contains(trace, "\"name\":\"hello message\"")) << trace;
+  EXPECT_TRUE(Contains(trace, "\"args\":{\"value\":7}")) << trace;
+}
+
+TEST_F(TracingChromeTest, OpenZonesAreWrittenAsBegin) {
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "open_zone");
+  std::string trace = WriteTrace();
+  IREE_TRACE_ZONE_END(z0);
+  EXPECT_TRUE(IsValidJson(trace)) << trace;
+  EXPECT_TRUE(Contains(trace, "\"ph\":\"B\"")) << trace;
+  EXPECT_TRUE(Contains(trace, "\"name\":\"open_zone\"")) << trace;
+}
+
+TEST_F(TracingChromeTest, ResetDropsEvents) {
+  IREE_TRACE_MESSAGE(INFO, "dropped message");
+  iree_tracing_chrome_reset();
+  std::string trace = WriteTrace();
+  EXPECT_TRUE(IsValidJson(trace)) << trace;
+  EXPECT_FALSE(Contains(trace, "dropped message")) << trace;
+}
+
+TEST_F(TracingChromeTest, DisabledCaptureRecordsNothing) {
+  iree_tracing_chrome_set_enabled(false);
+  EXPECT_FALSE(iree_tracing_chrome_is_enabled());
+  IREE_TRACE_MESSAGE(INFO, "disabled message");
+  iree_tracing_chrome_set_enabled(true);
+  std::string trace = WriteTrace();
+  EXPECT_TRUE(IsValidJson(trace)) << trace;
+  EXPECT_FALSE(Contains(trace, "disabled message")) << trace;
+}
+
+TEST_F(TracingChromeTest, TruncatesOnCodePointBoundaries) {
+  // Dynamic strings are truncated to 40 bytes. Each value below has a
+  // multi-byte code point straddling that limit which must be dropped as a
+  // whole.
+  std::string prefix(39, 'a');
+  std::string message = prefix + "\xC3\xA9";        // U+00E9
+  std::string zone_name = prefix + "\xE2\x82\xAC";  // U+20AC
+  IREE_TRACE_MESSAGE_DYNAMIC(INFO, message.data(), message.size());
+  IREE_TRACE_ZONE_BEGIN_NAMED_DYNAMIC(z0, zone_name.data(), zone_name.size());
+  IREE_TRACE_ZONE_END(z0);
+
+  std::string trace = WriteTrace();
+  EXPECT_TRUE(IsValidJson(trace)) << trace;
+  EXPECT_TRUE(Contains(trace, "\"name\":\"" + prefix + "\",\"args\":{\"color\""))
+      << trace;
+  EXPECT_TRUE(Contains(trace, "\"name\":\"" + prefix + "\",\"args\":{\"file\""))
+      << trace;
+}
+
+TEST_F(TracingChromeTest, RecyclesRingsOfExitedThreads) {
+  // Each thread exits before the next one starts so all of them share a single
+  // ring and only the events of the last one are retained.
+  for (int i = 0; i < 8; ++i) {
+    std::thread([i]() {
+      std::string message = "worker " + std::to_string(i) + " message";
+      IREE_TRACE_MESSAGE_DYNAMIC(INFO, message.data(), message.size());
+    }).join();
+  }
+  std::string trace = WriteTrace();
+  EXPECT_TRUE(IsValidJson(trace)) << trace;
+  EXPECT_TRUE(Contains(trace, "\"name\":\"worker 7 message\"")) << trace;
+  EXPECT_FALSE(Contains(trace, "\"name\":\"worker 0 message\"")) << trace;
+}
+
+#else
+
+TEST(TracingChromeTest, DISABLED_RequiresChromeBackend) {}
+
+#endif  // IREE_TRACING_FEATURE_INSTRUMENTATION && IREE_TRACING_BACKEND_CHROME
+
+}  // namespace
@@ -16,7 +16,13 @@
 #include "iree/compiler/Conversion/LinalgToLLVM/KernelDispatch.h"
 
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
@@ -69,8 +75,221 @@ static llvm::cl::opt<int> genericOpsWorkgroupTileSize(
         "linalg.generic and linalg.indexed_generic workgroup tile size"),
     llvm::cl::init(128));
 
+static llvm::cl::opt<std::string> clTuningDatabase(
+    "iree-codegen-llvm-tuning-database",
+    llvm::cl::desc("JSON database of per-op tile sizes (as produced by "
+                   "scripts/tune_llvm_tile_sizes.py) overriding the default "
+                   "tile sizes of matching operations"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clDumpTuningKeys(
+    "iree-codegen-llvm-dump-tuning-keys",
+    llvm::cl::desc("Print the tuning database key and default tile sizes of "
+                   "each dispatch root operation to stderr"),
+    llvm::cl::init(false));
+
+// Returns the original problem size of |operand| before tiling.
+static ArrayRef<int64_t> getOriginalOperandShape(Value operand) {
+  if (auto dispatchLoadOp =
+          operand.getDefiningOp<IREE::Flow::DispatchTensorLoadOp>()) {
+    return dispatchLoadOp.source()
+        .getType()
+        .cast<IREE::Flow::DispatchTensorType>()
+        .getShape();
+  }
+  if (auto operandParent = operand.getDefiningOp<memref::SubViewOp>()) {
+    return operandParent.source().getType().cast<ShapedType>().getShape();
+  }
+  if (auto operandParent = operand.getDefiningOp<SubTensorOp>()) {
+    return operandParent.source().getType().cast<ShapedType>().getShape();
+  }
+  if (auto operandParent = operand.getDefiningOp<memref::AllocaOp>()) {
+    return operandParent.getType().cast<ShapedType>().getShape();
+  }
+  return ArrayRef<int64_t>{};
+}
+
+//===----------------------------------------------------------------------===//
+// Tuning database
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+// Tile sizes for all tiling levels of an operation selected by op name and,
+// optionally, the original shapes of its input operands. The database is a
+// JSON file of the form:
+//   {"entries": [{"op": "linalg.matmul", "shape": [[384, 512], [512, 128]],
+//                 "workgroup_tile_sizes": [32, 64],
+//                 "l1_tile_sizes": [16, 32, 32],
+//                 "vector_tile_sizes": [4, 4, 4]}]}
+// Entries without a "shape" match any operation with the given name. Tiling
+// levels that are not specified keep their default tile sizes.
+struct TuningEntry {
+  std::string opName;
+  Optional<SmallVector<SmallVector<int64_t, 4>, 4>> inputShapes;
+  SmallVector<int64_t, 4>
+      tileSizes[static_cast<unsigned>(TilingLevel::NumTileLevels)];
+};
+
+}  // namespace
+
+static const char *kTuningLevelKeys[] = {
+    "workgroup_tile_sizes",
+    "l1_tile_sizes",
+    "vector_tile_sizes",
+};
+static_assert(llvm::array_lengthof(kTuningLevelKeys) ==
+                  static_cast<unsigned>(TilingLevel::NumTileLevels),
+              "expected one database key per tiling level");
+
+static bool parseIntegerArray(const llvm::json::Array &array,
+                              SmallVectorImpl<int64_t> &values) {
+  for (const llvm::json::Value &value : array) {
+    Optional<int64_t> integer = value.getAsInteger();
+    if (!integer) return false;
+    values.push_back(*integer);
+  }
+  return true;
+}
+
+static Optional<TuningEntry> parseTuningEntry(const llvm::json::Value &value) {
+  const llvm::json::Object *object = value.getAsObject();
+  if (!object) return llvm::None;
+  TuningEntry entry;
+  Optional<StringRef> opName = object->getString("op");
+  if (!opName) return llvm::None;
+  entry.opName = opName->str();
+  if (const llvm::json::Array *shapes = object->getArray("shape")) {
+    entry.inputShapes.emplace();
+    for (const llvm::json::Value &shape : *shapes) {
+      const llvm::json::Array *dims = shape.getAsArray();
+      entry.inputShapes->emplace_back();
+      if (!dims || !parseIntegerArray(*dims, entry.inputShapes->back())) {
+        return llvm::None;
+      }
+    }
+  }
+  for (unsigned level = 0; level < llvm::array_lengthof(kTuningLevelKeys);
+       ++level) {
+    const llvm::json::Array *tileSizes =
+        object->getArray(kTuningLevelKeys[level]);
+    if (tileSizes && !parseIntegerArray(*tileSizes, entry.tileSizes[level])) {
+      return llvm::None;
+    }
+  }
+  return entry;
+}
+
+namespace {
+
+// A tuning database loaded from a file. Load failures are retained so that they
+// can be reported by the pass that first uses the database.
+struct TuningDatabase {
+  std::vector<TuningEntry> entries;
+  std::string errorMessage;
+};
+
+}  // namespace
+
+static TuningDatabase loadTuningDatabase(StringRef path) {
+  TuningDatabase database;
+  auto fileOrErr = llvm::MemoryBuffer::getFile(path);
+  if (!fileOrErr) {
+    database.errorMessage = ("unable to open tuning database '" + path +
+                             "': " + fileOrErr.getError().message())
+                                .str();
+    return database;
+  }
+  auto json = llvm::json::parse((*fileOrErr)->getBuffer());
+  if (!json) {
+    database.errorMessage = ("unable to parse tuning database '" + path +
+                             "': " + llvm::toString(json.takeError()))
+                                .str();
+    return database;
+  }
+  const llvm::json::Object *root = json->getAsObject();
+  const llvm::json::Array *entryArray =
+      root ? root->getArray("entries") : nullptr;
+  if (!entryArray) {
+    database.errorMessage =
+        ("tuning database '" + path + "' is missing the 'entries' array")
+            .str();
+    return database;
+  }
+  for (const llvm::json::Value &value : *entryArray) {
+    Optional<TuningEntry> entry = parseTuningEntry(value);
+    if (!entry) {
+      database.errorMessage =
+          ("malformed entry in tuning database '" + path + "'").str();
+      database.entries.clear();
+      return database;
+    }
+    database.entries.push_back(std::move(*entry));
+  }
+  return database;
+}
+
+// Returns the database currently selected with
+// -iree-codegen-llvm-tuning-database. Databases are loaded once per path as the
+// tile size queries are spread across passes and threads.
+static const TuningDatabase &getTuningDatabase() {
+  static llvm::sys::SmartMutex<true> mutex;
+  static llvm::StringMap<TuningDatabase> databases;
+  static const TuningDatabase emptyDatabase;
+  const std::string &path = clTuningDatabase;
+  if (path.empty()) return emptyDatabase;
+  llvm::sys::SmartScopedLock<true> lock(mutex);
+  auto it = databases.find(path);
+  if (it == databases.end()) {
+    it = databases.try_emplace(path, loadTuningDatabase(path)).first;
+  }
+  // StringMap values are not moved on insertion so the reference stays valid.
+  return it->second;
+}
+
+LogicalResult verifyCPUTuningDatabase(Operation *op) {
+  const TuningDatabase &database = getTuningDatabase();
+  if (database.errorMessage.empty()) return success();
+  return op->emitError(database.errorMessage);
+}
+
+// Returns the original shapes of the input operands of |op| used to key the
+// tuning database. Unknown shapes are returned as empty.
+static SmallVector<SmallVector<int64_t, 4>, 4> getTuningInputShapes(
+    linalg::LinalgOp op) {
+  SmallVector<SmallVector<int64_t, 4>, 4> inputShapes;
+  for (Value input : op.getInputs()) {
+    ArrayRef<int64_t> shape = getOriginalOperandShape(input);
+    inputShapes.emplace_back(shape.begin(), shape.end());
+  }
+  return inputShapes;
+}
+
+// Returns the tuning database entry for |op|. Entries matching the input shapes
+// exactly take precedence over entries matching any shape.
+static const TuningEntry *lookupTuningEntry(Operation *op) {
+  // Databases that failed to load are diagnosed by verifyCPUTuningDatabase and
+  // hold no entries.
+  const std::vector<TuningEntry> &database = getTuningDatabase().entries;
+  if (database.empty()) return nullptr;
+  auto linalgOp = dyn_cast<linalg::LinalgOp>(op);
+  if (!linalgOp) return nullptr;
+  StringRef opName = op->getName().getStringRef();
+  auto inputShapes = getTuningInputShapes(linalgOp);
+  const TuningEntry *anyShapeEntry = nullptr;
+  for (const TuningEntry &entry : database) {
+    if (entry.opName != opName) continue;
+    if (!entry.inputShapes) {
+      if (!anyShapeEntry) anyShapeEntry = &entry;
+      continue;
+    }
+    if (*entry.inputShapes == inputShapes) return &entry;
+  }
+  return anyShapeEntry;
+}
+
 template <TilingLevel tilingLevel>
-llvm::SmallVector<int64_t, 4> getTileSizes(Operation *op) {
+static llvm::SmallVector<int64_t, 4> getDefaultTileSizes(Operation *op) {
   if (auto contractionOp = dyn_cast<linalg::ContractionOpInterface>(op)) {
     if (contractionOp.isRowMajorMatmul()) {
       int mWorkgroupSize = matmulWorkgroupTileSize;
@@ -79,33 +298,6 @@ llvm::SmallVector<int64_t, 4> getTileSizes(Operation *op) {
       int nL1TileSize = matmulL1TileSize;
       int kL1TileSize = matmulL1TileSize;
       if (auto matmulOp = dyn_cast<linalg::MatmulOp>(op)) {
-        // Returns the original problem size before tiling.
-        auto getOriginalOperandShape = [](Value operand) {
-          if (auto dispatchLoadOp =
-                  operand.getDefiningOp<IREE::Flow::DispatchTensorLoadOp>()) {
-            return dispatchLoadOp.source()
-                .getType()
-                .cast<IREE::Flow::DispatchTensorType>()
-                .getShape();
-          }
-          if (auto operandParent = operand.getDefiningOp<memref::SubViewOp>()) {
-            return operandParent.source()
-                .getType()
-                .cast<ShapedType>()
-                .getShape();
-          }
-          if (auto operandParent = operand.getDefiningOp<SubTensorOp>()) {
-            return operandParent.source()
-                .getType()
-                .cast<ShapedType>()
-                .getShape();
-          }
-          if (auto operandParent = operand.getDefiningOp<memref::AllocaOp>()) {
-            return operandParent.getType().cast<ShapedType>().getShape();
-          }
-          return ArrayRef<int64_t>{};
-        };
-
         auto lhsShape = getOriginalOperandShape(matmulOp.inputs()[0]);
         auto rhsShape = getOriginalOperandShape(matmulOp.inputs()[1]);
 
@@ -186,6 +378,42 @@ llvm::SmallVector<int64_t, 4> getTileSizes(Operation *op) {
   return {1, 1, 1};
 }
 
+template <TilingLevel tilingLevel>
+llvm::SmallVector<int64_t, 4> getTileSizes(Operation *op) {
+  if (const TuningEntry *entry = lookupTuningEntry(op)) {
+    const auto &tileSizes =
+        entry->tileSizes[static_cast<unsigned>(tilingLevel)];
+    if (!tileSizes.empty()) return tileSizes;
+  }
+  return getDefaultTileSizes<tilingLevel>(op);
+}
+
+// Prints the tuning database key of |op| along with its default tile sizes as
+// a single line of JSON. Consumed by scripts/tune_llvm_tile_sizes.py to map
+// dispatch functions to database entries and to seed the tile size sweep.
+static void dumpTuningKey(linalg::LinalgOp op) {
+  llvm::json::Array shapes;
+  for (const auto &shape : getTuningInputShapes(op)) {
+    shapes.push_back(llvm::json::Array(shape));
+  }
+  llvm::json::Object key{
+      {"dispatch", op->getParentOfType<FuncOp>().getName().str()},
+      {"op", op->getName().getStringRef().str()},
+      {"shape", std::move(shapes)},
+      {kTuningLevelKeys[0],
+       llvm::json::Array(
+           getDefaultTileSizes<TilingLevel::WorkGroupTiles>(op))},
+      {kTuningLevelKeys[1],
+       llvm::json::Array(getDefaultTileSizes<TilingLevel::Level1Tiles>(op))},
+      {kTuningLevelKeys[2],
+       llvm::json::Array(getDefaultTileSizes<TilingLevel::Level2Tiles>(op))},
+  };
+  std::string line;
+  llvm::raw_string_ostream os(line);
+  os << "iree-llvm-tuning-key: " << llvm::json::Value(std::move(key)) << "\n";
+  llvm::errs() << os.str();
+}
+
 #define DEFINE_TILE_SIZE_FN(tilingLevel)                                      \
   template <>                                                                 \
   SmallVector<Value, 4> TileSizeFn::get<tilingLevel>(OpBuilder & builder,     \
@@ -236,6 +464,7 @@ Optional<LaunchConfig> initCPULaunchConfig(
       return llvm::None;
     }
     rootOperation = linalgOp;
+    if (clDumpTuningKeys) dumpTuningKey(linalgOp);
     SmallVector<int64_t, 4> opTileSizes;
     if (!clLLVMTileSizes.empty()) {
       opTileSizes.assign(clLLVMTileSizes.begin(), clLLVMTileSizes.end());
@@ -42,6 +42,10 @@ struct TileSizeFn {
 template <TilingLevel tilingLevel>
 llvm::SmallVector<int64_t, 4> getTileSizes(Operation *op);
 
+// Loads the tuning database selected with -iree-codegen-llvm-tuning-database
+// and emits an error on |op| if it cannot be read or parsed.
+LogicalResult verifyCPUTuningDatabase(Operation *op);
+
 Optional<LaunchConfig> initCPULaunchConfig(
     MLIRContext *context, const linalg::LinalgDependenceGraph &dependenceGraph,
     ArrayRef<linalg::LinalgOp> linalgOps);
@@ -54,6 +54,7 @@ void MaterializeCPULaunchConfigurationPass::runOnOperation() {
   MLIRContext *context = &getContext();
   IREE::HAL::ExecutableTargetOp targetOp = getOperation();
   ModuleOp module = targetOp.getInnerModule();
+  if (failed(verifyCPUTuningDatabase(targetOp))) return signalPassFailure();
 
   for (FuncOp funcOp : module.getOps<FuncOp>()) {
     if (!isEntryPoint(funcOp)) continue;
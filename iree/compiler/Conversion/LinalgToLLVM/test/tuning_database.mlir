@@ -0,0 +1,78 @@
+// RUN: echo '{"entries": [{"op": "linalg.matmul", "shape": [[-1, -1], [-1, -1]], "workgroup_tile_sizes": [8, 16]}, {"op": "linalg.matmul", "workgroup_tile_sizes": [2, 2]}]}' > %t.exact.json
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-materialize-launch-configuration))" -iree-codegen-llvm-tuning-database=%t.exact.json -cse -canonicalize %s | IreeFileCheck %s
+// RUN: echo '{"entries": [{"op": "linalg.matmul", "workgroup_tile_sizes": [2, 32]}]}' > %t.any.json
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-materialize-launch-configuration))" -iree-codegen-llvm-tuning-database=%t.any.json -cse -canonicalize %s | IreeFileCheck %s --check-prefix=ANY
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-materialize-launch-configuration))" -iree-codegen-llvm-dump-tuning-keys %s 2>&1 >/dev/null | IreeFileCheck %s --check-prefix=KEY
+hal.executable @matmul_tensors attributes {sym_visibility = "private"} {
+  hal.interface @io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.target @llvm_aot, filter="dylib*" {
+    hal.executable.entry_point @matmul_tensors attributes {
+      interface = @io, ordinal = 0 : index,
+      signature = (!flow.dispatch.tensor<readonly:?x?xf32>, !flow.dispatch.tensor<readonly:?x?xf32>,
+        !flow.dispatch.tensor<writeonly:?x?xf32>) -> ()}
+    module {
+      func @matmul_tensors() {
+        %c0 = constant 0 : index
+        %c1 = constant 1 : index
+        %0 = hal.interface.binding.subspan @io::@arg0[%c0] : memref<?x?xf32>
+        %2 = hal.interface.binding.subspan @io::@arg1[%c0] : memref<?x?xf32>
+        %4 = hal.interface.binding.subspan @io::@arg2[%c0] : memref<?x?xf32>
+        %6 = hal.interface.binding.subspan @io::@ret0[%c0] : memref<?x?xf32>
+        %M = memref.dim %0, %c0 : memref<?x?xf32>
+        %N = memref.dim %2, %c1 : memref<?x?xf32>
+        %K = memref.dim %0, %c1 : memref<?x?xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %8 = muli %workgroup_size_y, %workgroup_id_y : index
+        %9 = muli %workgroup_size_y, %workgroup_count_y : index
+        scf.for %arg0 = %8 to %M step %9 {
+          %10 = muli %workgroup_size_x, %workgroup_id_x : index
+          %11 = muli %workgroup_size_x, %workgroup_count_x : index
+          scf.for %arg1 = %10 to %N step %11 {
+            %12 = affine.min affine_map<(d0)[s0, s1] -> (s0, -d0 + s1)>(%arg0)[%workgroup_size_y, %N]
+            %13 = memref.subview %0[%arg0, 0] [%12, %K] [1, 1] : memref<?x?xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+            %14 = affine.min affine_map<(d0)[s0, s1] -> (s0, -d0 + s1)>(%arg1)[%workgroup_size_x, %M]
+            %15 = memref.subview %2[0, %arg1] [%K, %14] [1, 1] : memref<?x?xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+            %16 = memref.subview %4[%arg0, %arg1] [%12, %14] [1, 1] : memref<?x?xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+            %17 = memref.alloc(%12, %14) : memref<?x?xf32>
+            linalg.copy(%16, %17) : memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>, memref<?x?xf32>
+            linalg.matmul {__internal_linalg_transform__ = "workgroup"} ins(%13, %15 : memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>, memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>) outs(%17 : memref<?x?xf32>)
+            %18 = memref.subview %6[%arg0, %arg1] [%12, %14] [1, 1] : memref<?x?xf32> to memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+            linalg.copy(%17, %18) : memref<?x?xf32>, memref<?x?xf32, affine_map<(d0, d1)[s0, s1] -> (d0 * s1 + s0 + d1)>>
+          }
+        }
+        return
+      }
+    }
+  }
+
+// Exact shape matches take precedence over entries matching any shape.
+//   CHECK-DAG: #[[MAP0:.+]] = affine_map<()[s0] -> (s0 ceildiv 16)>
+//   CHECK-DAG: #[[MAP1:.+]] = affine_map<()[s0] -> (s0 ceildiv 8)>
+//       CHECK: hal.executable.entry_point @matmul_tensors
+//  CHECK-NEXT:   ^{{[a-zA-Z0-9_]+}}(
+//  CHECK-SAME:     %[[ARG0:[a-zA-Z0-9_]+]]: index
+//  CHECK-SAME:     %[[ARG1:[a-zA-Z0-9_]+]]: index
+//   CHECK-DAG:     %[[WGX:.+]] = affine.apply #[[MAP0]]()[%[[ARG0]]]
+//   CHECK-DAG:     %[[WGY:.+]] = affine.apply #[[MAP1]]()[%[[ARG1]]]
+//       CHECK:     hal.return %[[WGX]], %[[WGY]]
+
+//   ANY-DAG: #[[MAP0:.+]] = affine_map<()[s0] -> (s0 ceildiv 32)>
+//   ANY-DAG: #[[MAP1:.+]] = affine_map<()[s0] -> (s0 ceildiv 2)>
+//       ANY: hal.executable.entry_point @matmul_tensors
+//  ANY-NEXT:   ^{{[a-zA-Z0-9_]+}}(
+//  ANY-SAME:     %[[ARG0:[a-zA-Z0-9_]+]]: index
+//  ANY-SAME:     %[[ARG1:[a-zA-Z0-9_]+]]: index
+//   ANY-DAG:     %[[WGX:.+]] = affine.apply #[[MAP0]]()[%[[ARG0]]]
+//   ANY-DAG:     %[[WGY:.+]] = affine.apply #[[MAP1]]()[%[[ARG1]]]
+//       ANY:     hal.return %[[WGX]], %[[WGY]]
+
+//       KEY: iree-llvm-tuning-key: {"dispatch":"matmul_tensors","l1_tile_sizes":[4,4,4],"op":"linalg.matmul","shape":{{\[\[}}-1,-1],[-1,-1]],"vector_tile_sizes":[4,4,4],"workgroup_tile_sizes":[4,4]}
@@ -0,0 +1,19 @@
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-materialize-launch-configuration))" -iree-codegen-llvm-tuning-database=%t.missing.json -verify-diagnostics %s
+// RUN: echo '{"entries": [{"workgroup_tile_sizes": [8, 16]}]}' > %t.malformed.json
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-materialize-launch-configuration))" -iree-codegen-llvm-tuning-database=%t.malformed.json -verify-diagnostics %s
+
+hal.executable @noop attributes {sym_visibility = "private"} {
+  hal.interface @io {
+  }
+  // expected-error @+1 {{tuning database}}
+  hal.executable.target @llvm_aot, filter="dylib*" {
+    hal.executable.entry_point @noop attributes {
+      interface = @io, ordinal = 0 : index,
+      signature = () -> ()}
+    module {
+      func @noop() {
+        return
+      }
+    }
+  }
+}
@@ -0,0 +1,234 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <type_traits>
+
+#include "iree/compiler/Conversion/LinalgToLinalg/Passes.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+// clang-format off
+//
+// Packs the constant RHS of linalg.matmul/linalg.batch_matmul into panels of
+// |panelSize| columns at compile time so that each panel is contiguous in
+// memory:
+//   rhs    : tensor<KxN>              rhs[k][n]
+//   packed : tensor<(N/P)xKxP>        packed[n1][k][n0] = rhs[k][n1 * P + n0]
+// The matmul is rewritten to a linalg.generic reading the packed constant and
+// producing the output expanded to tensor<Mx(N/P)xP>, which is then reshaped
+// back to tensor<MxN> (a metadata-only reshape as the dimensions are
+// contiguous):
+//   out[m][n1][n0] += lhs[m][k] * packed[n1][k][n0]
+// Batched matmuls are handled the same way with an additional outer batch
+// dimension. Because the packing happens on the constant the weights are
+// emitted in the packed layout and no repacking happens at runtime.
+//
+// clang-format on
+template <typename OpTy>
+class PackMatmulConstantRHSPattern : public OpRewritePattern<OpTy> {
+ public:
+  PackMatmulConstantRHSPattern(MLIRContext *context, int64_t panelSize)
+      : OpRewritePattern<OpTy>(context), panelSize(panelSize) {}
+
+  LogicalResult matchAndRewrite(OpTy matmulOp,
+                                PatternRewriter &rewriter) const override {
+    if (!matmulOp.hasTensorSemantics()) return failure();
+    constexpr bool isBatched = std::is_same<OpTy, linalg::BatchMatmulOp>();
+    constexpr int64_t batchRank = isBatched ? 1 : 0;
+
+    Value lhs = matmulOp.getInput(0);
+    Value rhs = matmulOp.getInput(1);
+    Value output = matmulOp.getOutput(0);
+    auto lhsType = lhs.getType().template dyn_cast<RankedTensorType>();
+    auto rhsType = rhs.getType().template dyn_cast<RankedTensorType>();
+    auto outputType = output.getType().template dyn_cast<RankedTensorType>();
+    if (!lhsType || !rhsType || !outputType) return failure();
+    if (!rhsType.hasStaticShape()) return failure();
+
+    // Mixed precision matmuls (like i8xi8->i32) need extension ops in the
+    // body; only handle the uniform case.
+    Type elementType = rhsType.getElementType();
+    if (lhsType.getElementType() != elementType ||
+        outputType.getElementType() != elementType) {
+      return failure();
+    }
+    if (!elementType.isa<FloatType, IntegerType>() ||
+        elementType.getIntOrFloatBitWidth() % 8 != 0) {
+      return failure();
+    }
+
+    // Splats have no layout to speak of.
+    DenseElementsAttr rhsAttr;
+    if (!matchPattern(rhs, m_Constant(&rhsAttr)) || rhsAttr.isSplat()) {
+      return failure();
+    }
+
+    // Only full panels are supported and a single panel is already packed.
+    auto rhsShape = rhsType.getShape();
+    int64_t batchSize = isBatched ? rhsShape[0] : 1;
+    int64_t k = rhsShape[batchRank];
+    int64_t n = rhsShape[batchRank + 1];
+    if (n % panelSize != 0 || n == panelSize) return failure();
+    int64_t panelCount = n / panelSize;
+
+    // Permute the constant data into panel-major order.
+    ArrayRef<char> rawData = rhsAttr.getRawData();
+    int64_t elementSize = elementType.getIntOrFloatBitWidth() / 8;
+    int64_t panelRowSize = panelSize * elementSize;
+    std::vector<char> packedData(rawData.size());
+    char *packedPtr = packedData.data();
+    for (int64_t b = 0; b < batchSize; ++b) {
+      const char *batchPtr = rawData.data() + b * k * n * elementSize;
+      for (int64_t panel = 0; panel < panelCount; ++panel) {
+        for (int64_t row = 0; row < k; ++row) {
+          std::memcpy(packedPtr,
+                      batchPtr + row * n * elementSize + panel * panelRowSize,
+                      panelRowSize);
+          packedPtr += panelRowSize;
+        }
+      }
+    }
+
+    Location loc = matmulOp.getLoc();
+    SmallVector<int64_t, 4> packedShape;
+    if (isBatched) packedShape.push_back(batchSize);
+    packedShape.append({panelCount, k, panelSize});
+    auto packedType = RankedTensorType::get(packedShape, elementType);
+    Value packedRHS = rewriter.create<ConstantOp>(
+        loc, DenseElementsAttr::getFromRawBuffer(packedType, packedData,
+                                                 /*isSplatBuffer=*/false));
+
+    // Expand the N dimension of the output into (N/P, P).
+    auto outputShape = outputType.getShape();
+    SmallVector<int64_t, 4> expandedOutputShape(outputShape.begin(),
+                                                outputShape.end() - 1);
+    expandedOutputShape.append({panelCount, panelSize});
+    auto expandedOutputType =
+        RankedTensorType::get(expandedOutputShape, elementType);
+    SmallVector<linalg::ReassociationIndices> outputReassociationIndices;
+    for (int64_t i = 0; i < outputType.getRank() - 1; ++i) {
+      outputReassociationIndices.push_back({i});
+    }
+    outputReassociationIndices.push_back(
+        {outputType.getRank() - 1, outputType.getRank()});
+    Value expandedOutput = rewriter.create<linalg::TensorReshapeOp>(
+        loc, expandedOutputType, output, outputReassociationIndices);
+
+    // Loops are ([b,] m, n1, n0, k).
+    MLIRContext *context = rewriter.getContext();
+    unsigned loopCount = batchRank + 4;
+    auto d = [&](unsigned i) { return rewriter.getAffineDimExpr(i); };
+    SmallVector<AffineExpr, 4> batchExprs;
+    if (isBatched) batchExprs.push_back(d(0));
+    auto m = d(batchRank), n1 = d(batchRank + 1), n0 = d(batchRank + 2),
+         kk = d(batchRank + 3);
+    auto withBatch = [&](ArrayRef<AffineExpr> exprs) {
+      SmallVector<AffineExpr, 4> results(batchExprs.begin(), batchExprs.end());
+      results.append(exprs.begin(), exprs.end());
+      return AffineMap::get(loopCount, 0, results, context);
+    };
+    SmallVector<AffineMap, 3> indexingMaps = {
+        withBatch({m, kk}),
+        withBatch({n1, kk, n0}),
+        withBatch({m, n1, n0}),
+    };
+    SmallVector<StringRef, 5> iteratorTypes(loopCount - 1,
+                                            getParallelIteratorTypeName());
+    iteratorTypes.push_back(getReductionIteratorTypeName());
+
+    bool isFloat = elementType.isa<FloatType>();
+    auto genericOp = rewriter.create<linalg::GenericOp>(
+        loc, expandedOutputType, ValueRange{lhs, packedRHS},
+        ValueRange{expandedOutput}, indexingMaps, iteratorTypes,
+        [&](OpBuilder &nestedBuilder, Location nestedLoc, ValueRange args) {
+          Value mul, add;
+          if (isFloat) {
+            mul = nestedBuilder.create<MulFOp>(nestedLoc, args[0], args[1]);
+            add = nestedBuilder.create<AddFOp>(nestedLoc, args[2], mul);
+          } else {
+            mul = nestedBuilder.create<MulIOp>(nestedLoc, args[0], args[1]);
+            add = nestedBuilder.create<AddIOp>(nestedLoc, args[2], mul);
+          }
+          nestedBuilder.create<linalg::YieldOp>(nestedLoc, add);
+        });
+
+    Value result = rewriter.create<linalg::TensorReshapeOp>(
+        loc, outputType, genericOp.getResult(0), outputReassociationIndices);
+    rewriter.replaceOp(matmulOp, result);
+    return success();
+  }
+
+ private:
+  int64_t panelSize;
+};
+
+struct PackMatmulConstantRHSPass
+    : public PassWrapper<PackMatmulConstantRHSPass, FunctionPass> {
+  PackMatmulConstantRHSPass() = default;
+  PackMatmulConstantRHSPass(const PackMatmulConstantRHSPass &that) {
+    panelSize = that.panelSize;
+  }
+  explicit PackMatmulConstantRHSPass(int64_t panelSize) {
+    this->panelSize = panelSize;
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect, StandardOpsDialect>();
+  }
+
+  void runOnFunction() override {
+    if (panelSize <= 0) {
+      getOperation().emitError()
+          << "panel-size must be positive but got " << panelSize;
+      return signalPassFailure();
+    }
+    MLIRContext *context = &getContext();
+    OwningRewritePatternList patterns(&getContext());
+    patterns.insert<PackMatmulConstantRHSPattern<linalg::MatmulOp>,
+                    PackMatmulConstantRHSPattern<linalg::BatchMatmulOp>>(
+        context, panelSize);
+    (void)applyPatternsAndFoldGreedily(getOperation(), std::move(patterns));
+  }
+
+  Option<int64_t> panelSize{
+      *this, "panel-size",
+      llvm::cl::desc("Number of RHS columns packed contiguously per panel"),
+      llvm::cl::init(8)};
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createPackMatmulConstantRHSPass(
+    int64_t panelSize) {
+  return std::make_unique<PackMatmulConstantRHSPass>(panelSize);
+}
+
+static PassRegistration<PackMatmulConstantRHSPass> pass(
+    "iree-codegen-pack-matmul-constant-rhs",
+    "Pack constant right-hand side operands of linalg matmul ops into "
+    "panel-major layout at compile time");
+
+}  // namespace iree_compiler
+}  // namespace mlir
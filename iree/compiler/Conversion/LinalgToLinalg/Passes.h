@@ -24,6 +24,11 @@ std::unique_ptr<OperationPass<FuncOp>> createConvert1x1ConvToMatmulPass();
 
 std::unique_ptr<OperationPass<FuncOp>> createConvertConv2DToImg2ColPass();
 
+/// Creates a pass to pack constant right-hand side operands of linalg.matmul
+/// and linalg.batch_matmul into panels of |panelSize| contiguous columns.
+std::unique_ptr<OperationPass<FuncOp>> createPackMatmulConstantRHSPass(
+    int64_t panelSize = 8);
+
 }  // namespace iree_compiler
 }  // namespace mlir
 #endif  // IREE_COMPILER_CONVERSION_LINALGTOLINALG_PASSES_H_
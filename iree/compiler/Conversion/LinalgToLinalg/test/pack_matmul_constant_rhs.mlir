@@ -0,0 +1,50 @@
+// RUN: iree-opt -split-input-file -iree-codegen-pack-matmul-constant-rhs="panel-size=2" %s | IreeFileCheck %s
+
+func @matmul_constant_rhs(%arg0: tensor<3x2xi32>, %arg1: tensor<3x4xi32>) -> tensor<3x4xi32> {
+  %rhs = constant dense<[[0, 1, 2, 3], [4, 5, 6, 7]]> : tensor<2x4xi32>
+  %0 = linalg.matmul ins(%arg0, %rhs : tensor<3x2xi32>, tensor<2x4xi32>) outs(%arg1 : tensor<3x4xi32>) -> tensor<3x4xi32>
+  return %0 : tensor<3x4xi32>
+}
+//  CHECK-DAG: #[[LHS_MAP:.+]] = affine_map<(d0, d1, d2, d3) -> (d0, d3)>
+//  CHECK-DAG: #[[RHS_MAP:.+]] = affine_map<(d0, d1, d2, d3) -> (d1, d3, d2)>
+//  CHECK-DAG: #[[OUT_MAP:.+]] = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2)>
+//      CHECK: func @matmul_constant_rhs
+// CHECK-SAME:   %[[LHS:.+]]: tensor<3x2xi32>, %[[OUT:.+]]: tensor<3x4xi32>
+//  CHECK-DAG:   %[[PACKED:.+]] = constant dense<{{\[}}{{\[}}[0, 1], [4, 5]], {{\[}}[2, 3], [6, 7]]]> : tensor<2x2x2xi32>
+//  CHECK-DAG:   %[[EXPANDED_OUT:.+]] = linalg.tensor_reshape %[[OUT]] {{\[}}[0], [1, 2]] : tensor<3x4xi32> into tensor<3x2x2xi32>
+//      CHECK:   %[[RESULT:.+]] = linalg.generic
+// CHECK-SAME:     indexing_maps = [#[[LHS_MAP]], #[[RHS_MAP]], #[[OUT_MAP]]]
+// CHECK-SAME:     iterator_types = ["parallel", "parallel", "parallel", "reduction"]
+// CHECK-SAME:     ins(%[[LHS]], %[[PACKED]] : tensor<3x2xi32>, tensor<2x2x2xi32>)
+// CHECK-SAME:     outs(%[[EXPANDED_OUT]] : tensor<3x2x2xi32>)
+//      CHECK:     muli
+//      CHECK:     addi
+//      CHECK:   %[[COLLAPSED:.+]] = linalg.tensor_reshape %[[RESULT]] {{\[}}[0], [1, 2]] : tensor<3x2x2xi32> into tensor<3x4xi32>
+//      CHECK:   return %[[COLLAPSED]]
+
+// -----
+
+func @batch_matmul_constant_rhs(%arg0: tensor<2x3x1xf32>, %arg1: tensor<2x3x4xf32>) -> tensor<2x3x4xf32> {
+  %rhs = constant dense<[[[0.0, 1.0, 2.0, 3.0]], [[4.0, 5.0, 6.0, 7.0]]]> : tensor<2x1x4xf32>
+  %0 = linalg.batch_matmul ins(%arg0, %rhs : tensor<2x3x1xf32>, tensor<2x1x4xf32>) outs(%arg1 : tensor<2x3x4xf32>) -> tensor<2x3x4xf32>
+  return %0 : tensor<2x3x4xf32>
+}
+//  CHECK-DAG: #[[RHS_MAP:.+]] = affine_map<(d0, d1, d2, d3, d4) -> (d0, d2, d4, d3)>
+//      CHECK: func @batch_matmul_constant_rhs
+//      CHECK:   constant dense<{{.+}}> : tensor<2x2x1x2xf32>
+//      CHECK:   linalg.tensor_reshape %{{.+}} {{\[}}[0], [1], [2, 3]] : tensor<2x3x4xf32> into tensor<2x3x2x2xf32>
+//      CHECK:   linalg.generic
+// CHECK-SAME:     iterator_types = ["parallel", "parallel", "parallel", "parallel", "reduction"]
+//      CHECK:     mulf
+//      CHECK:     addf
+//      CHECK:   linalg.tensor_reshape %{{.+}} {{\[}}[0], [1], [2, 3]] : tensor<2x3x2x2xf32> into tensor<2x3x4xf32>
+
+// -----
+
+func @matmul_dynamic_rhs(%arg0: tensor<3x2xf32>, %arg1: tensor<2x4xf32>, %arg2: tensor<3x4xf32>) -> tensor<3x4xf32> {
+  %0 = linalg.matmul ins(%arg0, %arg1 : tensor<3x2xf32>, tensor<2x4xf32>) outs(%arg2 : tensor<3x4xf32>) -> tensor<3x4xf32>
+  return %0 : tensor<3x4xf32>
+}
+//      CHECK: func @matmul_dynamic_rhs
+//      CHECK:   linalg.matmul
+//  CHECK-NOT:   linalg.generic
@@ -0,0 +1,9 @@
+// RUN: iree-opt -iree-codegen-pack-matmul-constant-rhs="panel-size=0" -verify-diagnostics %s
+// RUN: iree-opt -iree-codegen-pack-matmul-constant-rhs="panel-size=-4" -verify-diagnostics %s
+
+// expected-error @+1 {{panel-size must be positive}}
+func @invalid_panel_size(%arg0: tensor<3x2xi32>, %arg1: tensor<3x4xi32>) -> tensor<3x4xi32> {
+  %rhs = constant dense<[[0, 1, 2, 3], [4, 5, 6, 7]]> : tensor<2x4xi32>
+  %0 = linalg.matmul ins(%arg0, %rhs : tensor<3x2xi32>, tensor<2x4xi32>) outs(%arg1 : tensor<3x4xi32>) -> tensor<3x4xi32>
+  return %0 : tensor<3x4xi32>
+}
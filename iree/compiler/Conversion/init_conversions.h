@@ -90,6 +90,7 @@ inline void registerLinalgToLinalgPasses() {
     // LinalgToLinalg
     createConvert1x1ConvToMatmulPass();
     createConvertConv2DToImg2ColPass();
+    createPackMatmulConstantRHSPass();
     return true;
   }();
   (void)init_once;
@@ -58,6 +58,24 @@ static llvm::cl::opt<bool> clEnableConvToImg2Col(
     llvm::cl::desc("Enable converting convolution ops to img2col form."),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clEnablePackMatmulConstantRHS(
+    "iree-flow-enable-pack-matmul-constant-rhs",
+    llvm::cl::desc("Enable packing constant right-hand side operands of "
+                   "linalg matmul ops into panel-major layout."),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<int> clPackMatmulConstantRHSPanelSize(
+    "iree-flow-pack-matmul-constant-rhs-panel-size",
+    llvm::cl::desc("Number of contiguous columns per packed matmul constant "
+                   "right-hand side panel; must be positive."),
+    llvm::cl::init(8));
+
+static llvm::cl::list<int64_t> clDispatchShapeBuckets(
+    "iree-flow-dispatch-shape-buckets",
+    llvm::cl::desc("Comma-separated list of dynamic dimension values to emit "
+                   "specialized dispatches for"),
+    llvm::cl::CommaSeparated);
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -216,6 +234,11 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       passManager.addNestedPass<FuncOp>(
           mlir::iree_compiler::createConvertConv2DToImg2ColPass());
     }
+    if (clEnablePackMatmulConstantRHS) {
+      passManager.addNestedPass<FuncOp>(
+          mlir::iree_compiler::createPackMatmulConstantRHSPass(
+              clPackMatmulConstantRHSPanelSize));
+    }
 
     passManager.addNestedPass<FuncOp>(
         mlir::createConvertElementwiseToLinalgPass());
@@ -234,6 +257,17 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
     // creates a lot of dead IR that needs to be cleaned up.
     passManager.addNestedPass<FuncOp>(mlir::createCanonicalizerPass());
 
+    // Emit static shape variants of dynamic dispatches for the configured
+    // shape buckets. The canonicalizer inlines the now-constant dimensions
+    // into the specialized dispatch regions.
+    if (!clDispatchShapeBuckets.empty()) {
+      SmallVector<int64_t, 4> shapeBuckets(clDispatchShapeBuckets.begin(),
+                                           clDispatchShapeBuckets.end());
+      passManager.addNestedPass<FuncOp>(
+          IREE::Flow::createSpecializeDispatchShapesPass(shapeBuckets));
+      passManager.addNestedPass<FuncOp>(mlir::createCanonicalizerPass());
+    }
+
     // Outline the dispatch regions into their own functions wrapped in
     // executables.
     passManager.addPass(IREE::Flow::createOutlineDispatchRegions2Pass());
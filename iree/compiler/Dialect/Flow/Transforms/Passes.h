@@ -110,6 +110,12 @@ createFoldCompatibleDispatchRegionsPass();
 std::unique_ptr<OperationPass<ModuleOp>> createOutlineDispatchRegionsPass();
 std::unique_ptr<OperationPass<ModuleOp>> createOutlineDispatchRegions2Pass();
 
+// Specializes dispatches with a single dynamic dimension for each of the
+// |shapeBuckets| values and selects between them at runtime with the original
+// dispatch as the fallback.
+std::unique_ptr<OperationPass<FuncOp>> createSpecializeDispatchShapesPass(
+    ArrayRef<int64_t> shapeBuckets = {});
+
 // Injects tracing markers for dispatch operation tensor inputs and outputs.
 std::unique_ptr<OperationPass<FuncOp>> createInjectDispatchTracingPass();
 
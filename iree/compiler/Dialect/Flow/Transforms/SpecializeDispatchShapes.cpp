@@ -0,0 +1,316 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Shape/IR/ShapeTypes.h"
+#include "llvm/ADT/SetVector.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+// Returns the single dynamic index value that all of the dynamic shape
+// dimensions and workgroup counts of |dispatchOp| derive from, or nullptr if
+// there is none or more than one.
+static Value findDynamicDimension(DispatchWorkgroupsOp dispatchOp) {
+  llvm::SetVector<Value> dynamicValues;
+  for (auto value : dispatchOp->getOperands()) {
+    if (!value.getType().isa<IndexType>()) continue;
+    if (matchPattern(value, m_Constant())) continue;
+    dynamicValues.insert(value);
+  }
+  if (dynamicValues.size() != 1) return nullptr;
+  return dynamicValues.front();
+}
+
+// Returns |type| with each dynamic dimension tied to |dynamicDim| replaced by
+// |staticDim|. |dims| are the dynamic dimension values of all shaped values in
+// the list |type| is from and |dimIndex| is advanced past those of |type|. The
+// dimension values that remain dynamic are appended to |remainingDims|.
+static Type specializeTensorType(Type type, ValueRange dims,
+                                 unsigned &dimIndex, Value dynamicDim,
+                                 int64_t staticDim,
+                                 SmallVectorImpl<Value> &remainingDims) {
+  auto tensorType = type.dyn_cast<RankedTensorType>();
+  if (!tensorType) return type;
+  SmallVector<int64_t, 4> shape;
+  for (int64_t dim : tensorType.getShape()) {
+    if (dim == ShapedType::kDynamicSize) {
+      Value dimValue = dims[dimIndex++];
+      if (dimValue == dynamicDim) {
+        dim = staticDim;
+      } else {
+        remainingDims.push_back(dimValue);
+      }
+    }
+    shape.push_back(dim);
+  }
+  return RankedTensorType::get(shape, tensorType.getElementType());
+}
+
+// Updates the users of the dispatch region argument |arg| after its type has
+// been made (more) static. Shape queries take the new type and whole-tensor
+// loads produce the static tensor and cast back to the type their users
+// expect; the canonicalizer folds the casts away as the static shapes
+// propagate through the region.
+static void updateSpecializedArgumentUsers(BlockArgument arg) {
+  auto argType = arg.getType().dyn_cast<DispatchTensorType>();
+  if (!argType) return;
+  for (auto *user : llvm::to_vector<4>(arg.getUsers())) {
+    if (auto shapeOp = dyn_cast<DispatchShapeOp>(user)) {
+      shapeOp.result().setType(
+          Shape::RankedShapeType::get(argType.getShape(), arg.getContext()));
+    } else if (auto loadOp = dyn_cast<DispatchTensorLoadOp>(user)) {
+      if (!loadOp.getMixedSizes().empty()) continue;
+      auto oldType = loadOp.result().getType();
+      auto newType = argType.asTensorType();
+      if (oldType == newType) continue;
+      loadOp.result().setType(newType);
+      OpBuilder builder(loadOp.getContext());
+      builder.setInsertionPointAfter(loadOp);
+      auto castOp = builder.create<tensor::CastOp>(loadOp.getLoc(), oldType,
+                                                   loadOp.result());
+      SmallPtrSet<Operation *, 1> castOpSet = {castOp};
+      loadOp.result().replaceAllUsesExcept(castOp, castOpSet);
+    }
+  }
+}
+
+// Clones |dispatchOp| at |builder| with |dynamicDim| replaced by |staticDim|
+// in the captured operands/dimensions and within the dispatch region. Tensor
+// operands, results, and region arguments whose shapes derive from
+// |dynamicDim| are given static types so that the region can be compiled for
+// static shapes; tensor.cast ops convert between the original dynamic types
+// and the static ones at the dispatch boundary. Returns the results of the
+// specialized dispatch cast back to the original result types.
+static SmallVector<Value, 4> cloneSpecializedDispatch(
+    DispatchWorkgroupsOp dispatchOp, Value dynamicDim, int64_t staticDim,
+    OpBuilder &builder) {
+  auto loc = dispatchOp.getLoc();
+  Value staticDimValue = builder.createOrFold<ConstantIndexOp>(loc, staticDim);
+  auto mapDim = [&](Value value) {
+    return value == dynamicDim ? staticDimValue : value;
+  };
+
+  SmallVector<Value, 4> workgroupCount = llvm::to_vector<4>(
+      llvm::map_range(dispatchOp.workgroup_count(), mapDim));
+
+  SmallVector<Value, 4> operands;
+  SmallVector<Value, 4> operandDims;
+  unsigned operandDimIndex = 0;
+  for (auto operand : dispatchOp.operands()) {
+    Type type =
+        specializeTensorType(operand.getType(), dispatchOp.operand_dims(),
+                             operandDimIndex, dynamicDim, staticDim,
+                             operandDims);
+    if (type != operand.getType()) {
+      operands.push_back(builder.create<tensor::CastOp>(loc, type, operand));
+    } else {
+      operands.push_back(mapDim(operand));
+    }
+  }
+
+  SmallVector<Type, 4> resultTypes;
+  SmallVector<Value, 4> resultDims;
+  unsigned resultDimIndex = 0;
+  for (auto type : dispatchOp.getResultTypes()) {
+    resultTypes.push_back(specializeTensorType(type, dispatchOp.result_dims(),
+                                               resultDimIndex, dynamicDim,
+                                               staticDim, resultDims));
+  }
+
+  // Tied operand indices are absolute and the builder expects them relative to
+  // the operands() range.
+  auto tiedOperandIndices =
+      llvm::to_vector<4>(dispatchOp.getTiedResultOperandIndices());
+  unsigned tiedOperandOffset =
+      dispatchOp.getTiedOperandsIndexAndLength().first;
+  for (auto &tiedOperandIndex : tiedOperandIndices) {
+    if (tiedOperandIndex != TiedOpInterface::kUntiedIndex) {
+      tiedOperandIndex -= tiedOperandOffset;
+    }
+  }
+
+  // The builder creates the entry block with dispatch tensor arguments derived
+  // from the specialized operand and result types.
+  auto specializedOp = builder.create<DispatchWorkgroupsOp>(
+      loc, workgroupCount, resultTypes, resultDims, operands, operandDims,
+      tiedOperandIndices, dispatchOp->getAttrs());
+  Block &sourceBlock = dispatchOp.body().front();
+  Block &targetBlock = specializedOp.body().front();
+  auto regionBuilder = OpBuilder::atBlockBegin(&targetBlock);
+  BlockAndValueMapping mapping;
+  Value regionDimValue;
+  for (auto arg : sourceBlock.getArguments()) {
+    unsigned argIndex = arg.getArgNumber();
+    if (argIndex < dispatchOp.operands().size() &&
+        dispatchOp.operands()[argIndex] == dynamicDim) {
+      if (!regionDimValue) {
+        regionDimValue =
+            regionBuilder.createOrFold<ConstantIndexOp>(loc, staticDim);
+      }
+      mapping.map(arg, regionDimValue);
+    } else {
+      mapping.map(arg, targetBlock.getArgument(argIndex));
+    }
+  }
+  for (auto &op : sourceBlock) {
+    regionBuilder.clone(op, mapping);
+  }
+  for (auto it :
+       llvm::zip(sourceBlock.getArguments(), targetBlock.getArguments())) {
+    if (std::get<0>(it).getType() != std::get<1>(it).getType()) {
+      updateSpecializedArgumentUsers(std::get<1>(it));
+    }
+  }
+
+  // Users after the branch chain expect the original dynamic result types.
+  SmallVector<Value, 4> results;
+  for (auto it :
+       llvm::zip(dispatchOp.getResults(), specializedOp.getResults())) {
+    Value result = std::get<1>(it);
+    if (result.getType() != std::get<0>(it).getType()) {
+      result = builder.create<tensor::CastOp>(loc, std::get<0>(it).getType(),
+                                              result);
+    }
+    results.push_back(result);
+  }
+  return results;
+}
+
+// Replaces |dispatchOp| with a chain of conditional branches that compare its
+// dynamic dimension against each of |shapeBuckets| and run a specialized
+// dispatch when one matches. The original dispatch is kept as the fallback:
+//
+//   %eq0 = cmpi eq, %dim, %c128
+//   cond_br %eq0, ^bucket0, ^next0
+// ^bucket0:
+//   %arg128 = tensor.cast %arg : tensor<?xf32> to tensor<128xf32>
+//   %0 = flow.dispatch.workgroups(%arg128, %c128 ...)
+//   %0_dyn = tensor.cast %0 : tensor<128xf32> to tensor<?xf32>
+//   br ^continue(%0_dyn)
+// ^next0:
+//   ...
+// ^generic:
+//   %1 = flow.dispatch.workgroups(... %dim ...)
+//   br ^continue(%1)
+// ^continue(%result):
+static void specializeDispatch(DispatchWorkgroupsOp dispatchOp,
+                               Value dynamicDim,
+                               ArrayRef<int64_t> shapeBuckets) {
+  auto loc = dispatchOp.getLoc();
+  Block *headBlock = dispatchOp->getBlock();
+  Block *continueBlock = headBlock->splitBlock(dispatchOp->getNextNode());
+  for (auto result : dispatchOp.getResults()) {
+    result.replaceAllUsesWith(continueBlock->addArgument(result.getType()));
+  }
+
+  // The original dispatch moves into the generic fallback block.
+  auto *genericBlock = new Block();
+  genericBlock->insertBefore(continueBlock);
+  dispatchOp->moveBefore(genericBlock, genericBlock->end());
+  OpBuilder::atBlockEnd(genericBlock)
+      .create<BranchOp>(loc, continueBlock, dispatchOp.getResults());
+
+  Block *currentBlock = headBlock;
+  for (int64_t staticDim : shapeBuckets) {
+    auto *bucketBlock = new Block();
+    bucketBlock->insertBefore(genericBlock);
+    auto bucketBuilder = OpBuilder::atBlockEnd(bucketBlock);
+    auto specializedResults = cloneSpecializedDispatch(
+        dispatchOp, dynamicDim, staticDim, bucketBuilder);
+    bucketBuilder.create<BranchOp>(loc, continueBlock, specializedResults);
+
+    // The last bucket falls through to the generic dispatch.
+    Block *nextBlock = genericBlock;
+    if (staticDim != shapeBuckets.back()) {
+      nextBlock = new Block();
+      nextBlock->insertBefore(genericBlock);
+    }
+    auto builder = OpBuilder::atBlockEnd(currentBlock);
+    auto isBucket = builder.create<CmpIOp>(
+        loc, CmpIPredicate::eq, dynamicDim,
+        builder.createOrFold<ConstantIndexOp>(loc, staticDim));
+    builder.create<CondBranchOp>(loc, isBucket, bucketBlock, ValueRange{},
+                                 nextBlock, ValueRange{});
+    currentBlock = nextBlock;
+  }
+}
+
+class SpecializeDispatchShapesPass
+    : public SpecializeDispatchShapesBase<SpecializeDispatchShapesPass> {
+ public:
+  SpecializeDispatchShapesPass() = default;
+  SpecializeDispatchShapesPass(const SpecializeDispatchShapesPass &that) {
+    shapeBuckets = llvm::to_vector<4>(that.shapeBuckets);
+  }
+  explicit SpecializeDispatchShapesPass(ArrayRef<int64_t> shapeBuckets) {
+    this->shapeBuckets = shapeBuckets;
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<StandardOpsDialect, tensor::TensorDialect>();
+  }
+
+  void runOnOperation() override {
+    // Drop duplicate buckets so that the branch chain stays minimal.
+    SmallVector<int64_t, 4> uniqueBuckets;
+    for (int64_t bucket : shapeBuckets) {
+      if (bucket >= 0 && !llvm::is_contained(uniqueBuckets, bucket)) {
+        uniqueBuckets.push_back(bucket);
+      }
+    }
+    if (uniqueBuckets.empty()) return;
+
+    // Only dispatches directly within the function CFG can be branched around.
+    auto funcOp = getOperation();
+    SmallVector<std::pair<DispatchWorkgroupsOp, Value>, 4> worklist;
+    for (auto &block : funcOp.getBlocks()) {
+      for (auto dispatchOp : block.getOps<DispatchWorkgroupsOp>()) {
+        if (auto dynamicDim = findDynamicDimension(dispatchOp)) {
+          worklist.push_back(std::make_pair(dispatchOp, dynamicDim));
+        }
+      }
+    }
+    for (auto it : worklist) {
+      specializeDispatch(it.first, it.second, uniqueBuckets);
+    }
+  }
+
+ private:
+  ListOption<int64_t> shapeBuckets{
+      *this, "buckets",
+      llvm::cl::desc("Comma-separated list of dynamic dimension values to "
+                     "emit specialized dispatches for"),
+      llvm::cl::ZeroOrMore, llvm::cl::MiscFlags::CommaSeparated};
+};
+
+std::unique_ptr<OperationPass<FuncOp>> createSpecializeDispatchShapesPass(
+    ArrayRef<int64_t> shapeBuckets) {
+  return std::make_unique<SpecializeDispatchShapesPass>(shapeBuckets);
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,94 @@
+// RUN: iree-opt -allow-unregistered-dialect -split-input-file -iree-flow-specialize-dispatch-shapes="buckets=128,512" %s | IreeFileCheck %s
+
+// CHECK-LABEL: func @singleDynamicDim
+// CHECK-SAME: (%[[ARG0:.+]]: tensor<?x4xf32>, %[[DIM:.+]]: index)
+func @singleDynamicDim(%arg0 : tensor<?x4xf32>, %dim : index) -> tensor<4x?xf32> {
+  %c1 = constant 1 : index
+  //      CHECK: %[[C128:.+]] = constant 128 : index
+  // CHECK-NEXT: %[[IS128:.+]] = cmpi eq, %[[DIM]], %[[C128]] : index
+  // CHECK-NEXT: cond_br %[[IS128]], ^bb1, ^bb2
+  // CHECK-NEXT: ^bb1:
+  // CHECK-NEXT:   %[[S128:.+]] = constant 128 : index
+  // CHECK-NEXT:   %[[ARG128:.+]] = tensor.cast %[[ARG0]] : tensor<?x4xf32> to tensor<128x4xf32>
+  // CHECK-NEXT:   %[[R128:.+]] = flow.dispatch.workgroups[%[[S128]], %c1](%[[ARG128]], %[[S128]])
+  // CHECK-SAME:       : (tensor<128x4xf32>, index) -> tensor<4x128xf32> =
+  // CHECK-NEXT:   (%[[INNER_ARG128:.+]]: !flow.dispatch.tensor<readonly:128x4xf32>, %{{.+}}: index, %[[INNER_RET128:.+]]: !flow.dispatch.tensor<writeonly:4x128xf32>)
+  // CHECK-NEXT:     %[[INNER128:.+]] = constant 128 : index
+  // CHECK-NEXT:     "test.sink"(%[[INNER_ARG128]], %[[INNER128]], %[[INNER_RET128]])
+  //      CHECK:   %[[R128_DYN:.+]] = tensor.cast %[[R128]] : tensor<4x128xf32> to tensor<4x?xf32>
+  // CHECK-NEXT:   br ^bb5(%[[R128_DYN]] : tensor<4x?xf32>)
+  // CHECK-NEXT: ^bb2:
+  // CHECK-NEXT:   %[[C512:.+]] = constant 512 : index
+  // CHECK-NEXT:   %[[IS512:.+]] = cmpi eq, %[[DIM]], %[[C512]] : index
+  // CHECK-NEXT:   cond_br %[[IS512]], ^bb3, ^bb4
+  // CHECK-NEXT: ^bb3:
+  // CHECK-NEXT:   %[[S512:.+]] = constant 512 : index
+  // CHECK-NEXT:   %[[ARG512:.+]] = tensor.cast %[[ARG0]] : tensor<?x4xf32> to tensor<512x4xf32>
+  // CHECK-NEXT:   %[[R512:.+]] = flow.dispatch.workgroups[%[[S512]], %c1](%[[ARG512]], %[[S512]])
+  // CHECK-SAME:       : (tensor<512x4xf32>, index) -> tensor<4x512xf32> =
+  //      CHECK:   %[[R512_DYN:.+]] = tensor.cast %[[R512]] : tensor<4x512xf32> to tensor<4x?xf32>
+  // CHECK-NEXT:   br ^bb5(%[[R512_DYN]] : tensor<4x?xf32>)
+  // CHECK-NEXT: ^bb4:
+  // CHECK-NEXT:   %[[GENERIC:.+]] = flow.dispatch.workgroups[%[[DIM]], %c1](%[[ARG0]], %[[DIM]])
+  // CHECK-SAME:       : (tensor<?x4xf32>{%[[DIM]]}, index) -> tensor<4x?xf32>{%[[DIM]]} =
+  //      CHECK:   br ^bb5(%[[GENERIC]] : tensor<4x?xf32>)
+  // CHECK-NEXT: ^bb5(%[[RESULT:[a-z0-9]+]]: tensor<4x?xf32>):
+  // CHECK-NEXT:   return %[[RESULT]]
+  %0 = flow.dispatch.workgroups[%dim, %c1](%arg0, %dim) : (tensor<?x4xf32>{%dim}, index) -> tensor<4x?xf32>{%dim} = (
+    %arg: !flow.dispatch.tensor<readonly:?x4xf32>, %arg_dim: index, %ret: !flow.dispatch.tensor<writeonly:4x?xf32>
+  ) {
+    "test.sink"(%arg, %arg_dim, %ret) : (!flow.dispatch.tensor<readonly:?x4xf32>, index, !flow.dispatch.tensor<writeonly:4x?xf32>) -> ()
+    flow.return
+  }
+  return %0 : tensor<4x?xf32>
+}
+
+// -----
+
+// Whole-tensor loads and shape queries in the specialized region see the static
+// bucket shape; the loaded value is cast back for the unchanged region body.
+
+// CHECK-LABEL: func @staticRegionTypes
+// CHECK-SAME: (%[[ARG0:.+]]: tensor<?xf32>, %[[DIM:.+]]: index)
+func @staticRegionTypes(%arg0 : tensor<?xf32>, %dim : index) -> tensor<?xf32> {
+  //      CHECK: ^bb1:
+  //      CHECK:   flow.dispatch.workgroups
+  // CHECK-SAME:       : (tensor<128xf32>, index) -> tensor<128xf32> =
+  // CHECK-NEXT:   (%[[IN:.+]]: !flow.dispatch.tensor<readonly:128xf32>, %{{.+}}: index, %[[OUT:.+]]: !flow.dispatch.tensor<writeonly:128xf32>)
+  //      CHECK:     %[[SHAPE:.+]] = flow.dispatch.shape %[[IN]] : !flow.dispatch.tensor<readonly:128xf32> -> !shapex.ranked_shape<[128]>
+  // CHECK-NEXT:     %[[LOAD:.+]] = flow.dispatch.tensor.load %[[IN]], {{.+}} : !flow.dispatch.tensor<readonly:128xf32> -> tensor<128xf32>
+  // CHECK-NEXT:     %[[LOAD_DYN:.+]] = tensor.cast %[[LOAD]] : tensor<128xf32> to tensor<?xf32>
+  // CHECK-NEXT:     "test.sink"(%[[SHAPE]], %[[LOAD_DYN]])
+  // CHECK-NEXT:     flow.dispatch.tensor.store %[[LOAD_DYN]], %[[OUT]], {{.+}} : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:128xf32>
+  //      CHECK: ^bb4:
+  //      CHECK:   flow.dispatch.workgroups
+  // CHECK-SAME:       : (tensor<?xf32>{%[[DIM]]}, index) -> tensor<?xf32>{%[[DIM]]} =
+  %0 = flow.dispatch.workgroups[%dim](%arg0, %dim) : (tensor<?xf32>{%dim}, index) -> tensor<?xf32>{%dim} = (
+    %arg: !flow.dispatch.tensor<readonly:?xf32>, %arg_dim: index, %ret: !flow.dispatch.tensor<writeonly:?xf32>
+  ) {
+    %shape = flow.dispatch.shape %arg : !flow.dispatch.tensor<readonly:?xf32> -> !shapex.ranked_shape<[?]>
+    %value = flow.dispatch.tensor.load %arg, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:?xf32> -> tensor<?xf32>
+    "test.sink"(%shape, %value) : (!shapex.ranked_shape<[?]>, tensor<?xf32>) -> ()
+    flow.dispatch.tensor.store %value, %ret, offsets=[], sizes=[], strides=[] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:?xf32>
+    flow.return
+  }
+  return %0 : tensor<?xf32>
+}
+
+// -----
+
+// Dispatches with multiple independent dynamic dimensions are not specialized.
+
+// CHECK-LABEL: func @multipleDynamicDims
+func @multipleDynamicDims(%arg0 : tensor<?x?xf32>, %dim0 : index, %dim1 : index) -> tensor<?x?xf32> {
+  // CHECK-NOT: cond_br
+  // CHECK: flow.dispatch.workgroups
+  // CHECK-NOT: cond_br
+  %0 = flow.dispatch.workgroups[%dim0, %dim1](%arg0) : (tensor<?x?xf32>{%dim0, %dim1}) -> tensor<?x?xf32>{%dim1, %dim0} = (
+    %arg: !flow.dispatch.tensor<readonly:?x?xf32>, %ret: !flow.dispatch.tensor<writeonly:?x?xf32>
+  ) {
+    "test.sink"(%arg, %ret) : (!flow.dispatch.tensor<readonly:?x?xf32>, !flow.dispatch.tensor<writeonly:?x?xf32>) -> ()
+    flow.return
+  }
+  return %0 : tensor<?x?xf32>
+}
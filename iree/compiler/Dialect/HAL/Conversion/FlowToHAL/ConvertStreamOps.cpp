@@ -110,6 +110,203 @@ static ValueAliasingMap computeValueAliases(
   return valueAliases;
 }
 
+// Returns the values that alias |value| including |value| itself.
+static SmallVector<Value> getEquivalentValues(
+    Value value, const ValueAliasingMap &valueAliases) {
+  SmallVector<Value> values = {value};
+  auto it = valueAliases.find(value);
+  if (it != valueAliases.end()) {
+    values.append(it->second.begin(), it->second.end());
+  }
+  return values;
+}
+
+//===----------------------------------------------------------------------===//
+// Subrange alias analysis
+//===----------------------------------------------------------------------===//
+
+// Maps values stored within a subrange of another value's buffer to the
+// flow.tensor.slice or flow.tensor.update op defining the subrange. Entries are
+// in stream order.
+using SubrangeAliasMap = llvm::MapVector<Value, Operation *>;
+
+// Returns the value whose buffer a subrange alias defined by |op| points into.
+static Value getSubrangeBaseValue(Operation *op) {
+  if (auto sliceOp = dyn_cast<IREE::Flow::TensorSliceOp>(op)) {
+    return sliceOp.source();
+  }
+  return cast<IREE::Flow::TensorUpdateOp>(op).target();
+}
+
+// Returns the indices into the base value at which the subrange defined by
+// |op| starts.
+static OperandRange getSubrangeStartIndices(Operation *op) {
+  if (auto sliceOp = dyn_cast<IREE::Flow::TensorSliceOp>(op)) {
+    return sliceOp.start_indices();
+  }
+  return cast<IREE::Flow::TensorUpdateOp>(op).start_indices();
+}
+
+// Returns true if a |subrangeType| tensor placed within |baseType| occupies a
+// single contiguous byte range of the base buffer. This is the case when all
+// dimensions inside of the outermost non-unit dimension span the full base
+// dimension.
+static bool isContiguousSubrange(ShapedType subrangeType, ShapedType baseType) {
+  if (!subrangeType.hasRank() || !baseType.hasRank()) return false;
+  int64_t rank = subrangeType.getRank();
+  int64_t i = 0;
+  while (i < rank && subrangeType.getDimSize(i) == 1) ++i;
+  for (++i; i < rank; ++i) {
+    if (subrangeType.isDynamicDim(i) || baseType.isDynamicDim(i) ||
+        subrangeType.getDimSize(i) != baseType.getDimSize(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if a subrange of |baseType| starting at |startIndices| begins at
+// a byte offset that is a constant multiple of |alignment|. Start indices
+// captured by |streamOp| are resolved to the values captured.
+static bool isAlignedSubrangeOffset(IREE::Flow::ExStreamFragmentOp streamOp,
+                                    OperandRange startIndices,
+                                    ShapedType baseType, int64_t alignment) {
+  if (!baseType.hasStaticShape()) return false;
+  auto *streamBlock = &streamOp.body().front();
+  int64_t elementOffset = 0;
+  for (auto startIndex : llvm::enumerate(startIndices)) {
+    Value value = startIndex.value();
+    if (auto blockArg = value.dyn_cast<BlockArgument>()) {
+      if (blockArg.getOwner() != streamBlock) return false;
+      value = streamOp.operands()[blockArg.getArgNumber()];
+    }
+    APInt index;
+    if (!matchPattern(value, m_ConstantInt(&index))) return false;
+    int64_t axisOffset = index.getSExtValue();
+    for (int64_t i = startIndex.index() + 1; i < baseType.getRank(); ++i) {
+      axisOffset *= baseType.getDimSize(i);
+    }
+    elementOffset += axisOffset;
+  }
+  int64_t byteOffset =
+      elementOffset *
+      IREE::HAL::getRoundedElementByteWidth(baseType.getElementType());
+  return byteOffset % alignment == 0;
+}
+
+// Finds slices and updates that can be performed by placing one value within
+// the buffer of another instead of recording a copy:
+//
+// * flow.tensor.slice results become views into their source buffer when
+//   neither the source nor the result is written to after the slice.
+// * flow.tensor.update operands produced by a dispatch are written by that
+//   dispatch directly into the target buffer when nothing touches the target
+//   between the dispatch and the update.
+//
+// Only contiguous ranges are handled as the buffers are bound by offset and
+// length. The ranges must also start at a constant byte offset that is a
+// multiple of |minBufferOffsetAlignment| as the subspans are bound to
+// dispatches the same way as the transient slices hal.allocator.pack aligns to
+// it; unaligned ranges keep their copy.
+//
+// NOTE: this only removes copies within a single stream. Sharing transient
+// storage across the streams of a function needs a function-level planner.
+static SubrangeAliasMap computeSubrangeAliases(
+    IREE::Flow::ExStreamFragmentOp streamOp,
+    const ValueAliasingMap &valueAliases, int64_t minBufferOffsetAlignment) {
+  auto *streamBlock = &streamOp.body().front();
+  DenseMap<Operation *, int> opOrdering;
+  for (auto &op : *streamBlock) {
+    opOrdering[&op] = opOrdering.size();
+  }
+  auto returnOp = cast<IREE::Flow::ReturnOp>(streamBlock->back());
+  SmallPtrSet<Value, 16> returnedValues;
+  returnedValues.insert(returnOp.operand_begin(), returnOp.operand_end());
+
+  // Returns true if any value equivalent to |value| has its storage written
+  // by an op ordered after |ordinal|. Reshapes only change metadata.
+  auto isWrittenAfter = [&](Value value, int ordinal) {
+    for (auto alias : getEquivalentValues(value, valueAliases)) {
+      auto *definingOp = alias.getDefiningOp();
+      if (!definingOp || definingOp->getBlock() != streamBlock) continue;
+      if (isa<IREE::Flow::TensorReshapeOp>(definingOp)) continue;
+      if (opOrdering[definingOp] > ordinal) return true;
+    }
+    return false;
+  };
+
+  SubrangeAliasMap subrangeAliases;
+  for (auto &op : *streamBlock) {
+    if (auto sliceOp = dyn_cast<IREE::Flow::TensorSliceOp>(op)) {
+      auto source = sliceOp.source();
+      auto result = sliceOp.result();
+      if (!isContiguousSubrange(result.getType().cast<ShapedType>(),
+                                source.getType().cast<ShapedType>()) ||
+          !isAlignedSubrangeOffset(streamOp, sliceOp.start_indices(),
+                                   source.getType().cast<ShapedType>(),
+                                   minBufferOffsetAlignment)) {
+        continue;
+      }
+      // Escaping results get their own output buffers.
+      auto resultValues = getEquivalentValues(result, valueAliases);
+      if (llvm::any_of(resultValues,
+                       [&](Value v) { return returnedValues.contains(v); })) {
+        continue;
+      }
+      int ordinal = opOrdering[&op];
+      if (isWrittenAfter(source, ordinal) ||
+          isWrittenAfter(result, ordinal)) {
+        continue;
+      }
+      subrangeAliases.insert(std::make_pair(result, &op));
+    } else if (auto updateOp = dyn_cast<IREE::Flow::TensorUpdateOp>(op)) {
+      auto update = updateOp.update();
+      auto target = updateOp.target();
+      auto *producerOp = update.getDefiningOp();
+      if (!producerOp || !isa<IREE::Flow::DispatchOp>(producerOp)) continue;
+      if (!update.hasOneUse() || valueAliases.count(update)) continue;
+      if (!isContiguousSubrange(update.getType().cast<ShapedType>(),
+                                target.getType().cast<ShapedType>()) ||
+          !isAlignedSubrangeOffset(streamOp, updateOp.start_indices(),
+                                   target.getType().cast<ShapedType>(),
+                                   minBufferOffsetAlignment)) {
+        continue;
+      }
+
+      // The target buffer (and the start indices used to compute the offset
+      // into it) must be available when the producer is recorded.
+      int producerOrdinal = opOrdering[producerOp];
+      auto isDefinedBeforeProducer = [&](Value value) {
+        auto *definingOp = value.getDefiningOp();
+        if (!definingOp || definingOp->getBlock() != streamBlock) return true;
+        return opOrdering[definingOp] < producerOrdinal;
+      };
+      if (!isDefinedBeforeProducer(target) ||
+          !llvm::all_of(updateOp.start_indices(), isDefinedBeforeProducer)) {
+        continue;
+      }
+
+      // Nothing may read or write the target from the producer up to the
+      // update as the target contents are clobbered by the producer.
+      auto targetValues = getEquivalentValues(target, valueAliases);
+      auto isTargetValue = [&](Value value) {
+        return llvm::is_contained(targetValues, value);
+      };
+      bool targetUsed = false;
+      for (auto *it = producerOp; it != &op; it = it->getNextNode()) {
+        if (llvm::any_of(it->getOperands(), isTargetValue) ||
+            llvm::any_of(it->getResults(), isTargetValue)) {
+          targetUsed = true;
+          break;
+        }
+      }
+      if (targetUsed) continue;
+      subrangeAliases.insert(std::make_pair(update, &op));
+    }
+  }
+  return subrangeAliases;
+}
+
 //===----------------------------------------------------------------------===//
 // Liveness interval analysis
 //===----------------------------------------------------------------------===//
@@ -137,10 +334,12 @@ using LivenessIntervalList = SmallVector<LivenessInterval>;
 // All values will have a range with aliased values sharing the union of their
 // constituent ranges - including block arguments. Note that not all values will
 // have buffers allocated to them - we are just tracking transitive SSA value
-// lifetime.
+// lifetime. Values that are subrange aliases of another value extend the
+// lifetime of the value whose buffer they are stored in.
 static LivenessIntervalList computeLivenessIntervals(
     IREE::Flow::ExStreamFragmentOp streamOp,
-    const ValueAliasingMap &valueAliases) {
+    const ValueAliasingMap &valueAliases,
+    const SubrangeAliasMap &subrangeAliases) {
   // Perform a liveness analysis on the stream fragment.
   // Fragments have a single block and as such the live-in/live-out block
   // information derived here applies to the entire stream region.
@@ -225,6 +424,18 @@ static LivenessIntervalList computeLivenessIntervals(
     }
   }
 
+  // Keep base values live for as long as any subrange stored within them.
+  // Walking in reverse stream order lets chained subranges (slices of slices)
+  // propagate their lifetime all the way to the root value.
+  for (auto it : llvm::reverse(subrangeAliases)) {
+    int end = valueIntervals[it.first].end;
+    auto baseValue = getSubrangeBaseValue(it.second);
+    for (auto alias : getEquivalentValues(baseValue, valueAliases)) {
+      auto &aliasInterval = valueIntervals[alias];
+      aliasInterval.end = std::max(aliasInterval.end, end);
+    }
+  }
+
   // Sort all intervals by lifetime start. This makes the intervals easier to
   // read and deterministic across runs.
   SmallVector<LivenessInterval> sortedIntervals;
@@ -261,11 +472,13 @@ struct BufferRange {
 class StreamSchedulingState {
  public:
   explicit StreamSchedulingState(Location loc, Value device, Value allocator,
-                                 ValueAliasingMap &valueAliases)
+                                 ValueAliasingMap &valueAliases,
+                                 SubrangeAliasMap &subrangeAliases)
       : loc(loc),
         device_(device),
         allocator_(allocator),
-        valueAliases(valueAliases) {}
+        valueAliases(valueAliases),
+        subrangeAliases(subrangeAliases) {}
 
   Value device() { return device_; }
   Value allocator() { return allocator_; }
@@ -367,8 +580,8 @@ class StreamSchedulingState {
     assert(!bufferRangeMap.count(tensorValue));
     bufferRangeMap.insert(std::make_pair(tensorValue, bufferRange));
 
-    // TODO(#5410): make alias propagation map through an indexing map for
-    // slices/updates. Right now we assume all aliases are 1:1 full maps.
+    // Slices/updates are not part of the alias map and are instead mapped to
+    // subspans of their base buffer by mapSubrangeAlias.
     for (auto alias : valueAliases[tensorValue]) {
       bufferRangeMap.insert(std::make_pair(alias, bufferRange));
     }
@@ -386,6 +599,12 @@ class StreamSchedulingState {
     return bufferRangeMap.count(tensorValue) != 0;
   }
 
+  // Returns the slice/update op if |tensorValue| is stored within a subrange
+  // of another value's buffer.
+  Operation *lookupSubrangeAliasOp(Value tensorValue) {
+    return subrangeAliases.lookup(tensorValue);
+  }
+
   // Calls |callback| for |tensorValue| and each value aliasing it.
   void forEachEquivalentTensorValue(Value tensorValue,
                                     std::function<void(Value)> callback) {
@@ -419,6 +638,10 @@ class StreamSchedulingState {
   // as equivalent: some values may be subranges of others.
   ValueAliasingMap valueAliases;
 
+  // Values stored within a subrange of another value's buffer mapped to the
+  // slice/update op defining the subrange.
+  SubrangeAliasMap subrangeAliases;
+
   // Index value -> std.constant index value.
   DenseMap<int64_t, Value> indexConstantMap;
 
@@ -543,9 +766,8 @@ static void allocateTransientBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
                                      LivenessIntervalList &livenessIntervals,
                                      StreamSchedulingState &schedulingState,
                                      ConversionPatternRewriter &rewriter) {
-  // TODO(#5410): unify with slice/update handling below. We should have a
-  // more generic way of handling these special ops and need to be able to hook
-  // into ones that directly control aliasing behavior like slice/update.
+  // TODO(#5410): unify with the subrange alias handling below. We should have
+  // a more generic way of handling these special ops.
   SmallPtrSet<Value, 16> coveredValues;
   streamOp.walk([&](IREE::HAL::ConstantSubspanOp subspanOp) {
     auto tensorValue = subspanOp.result();
@@ -565,6 +787,16 @@ static void allocateTransientBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
         tensorValue, [&](Value alias) { coveredValues.insert(alias); });
   });
 
+  // Subrange aliases are stored within the buffer of their base value and are
+  // mapped as the commands are recorded.
+  streamOp.walk([&](Operation *op) {
+    for (auto result : op->getResults()) {
+      if (!schedulingState.lookupSubrangeAliasOp(result)) continue;
+      schedulingState.forEachEquivalentTensorValue(
+          result, [&](Value alias) { coveredValues.insert(alias); });
+    }
+  });
+
   // Gather all of the transient values we need to allocate buffers for.
   SmallVector<Value> transientValues;
   SmallVector<int64_t> lifetimeIntervals;
@@ -847,7 +1079,11 @@ static LogicalResult recordDispatch(Value device, Value commandBuffer,
   for (auto dim : dispatchOp.workgroup_count()) {
     dispatchState.workgroupCount.push_back(rewriter.getRemappedValue(dim));
   }
-  // TODO(benvanik): support extended push constants.
+  // Dispatch operands are pushed starting at offset 0 and backends declare any
+  // push constants of their own in the interface during extractInterface.
+  // Constants past the 64 stored inline by local HAL command buffers are pushed
+  // the same way: the runtime keeps them in one contiguous range so no spilling
+  // or base offset is needed here.
   dispatchState.basePushConstantOffset = 0;
 
   // Ask each target backend to record their dispatch logic.
@@ -923,11 +1159,15 @@ static LogicalResult recordTensorClone(Value device, Value commandBuffer,
   return success();
 }
 
-// TODO(#5410): make this an aliasing operation in allocateTransientBuffers.
 static LogicalResult recordTensorSlice(Value device, Value commandBuffer,
                                        IREE::Flow::TensorSliceOp &sliceOp,
                                        StreamSchedulingState &schedulingState,
                                        ConversionPatternRewriter &rewriter) {
+  // Aliased slices are views into the source buffer and need no copy.
+  if (schedulingState.lookupSubrangeAliasOp(sliceOp.result())) {
+    return success();
+  }
+
   auto sourceBuffer = schedulingState.lookupTensorBufferRange(sliceOp.source());
   auto resultBuffer = schedulingState.lookupTensorBufferRange(sliceOp.result());
 
@@ -964,11 +1204,15 @@ static LogicalResult recordTensorSlice(Value device, Value commandBuffer,
   return success();
 }
 
-// TODO(#5410): make this an aliasing operation in allocateTransientBuffers.
 static LogicalResult recordTensorUpdate(Value device, Value commandBuffer,
                                         IREE::Flow::TensorUpdateOp &updateOp,
                                         StreamSchedulingState &schedulingState,
                                         ConversionPatternRewriter &rewriter) {
+  // Aliased updates were produced directly into the target buffer.
+  if (schedulingState.lookupSubrangeAliasOp(updateOp.update())) {
+    return success();
+  }
+
   auto updateBuffer =
       schedulingState.lookupTensorBufferRange(updateOp.update());
   auto targetBuffer =
@@ -1008,11 +1252,55 @@ static LogicalResult recordTensorUpdate(Value device, Value commandBuffer,
   return success();
 }
 
+// Maps the subrange alias |tensorValue| to the range of its base buffer
+// defined by |aliasOp|. Must be called before any command using |tensorValue|
+// is recorded.
+static LogicalResult mapSubrangeAlias(Value tensorValue, Operation *aliasOp,
+                                      StreamSchedulingState &schedulingState,
+                                      ConversionPatternRewriter &rewriter) {
+  auto loc = aliasOp->getLoc();
+  auto baseValue = getSubrangeBaseValue(aliasOp);
+  auto baseBuffer = schedulingState.lookupTensorBufferRange(baseValue);
+  auto base = IREE::HAL::TensorRewriteAdaptor::getChecked(
+      loc, baseValue, baseBuffer.buffer, rewriter);
+  if (!base.hasValue()) {
+    return aliasOp->emitOpError()
+           << "cannot create adaptor for subrange base value";
+  }
+
+  auto startIndices = llvm::to_vector<4>(
+      llvm::map_range(getSubrangeStartIndices(aliasOp), [&](Value value) {
+        return rewriter.getRemappedValue(value);
+      }));
+  auto shapeDims = IREE::HAL::getShapeDims(loc, tensorValue, rewriter);
+  if (!shapeDims) return failure();
+  auto range = base->computeRange(startIndices, *shapeDims);
+  if (!range) return failure();
+
+  auto subspanValue = rewriter.createOrFold<IREE::HAL::BufferSubspanOp>(
+      loc, baseBuffer.buffer.getType(), baseBuffer.buffer, range->offset,
+      range->length);
+  schedulingState.mapTensorToBufferRange(
+      tensorValue, BufferRange{subspanValue, range->length});
+  return success();
+}
+
 static LogicalResult recordStreamCommands(
     Value device, Value commandBuffer, Block &streamBlock,
     StreamSchedulingState &schedulingState,
     ConversionPatternRewriter &rewriter) {
   for (auto &op : streamBlock) {
+    // Place subrange aliases within their base buffer prior to the commands
+    // producing them.
+    for (auto result : op.getResults()) {
+      auto *aliasOp = schedulingState.lookupSubrangeAliasOp(result);
+      if (!aliasOp) continue;
+      if (failed(mapSubrangeAlias(result, aliasOp, schedulingState,
+                                  rewriter))) {
+        return failure();
+      }
+    }
+
     if (auto dispatchOp = dyn_cast<IREE::Flow::DispatchOp>(op)) {
       if (failed(recordDispatch(device, commandBuffer, dispatchOp,
                                 schedulingState, rewriter))) {
@@ -1049,6 +1337,35 @@ static LogicalResult recordStreamCommands(
   return success();
 }
 
+// Returns the minimum buffer offset alignment required by the target backends
+// of all executables in the module containing |op|. This is the same
+// conservative constraint hal.allocator.pack aligns transient slices to.
+static int64_t queryMinBufferOffsetAlignment(Operation *op) {
+  auto *context = op->getContext();
+  IREE::HAL::BufferConstraintsAttr bufferConstraints;
+  if (auto moduleOp = op->getParentOfType<ModuleOp>()) {
+    for (auto executableOp : moduleOp.getOps<IREE::HAL::ExecutableOp>()) {
+      for (auto targetOp :
+           executableOp.getBlock().getOps<IREE::HAL::ExecutableTargetOp>()) {
+        for (auto &targetBackend : IREE::HAL::matchTargetBackends(
+                 {targetOp.target_backend_filter().str()})) {
+          auto targetConstraints =
+              targetBackend->queryBufferConstraints(context);
+          bufferConstraints =
+              bufferConstraints ? IREE::HAL::intersectBufferConstraints(
+                                      bufferConstraints, targetConstraints)
+                                : targetConstraints;
+        }
+      }
+    }
+  }
+  if (!bufferConstraints) {
+    bufferConstraints =
+        IREE::HAL::TargetBackend::makeDefaultBufferConstraints(context);
+  }
+  return bufferConstraints.min_buffer_offset_alignment().getSExtValue();
+}
+
 class ExStreamFragmentOpConversion
     : public OpConversionPattern<IREE::Flow::ExStreamFragmentOp> {
  public:
@@ -1061,7 +1378,10 @@ class ExStreamFragmentOpConversion
         newOperands, streamOp->getAttrDictionary());
 
     auto valueAliases = computeValueAliases(streamOp);
-    auto livenessIntervals = computeLivenessIntervals(streamOp, valueAliases);
+    auto subrangeAliases = computeSubrangeAliases(
+        streamOp, valueAliases, queryMinBufferOffsetAlignment(streamOp));
+    auto livenessIntervals =
+        computeLivenessIntervals(streamOp, valueAliases, subrangeAliases);
 
     auto device =
         rewriter.createOrFold<IREE::HAL::ExSharedDeviceOp>(streamOp.getLoc());
@@ -1069,7 +1389,7 @@ class ExStreamFragmentOpConversion
         rewriter.create<IREE::HAL::DeviceAllocatorOp>(streamOp.getLoc(), device)
             .getResult();
     StreamSchedulingState schedulingState(streamOp.getLoc(), device, allocator,
-                                          valueAliases);
+                                          valueAliases, subrangeAliases);
 
     // Map stream captures to their external buffers or SSA values.
     // This covers all of the live-in stream values.
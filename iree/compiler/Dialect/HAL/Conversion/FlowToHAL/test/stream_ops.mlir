@@ -238,6 +238,422 @@ func @tensorUpdate(%arg0 : tensor<1x1x10xf32>, %arg1 : tensor<5x1x10xf32>) -> te
 
 // -----
 
+hal.executable @ex_slice {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<3x24x48xf32>) -> tensor<3x24x48xf32>
+    }
+    module {}
+  }
+}
+
+// Slices of values not written after the slice are views into the source.
+
+// CHECK-LABEL: @tensorSliceAliasing
+// CHECK-SAME: (%[[SBUF:.+]]:{{.+}})
+func @tensorSliceAliasing(%arg0 : tensor<5x24x48xf32>) -> tensor<3x24x48xf32> {
+  %c0 = constant 0 : index
+  %c2 = constant 2 : index
+  %c3 = constant 3 : index
+  %c24 = constant 24 : index
+  %c48 = constant 48 : index
+  // CHECK: %[[RET_BUF:.+]] = hal.allocator.allocate
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  // CHECK-NOT: hal.command_buffer.copy_buffer
+  %2 = flow.ex.stream.fragment(%arg0, %c0, %c2, %c3, %c24, %c48)
+      : (tensor<5x24x48xf32>, index, index, index, index, index) -> tensor<3x24x48xf32> =
+      (%arg2 : tensor<5x24x48xf32>, %arg3 : index, %arg4 : index, %arg5 : index,
+       %arg6 : index, %arg7 : index) -> tensor<3x24x48xf32> {
+     %slice = flow.tensor.slice %arg2[%arg4, %arg3, %arg3 for %arg5, %arg6, %arg7]
+         : tensor<5x24x48xf32> -> tensor<3x24x48xf32>
+     //      CHECK: hal.command_buffer.push_descriptor_set
+     // CHECK-SAME:   bindings([
+     // CHECK-NEXT:     %c0 = (%[[SBUF]] : !hal.buffer)[%c9216, %c13824],
+     // CHECK-NEXT:     %c1 = (%[[RET_BUF]] : !hal.buffer)[%c0, %c13824]
+     //      CHECK: hal.command_buffer.dispatch.symbol
+     %0 = flow.dispatch @ex_slice::@entry0[%arg5](%slice) : (tensor<3x24x48xf32>) -> tensor<3x24x48xf32>
+     flow.return %0 : tensor<3x24x48xf32>
+  }
+  // CHECK-NOT: hal.command_buffer.copy_buffer
+  // CHECK: hal.command_buffer.end<%[[CMD]]
+  return %2 : tensor<3x24x48xf32>
+}
+
+// -----
+
+hal.executable @ex_update {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<1x1x10xf32>) -> tensor<1x1x10xf32>
+    }
+    module {}
+  }
+}
+
+// Updates produced by a dispatch are written directly into the target.
+
+// CHECK-LABEL: @tensorUpdateInPlace
+// CHECK-SAME: (%[[UBUF:.+]]:{{.+}}, %[[TBUF:.+]]:{{.+}})
+func @tensorUpdateInPlace(%arg0 : tensor<1x1x10xf32>, %arg1 : tensor<5x1x10xf32>) -> tensor<5x1x10xf32> {
+  %c4 = constant 4 : index
+  %c0 = constant 0 : index
+  // CHECK: %[[RET_BUF:.+]] = hal.allocator.allocate
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  %0 = flow.ex.stream.fragment(%arg0, %arg1, %c4, %c0) : (tensor<1x1x10xf32>, tensor<5x1x10xf32>, index, index) -> tensor<5x1x10xf32> =
+      (%arg2: tensor<1x1x10xf32>, %arg3: tensor<5x1x10xf32>, %arg4: index, %arg5: index) -> tensor<5x1x10xf32> {
+    // CHECK: hal.command_buffer.copy_buffer
+    // CHECK-SAME:   source(%[[TBUF]] : !hal.buffer)[%c0]
+    // CHECK-SAME:   target(%[[RET_BUF]] : !hal.buffer)[%c0]
+    %clone = flow.tensor.clone %arg3 : tensor<5x1x10xf32>
+    //      CHECK: hal.command_buffer.push_descriptor_set
+    // CHECK-SAME:   bindings([
+    // CHECK-NEXT:     %c0 = (%[[UBUF]] : !hal.buffer)[%c0, %c40],
+    // CHECK-NEXT:     %c1 = (%[[RET_BUF]] : !hal.buffer)[%c160, %c40]
+    //      CHECK: hal.command_buffer.dispatch.symbol
+    %1 = flow.dispatch @ex_update::@entry0[%arg4](%arg2) : (tensor<1x1x10xf32>) -> tensor<1x1x10xf32>
+    // CHECK-NOT: hal.command_buffer.copy_buffer
+    %2 = flow.tensor.update %1, %clone[%arg4, %arg5, %arg5] : tensor<1x1x10xf32> -> tensor<5x1x10xf32>
+    flow.return %2 : tensor<5x1x10xf32>
+  }
+  // CHECK: hal.command_buffer.end<%[[CMD]]
+  // CHECK: return %[[RET_BUF]]
+  return %0 : tensor<5x1x10xf32>
+}
+
+// -----
+
+hal.executable @ex_slice {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<3x12x48xf32>) -> tensor<3x12x48xf32>
+    }
+    module {}
+  }
+}
+
+// Slices that do not cover a contiguous range of their source are copied.
+
+// CHECK-LABEL: @tensorSliceNonContiguous
+// CHECK-SAME: (%[[SBUF:.+]]:{{.+}})
+func @tensorSliceNonContiguous(%arg0 : tensor<5x24x48xf32>) -> tensor<3x12x48xf32> {
+  %c0 = constant 0 : index
+  %c2 = constant 2 : index
+  %c3 = constant 3 : index
+  %c12 = constant 12 : index
+  %c48 = constant 48 : index
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  %2 = flow.ex.stream.fragment(%arg0, %c0, %c2, %c3, %c12, %c48)
+      : (tensor<5x24x48xf32>, index, index, index, index, index) -> tensor<3x12x48xf32> =
+      (%arg2 : tensor<5x24x48xf32>, %arg3 : index, %arg4 : index, %arg5 : index,
+       %arg6 : index, %arg7 : index) -> tensor<3x12x48xf32> {
+     //      CHECK: hal.command_buffer.copy_buffer<%[[CMD]]
+     // CHECK-SAME:   source(%[[SBUF]] : !hal.buffer)[%c9216]
+     // CHECK-SAME:   target(%[[SLICE_BUF:.+]] : !hal.buffer)[%c0]
+     %slice = flow.tensor.slice %arg2[%arg4, %arg3, %arg3 for %arg5, %arg6, %arg7]
+         : tensor<5x24x48xf32> -> tensor<3x12x48xf32>
+     //      CHECK: hal.command_buffer.push_descriptor_set
+     // CHECK-SAME:   bindings([
+     // CHECK-NEXT:     %c0 = (%[[SLICE_BUF]] : !hal.buffer)
+     //      CHECK: hal.command_buffer.dispatch.symbol
+     %0 = flow.dispatch @ex_slice::@entry0[%arg5](%slice) : (tensor<3x12x48xf32>) -> tensor<3x12x48xf32>
+     flow.return %0 : tensor<3x12x48xf32>
+  }
+  return %2 : tensor<3x12x48xf32>
+}
+
+// -----
+
+hal.executable @ex_slice {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<3x5xf32>) -> tensor<3x5xf32>
+    }
+    module {}
+  }
+}
+
+// Slices starting at a byte offset that is not a multiple of the minimum buffer
+// offset alignment (16 bytes by default) are copied: row 1 starts at byte 20.
+
+// CHECK-LABEL: @tensorSliceUnaligned
+// CHECK-SAME: (%[[SBUF:.+]]:{{.+}})
+func @tensorSliceUnaligned(%arg0 : tensor<4x5xf32>) -> tensor<3x5xf32> {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c3 = constant 3 : index
+  %c5 = constant 5 : index
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  %2 = flow.ex.stream.fragment(%arg0, %c0, %c1, %c3, %c5)
+      : (tensor<4x5xf32>, index, index, index, index) -> tensor<3x5xf32> =
+      (%arg2 : tensor<4x5xf32>, %arg3 : index, %arg4 : index, %arg5 : index,
+       %arg6 : index) -> tensor<3x5xf32> {
+     //      CHECK: hal.command_buffer.copy_buffer<%[[CMD]]
+     // CHECK-SAME:   source(%[[SBUF]] : !hal.buffer)[%c20]
+     // CHECK-SAME:   target(%[[SLICE_BUF:.+]] : !hal.buffer)[%c0]
+     %slice = flow.tensor.slice %arg2[%arg4, %arg3 for %arg5, %arg6]
+         : tensor<4x5xf32> -> tensor<3x5xf32>
+     //      CHECK: hal.command_buffer.push_descriptor_set
+     // CHECK-SAME:   bindings([
+     // CHECK-NEXT:     %c0 = (%[[SLICE_BUF]] : !hal.buffer)
+     //      CHECK: hal.command_buffer.dispatch.symbol
+     %0 = flow.dispatch @ex_slice::@entry0[%arg5](%slice) : (tensor<3x5xf32>) -> tensor<3x5xf32>
+     flow.return %0 : tensor<3x5xf32>
+  }
+  return %2 : tensor<3x5xf32>
+}
+
+// -----
+
+hal.executable @ex_slice {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<3x4xf32>) -> tensor<3x4xf32>
+    }
+    module {}
+  }
+}
+
+// Slices starting at an aligned byte offset are views: row 1 starts at byte 16.
+
+// CHECK-LABEL: @tensorSliceAligned
+// CHECK-SAME: (%[[SBUF:.+]]:{{.+}})
+func @tensorSliceAligned(%arg0 : tensor<4x4xf32>) -> tensor<3x4xf32> {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c3 = constant 3 : index
+  %c4 = constant 4 : index
+  // CHECK: %[[RET_BUF:.+]] = hal.allocator.allocate
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  // CHECK-NOT: hal.command_buffer.copy_buffer
+  %2 = flow.ex.stream.fragment(%arg0, %c0, %c1, %c3, %c4)
+      : (tensor<4x4xf32>, index, index, index, index) -> tensor<3x4xf32> =
+      (%arg2 : tensor<4x4xf32>, %arg3 : index, %arg4 : index, %arg5 : index,
+       %arg6 : index) -> tensor<3x4xf32> {
+     %slice = flow.tensor.slice %arg2[%arg4, %arg3 for %arg5, %arg6]
+         : tensor<4x4xf32> -> tensor<3x4xf32>
+     //      CHECK: hal.command_buffer.push_descriptor_set
+     // CHECK-SAME:   bindings([
+     // CHECK-NEXT:     %c0 = (%[[SBUF]] : !hal.buffer)[%c16, %c48],
+     // CHECK-NEXT:     %c1 = (%[[RET_BUF]] : !hal.buffer)[%c0, %c48]
+     //      CHECK: hal.command_buffer.dispatch.symbol
+     %0 = flow.dispatch @ex_slice::@entry0[%arg5](%slice) : (tensor<3x4xf32>) -> tensor<3x4xf32>
+     flow.return %0 : tensor<3x4xf32>
+  }
+  // CHECK-NOT: hal.command_buffer.copy_buffer
+  // CHECK: hal.command_buffer.end<%[[CMD]]
+  return %2 : tensor<3x4xf32>
+}
+
+// -----
+
+hal.executable @ex_slice {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<3x24x48xf32>) -> tensor<3x24x48xf32>
+    }
+    module {}
+  }
+}
+
+// Slices returned from the stream get their own output buffer.
+
+// CHECK-LABEL: @tensorSliceEscaping
+// CHECK-SAME: (%[[SBUF:.+]]:{{.+}})
+func @tensorSliceEscaping(%arg0 : tensor<5x24x48xf32>) -> (tensor<3x24x48xf32>, tensor<3x24x48xf32>) {
+  %c0 = constant 0 : index
+  %c2 = constant 2 : index
+  %c3 = constant 3 : index
+  %c24 = constant 24 : index
+  %c48 = constant 48 : index
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  %2:2 = flow.ex.stream.fragment(%arg0, %c0, %c2, %c3, %c24, %c48)
+      : (tensor<5x24x48xf32>, index, index, index, index, index) -> (tensor<3x24x48xf32>, tensor<3x24x48xf32>) =
+      (%arg2 : tensor<5x24x48xf32>, %arg3 : index, %arg4 : index, %arg5 : index,
+       %arg6 : index, %arg7 : index) -> (tensor<3x24x48xf32>, tensor<3x24x48xf32>) {
+     //      CHECK: hal.command_buffer.copy_buffer<%[[CMD]]
+     // CHECK-SAME:   source(%[[SBUF]] : !hal.buffer)[%c9216]
+     // CHECK-SAME:   target(%[[SLICE_BUF:.+]] : !hal.buffer)[%c0]
+     // CHECK-SAME:   length(%c13824)
+     %slice = flow.tensor.slice %arg2[%arg4, %arg3, %arg3 for %arg5, %arg6, %arg7]
+         : tensor<5x24x48xf32> -> tensor<3x24x48xf32>
+     //      CHECK: hal.command_buffer.push_descriptor_set
+     // CHECK-SAME:   bindings([
+     // CHECK-NEXT:     %c0 = (%[[SLICE_BUF]] : !hal.buffer)[%c0, %c13824],
+     %0 = flow.dispatch @ex_slice::@entry0[%arg5](%slice) : (tensor<3x24x48xf32>) -> tensor<3x24x48xf32>
+     flow.return %slice, %0 : tensor<3x24x48xf32>, tensor<3x24x48xf32>
+  }
+  // CHECK: return %[[SLICE_BUF]]
+  return %2#0, %2#1 : tensor<3x24x48xf32>, tensor<3x24x48xf32>
+}
+
+// -----
+
+hal.executable @ex_slice {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (!flow.dispatch.tensor<readwrite:3x24x48xf32>) -> ()
+    }
+    module {}
+  }
+}
+hal.executable @ex_read {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<3x24x48xf32>) -> tensor<3x24x48xf32>
+    }
+    module {}
+  }
+}
+
+// Slices written in place after the slice must not clobber their source.
+
+// CHECK-LABEL: @tensorSliceWrittenAfter
+// CHECK-SAME: (%[[SBUF:.+]]:{{.+}})
+func @tensorSliceWrittenAfter(%arg0 : tensor<5x24x48xf32>) -> tensor<3x24x48xf32> {
+  %c0 = constant 0 : index
+  %c2 = constant 2 : index
+  %c3 = constant 3 : index
+  %c24 = constant 24 : index
+  %c48 = constant 48 : index
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  %2 = flow.ex.stream.fragment(%arg0, %c0, %c2, %c3, %c24, %c48)
+      : (tensor<5x24x48xf32>, index, index, index, index, index) -> tensor<3x24x48xf32> =
+      (%arg2 : tensor<5x24x48xf32>, %arg3 : index, %arg4 : index, %arg5 : index,
+       %arg6 : index, %arg7 : index) -> tensor<3x24x48xf32> {
+     //      CHECK: hal.command_buffer.copy_buffer<%[[CMD]]
+     // CHECK-SAME:   source(%[[SBUF]] : !hal.buffer)[%c9216]
+     // CHECK-SAME:   target(%[[SLICE_BUF:.+]] : !hal.buffer)[%c0]
+     // CHECK-SAME:   length(%c13824)
+     %slice = flow.tensor.slice %arg2[%arg4, %arg3, %arg3 for %arg5, %arg6, %arg7]
+         : tensor<5x24x48xf32> -> tensor<3x24x48xf32>
+     //      CHECK: hal.command_buffer.push_descriptor_set
+     // CHECK-SAME:   bindings([
+     // CHECK-NEXT:     %c0 = (%[[SLICE_BUF]] : !hal.buffer)
+     //      CHECK: hal.command_buffer.dispatch.symbol
+     %0 = flow.dispatch @ex_slice::@entry0[%arg5](%slice) : (tensor<3x24x48xf32>) -> %slice
+     %1 = flow.dispatch @ex_read::@entry0[%arg5](%0) : (tensor<3x24x48xf32>) -> tensor<3x24x48xf32>
+     flow.return %1 : tensor<3x24x48xf32>
+  }
+  return %2 : tensor<3x24x48xf32>
+}
+
+// -----
+
+hal.executable @ex_update {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<1x1x10xf32>) -> tensor<1x1x10xf32>
+    }
+    module {}
+  }
+}
+hal.executable @ex_read {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : index,
+      signature = (tensor<5x1x10xf32>) -> tensor<5x1x10xf32>
+    }
+    module {}
+  }
+}
+
+// Updates are copied when the target is read between the producer of the
+// update and the update itself.
+
+// CHECK-LABEL: @tensorUpdateTargetReadBetween
+// CHECK-SAME: (%[[UBUF:.+]]:{{.+}}, %[[TBUF:.+]]:{{.+}})
+func @tensorUpdateTargetReadBetween(%arg0 : tensor<1x1x10xf32>, %arg1 : tensor<5x1x10xf32>) -> (tensor<5x1x10xf32>, tensor<5x1x10xf32>) {
+  %c4 = constant 4 : index
+  %c0 = constant 0 : index
+  // CHECK: %[[CMD:.+]] = hal.command_buffer.create
+  %0:2 = flow.ex.stream.fragment(%arg0, %arg1, %c4, %c0) : (tensor<1x1x10xf32>, tensor<5x1x10xf32>, index, index) -> (tensor<5x1x10xf32>, tensor<5x1x10xf32>) =
+      (%arg2: tensor<1x1x10xf32>, %arg3: tensor<5x1x10xf32>, %arg4: index, %arg5: index) -> (tensor<5x1x10xf32>, tensor<5x1x10xf32>) {
+    //      CHECK: hal.command_buffer.copy_buffer
+    // CHECK-SAME:   source(%[[TBUF]] : !hal.buffer)[%c0]
+    // CHECK-SAME:   target(%[[CLONE_BUF:.+]] : !hal.buffer)[%c0]
+    %clone = flow.tensor.clone %arg3 : tensor<5x1x10xf32>
+    //      CHECK: hal.command_buffer.push_descriptor_set
+    // CHECK-SAME:   bindings([
+    // CHECK-NEXT:     %c0 = (%[[UBUF]] : !hal.buffer)[%c0, %c40],
+    // CHECK-NEXT:     %c1 = (%{{.+}} : !hal.buffer)
+    //      CHECK: hal.command_buffer.dispatch.symbol
+    %1 = flow.dispatch @ex_update::@entry0[%arg4](%arg2) : (tensor<1x1x10xf32>) -> tensor<1x1x10xf32>
+    //      CHECK: hal.command_buffer.push_descriptor_set
+    // CHECK-SAME:   bindings([
+    // CHECK-NEXT:     %c0 = (%[[CLONE_BUF]] : !hal.buffer)[%c0, %c200],
+    //      CHECK: hal.command_buffer.dispatch.symbol
+    %2 = flow.dispatch @ex_read::@entry0[%arg4](%clone) : (tensor<5x1x10xf32>) -> tensor<5x1x10xf32>
+    //      CHECK: hal.command_buffer.copy_buffer
+    // CHECK-SAME:   target(%[[CLONE_BUF]] : !hal.buffer)[%c160]
+    // CHECK-SAME:   length(%c40)
+    %3 = flow.tensor.update %1, %clone[%arg4, %arg5, %arg5] : tensor<1x1x10xf32> -> tensor<5x1x10xf32>
+    flow.return %3, %2 : tensor<5x1x10xf32>, tensor<5x1x10xf32>
+  }
+  // CHECK: hal.command_buffer.end<%[[CMD]]
+  // CHECK: return %[[CLONE_BUF]]
+  return %0#0, %0#1 : tensor<5x1x10xf32>, tensor<5x1x10xf32>
+}
+
+// -----
+
 hal.executable @ex0 {
   hal.interface @interface attributes {push_constants = 2 : index} {
     hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
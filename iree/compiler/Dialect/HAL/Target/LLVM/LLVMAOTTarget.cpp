@@ -14,6 +14,7 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMAOTTarget.h"
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "iree/compiler/Conversion/LinalgToLLVM/LLVMCodeGenOptions.h"
@@ -24,9 +25,16 @@
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Utils/FlatbufferUtils.h"
 #include "iree/schemas/dylib_executable_def_builder.h"
+#include "iree/schemas/executable_variants_def_builder.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetSelect.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
@@ -63,6 +71,120 @@ std::string guessModuleName(mlir::ModuleOp moduleOp) {
   }
 }
 
+// Returns the number of partitions |llvmModule| should be split into for
+// parallel code generation when |codegenPartitions| are requested. Functions
+// are the unit of partitioning so there's no use in having more partitions than
+// defined functions. The result depends only on the module and the options so
+// that the output does not vary across hosts.
+unsigned getCodegenPartitionCount(unsigned codegenPartitions,
+                                  const llvm::Module &llvmModule) {
+  unsigned functionCount =
+      llvm::count_if(llvmModule, [](const llvm::Function &func) {
+        return !func.isDeclaration();
+      });
+  return std::max(1u, std::min(codegenPartitions, functionCount));
+}
+
+// Bump when changing how executables are compiled in a way that is not
+// captured by the cache key (such as codegen or linker changes).
+const char kLibraryCacheVersion[] = "1";
+
+// Returns a key uniquely identifying the library produced for |targetOp| when
+// compiled with |options|. The key covers the printed translated executable IR
+// (including the entry points and interfaces) and every option that influences
+// code generation or linking.
+std::string computeLibraryCacheKey(IREE::HAL::ExecutableTargetOp targetOp,
+                                   StringRef libraryName,
+                                   const LLVMTargetOptions &options) {
+  llvm::SHA1 hasher;
+  auto addField = [&](StringRef value) {
+    hasher.update(value);
+    // Separator so that adjacent fields cannot alias.
+    hasher.update(StringRef("\0", 1));
+  };
+  addField(kLibraryCacheVersion);
+  addField(LLVM_VERSION_STRING);
+  addField(libraryName);
+  addField(options.targetTriple);
+  addField(options.targetCPU);
+  addField(options.targetCPUFeatures);
+  addField(options.options.MCOptions.ABIName);
+  addField(llvm::formatv(
+               "opt={0}/{1} interleave={2} vectorize={3} unroll={4} slp={5} "
+               "float-abi={6} debug={7} sanitizer={8} embedded={9} static={10} "
+               "partitions={11}",
+               options.optLevel.getSpeedupLevel(),
+               options.optLevel.getSizeLevel(),
+               options.pipelineTuningOptions.LoopInterleaving,
+               options.pipelineTuningOptions.LoopVectorization,
+               options.pipelineTuningOptions.LoopUnrolling,
+               options.pipelineTuningOptions.SLPVectorization,
+               static_cast<int>(options.options.FloatABIType),
+               options.debugSymbols, static_cast<int>(options.sanitizerKind),
+               options.linkEmbedded, options.linkStatic,
+               options.codegenPartitions)
+               .str());
+
+  // Locations only matter when they are emitted as debug info.
+  std::string irString;
+  llvm::raw_string_ostream irStream(irString);
+  OpPrintingFlags printingFlags;
+  if (options.debugSymbols) printingFlags.enableDebugInfo();
+  targetOp.getOperation()->print(irStream, printingFlags);
+  addField(irStream.str());
+
+  return llvm::toHex(hasher.final());
+}
+
+// Returns the path of the cached library with |cacheKey| in |cacheDirectory|.
+std::string getLibraryCachePath(StringRef cacheDirectory, StringRef cacheKey) {
+  llvm::SmallString<256> path(cacheDirectory);
+  llvm::sys::path::append(path, cacheKey + ".so");
+  return path.str().str();
+}
+
+// Loads a cached library into a new temporary artifact, if present.
+Optional<Artifacts> loadCachedLibrary(StringRef cacheDirectory,
+                                      StringRef cacheKey,
+                                      StringRef libraryName) {
+  auto fileData = llvm::MemoryBuffer::getFile(
+      getLibraryCachePath(cacheDirectory, cacheKey));
+  if (!fileData) return llvm::None;
+  Artifacts artifacts;
+  artifacts.libraryFile = Artifact::createTemporary(libraryName, "so");
+  if (!artifacts.libraryFile.outputFile) return llvm::None;
+  auto &os = artifacts.libraryFile.outputFile->os();
+  os << fileData.get()->getBuffer();
+  os.flush();
+  artifacts.libraryFile.close();
+  return artifacts;
+}
+
+// Stores the linked library in |cacheDirectory| under |cacheKey|. The file is
+// written to a temporary path and renamed into place so that concurrent
+// compilations sharing the cache never observe partial files. Failures are
+// ignored as the cache is only an optimization.
+void storeCachedLibrary(StringRef cacheDirectory, StringRef cacheKey,
+                        const Artifacts &artifacts) {
+  if (llvm::sys::fs::create_directories(cacheDirectory)) return;
+  llvm::SmallString<256> tempPath(cacheDirectory);
+  llvm::sys::path::append(tempPath, cacheKey + "-%%%%%%%%.tmp");
+  int tempFD = -1;
+  if (llvm::sys::fs::createUniqueFile(tempPath, tempFD, tempPath)) return;
+  bool wroteFile = false;
+  {
+    llvm::raw_fd_ostream os(tempFD, /*shouldClose=*/true);
+    wroteFile = artifacts.libraryFile.readInto(os);
+    os.flush();
+    wroteFile = wroteFile && !os.has_error();
+  }
+  if (!wroteFile ||
+      llvm::sys::fs::rename(tempPath,
+                            getLibraryCachePath(cacheDirectory, cacheKey))) {
+    llvm::sys::fs::remove(tempPath);
+  }
+}
+
 }  // namespace
 
 class LLVMAOTTargetBackend final : public TargetBackend {
@@ -158,10 +280,6 @@ class LLVMAOTTargetBackend final : public TargetBackend {
 
   LogicalResult serializeExecutable(IREE::HAL::ExecutableTargetOp targetOp,
                                     OpBuilder &executableBuilder) override {
-    // Perform the translation in a separate context to avoid any
-    // multi-threading issues.
-    llvm::LLVMContext context;
-
     // We name our files after the executable name so that they are easy to
     // track both during compilation (logs/artifacts/etc), as outputs (final
     // intermediate code/binary files), and at runtime (loaded
@@ -177,6 +295,124 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         LLVM::LLVMDialect::getTargetTripleAttrName(),
         executableBuilder.getStringAttr(targetTriple.str()));
 
+    if (!options_.targetCPUFeatureVariants.empty()) {
+      if (!options_.linkEmbedded) {
+        return targetOp.emitError()
+               << "CPU feature variants are only supported when linking "
+                  "embedded ELFs (-iree-llvm-link-embedded)";
+      }
+      return serializeVariantsExecutable(targetOp, libraryName,
+                                         executableBuilder);
+    }
+
+    Artifacts linkArtifacts;
+    if (failed(buildLibrary(targetOp, libraryName, options_, linkArtifacts))) {
+      return failure();
+    }
+
+    if (options_.linkEmbedded) {
+      // Load the linked ELF file and pack into an attr.
+      auto elfFile = linkArtifacts.libraryFile.read();
+      if (!elfFile.hasValue()) {
+        return targetOp.emitError() << "failed to read back dylib temp file at "
+                                    << linkArtifacts.libraryFile.path;
+      }
+      auto bufferAttr = DenseIntElementsAttr::get(
+          VectorType::get({static_cast<int64_t>(elfFile->size())},
+                          IntegerType::get(executableBuilder.getContext(), 8)),
+          std::move(elfFile.getValue()));
+
+      // Add the binary to the parent hal.executable.
+      auto executableFormatAttr = executableBuilder.getStringAttr("EX_ELF");
+      auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
+          targetOp.getLoc(), targetOp.sym_name(), executableFormatAttr,
+          bufferAttr);
+      binaryOp.mime_typeAttr(
+          executableBuilder.getStringAttr("application/x-elf"));
+    } else {
+      FlatbufferBuilder builder;
+      iree_DyLibExecutableDef_start_as_root(builder);
+
+      // Embed debug symbols at the end of the flatbuffer by adding first in the
+      // bottoms-up builder.
+      flatbuffers_uint8_vec_ref_t debugDatabaseRef = 0;
+      flatbuffers_string_ref_t debugDatabaseFilenameRef = 0;
+      if (options_.debugSymbols && linkArtifacts.debugFile.outputFile) {
+        debugDatabaseRef = builder.streamUint8Vec([&](raw_ostream &stream) {
+          return linkArtifacts.debugFile.readInto(stream);
+        });
+        debugDatabaseFilenameRef = builder.createString(
+            llvm::sys::path::filename(linkArtifacts.debugFile.path));
+      }
+
+      // Embed entire dynamic library output.
+      flatbuffers_uint8_vec_ref_t libraryEmbeddedRef =
+          builder.streamUint8Vec([&](raw_ostream &stream) {
+            return linkArtifacts.libraryFile.readInto(stream);
+          });
+      if (!libraryEmbeddedRef) {
+        return targetOp.emitError() << "failed to read back dylib temp file at "
+                                    << linkArtifacts.libraryFile.path;
+      }
+
+      iree_DyLibExecutableDef_library_embedded_add(builder, libraryEmbeddedRef);
+      iree_DyLibExecutableDef_debug_database_filename_add(
+          builder, debugDatabaseFilenameRef);
+      iree_DyLibExecutableDef_debug_database_embedded_add(builder,
+                                                          debugDatabaseRef);
+      iree_DyLibExecutableDef_end_as_root(builder);
+
+      auto executableFormatAttr = targetTriple.isWasm()
+                                      ? executableBuilder.getStringAttr("WASM")
+                                      : executableBuilder.getStringAttr("DLIB");
+
+      // Add the binary data to the target executable.
+      auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
+          targetOp.getLoc(), targetOp.sym_name(), executableFormatAttr,
+          builder.getBufferAttr(executableBuilder.getContext()));
+      binaryOp.mime_typeAttr(
+          executableBuilder.getStringAttr("application/x-flatbuffers"));
+    }
+    return success();
+  }
+
+ private:
+  // Preserves |artifacts| (including libraries reused from the cache) for
+  // debugging and reports where they can be found.
+  static void keepLinkerArtifacts(IREE::HAL::ExecutableTargetOp targetOp,
+                                  Artifacts &artifacts) {
+    mlir::emitRemark(targetOp.getLoc())
+        << "Linker artifacts for " << targetOp.getName() << " preserved:\n"
+        << "    " << artifacts.libraryFile.path;
+    artifacts.keepAllFiles();
+  }
+
+  // Translates the executable to LLVM IR, compiles it for |variantOptions|, and
+  // links it into a library stored in |outArtifacts|.
+  LogicalResult buildLibrary(IREE::HAL::ExecutableTargetOp targetOp,
+                             StringRef libraryName,
+                             LLVMTargetOptions variantOptions,
+                             Artifacts &outArtifacts) {
+    // Reuse a previously linked library if nothing that influences it changed.
+    std::string cacheKey;
+    if (!variantOptions.cacheDirectory.empty()) {
+      cacheKey = computeLibraryCacheKey(targetOp, libraryName, variantOptions);
+      auto cachedArtifacts = loadCachedLibrary(variantOptions.cacheDirectory,
+                                               cacheKey, libraryName);
+      if (cachedArtifacts.hasValue()) {
+        outArtifacts = std::move(cachedArtifacts.getValue());
+        if (variantOptions.keepLinkerArtifacts) {
+          keepLinkerArtifacts(targetOp, outArtifacts);
+        }
+        return success();
+      }
+    }
+
+    // Perform the translation in a separate context to avoid any
+    // multi-threading issues.
+    llvm::LLVMContext context;
+    llvm::Triple targetTriple(variantOptions.targetTriple);
+
     // At this moment we are leaving MLIR LLVM dialect land translating module
     // into target independent LLVMIR.
     auto llvmModule = mlir::translateModuleToLLVMIR(targetOp.getInnerModule(),
@@ -205,7 +441,7 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     LibraryBuilder libraryBuilder(
         llvmModule.get(), LibraryBuilder::Mode::INCLUDE_REFLECTION_ATTRS,
         LibraryBuilder::Version::V_0);
-    switch (options_.sanitizerKind) {
+    switch (variantOptions.sanitizerKind) {
       case SanitizerKind::kNone: {
         libraryBuilder.setSanitizerKind(LibraryBuilder::SanitizerKind::NONE);
         break;
@@ -234,11 +470,11 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         llvm::GlobalValue::LinkageTypes::ExternalLinkage);
 
     // Try to grab a linker tool based on the options (and target environment).
-    auto linkerTool = LinkerTool::getForTarget(targetTriple, options_);
+    auto linkerTool = LinkerTool::getForTarget(targetTriple, variantOptions);
     if (!linkerTool) {
       return mlir::emitError(targetOp.getLoc())
              << "failed to find a target linker for the given target triple '"
-             << options_.targetTriple << "'";
+             << variantOptions.targetTriple << "'";
     }
 
     // Configure the module with any code generation options required later by
@@ -251,37 +487,47 @@ class LLVMAOTTargetBackend final : public TargetBackend {
 
     // LLVM opt passes that perform code generation optimizations/transformation
     // similar to what a frontend would do before passing to linking.
-    auto targetMachine = createTargetMachine(options_);
+    auto targetMachine = createTargetMachine(variantOptions);
     if (!targetMachine) {
       return mlir::emitError(targetOp.getLoc())
              << "failed to create target machine for target triple '"
-             << options_.targetTriple << "'";
+             << variantOptions.targetTriple << "'";
     }
     llvmModule->setDataLayout(targetMachine->createDataLayout());
     llvmModule->setTargetTriple(targetMachine->getTargetTriple().str());
-    if (failed(
-            runLLVMIRPasses(options_, targetMachine.get(), llvmModule.get()))) {
+    if (failed(runLLVMIRPasses(variantOptions, targetMachine.get(),
+                               llvmModule.get()))) {
       return targetOp.emitError()
              << "failed to run LLVM-IR opt passes for IREE::HAL::ExecutableOp "
                 "targeting '"
-             << options_.targetTriple << "'";
+             << variantOptions.targetTriple << "'";
     }
 
-    // Emit object files.
-    SmallVector<Artifact, 4> objectFiles;
-    {
-      // NOTE: today we just use a single object file, however if we wanted to
-      // scale code generation and linking we'd want to generate one per
-      // function (or something like that).
-      std::string objectData;
+    // Emit object files. Large modules (such as those produced by linking all
+    // executables together) are split into partitions that are compiled in
+    // parallel and linked back together below.
+    SmallVector<std::string, 4> objectData;
+    unsigned partitionCount = getCodegenPartitionCount(
+        variantOptions.codegenPartitions, *llvmModule);
+    if (partitionCount > 1) {
+      if (failed(runParallelEmitObjFilePasses(variantOptions, llvmModule.get(),
+                                              partitionCount, objectData))) {
+        return targetOp.emitError()
+               << "failed to compile LLVM-IR module to object files";
+      }
+    } else {
+      objectData.emplace_back();
       if (failed(runEmitObjFilePasses(targetMachine.get(), llvmModule.get(),
-                                      &objectData))) {
+                                      &objectData.back()))) {
         return targetOp.emitError()
                << "failed to compile LLVM-IR module to an object file";
       }
+    }
+    SmallVector<Artifact, 4> objectFiles;
+    for (auto &data : objectData) {
       auto objectFile = Artifact::createTemporary(libraryName, "obj");
       auto &os = objectFile.outputFile->os();
-      os << objectData;
+      os << data;
       os.flush();
       os.close();
       objectFiles.push_back(std::move(objectFile));
@@ -297,80 +543,81 @@ class LLVMAOTTargetBackend final : public TargetBackend {
              << linkerTool->getToolPath();
     }
     auto &linkArtifacts = linkArtifactsOr.getValue();
-    if (options_.keepLinkerArtifacts) {
-      mlir::emitRemark(targetOp.getLoc())
-          << "Linker artifacts for " << targetOp.getName() << " preserved:\n"
-          << "    " << linkArtifacts.libraryFile.path;
-      linkArtifacts.keepAllFiles();
+    if (variantOptions.keepLinkerArtifacts) {
+      keepLinkerArtifacts(targetOp, linkArtifacts);
     }
 
-    if (options_.linkEmbedded) {
-      // Load the linked ELF file and pack into an attr.
-      auto elfFile = linkArtifacts.libraryFile.read();
-      if (!elfFile.hasValue()) {
-        return targetOp.emitError() << "failed to read back dylib temp file at "
-                                    << linkArtifacts.libraryFile.path;
-      }
-      auto bufferAttr = DenseIntElementsAttr::get(
-          VectorType::get({static_cast<int64_t>(elfFile->size())},
-                          IntegerType::get(executableBuilder.getContext(), 8)),
-          std::move(elfFile.getValue()));
-
-      // Add the binary to the parent hal.executable.
-      auto executableFormatAttr = executableBuilder.getStringAttr("EX_ELF");
-      auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
-          targetOp.getLoc(), targetOp.sym_name(), executableFormatAttr,
-          bufferAttr);
-      binaryOp.mime_typeAttr(
-          executableBuilder.getStringAttr("application/x-elf"));
-    } else {
-      FlatbufferBuilder builder;
-      iree_DyLibExecutableDef_start_as_root(builder);
+    // Libraries with separate debug databases are not cached as we'd lose the
+    // debug information on reuse.
+    if (!cacheKey.empty() && !linkArtifacts.debugFile.outputFile) {
+      storeCachedLibrary(variantOptions.cacheDirectory, cacheKey,
+                         linkArtifacts);
+    }
+    outArtifacts = std::move(linkArtifacts);
+    return success();
+  }
 
-      // Embed debug symbols at the end of the flatbuffer by adding first in the
-      // bottoms-up builder.
-      flatbuffers_uint8_vec_ref_t debugDatabaseRef = 0;
-      flatbuffers_string_ref_t debugDatabaseFilenameRef = 0;
-      if (options_.debugSymbols && linkArtifacts.debugFile.outputFile) {
-        debugDatabaseRef = builder.streamUint8Vec([&](raw_ostream &stream) {
-          return linkArtifacts.debugFile.readInto(stream);
-        });
-        debugDatabaseFilenameRef = builder.createString(
-            llvm::sys::path::filename(linkArtifacts.debugFile.path));
+  // Compiles one embedded ELF per CPU feature variant plus the baseline and
+  // packs them into a bundle the runtime selects from based on the host CPU.
+  LogicalResult serializeVariantsExecutable(
+      IREE::HAL::ExecutableTargetOp targetOp, StringRef libraryName,
+      OpBuilder &executableBuilder) {
+    // Variants in order of preference with the baseline (which has no
+    // requirements beyond the target triple) last.
+    SmallVector<std::string, 4> variantFeatures(
+        options_.targetCPUFeatureVariants.begin(),
+        options_.targetCPUFeatureVariants.end());
+    variantFeatures.push_back("");
+
+    FlatbufferBuilder builder;
+    SmallVector<iree_ExecutableVariantDef_ref_t, 4> variantRefs;
+    for (auto variant : llvm::enumerate(variantFeatures)) {
+      LLVMTargetOptions variantOptions = options_;
+      if (!variant.value().empty()) {
+        variantOptions.targetCPUFeatures =
+            variantOptions.targetCPUFeatures.empty()
+                ? variant.value()
+                : variantOptions.targetCPUFeatures + "," + variant.value();
       }
-
-      // Embed entire dynamic library output.
-      flatbuffers_uint8_vec_ref_t libraryEmbeddedRef =
-          builder.streamUint8Vec([&](raw_ostream &stream) {
-            return linkArtifacts.libraryFile.readInto(stream);
-          });
-      if (!libraryEmbeddedRef) {
+      Artifacts linkArtifacts;
+      if (failed(buildLibrary(
+              targetOp,
+              llvm::formatv("{0}_variant{1}", libraryName, variant.index())
+                  .str(),
+              variantOptions, linkArtifacts))) {
+        return failure();
+      }
+      auto executableDataRef = builder.streamUint8Vec([&](raw_ostream &stream) {
+        return linkArtifacts.libraryFile.readInto(stream);
+      });
+      if (!executableDataRef) {
         return targetOp.emitError() << "failed to read back dylib temp file at "
                                     << linkArtifacts.libraryFile.path;
       }
-
-      iree_DyLibExecutableDef_library_embedded_add(builder, libraryEmbeddedRef);
-      iree_DyLibExecutableDef_debug_database_filename_add(
-          builder, debugDatabaseFilenameRef);
-      iree_DyLibExecutableDef_debug_database_embedded_add(builder,
-                                                          debugDatabaseRef);
-      iree_DyLibExecutableDef_end_as_root(builder);
-
-      auto executableFormatAttr = targetTriple.isWasm()
-                                      ? executableBuilder.getStringAttr("WASM")
-                                      : executableBuilder.getStringAttr("DLIB");
-
-      // Add the binary data to the target executable.
-      auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
-          targetOp.getLoc(), targetOp.sym_name(), executableFormatAttr,
-          builder.getBufferAttr(executableBuilder.getContext()));
-      binaryOp.mime_typeAttr(
-          executableBuilder.getStringAttr("application/x-flatbuffers"));
+      auto cpuFeaturesRef = builder.createString(variant.value());
+      auto executableFormatRef = builder.createString("EX_ELF");
+      iree_ExecutableVariantDef_start(builder);
+      iree_ExecutableVariantDef_cpu_features_add(builder, cpuFeaturesRef);
+      iree_ExecutableVariantDef_executable_format_add(builder,
+                                                      executableFormatRef);
+      iree_ExecutableVariantDef_executable_data_add(builder, executableDataRef);
+      variantRefs.push_back(iree_ExecutableVariantDef_end(builder));
     }
+
+    auto variantsRef = builder.createOffsetVecDestructive(variantRefs);
+    iree_ExecutableVariantsDef_start_as_root(builder);
+    iree_ExecutableVariantsDef_variants_add(builder, variantsRef);
+    iree_ExecutableVariantsDef_end_as_root(builder);
+
+    auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
+        targetOp.getLoc(), targetOp.sym_name(),
+        executableBuilder.getStringAttr("EX_VARIANTS"),
+        builder.getBufferAttr(executableBuilder.getContext()));
+    binaryOp.mime_typeAttr(
+        executableBuilder.getStringAttr("application/x-flatbuffers"));
     return success();
   }
 
- private:
   LLVMTargetOptions options_;
 };
 
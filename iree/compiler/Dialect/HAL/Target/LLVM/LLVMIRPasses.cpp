@@ -15,6 +15,7 @@
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMIRPasses.h"
 
 #include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
@@ -147,6 +148,34 @@ LogicalResult runEmitObjFilePasses(llvm::TargetMachine *machine,
   return success();
 }
 
+LogicalResult runParallelEmitObjFilePasses(
+    const LLVMTargetOptions &options, llvm::Module *module,
+    unsigned partitionCount, SmallVectorImpl<std::string> &objData) {
+  SmallVector<SmallVector<char, 0>, 8> streamBuffers(partitionCount);
+  SmallVector<std::unique_ptr<llvm::raw_svector_ostream>, 8> streams;
+  SmallVector<llvm::raw_pwrite_stream *, 8> streamPtrs;
+  for (auto &streamBuffer : streamBuffers) {
+    streams.push_back(
+        std::make_unique<llvm::raw_svector_ostream>(streamBuffer));
+    streamPtrs.push_back(streams.back().get());
+  }
+
+  // Each partition is compiled on its own thread with its own target machine.
+  // Locals are externalized (with hidden visibility) so that references across
+  // partitions resolve when the objects are linked back together.
+  llvm::splitCodeGen(
+      *module, streamPtrs, /*BCOSs=*/{},
+      [&]() { return createTargetMachine(options); }, llvm::CGFT_ObjectFile,
+      /*PreserveLocals=*/false);
+
+  for (auto &streamBuffer : streamBuffers) {
+    if (streamBuffer.empty()) continue;
+    objData.emplace_back(streamBuffer.begin(), streamBuffer.end());
+  }
+  if (objData.empty()) return failure();
+  return success();
+}
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
@@ -40,6 +40,14 @@ LogicalResult runLLVMIRPasses(const LLVMTargetOptions &options,
 LogicalResult runEmitObjFilePasses(llvm::TargetMachine *machine,
                                    llvm::Module *module, std::string *objData);
 
+// Splits |module| into up to |partitionCount| partitions and emits one object
+// file per partition, compiling them in parallel. The partitioning depends only
+// on the module contents and |partitionCount| so output is deterministic for a
+// given partition count. |module| is left in an unspecified state.
+LogicalResult runParallelEmitObjFilePasses(
+    const LLVMTargetOptions &options, llvm::Module *module,
+    unsigned partitionCount, SmallVectorImpl<std::string> &objData);
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
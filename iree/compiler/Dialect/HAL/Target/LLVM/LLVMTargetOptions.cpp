@@ -74,6 +74,13 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::desc("LLVM target machine CPU features; use 'host' for your "
                      "host native CPU"),
       llvm::cl::init(""));
+  static llvm::cl::list<std::string> clTargetCPUFeatureVariants(
+      "iree-llvm-target-cpu-features-variant",
+      llvm::cl::desc("Additional LLVM target machine CPU features to compile "
+                     "executable variants for (such as '+avx2,+fma'); may be "
+                     "repeated in order of preference and requires "
+                     "-iree-llvm-link-embedded"),
+      llvm::cl::ZeroOrMore);
 
   static llvm::cl::opt<bool> llvmLoopInterleaving(
       "iree-llvm-loop-interleaving", llvm::cl::init(false),
@@ -95,6 +102,8 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   if (clTargetCPUFeatures != "host") {
     llvmTargetOptions.targetCPUFeatures = clTargetCPUFeatures;
   }
+  llvmTargetOptions.targetCPUFeatureVariants.assign(
+      clTargetCPUFeatureVariants.begin(), clTargetCPUFeatureVariants.end());
 
   // LLVM opt options.
   llvmTargetOptions.pipelineTuningOptions.LoopInterleaving =
@@ -152,12 +161,28 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::init(llvmTargetOptions.linkStatic));
   llvmTargetOptions.linkStatic = clLinkStatic;
 
+  static llvm::cl::opt<unsigned> clCodegenPartitions(
+      "iree-llvm-codegen-partitions",
+      llvm::cl::desc("Number of partitions the code of a single executable is "
+                     "split into and generated in parallel; the output binary "
+                     "depends on the value but not on the host"),
+      llvm::cl::init(llvmTargetOptions.codegenPartitions));
+  llvmTargetOptions.codegenPartitions = clCodegenPartitions;
+
   static llvm::cl::opt<bool> clKeepLinkerArtifacts(
       "iree-llvm-keep-linker-artifacts",
       llvm::cl::desc("Keep LLVM linker target artifacts (.so/.dll/etc)"),
       llvm::cl::init(llvmTargetOptions.keepLinkerArtifacts));
   llvmTargetOptions.keepLinkerArtifacts = clKeepLinkerArtifacts;
 
+  static llvm::cl::opt<std::string> clCacheDirectory(
+      "iree-llvm-cache-dir",
+      llvm::cl::desc("Directory used to cache linked executable libraries "
+                     "across compilations; unchanged executables reuse the "
+                     "cached library instead of running LLVM codegen"),
+      llvm::cl::init(llvmTargetOptions.cacheDirectory));
+  llvmTargetOptions.cacheDirectory = clCacheDirectory;
+
   return llvmTargetOptions;
 }
 
@@ -15,6 +15,9 @@
 #ifndef IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 #define IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 
+#include <string>
+#include <vector>
+
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Target/TargetOptions.h"
 
@@ -36,6 +39,13 @@ struct LLVMTargetOptions {
   std::string targetCPU;
   std::string targetCPUFeatures;
 
+  // Additional CPU feature sets to compile variants of each executable for.
+  // Each entry is appended to |targetCPUFeatures| and the variants are ordered
+  // by preference; the runtime selects the first one supported by the host
+  // and falls back to the baseline |targetCPUFeatures| variant otherwise.
+  // Only supported when |linkEmbedded| is set.
+  std::vector<std::string> targetCPUFeatureVariants;
+
   llvm::PipelineTuningOptions pipelineTuningOptions;
   llvm::PassBuilder::OptimizationLevel optLevel;
   llvm::TargetOptions options;
@@ -57,8 +67,22 @@ struct LLVMTargetOptions {
   // any machine without requiring matching system libraries to be installed.
   bool linkStatic = false;
 
+  // Number of partitions the code of a single executable is split into.
+  // Large executables (such as those produced by linking all dispatches
+  // together) can be split into multiple partitions that are compiled on their
+  // own threads and linked back together. The output binary depends only on
+  // the partition count and not on the host so it is deterministic for a given
+  // value. 1 compiles the whole executable on the calling thread.
+  unsigned codegenPartitions = 1;
+
   // True to keep linker artifacts for debugging.
   bool keepLinkerArtifacts = false;
+
+  // Directory used to persist linked libraries across compilations keyed by a
+  // hash of the translated executable IR and these options. Executables whose
+  // key matches a cached library skip LLVM code generation and linking.
+  // Disabled when empty.
+  std::string cacheDirectory;
 };
 
 // Returns LLVMTargetOptions struct intialized with the iree-llvm-* flags.
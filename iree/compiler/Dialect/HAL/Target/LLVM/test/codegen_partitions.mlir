@@ -0,0 +1,57 @@
+// The output only depends on the partition count and not on the number of
+// threads used to translate executables or to generate code.
+// RUN: iree-opt -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf %s -o %t.default.mlir
+// RUN: iree-opt -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-codegen-partitions=1 -mlir-disable-threading %s -o %t.one.mlir
+// RUN: diff %t.default.mlir %t.one.mlir
+// RUN: iree-opt -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-codegen-partitions=2 %s -o %t.two.mlir
+// RUN: iree-opt -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-codegen-partitions=2 -mlir-disable-threading %s -o %t.two_sequential.mlir
+// RUN: diff %t.two.mlir %t.two_sequential.mlir
+// RUN: IreeFileCheck %s --input-file=%t.one.mlir
+// RUN: IreeFileCheck %s --input-file=%t.two.mlir
+
+#map = affine_map<(d0) -> (d0)>
+flow.executable @add_dispatch_0 {
+  flow.dispatch.entry @add_dispatch_0 attributes {
+    signature = (tensor<16xf32>, tensor<16xf32>) -> tensor<16xf32>,
+    workgroup_rank = 3 : index
+  }
+  module  {
+    func @add_dispatch_0(%arg0: !flow.dispatch.tensor<readonly:16xf32>, %arg1: !flow.dispatch.tensor<readonly:16xf32>, %arg2: !flow.dispatch.tensor<writeonly:16xf32>) {
+      %0 = linalg.init_tensor [16] : tensor<16xf32>
+      %1 = flow.dispatch.tensor.load %arg0, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %2 = flow.dispatch.tensor.load %arg1, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %3 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%1, %2 : tensor<16xf32>, tensor<16xf32>) outs(%0 : tensor<16xf32>) {
+      ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):  // no predecessors
+        %4 = addf %arg3, %arg4 : f32
+        linalg.yield %4 : f32
+      } -> tensor<16xf32>
+      flow.dispatch.tensor.store %3, %arg2, offsets=[], sizes=[], strides=[] : tensor<16xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+      return
+    }
+  }
+}
+
+flow.executable @mul_dispatch_1 {
+  flow.dispatch.entry @mul_dispatch_1 attributes {
+    signature = (tensor<16xf32>, tensor<16xf32>) -> tensor<16xf32>,
+    workgroup_rank = 3 : index
+  }
+  module  {
+    func @mul_dispatch_1(%arg0: !flow.dispatch.tensor<readonly:16xf32>, %arg1: !flow.dispatch.tensor<readonly:16xf32>, %arg2: !flow.dispatch.tensor<writeonly:16xf32>) {
+      %0 = linalg.init_tensor [16] : tensor<16xf32>
+      %1 = flow.dispatch.tensor.load %arg0, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %2 = flow.dispatch.tensor.load %arg1, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %3 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%1, %2 : tensor<16xf32>, tensor<16xf32>) outs(%0 : tensor<16xf32>) {
+      ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):  // no predecessors
+        %4 = mulf %arg3, %arg4 : f32
+        linalg.yield %4 : f32
+      } -> tensor<16xf32>
+      flow.dispatch.tensor.store %3, %arg2, offsets=[], sizes=[], strides=[] : tensor<16xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+      return
+    }
+  }
+}
+
+// CHECK:       hal.executable.binary @llvm_aot attributes {
+// CHECK-SAME:     data = dense
+// CHECK-SAME:     format = "EX_ELF"
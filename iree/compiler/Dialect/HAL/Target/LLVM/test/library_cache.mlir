@@ -0,0 +1,39 @@
+// RUN: rm -rf %t.cache
+// RUN: iree-opt -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-cache-dir=%t.cache %s | IreeFileCheck %s --check-prefix=MISS
+// RUN: test $(ls %t.cache | wc -l) -eq 1
+// Replace the cached library with a marker so that its reuse is observable.
+// RUN: for f in %t.cache/*.so; do printf IREE > $f; done
+// RUN: iree-opt -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-cache-dir=%t.cache %s | IreeFileCheck %s --check-prefix=HIT
+// RUN: iree-opt -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-cache-dir=%t.cache %s -iree-llvm-keep-linker-artifacts 2>&1 >/dev/null | IreeFileCheck %s --check-prefix=KEEP
+
+#map = affine_map<(d0) -> (d0)>
+flow.executable @add_dispatch_0 {
+  flow.dispatch.entry @add_dispatch_0 attributes {
+    signature = (tensor<16xf32>, tensor<16xf32>) -> tensor<16xf32>,
+    workgroup_rank = 3 : index
+  }
+  module  {
+    func @add_dispatch_0(%arg0: !flow.dispatch.tensor<readonly:16xf32>, %arg1: !flow.dispatch.tensor<readonly:16xf32>, %arg2: !flow.dispatch.tensor<writeonly:16xf32>) {
+      %0 = linalg.init_tensor [16] : tensor<16xf32>
+      %1 = flow.dispatch.tensor.load %arg0, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %2 = flow.dispatch.tensor.load %arg1, offsets=[], sizes=[], strides=[] : !flow.dispatch.tensor<readonly:16xf32> -> tensor<16xf32>
+      %3 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel"]} ins(%1, %2 : tensor<16xf32>, tensor<16xf32>) outs(%0 : tensor<16xf32>) {
+      ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):  // no predecessors
+        %4 = addf %arg3, %arg4 : f32
+        linalg.yield %4 : f32
+      } -> tensor<16xf32>
+      flow.dispatch.tensor.store %3, %arg2, offsets=[], sizes=[], strides=[] : tensor<16xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+      return
+    }
+  }
+}
+
+// MISS:       hal.executable.binary @llvm_aot attributes {
+// MISS-SAME:     data = dense
+// MISS-SAME:     format = "EX_ELF"
+
+// HIT:       hal.executable.binary @llvm_aot attributes {
+// HIT-SAME:     data = dense<[73, 82, 69, 69]> : vector<4xi8>
+// HIT-SAME:     format = "EX_ELF"
+
+// KEEP: remark: Linker artifacts for {{.+}} preserved:
@@ -1,4 +1,5 @@
 // RUN: iree-opt -split-input-file -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot %s | IreeFileCheck %s
+// RUN: iree-opt -split-input-file -iree-hal-transformation-pipeline -iree-hal-target-backends=dylib-llvm-aot -iree-llvm-link-embedded=true -iree-llvm-target-triple=x86_64-unknown-unknown-eabi-elf -iree-llvm-target-cpu-features-variant=+avx512f -iree-llvm-target-cpu-features-variant=+avx2,+fma %s | IreeFileCheck %s --check-prefix=VARIANTS
 
 #map = affine_map<(d0) -> (d0)>
 flow.executable @add_dispatch_0 {
@@ -25,3 +26,7 @@ flow.executable @add_dispatch_0 {
 // CHECK:       hal.executable.binary @llvm_aot attributes {
 // CHECK-SAME:     data = dense
 // CHECK-SAME:     format = "DLIB"
+
+// VARIANTS:       hal.executable.binary @llvm_aot attributes {
+// VARIANTS-SAME:     data = dense
+// VARIANTS-SAME:     format = "EX_VARIANTS"
@@ -20,8 +20,10 @@
 
 #include "iree/compiler/Dialect/IREE/IR/IREETypes.h"
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/Attributes.h"
@@ -154,6 +156,24 @@ struct RegisterUsage {
     }
   }
 
+  // Attempts to allocate the specific register |reg| and returns true if it
+  // was available.
+  bool tryAllocateRegister(Register reg) {
+    int ordinalStart = reg.ordinal();
+    if (reg.isRef()) {
+      if (refRegisters.test(ordinalStart)) return false;
+    } else {
+      unsigned int ordinalEnd = ordinalStart + (reg.byteWidth() / 4) - 1;
+      if (ordinalEnd >= Register::kInt32RegisterCount) return false;
+      for (unsigned int ordinal = ordinalStart; ordinal <= ordinalEnd;
+           ++ordinal) {
+        if (intRegisters.test(ordinal)) return false;
+      }
+    }
+    markRegisterUsed(reg);
+    return true;
+  }
+
   void markRegisterUsed(Register reg) {
     int ordinalStart = reg.ordinal();
     if (reg.isRef()) {
@@ -205,6 +225,64 @@ static SmallVector<Block *, 8> sortBlocksInDominanceOrder(
   return orderedBlocks;
 }
 
+// Returns true if |reg| can hold a value of |type|.
+static bool isRegisterCompatible(Register reg, Type type) {
+  if (type.isIntOrFloat()) {
+    return reg.isValue() && reg.byteWidth() == type.getIntOrFloatBitWidth() / 8;
+  }
+  return reg.isRef();
+}
+
+// Returns the values passed to |blockArg| from the terminators of all of its
+// predecessor blocks.
+static SmallVector<Value, 4> getIncomingValues(BlockArgument blockArg) {
+  SmallVector<Value, 4> values;
+  Block *block = blockArg.getOwner();
+  for (auto it = block->pred_begin(); it != block->pred_end(); ++it) {
+    auto branchOp = dyn_cast<BranchOpInterface>((*it)->getTerminator());
+    if (!branchOp) continue;
+    auto operands = branchOp.getSuccessorOperands(it.getSuccessorIndex());
+    if (!operands.hasValue()) continue;
+    values.push_back((*operands)[blockArg.getArgNumber()]);
+  }
+  return values;
+}
+
+// Returns the block arguments |value| is passed to by the branches using it.
+static SmallVector<BlockArgument, 4> getOutgoingBlockArgs(Value value) {
+  SmallVector<BlockArgument, 4> blockArgs;
+  llvm::SmallPtrSet<Operation *, 4> branchOps;
+  for (auto *user : value.getUsers()) {
+    auto branchOp = dyn_cast<BranchOpInterface>(user);
+    if (!branchOp || !branchOps.insert(user).second) continue;
+    for (unsigned i = 0; i < branchOp->getNumSuccessors(); ++i) {
+      auto operands = branchOp.getSuccessorOperands(i);
+      if (!operands.hasValue()) continue;
+      for (auto it : llvm::enumerate(*operands)) {
+        if (it.value() != value) continue;
+        blockArgs.push_back(branchOp->getSuccessor(i)->getArgument(it.index()));
+      }
+    }
+  }
+  return blockArgs;
+}
+
+// Allocates a register for a value of |type|, preferring the register in |map|
+// of the first of |hintValues| that has already been allocated and whose
+// register is free in |registerUsage|.
+static Optional<Register> allocateCoalescedRegister(
+    const llvm::DenseMap<Value, Register> &map, RegisterUsage &registerUsage,
+    Type type, ArrayRef<Value> hintValues) {
+  for (auto hintValue : hintValues) {
+    auto it = map.find(hintValue);
+    if (it == map.end()) continue;
+    Register hintReg = it->getSecond().asBaseRegister();
+    if (!isRegisterCompatible(hintReg, type)) continue;
+    if (registerUsage.tryAllocateRegister(hintReg)) return hintReg;
+  }
+  return registerUsage.allocateRegister(type);
+}
+
 // NOTE: this is not a good algorithm, nor is it a good allocator. If you're
 // looking at this and have ideas of how to do this for real please feel
 // free to rip it all apart :)
@@ -240,9 +318,13 @@ LogicalResult RegisterAllocation::recalculate(IREE::VM::FuncOp funcOp) {
       registerUsage.markRegisterUsed(mapToRegister(liveInValue));
     }
 
-    // Allocate arguments first from left-to-right.
+    // Allocate arguments first from left-to-right. Each argument is coalesced
+    // with the register of a value passed to it by an already-allocated
+    // predecessor when that register is free so that the branch need not
+    // remap it.
     for (auto blockArg : block->getArguments()) {
-      auto reg = registerUsage.allocateRegister(blockArg.getType());
+      auto reg = allocateCoalescedRegister(
+          map_, registerUsage, blockArg.getType(), getIncomingValues(blockArg));
       if (!reg.hasValue()) {
         return funcOp.emitError() << "register allocation failed for block arg "
                                   << blockArg.getArgNumber();
@@ -267,7 +349,15 @@ LogicalResult RegisterAllocation::recalculate(IREE::VM::FuncOp funcOp) {
         }
       }
       for (auto result : op.getResults()) {
-        auto reg = registerUsage.allocateRegister(result.getType());
+        // Results passed to successor block arguments that have already been
+        // allocated (such as loop-carried values on back edges) try to land
+        // directly in the argument register.
+        SmallVector<Value, 4> hintValues;
+        for (auto blockArg : getOutgoingBlockArgs(result)) {
+          hintValues.push_back(blockArg);
+        }
+        auto reg = allocateCoalescedRegister(map_, registerUsage,
+                                             result.getType(), hintValues);
         if (!reg.hasValue()) {
           return op.emitError() << "register allocation failed for result "
                                 << result.cast<OpResult>().getResultNumber();
@@ -500,6 +590,17 @@ struct FeedbackArcSet {
   }
 };
 
+// Sets the move bit on the source of each remapping in |srcDstRegs| whose
+// register is in |moveRegs|.
+static void setRemapMoveBits(
+    MutableArrayRef<std::pair<Register, Register>> srcDstRegs,
+    const llvm::SmallDenseSet<Register, 8> &moveRegs) {
+  for (auto &srcDstReg : srcDstRegs) {
+    bool isMove = moveRegs.count(srcDstReg.first.asBaseRegister()) > 0;
+    srcDstReg.first.setMove(isMove);
+  }
+}
+
 SmallVector<std::pair<Register, Register>, 8>
 RegisterAllocation::remapSuccessorRegisters(Operation *op, int successorIndex) {
   // Compute the initial directed graph of register movements.
@@ -509,6 +610,7 @@ RegisterAllocation::remapSuccessorRegisters(Operation *op, int successorIndex) {
   auto *targetBlock = op->getSuccessor(successorIndex);
   auto operands =
       cast<BranchOpInterface>(op).getSuccessorOperands(successorIndex);
+  llvm::SmallDenseSet<Register, 8> moveRegs;
   for (auto it : llvm::enumerate(*operands)) {
     auto srcReg = mapToRegister(it.value());
     BlockArgument targetArg = targetBlock->getArgument(it.index());
@@ -516,6 +618,14 @@ RegisterAllocation::remapSuccessorRegisters(Operation *op, int successorIndex) {
     if (srcReg != dstReg) {
       srcDstRegs.push_back({srcReg, dstReg});
     }
+
+    // Refs that die at the branch are moved into the successor instead of
+    // being retained and later released. Values passed to multiple arguments
+    // are retained as the first move would clear the source register.
+    if (srcReg.isRef() && liveness_.isLastValueUse(it.value(), op) &&
+        llvm::count(*operands, it.value()) == 1) {
+      moveRegs.insert(srcReg);
+    }
   }
 
   // Compute the feedback arc set to determine which edges are the ones inducing
@@ -529,6 +639,7 @@ RegisterAllocation::remapSuccessorRegisters(Operation *op, int successorIndex) {
 
   // If there's no cycles we can simply use the sorted DAG produced.
   if (feedbackArcSet.feedbackEdges.empty()) {
+    setRemapMoveBits(feedbackArcSet.acyclicEdges, moveRegs);
     return feedbackArcSet.acyclicEdges;
   }
 
@@ -547,7 +658,11 @@ RegisterAllocation::remapSuccessorRegisters(Operation *op, int successorIndex) {
     feedbackArcSet.acyclicEdges.insert(feedbackArcSet.acyclicEdges.begin(),
                                        {feedbackEdge.first, scratchReg});
     feedbackArcSet.acyclicEdges.push_back({scratchReg, feedbackEdge.second});
+
+    // Scratch registers are dead after the remap so always move out of them.
+    if (scratchReg.isRef()) moveRegs.insert(scratchReg);
   }
+  setRemapMoveBits(feedbackArcSet.acyclicEdges, moveRegs);
   if (scratchI32Reg != maxI32RegisterOrdinal_) {
     scratchI32RegisterCount_ = scratchI32Reg - maxI32RegisterOrdinal_;
     assert(getMaxI32RegisterOrdinal() <= Register::kInt32RegisterCount &&
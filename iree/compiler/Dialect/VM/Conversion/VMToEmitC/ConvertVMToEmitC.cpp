@@ -16,8 +16,8 @@
 
 #include "emitc/Dialect/EmitC/EmitCDialect.h"
 #include "iree/compiler/Dialect/IREE/IR/IREEDialect.h"
-#include "iree/compiler/Dialect/VM/Analysis/RegisterAllocation.h"
 #include "iree/compiler/Dialect/VM/IR/VMOps.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Matchers.h"
@@ -56,6 +56,70 @@ emitc::CallOp failableCall(ConversionPatternRewriter &rewriter, Location loc,
   return callOp;
 }
 
+/// Returns a pointer to the `local_refs` slot assigned to the ref |value| or
+/// a null Value if it has none. The pointer keeps the ref type of |value| so
+/// that VM ops consuming it after the conversion still verify; the C module
+/// target declares such values as `iree_vm_ref_t*`.
+Value localRefSlotAddress(ConversionPatternRewriter &rewriter, Location loc,
+                          Value value,
+                          const IREE::VM::LocalRefSlots &localRefSlots) {
+  int slot = localRefSlots.getSlot(value);
+  if (slot < 0) return {};
+
+  auto ctx = rewriter.getContext();
+  auto refPtrOp = rewriter.create<emitc::CallOp>(
+      /*location=*/loc,
+      /*type=*/value.getType(),
+      /*callee=*/StringAttr::get(ctx, "VM_ARRAY_ELEMENT_ADDRESS"),
+      /*args=*/
+      ArrayAttr::get(ctx, {StringAttr::get(ctx, "local_refs"),
+                           rewriter.getI32IntegerAttr(slot)}),
+      /*templateArgs=*/ArrayAttr{},
+      /*operands=*/ArrayRef<Value>{});
+  return refPtrOp.getResult(0);
+}
+
+/// Dereferences the ref pointer |listRef| to an `iree_vm_list_t*` and returns
+/// from the function if the list is null.
+Value derefList(ConversionPatternRewriter &rewriter, Location loc,
+                Value listRef) {
+  auto ctx = rewriter.getContext();
+
+  auto refOp = rewriter.create<emitc::ApplyOp>(
+      /*location=*/loc,
+      /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_ref_t"),
+      /*applicableOperator=*/rewriter.getStringAttr("*"),
+      /*operand=*/listRef);
+
+  auto listDerefOp = rewriter.create<emitc::CallOp>(
+      /*location=*/loc,
+      /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_list_t*"),
+      /*callee=*/rewriter.getStringAttr("iree_vm_list_deref"),
+      /*args=*/ArrayAttr{},
+      /*templateArgs=*/ArrayAttr{},
+      /*operands=*/ArrayRef<Value>{refOp.getResult()});
+
+  rewriter.create<emitc::CallOp>(
+      /*location=*/loc,
+      /*type=*/TypeRange{},
+      /*callee=*/rewriter.getStringAttr("VM_RETURN_IF_LIST_NULL"),
+      /*args=*/
+      ArrayAttr::get(ctx, {rewriter.getIndexAttr(0),
+                           StringAttr::get(ctx, "local_refs")}),
+      /*templateArgs=*/ArrayAttr{},
+      /*operands=*/ArrayRef<Value>{listDerefOp.getResult(0)});
+
+  return listDerefOp.getResult(0);
+}
+
+/// Returns the C type used for values of the primitive |type|.
+Optional<StringRef> getCType(Type type) {
+  if (type.isInteger(32)) return StringRef("int32_t");
+  if (type.isInteger(64)) return StringRef("int64_t");
+  if (type.isF32()) return StringRef("float");
+  return None;
+}
+
 SmallVector<Attribute, 4> indexSequence(int64_t n, MLIRContext *ctx) {
   return llvm::to_vector<4>(
       llvm::map_range(llvm::seq<int64_t>(0, n), [&ctx](int64_t i) -> Attribute {
@@ -156,22 +220,40 @@ class ConstZeroOpConversion : public OpRewritePattern<ConstZeroOpTy> {
   }
 };
 
+// Releases the `local_refs` slot of the result so that it holds a null ref.
 class ConstRefZeroOpConversion
-    : public OpRewritePattern<IREE::VM::ConstRefZeroOp> {
+    : public OpConversionPattern<IREE::VM::ConstRefZeroOp> {
  public:
-  using OpRewritePattern<IREE::VM::ConstRefZeroOp>::OpRewritePattern;
+  ConstRefZeroOpConversion(MLIRContext *context,
+                           IREE::VM::LocalRefSlots &localRefSlots)
+      : OpConversionPattern<IREE::VM::ConstRefZeroOp>(context),
+        localRefSlots(localRefSlots) {}
 
-  LogicalResult matchAndRewrite(IREE::VM::ConstRefZeroOp constRefZeroOp,
-                                PatternRewriter &rewriter) const final {
-    StringRef typeString = "iree_vm_ref_t";
-    auto type = emitc::OpaqueType::get(constRefZeroOp.getContext(), typeString);
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::ConstRefZeroOp constRefZeroOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto loc = constRefZeroOp.getLoc();
 
-    StringRef valueString = "{0}";
-    StringAttr value = rewriter.getStringAttr(valueString);
+    Value refPtr = localRefSlotAddress(rewriter, loc, constRefZeroOp.getResult(),
+                                       localRefSlots);
+    if (!refPtr) {
+      return constRefZeroOp.emitOpError() << "result has no local ref slot";
+    }
+
+    rewriter.create<emitc::CallOp>(
+        /*location=*/loc,
+        /*type=*/TypeRange{},
+        /*callee=*/rewriter.getStringAttr("iree_vm_ref_release"),
+        /*args=*/ArrayAttr{},
+        /*templateArgs=*/ArrayAttr{},
+        /*operands=*/ArrayRef<Value>{refPtr});
 
-    rewriter.replaceOpWithNewOp<emitc::ConstOp>(constRefZeroOp, type, value);
+    rewriter.replaceOp(constRefZeroOp, refPtr);
     return success();
   }
+
+  IREE::VM::LocalRefSlots &localRefSlots;
 };
 
 template <typename LoadOpTy, typename GlobalOpTy>
@@ -247,6 +329,122 @@ class GlobalStoreOpConversion : public OpConversionPattern<StoreOpTy> {
   StringRef funcName;
 };
 
+// Retains the ref held by a vm.global.ref into the `local_refs` slot of the
+// loaded value.
+class GlobalLoadRefOpConversion
+    : public OpConversionPattern<IREE::VM::GlobalLoadRefOp> {
+ public:
+  GlobalLoadRefOpConversion(MLIRContext *context,
+                            IREE::VM::LocalRefSlots &localRefSlots)
+      : OpConversionPattern<IREE::VM::GlobalLoadRefOp>(context),
+        localRefSlots(localRefSlots) {}
+
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::GlobalLoadRefOp loadOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto loc = loadOp.getLoc();
+
+    auto globalOp =
+        lookupGlobalOp<IREE::VM::GlobalLoadRefOp, IREE::VM::GlobalRefOp>(
+            loadOp);
+    if (!globalOp) return loadOp.emitError() << "Unable to find GlobalOp";
+
+    Value refPtr =
+        localRefSlotAddress(rewriter, loc, loadOp.getResult(), localRefSlots);
+    if (!refPtr) return loadOp.emitOpError() << "result has no local ref slot";
+
+    // TODO(simon-camp): We can't represent structs in emitc (yet maybe), so
+    // the array where ref globals live after code generation as well as the
+    // state struct argument name are hardcoded here.
+    rewriter.create<emitc::CallOp>(
+        /*location=*/loc,
+        /*type=*/TypeRange{},
+        /*callee=*/rewriter.getStringAttr("vm_global_load_ref"),
+        /*args=*/
+        rewriter.getArrayAttr(
+            {rewriter.getStringAttr("state->refs"),
+             rewriter.getUI32IntegerAttr(static_cast<uint32_t>(
+                 globalOp.ordinal().getValue().getZExtValue())),
+             rewriter.getIndexAttr(0)}),
+        /*templateArgs=*/ArrayAttr{},
+        /*operands=*/ArrayRef<Value>{refPtr});
+
+    rewriter.replaceOp(loadOp, refPtr);
+    return success();
+  }
+
+  IREE::VM::LocalRefSlots &localRefSlots;
+};
+
+class GlobalStoreRefOpConversion
+    : public OpConversionPattern<IREE::VM::GlobalStoreRefOp> {
+  using OpConversionPattern<IREE::VM::GlobalStoreRefOp>::OpConversionPattern;
+
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::GlobalStoreRefOp storeOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto globalOp =
+        lookupGlobalOp<IREE::VM::GlobalStoreRefOp, IREE::VM::GlobalRefOp>(
+            storeOp);
+    if (!globalOp) return storeOp.emitError() << "Unable to find GlobalOp";
+
+    rewriter.replaceOpWithNewOp<emitc::CallOp>(
+        /*op=*/storeOp,
+        /*type=*/TypeRange{},
+        /*callee=*/rewriter.getStringAttr("vm_global_store_ref"),
+        /*args=*/
+        rewriter.getArrayAttr(
+            {rewriter.getStringAttr("state->refs"),
+             rewriter.getUI32IntegerAttr(static_cast<uint32_t>(
+                 globalOp.ordinal().getValue().getZExtValue())),
+             rewriter.getIndexAttr(0)}),
+        /*templateArgs=*/ArrayAttr{},
+        /*operands=*/operands);
+
+    return success();
+  }
+};
+
+// Retains the chosen operand into the `local_refs` slot of the result.
+class SelectRefOpConversion
+    : public OpConversionPattern<IREE::VM::SelectRefOp> {
+ public:
+  SelectRefOpConversion(MLIRContext *context,
+                        IREE::VM::LocalRefSlots &localRefSlots)
+      : OpConversionPattern<IREE::VM::SelectRefOp>(context),
+        localRefSlots(localRefSlots) {}
+
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::SelectRefOp selectOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto loc = selectOp.getLoc();
+
+    Value refPtr =
+        localRefSlotAddress(rewriter, loc, selectOp.getResult(), localRefSlots);
+    if (!refPtr) {
+      return selectOp.emitOpError() << "result has no local ref slot";
+    }
+
+    SmallVector<Value, 4> updatedOperands(operands.begin(), operands.end());
+    updatedOperands.push_back(refPtr);
+    rewriter.create<emitc::CallOp>(
+        /*location=*/loc,
+        /*type=*/TypeRange{},
+        /*callee=*/rewriter.getStringAttr("vm_select_ref"),
+        /*args=*/ArrayAttr{},
+        /*templateArgs=*/ArrayAttr{},
+        /*operands=*/ArrayRef<Value>(updatedOperands));
+
+    rewriter.replaceOp(selectOp, refPtr);
+    return success();
+  }
+
+  IREE::VM::LocalRefSlots &localRefSlots;
+};
+
 // Convert vm list operations to two emitc calls. The wrapping ref pointer is
 // first dereferenced and the result is used as the argument of the specified
 // function name.
@@ -274,38 +472,14 @@ class ListOpConversion : public OpConversionPattern<SrcOpTy> {
     }
 
     Value listOperand = op.getOperation()->getOperand(listArgumentIndex);
-
-    // deref
-    auto refOp = rewriter.create<emitc::ApplyOp>(
-        /*location=*/loc,
-        /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_ref_t"),
-        /*applicableOperator=*/rewriter.getStringAttr("*"),
-        /*operand=*/listOperand);
-
-    auto listDerefOp = rewriter.create<emitc::CallOp>(
-        /*location=*/loc,
-        /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_list_t*"),
-        /*callee=*/rewriter.getStringAttr("iree_vm_list_deref"),
-        /*args=*/ArrayAttr{},
-        /*templateArgs=*/ArrayAttr{},
-        /*operands=*/ArrayRef<Value>{refOp.getResult()});
-
-    rewriter.create<emitc::CallOp>(
-        /*location=*/loc,
-        /*type=*/TypeRange{},
-        /*callee=*/rewriter.getStringAttr("VM_RETURN_IF_LIST_NULL"),
-        /*args=*/
-        ArrayAttr::get(ctx, {rewriter.getIndexAttr(0),
-                             StringAttr::get(ctx, "local_refs")}),
-        /*templateArgs=*/ArrayAttr{},
-        /*operands=*/ArrayRef<Value>{listDerefOp.getResult(0)});
+    Value list = derefList(rewriter, loc, listOperand);
 
     // Replace the one list argument (which is wrapped in a ref) with the
     // unwrapped list.
     SmallVector<Value, 4> updatedOperands;
     for (auto &operand : llvm::enumerate(operands)) {
       if (operand.index() == listArgumentIndex) {
-        updatedOperands.push_back(listDerefOp.getResult(0));
+        updatedOperands.push_back(list);
       } else {
         updatedOperands.push_back(operand.value());
       }
@@ -345,7 +519,11 @@ class ListOpConversion : public OpConversionPattern<SrcOpTy> {
 
 class ListAllocOpConversion
     : public OpConversionPattern<IREE::VM::ListAllocOp> {
-  using OpConversionPattern<IREE::VM::ListAllocOp>::OpConversionPattern;
+ public:
+  ListAllocOpConversion(MLIRContext *context,
+                        IREE::VM::LocalRefSlots &localRefSlots)
+      : OpConversionPattern<IREE::VM::ListAllocOp>(context),
+        localRefSlots(localRefSlots) {}
 
  private:
   LogicalResult matchAndRewrite(
@@ -380,6 +558,23 @@ class ListAllocOpConversion
       elementTypeStr =
           std::string("IREE_VM_VALUE_TYPE_I") + std::to_string(bitWidth);
       elementTypeConstructor = "iree_vm_type_def_make_value_type";
+    } else if (elementType.isF32()) {
+      elementTypeStr = "IREE_VM_VALUE_TYPE_F32";
+      elementTypeConstructor = "iree_vm_type_def_make_value_type";
+    } else if (elementType.isa<IREE::VM::OpaqueType>()) {
+      elementTypeConstructor = "iree_vm_type_def_make_variant_type";
+    } else if (auto refType = elementType.dyn_cast<IREE::VM::RefType>()) {
+      auto objectType = refType.getObjectType();
+      if (objectType.isa<IREE::VM::ListType>()) {
+        elementTypeStr = "iree_vm_list_type_id()";
+      } else if (objectType.isa<IREE::VM::BufferType>()) {
+        elementTypeStr = "iree_vm_buffer_type_id()";
+      } else if (objectType.isa<IREE::VM::OpaqueType>()) {
+        elementTypeStr = "IREE_VM_REF_TYPE_ANY";
+      } else {
+        return allocOp.emitError() << "Unhandeled element type " << elementType;
+      }
+      elementTypeConstructor = "iree_vm_type_def_make_ref_type";
     } else {
       return allocOp.emitError() << "Unhandeled element type " << elementType;
     }
@@ -388,7 +583,10 @@ class ListAllocOpConversion
         /*location=*/loc,
         /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_type_def_t"),
         /*callee=*/rewriter.getStringAttr(elementTypeConstructor),
-        /*args=*/ArrayAttr::get(ctx, {StringAttr::get(ctx, elementTypeStr)}),
+        /*args=*/
+        elementTypeStr.empty()
+            ? ArrayAttr::get(ctx, {})
+            : ArrayAttr::get(ctx, {StringAttr::get(ctx, elementTypeStr)}),
         /*templateArgs=*/ArrayAttr{},
         /*operands=*/ArrayRef<Value>{});
 
@@ -422,30 +620,12 @@ class ListAllocOpConversion
         ArrayRef<Value>{elementTypePtrOp.getResult(), operands[0],
                         listPtrOp.getResult()});
 
-    // TODO(simon-camp): This is expensive as we recalculate the
-    // RegisterAllocation for every alloc in a function. We could make it
-    // compatible with the analysis framework in MLIR which would cache it
-    // automatically IIUC. See here for reference
-    // https://mlir.llvm.org/docs/PassManagement/#analysis-management
-    auto funcOp = allocOp.getOperation()->getParentOfType<IREE::VM::FuncOp>();
-    RegisterAllocation registerAllocation;
-    if (failed(registerAllocation.recalculate(funcOp))) {
-      return allocOp.emitOpError() << "unable to perform register allocation";
+    Value refPtr =
+        localRefSlotAddress(rewriter, loc, allocOp.getResult(), localRefSlots);
+    if (!refPtr) {
+      return allocOp.emitOpError() << "result has no local ref slot";
     }
 
-    int32_t ordinal =
-        registerAllocation.mapToRegister(allocOp.getResult()).ordinal();
-
-    auto refPtrOp = rewriter.replaceOpWithNewOp<emitc::CallOp>(
-        /*op=*/allocOp,
-        /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_ref_t*"),
-        /*callee=*/rewriter.getStringAttr("VM_ARRAY_ELEMENT_ADDRESS"),
-        /*args=*/
-        ArrayAttr::get(ctx, {StringAttr::get(ctx, "local_refs"),
-                             rewriter.getI32IntegerAttr(ordinal)}),
-        /*templateArgs=*/ArrayAttr{},
-        /*operands=*/ArrayRef<Value>{});
-
     auto refTypeOp = rewriter.create<emitc::CallOp>(
         /*location=*/loc,
         /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_ref_type_t"),
@@ -461,11 +641,13 @@ class ListAllocOpConversion
         /*args=*/ArrayAttr{},
         /*templateArgs=*/ArrayAttr{},
         /*operands=*/
-        ArrayRef<Value>{listOp.getResult(), refTypeOp.getResult(0),
-                        refPtrOp.getResult(0)});
+        ArrayRef<Value>{listOp.getResult(), refTypeOp.getResult(0), refPtr});
 
+    rewriter.replaceOp(allocOp, refPtr);
     return success();
   }
+
+  IREE::VM::LocalRefSlots &localRefSlots;
 };
 
 template <typename GetOpTy>
@@ -494,6 +676,10 @@ class ListGetOpConversion : public OpConversionPattern<GetOpTy> {
               return std::make_pair(StringRef("IREE_VM_VALUE_TYPE_I64"),
                                     StringRef("iree_vm_value_get_i64"));
             })
+            .template Case<IREE::VM::ListGetF32Op>([&](auto op) {
+              return std::make_pair(StringRef("IREE_VM_VALUE_TYPE_F32"),
+                                    StringRef("iree_vm_value_get_f32"));
+            })
             .Default([](Operation *) { return std::make_pair(None, None); });
 
     if (!valueTypeEnum.hasValue() || !valueExtractor.hasValue()) {
@@ -511,29 +697,7 @@ class ListGetOpConversion : public OpConversionPattern<GetOpTy> {
         /*applicableOperator=*/rewriter.getStringAttr("&"),
         /*operand=*/valueOp.getResult());
 
-    auto refOp = rewriter.create<emitc::ApplyOp>(
-        /*location=*/loc,
-        /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_ref_t"),
-        /*applicableOperator=*/rewriter.getStringAttr("*"),
-        /*operand=*/getOp.list());
-
-    auto listDerefOp = rewriter.create<emitc::CallOp>(
-        /*location=*/loc,
-        /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_list_t*"),
-        /*callee=*/rewriter.getStringAttr("iree_vm_list_deref"),
-        /*args=*/ArrayAttr{},
-        /*templateArgs=*/ArrayAttr{},
-        /*operands=*/ArrayRef<Value>{refOp.getResult()});
-
-    rewriter.create<emitc::CallOp>(
-        /*location=*/loc,
-        /*type=*/TypeRange{},
-        /*callee=*/rewriter.getStringAttr("VM_RETURN_IF_LIST_NULL"),
-        /*args=*/
-        ArrayAttr::get(ctx, {rewriter.getIndexAttr(0),
-                             StringAttr::get(ctx, "local_refs")}),
-        /*templateArgs=*/ArrayAttr{},
-        /*operands=*/ArrayRef<Value>{listDerefOp.getResult(0)});
+    Value list = derefList(rewriter, loc, getOp.list());
 
     auto getValueOp = failableCall(
         /*rewriter=*/rewriter,
@@ -545,8 +709,7 @@ class ListGetOpConversion : public OpConversionPattern<GetOpTy> {
                              rewriter.getIndexAttr(2)}),
         /*templateArgs=*/ArrayAttr{},
         /*operands=*/
-        ArrayRef<Value>{listDerefOp.getResult(0), getOp.index(),
-                        valuePtrOp.getResult()});
+        ArrayRef<Value>{list, getOp.index(), valuePtrOp.getResult()});
 
     rewriter.replaceOpWithNewOp<emitc::CallOp>(
         /*op=*/getOp,
@@ -577,6 +740,8 @@ class ListSetOpConversion : public OpConversionPattern<SetOpTy> {
                 [&](auto op) { return StringRef("iree_vm_value_make_i32"); })
             .template Case<IREE::VM::ListSetI64Op>(
                 [&](auto op) { return StringRef("iree_vm_value_make_i64"); })
+            .template Case<IREE::VM::ListSetF32Op>(
+                [&](auto op) { return StringRef("iree_vm_value_make_f32"); })
             .Default([](Operation *) { return None; });
 
     if (!valueConstructor.hasValue()) {
@@ -597,49 +762,186 @@ class ListSetOpConversion : public OpConversionPattern<SetOpTy> {
         /*applicableOperator=*/rewriter.getStringAttr("&"),
         /*operand=*/valueOp.getResult(0));
 
-    auto refOp = rewriter.create<emitc::ApplyOp>(
-        /*location=*/loc,
-        /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_ref_t"),
-        /*applicableOperator=*/rewriter.getStringAttr("*"),
-        /*operand=*/setOp.list());
+    Value list = derefList(rewriter, loc, setOp.list());
 
-    auto listDerefOp = rewriter.create<emitc::CallOp>(
-        /*location=*/loc,
-        /*type=*/emitc::OpaqueType::get(ctx, "iree_vm_list_t*"),
-        /*callee=*/rewriter.getStringAttr("iree_vm_list_deref"),
+    auto callOp = failableCall(
+        /*rewriter=*/rewriter,
+        /*loc=*/loc,
+        /*callee=*/rewriter.getStringAttr("iree_vm_list_set_value"),
         /*args=*/ArrayAttr{},
         /*templateArgs=*/ArrayAttr{},
-        /*operands=*/ArrayRef<Value>{refOp.getResult()});
+        /*operands=*/
+        ArrayRef<Value>{list, setOp.index(), valuePtrOp.getResult()});
 
-    rewriter.create<emitc::CallOp>(
+    rewriter.replaceOp(setOp, ArrayRef<Value>{});
+
+    return success();
+  }
+};
+
+// Retains the element into the `local_refs` slot of the result.
+class ListGetRefOpConversion
+    : public OpConversionPattern<IREE::VM::ListGetRefOp> {
+ public:
+  ListGetRefOpConversion(MLIRContext *context,
+                         IREE::VM::LocalRefSlots &localRefSlots)
+      : OpConversionPattern<IREE::VM::ListGetRefOp>(context),
+        localRefSlots(localRefSlots) {}
+
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::ListGetRefOp getOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto loc = getOp.getLoc();
+
+    Value refPtr =
+        localRefSlotAddress(rewriter, loc, getOp.getResult(), localRefSlots);
+    if (!refPtr) return getOp.emitOpError() << "result has no local ref slot";
+
+    Value list = derefList(rewriter, loc, getOp.list());
+
+    failableCall(
+        /*rewriter=*/rewriter,
         /*location=*/loc,
-        /*type=*/TypeRange{},
-        /*callee=*/rewriter.getStringAttr("VM_RETURN_IF_LIST_NULL"),
-        /*args=*/
-        ArrayAttr::get(ctx, {rewriter.getIndexAttr(0),
-                             StringAttr::get(ctx, "local_refs")}),
+        /*callee=*/rewriter.getStringAttr("iree_vm_list_get_ref_retain"),
+        /*args=*/ArrayAttr{},
         /*templateArgs=*/ArrayAttr{},
-        /*operands=*/ArrayRef<Value>{listDerefOp.getResult(0)});
+        /*operands=*/ArrayRef<Value>{list, getOp.index(), refPtr});
 
-    auto callOp = failableCall(
+    rewriter.replaceOp(getOp, refPtr);
+    return success();
+  }
+
+  IREE::VM::LocalRefSlots &localRefSlots;
+};
+
+class ListSetRefOpConversion
+    : public OpConversionPattern<IREE::VM::ListSetRefOp> {
+  using OpConversionPattern<IREE::VM::ListSetRefOp>::OpConversionPattern;
+
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::ListSetRefOp setOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto loc = setOp.getLoc();
+
+    Value list = derefList(rewriter, loc, setOp.list());
+
+    failableCall(
         /*rewriter=*/rewriter,
-        /*loc=*/loc,
-        /*callee=*/rewriter.getStringAttr("iree_vm_list_set_value"),
+        /*location=*/loc,
+        /*callee=*/rewriter.getStringAttr("iree_vm_list_set_ref_retain"),
         /*args=*/ArrayAttr{},
         /*templateArgs=*/ArrayAttr{},
-        /*operands=*/
-        ArrayRef<Value>{listDerefOp.getResult(0), setOp.index(),
-                        valuePtrOp.getResult()});
+        /*operands=*/ArrayRef<Value>{list, setOp.index(), setOp.value()});
 
     rewriter.replaceOp(setOp, ArrayRef<Value>{});
+    return success();
+  }
+};
+
+// Converts vm.call to a call of the C function generated for the callee:
+// the `_impl` function of an internal vm.func or the marshaling function of a
+// vm.import. Both take the stack first and the module state last:
+//   iree_status_t fn(iree_vm_stack_t* stack, <args>, <result pointers>,
+//                    <module>_state_t* state)
+// Primitive results are returned through pointers to local variables and ref
+// results are retained into the `local_refs` slots of the results.
+class VMCallOpConversion : public OpConversionPattern<IREE::VM::CallOp> {
+ public:
+  VMCallOpConversion(MLIRContext *context,
+                     IREE::VM::LocalRefSlots &localRefSlots)
+      : OpConversionPattern<IREE::VM::CallOp>(context),
+        localRefSlots(localRefSlots) {}
+
+ private:
+  LogicalResult matchAndRewrite(
+      IREE::VM::CallOp callOp, ArrayRef<Value> operands,
+      ConversionPatternRewriter &rewriter) const override {
+    auto ctx = callOp.getContext();
+    auto loc = callOp.getLoc();
+
+    auto moduleOp =
+        callOp.getOperation()->getParentOfType<IREE::VM::ModuleOp>();
+    Operation *calleeOp = moduleOp.lookupSymbol(callOp.callee());
+
+    std::string calleeName;
+    if (auto funcOp = dyn_cast_or_null<IREE::VM::FuncOp>(calleeOp)) {
+      calleeName =
+          IREE::VM::buildFunctionName(moduleOp, funcOp, /*implSuffix=*/true);
+    } else if (auto importOp = dyn_cast_or_null<IREE::VM::ImportOp>(calleeOp)) {
+      if (importOp.isVariadic()) {
+        return callOp.emitOpError() << "variadic imports not supported";
+      }
+      calleeName = IREE::VM::buildImportFunctionName(moduleOp, importOp);
+    } else {
+      return callOp.emitOpError() << "unable to find callee";
+    }
+
+    SmallVector<Value, 4> updatedOperands(operands.begin(), operands.end());
+    SmallVector<Value, 4> results;
+    for (Value result : callOp.getResults()) {
+      Type type = result.getType();
+      if (type.isa<IREE::VM::RefType>()) {
+        Value refPtr = localRefSlotAddress(rewriter, loc, result, localRefSlots);
+        if (!refPtr) {
+          return callOp.emitOpError() << "result has no local ref slot";
+        }
+        updatedOperands.push_back(refPtr);
+        results.push_back(refPtr);
+        continue;
+      }
+
+      Optional<StringRef> cType = getCType(type);
+      if (!cType.hasValue()) {
+        return callOp.emitOpError() << "result type " << type
+                                    << " not handled";
+      }
+      Attribute zero = type.isa<FloatType>()
+                           ? rewriter.getFloatAttr(type, 0.0).cast<Attribute>()
+                           : rewriter.getIntegerAttr(type, 0).cast<Attribute>();
+      auto resultOp = rewriter.create<emitc::ConstOp>(
+          /*location=*/loc,
+          /*resultType=*/type,
+          /*value=*/zero);
+      auto resultPtrOp = rewriter.create<emitc::ApplyOp>(
+          /*location=*/loc,
+          /*result=*/
+          emitc::OpaqueType::get(ctx, (cType.getValue() + "*").str()),
+          /*applicableOperator=*/rewriter.getStringAttr("&"),
+          /*operand=*/resultOp.getResult());
+      updatedOperands.push_back(resultPtrOp.getResult());
+      results.push_back(resultOp.getResult());
+    }
 
+    // TODO(simon-camp): We can't represent structs in emitc (yet maybe), so
+    // the stack and state argument names are hardcoded here.
+    SmallVector<Attribute, 4> args;
+    args.push_back(StringAttr::get(ctx, "stack"));
+    for (size_t i = 0; i < updatedOperands.size(); ++i) {
+      args.push_back(rewriter.getIndexAttr(i));
+    }
+    args.push_back(StringAttr::get(ctx, "state"));
+
+    failableCall(
+        /*rewriter=*/rewriter,
+        /*location=*/loc,
+        /*callee=*/rewriter.getStringAttr(calleeName),
+        /*args=*/ArrayAttr::get(ctx, args),
+        /*templateArgs=*/ArrayAttr{},
+        /*operands=*/ArrayRef<Value>(updatedOperands));
+
+    rewriter.replaceOp(callOp, results);
     return success();
   }
+
+  IREE::VM::LocalRefSlots &localRefSlots;
 };
 }  // namespace
 
 void populateVMToCPatterns(MLIRContext *context,
-                           OwningRewritePatternList &patterns) {
+                           OwningRewritePatternList &patterns,
+                           IREE::VM::LocalRefSlots &localRefSlots) {
   // Globals
   patterns.insert<
       GlobalLoadOpConversion<IREE::VM::GlobalLoadI32Op, IREE::VM::GlobalI32Op>>(
@@ -647,14 +949,16 @@ void populateVMToCPatterns(MLIRContext *context,
   patterns.insert<GlobalStoreOpConversion<IREE::VM::GlobalStoreI32Op,
                                           IREE::VM::GlobalI32Op>>(
       context, "vm_global_store_i32");
+  patterns.insert<GlobalLoadRefOpConversion>(context, localRefSlots);
+  patterns.insert<GlobalStoreRefOpConversion>(context);
 
   // Constants
   patterns.insert<ConstOpConversion<IREE::VM::ConstI32Op>>(context);
   patterns.insert<ConstZeroOpConversion<IREE::VM::ConstI32ZeroOp>>(context);
-  patterns.insert<ConstRefZeroOpConversion>(context);
+  patterns.insert<ConstRefZeroOpConversion>(context, localRefSlots);
 
   // List ops
-  patterns.insert<ListAllocOpConversion>(context);
+  patterns.insert<ListAllocOpConversion>(context, localRefSlots);
   patterns.insert<ListOpConversion<IREE::VM::ListReserveOp>>(
       context, "iree_vm_list_reserve", 0, true);
   patterns.insert<ListOpConversion<IREE::VM::ListResizeOp>>(
@@ -663,10 +967,13 @@ void populateVMToCPatterns(MLIRContext *context,
       context, "iree_vm_list_size", 0, false);
   patterns.insert<ListGetOpConversion<IREE::VM::ListGetI32Op>>(context);
   patterns.insert<ListSetOpConversion<IREE::VM::ListSetI32Op>>(context);
+  patterns.insert<ListGetRefOpConversion>(context, localRefSlots);
+  patterns.insert<ListSetRefOpConversion>(context);
 
   // Conditional assignment ops
   patterns.insert<CallOpConversion<IREE::VM::SelectI32Op>>(context,
                                                            "vm_select_i32");
+  patterns.insert<SelectRefOpConversion>(context, localRefSlots);
 
   // Native integer arithmetic ops
   patterns.insert<CallOpConversion<IREE::VM::AddI32Op>>(context, "vm_add_i32");
@@ -717,11 +1024,86 @@ void populateVMToCPatterns(MLIRContext *context,
                                                            "vm_cmp_lt_i32u");
   patterns.insert<CallOpConversion<IREE::VM::CmpNZI32Op>>(context,
                                                           "vm_cmp_nz_i32");
+  patterns.insert<CallOpConversion<IREE::VM::CmpEQRefOp>>(context,
+                                                          "vm_cmp_eq_ref");
+  patterns.insert<CallOpConversion<IREE::VM::CmpNERefOp>>(context,
+                                                          "vm_cmp_ne_ref");
+  patterns.insert<CallOpConversion<IREE::VM::CmpNZRefOp>>(context,
+                                                          "vm_cmp_nz_ref");
+
+  // Control flow ops
+  patterns.insert<VMCallOpConversion>(context, localRefSlots);
+
+  // ExtF32: Globals
+  patterns.insert<
+      GlobalLoadOpConversion<IREE::VM::GlobalLoadF32Op, IREE::VM::GlobalF32Op>>(
+      context, "vm_global_load_f32");
+  patterns.insert<GlobalStoreOpConversion<IREE::VM::GlobalStoreF32Op,
+                                          IREE::VM::GlobalF32Op>>(
+      context, "vm_global_store_f32");
 
   // ExtF32: Native floating-point constants
   patterns.insert<ConstOpConversion<IREE::VM::ConstF32Op>>(context);
   patterns.insert<ConstZeroOpConversion<IREE::VM::ConstF32ZeroOp>>(context);
 
+  // ExtF32: List ops
+  patterns.insert<ListGetOpConversion<IREE::VM::ListGetF32Op>>(context);
+  patterns.insert<ListSetOpConversion<IREE::VM::ListSetF32Op>>(context);
+
+  // ExtF32: Conditional assignment ops
+  patterns.insert<CallOpConversion<IREE::VM::SelectF32Op>>(context,
+                                                           "vm_select_f32");
+
+  // ExtF32: Native floating-point arithmetic ops
+  patterns.insert<CallOpConversion<IREE::VM::AddF32Op>>(context, "vm_add_f32");
+  patterns.insert<CallOpConversion<IREE::VM::SubF32Op>>(context, "vm_sub_f32");
+  patterns.insert<CallOpConversion<IREE::VM::MulF32Op>>(context, "vm_mul_f32");
+  patterns.insert<CallOpConversion<IREE::VM::DivF32Op>>(context, "vm_div_f32");
+  patterns.insert<CallOpConversion<IREE::VM::RemF32Op>>(context, "vm_rem_f32");
+  patterns.insert<CallOpConversion<IREE::VM::AbsF32Op>>(context, "vm_abs_f32");
+  patterns.insert<CallOpConversion<IREE::VM::NegF32Op>>(context, "vm_neg_f32");
+  patterns.insert<CallOpConversion<IREE::VM::CeilF32Op>>(context,
+                                                         "vm_ceil_f32");
+  patterns.insert<CallOpConversion<IREE::VM::FloorF32Op>>(context,
+                                                          "vm_floor_f32");
+
+  // ExtF32: Native floating-point math ops
+  patterns.insert<CallOpConversion<IREE::VM::AtanF32Op>>(context,
+                                                         "vm_atan_f32");
+  patterns.insert<CallOpConversion<IREE::VM::Atan2F32Op>>(context,
+                                                          "vm_atan2_f32");
+  patterns.insert<CallOpConversion<IREE::VM::CosF32Op>>(context, "vm_cos_f32");
+  patterns.insert<CallOpConversion<IREE::VM::SinF32Op>>(context, "vm_sin_f32");
+  patterns.insert<CallOpConversion<IREE::VM::ExpF32Op>>(context, "vm_exp_f32");
+  patterns.insert<CallOpConversion<IREE::VM::Exp2F32Op>>(context,
+                                                         "vm_exp2_f32");
+  patterns.insert<CallOpConversion<IREE::VM::ExpM1F32Op>>(context,
+                                                          "vm_expm1_f32");
+  patterns.insert<CallOpConversion<IREE::VM::LogF32Op>>(context, "vm_log_f32");
+  patterns.insert<CallOpConversion<IREE::VM::Log10F32Op>>(context,
+                                                          "vm_log10_f32");
+  patterns.insert<CallOpConversion<IREE::VM::Log1pF32Op>>(context,
+                                                          "vm_log1p_f32");
+  patterns.insert<CallOpConversion<IREE::VM::Log2F32Op>>(context,
+                                                         "vm_log2_f32");
+  patterns.insert<CallOpConversion<IREE::VM::PowF32Op>>(context, "vm_pow_f32");
+  patterns.insert<CallOpConversion<IREE::VM::RsqrtF32Op>>(context,
+                                                          "vm_rsqrt_f32");
+  patterns.insert<CallOpConversion<IREE::VM::SqrtF32Op>>(context,
+                                                         "vm_sqrt_f32");
+  patterns.insert<CallOpConversion<IREE::VM::TanhF32Op>>(context,
+                                                         "vm_tanh_f32");
+
+  // ExtF32: Casting and type conversion/emulation ops
+  patterns.insert<CallOpConversion<IREE::VM::CastSI32F32Op>>(context,
+                                                             "vm_cast_si32f32");
+  patterns.insert<CallOpConversion<IREE::VM::CastUI32F32Op>>(context,
+                                                             "vm_cast_ui32f32");
+  patterns.insert<CallOpConversion<IREE::VM::CastF32SI32Op>>(context,
+                                                             "vm_cast_f32si32");
+  patterns.insert<CallOpConversion<IREE::VM::CastF32UI32Op>>(context,
+                                                             "vm_cast_f32ui32");
+
   // ExtF32: Comparison ops
   patterns.insert<CallOpConversion<IREE::VM::CmpEQF32OOp>>(context,
                                                            "vm_cmp_eq_f32o");
@@ -742,6 +1124,14 @@ void populateVMToCPatterns(MLIRContext *context,
   patterns.insert<CallOpConversion<IREE::VM::CmpNaNF32Op>>(context,
                                                            "vm_cmp_nan_f32");
 
+  // ExtI64: Globals
+  patterns.insert<
+      GlobalLoadOpConversion<IREE::VM::GlobalLoadI64Op, IREE::VM::GlobalI64Op>>(
+      context, "vm_global_load_i64");
+  patterns.insert<GlobalStoreOpConversion<IREE::VM::GlobalStoreI64Op,
+                                          IREE::VM::GlobalI64Op>>(
+      context, "vm_global_store_i64");
+
   // ExtI64: Constants
   patterns.insert<ConstOpConversion<IREE::VM::ConstI64Op>>(context);
   patterns.insert<ConstZeroOpConversion<IREE::VM::ConstI64ZeroOp>>(context);
@@ -801,6 +1191,38 @@ void populateVMToCPatterns(MLIRContext *context,
 namespace IREE {
 namespace VM {
 
+void LocalRefSlots::recalculate(IREE::VM::FuncOp funcOp) {
+  int slotCount = 0;
+  funcOp.walk([&](Operation *op) {
+    for (Value result : op->getResults()) {
+      if (result.getType().isa<IREE::VM::RefType>()) {
+        slots[result] = slotCount++;
+      }
+    }
+  });
+  funcOp->setAttr(kLocalRefCountAttrName,
+                  Builder(funcOp.getContext()).getI32IntegerAttr(slotCount));
+}
+
+std::string buildFunctionName(IREE::VM::ModuleOp &moduleOp,
+                              IREE::VM::FuncOp &funcOp, bool implSuffix) {
+  std::string functionName =
+      std::string(moduleOp.getName()) + "_" + std::string(funcOp.getName());
+
+  return implSuffix ? functionName + "_impl" : functionName;
+}
+
+std::string buildImportFunctionName(IREE::VM::ModuleOp &moduleOp,
+                                    IREE::VM::ImportOp &importOp) {
+  // Import names are qualified with the name of the module they come from
+  // (`module.function`) so they need to be turned into C identifiers.
+  std::string importName = importOp.getName().str();
+  for (char &c : importName) {
+    if (!llvm::isAlnum(c)) c = '_';
+  }
+  return std::string(moduleOp.getName()) + "_call_" + importName;
+}
+
 namespace {
 
 // A pass converting IREE VM operations into the EmitC dialect.
@@ -814,8 +1236,14 @@ class ConvertVMToEmitCPass
   void runOnOperation() override {
     ConversionTarget target(getContext());
 
+    // Assign the `local_refs` slots before any op is rewritten.
+    LocalRefSlots localRefSlots;
+    for (auto funcOp : getOperation().getOps<IREE::VM::FuncOp>()) {
+      localRefSlots.recalculate(funcOp);
+    }
+
     OwningRewritePatternList patterns(&getContext());
-    populateVMToCPatterns(&getContext(), patterns);
+    populateVMToCPatterns(&getContext(), patterns, localRefSlots);
 
     target.addLegalDialect<mlir::emitc::EmitCDialect>();
     target.addLegalDialect<iree_compiler::IREEDialect>();
@@ -826,11 +1254,14 @@ class ConvertVMToEmitCPass
     target.addLegalOp<IREE::VM::ModuleTerminatorOp>();
     target.addLegalOp<IREE::VM::FuncOp>();
     target.addLegalOp<IREE::VM::GlobalI32Op>();
+    target.addLegalOp<IREE::VM::GlobalI64Op>();
+    target.addLegalOp<IREE::VM::GlobalF32Op>();
+    target.addLegalOp<IREE::VM::GlobalRefOp>();
     target.addLegalOp<IREE::VM::ExportOp>();
+    target.addLegalOp<IREE::VM::ImportOp>();
 
     // Control flow ops
     target.addLegalOp<IREE::VM::BranchOp>();
-    target.addLegalOp<IREE::VM::CallOp>();
     target.addLegalOp<IREE::VM::CondBranchOp>();
     // Note: We translate the fail op to two function calls in the
     // end, but we can't simply convert it here because it is a
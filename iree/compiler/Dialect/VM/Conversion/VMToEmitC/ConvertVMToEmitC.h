@@ -16,13 +16,60 @@
 #define IREE_COMPILER_DIALECT_VM_CONVERSION_VMTOEMITC_CONVERTVMTOEMITC_H_
 
 #include "iree/compiler/Dialect/VM/IR/VMOps.h"
+#include "llvm/ADT/DenseMap.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
 namespace iree_compiler {
+namespace IREE {
+namespace VM {
+
+// Name of the vm.func attribute holding the number of `local_refs` slots the
+// conversion assigned to ref values defined by ops within the function.
+// Slots for ref-typed block arguments are appended after these by the C
+// module target.
+constexpr const char kLocalRefCountAttrName[] = "vm.emitc.local_ref_count";
+
+// Assigns every ref value defined by an op within a vm.func its own slot in
+// the `local_refs` array of the generated C function. Ref values are then
+// represented as `iree_vm_ref_t*` pointers into that array.
+//
+// Unlike the bytecode RegisterAllocation slots are never reused: a slot keeps
+// its ref retained until it is overwritten or the function returns, which
+// avoids aliasing an op's operands with its results.
+class LocalRefSlots {
+ public:
+  // Assigns slots to all ref values defined by ops in |funcOp| and records the
+  // slot count on |funcOp| as kLocalRefCountAttrName.
+  void recalculate(IREE::VM::FuncOp funcOp);
+
+  // Returns the slot assigned to |value| or -1 if it was not assigned one.
+  int getSlot(Value value) const {
+    auto it = slots.find(value);
+    return it == slots.end() ? -1 : it->second;
+  }
+
+ private:
+  llvm::DenseMap<Value, int> slots;
+};
+
+// Returns the name of the C function generated for |funcOp|. The `_impl`
+// function holds the translated body while the plain name is the wrapper
+// referenced from the module descriptor.
+std::string buildFunctionName(IREE::VM::ModuleOp &moduleOp,
+                              IREE::VM::FuncOp &funcOp, bool implSuffix);
+
+// Returns the name of the C function marshaling calls to |importOp| through
+// the VM calling convention.
+std::string buildImportFunctionName(IREE::VM::ModuleOp &moduleOp,
+                                    IREE::VM::ImportOp &importOp);
+
+}  // namespace VM
+}  // namespace IREE
 
 void populateVMToCPatterns(MLIRContext *context,
-                           OwningRewritePatternList &patterns);
+                           OwningRewritePatternList &patterns,
+                           IREE::VM::LocalRefSlots &localRefSlots);
 
 namespace IREE {
 namespace VM {
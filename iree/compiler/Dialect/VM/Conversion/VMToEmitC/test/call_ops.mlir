@@ -0,0 +1,34 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='vm.module(iree-convert-vm-to-emitc)' %s | IreeFileCheck %s
+
+vm.module @my_module {
+  vm.func @callee(%arg0 : i32, %arg1 : !vm.ref<?>) -> (i32, !vm.ref<?>) {
+    vm.return %arg0, %arg1 : i32, !vm.ref<?>
+  }
+
+  // CHECK-LABEL: vm.func @call_internal
+  vm.func @call_internal(%arg0 : i32, %arg1 : !vm.ref<?>) -> (i32, !vm.ref<?>) {
+    // CHECK: %[[REF:.+]] = emitc.call "VM_ARRAY_ELEMENT_ADDRESS"() {args = ["local_refs", 0 : i32]} : () -> !vm.ref<?>
+    // CHECK-NEXT: %[[RES:.+]] = "emitc.const"() {value = 0 : i32} : () -> i32
+    // CHECK-NEXT: %[[RES_PTR:.+]] = emitc.apply "&"(%[[RES]]) : (i32) -> !emitc.opaque<"int32_t*">
+    // CHECK-NEXT: %[[STATUS:.+]] = emitc.call "my_module_callee_impl"(%arg0, %arg1, %[[RES_PTR]], %[[REF]]) {args = ["stack", 0 : index, 1 : index, 2 : index, 3 : index, "state"]}
+    // CHECK-NEXT: emitc.call "VM_RETURN_IF_ERROR"(%[[STATUS]]) {args = [0 : index, "local_refs"]}
+    %0:2 = vm.call @callee(%arg0, %arg1) : (i32, !vm.ref<?>) -> (i32, !vm.ref<?>)
+    // CHECK-NEXT: vm.return %[[RES]], %[[REF]] : i32, !vm.ref<?>
+    vm.return %0#0, %0#1 : i32, !vm.ref<?>
+  }
+}
+
+// -----
+
+vm.module @my_module {
+  vm.import @other_module.fn(%arg0 : f32) -> f32
+
+  // CHECK-LABEL: vm.func @call_import
+  vm.func @call_import(%arg0 : f32) -> f32 {
+    // CHECK: %[[RES:.+]] = "emitc.const"() {value = 0.000000e+00 : f32} : () -> f32
+    // CHECK-NEXT: %[[RES_PTR:.+]] = emitc.apply "&"(%[[RES]]) : (f32) -> !emitc.opaque<"float*">
+    // CHECK-NEXT: %[[STATUS:.+]] = emitc.call "my_module_call_other_module_fn"(%arg0, %[[RES_PTR]]) {args = ["stack", 0 : index, 1 : index, "state"]}
+    %0 = vm.call @other_module.fn(%arg0) : (f32) -> f32
+    vm.return %0 : f32
+  }
+}
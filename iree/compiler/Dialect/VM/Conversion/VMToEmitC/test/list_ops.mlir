@@ -0,0 +1,40 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='vm.module(iree-convert-vm-to-emitc)' %s | IreeFileCheck %s
+
+vm.module @my_module {
+  // CHECK-LABEL: vm.func @list_get_set_ref
+  vm.func @list_get_set_ref(%arg0 : !vm.list<!vm.ref<?>>, %arg1 : i32, %arg2 : !vm.ref<?>) -> !vm.ref<?> {
+    // CHECK: %[[DEREF:.+]] = emitc.apply "*"(%arg0) : (!vm.list<!vm.ref<?>>) -> !emitc.opaque<"iree_vm_ref_t">
+    // CHECK-NEXT: %[[LIST:.+]] = emitc.call "iree_vm_list_deref"(%[[DEREF]]) : (!emitc.opaque<"iree_vm_ref_t">) -> !emitc.opaque<"iree_vm_list_t*">
+    // CHECK-NEXT: emitc.call "VM_RETURN_IF_LIST_NULL"(%[[LIST]]) {args = [0 : index, "local_refs"]}
+    // CHECK-NEXT: %[[STATUS:.+]] = emitc.call "iree_vm_list_set_ref_retain"(%[[LIST]], %arg1, %arg2)
+    vm.list.set.ref %arg0, %arg1, %arg2 : (!vm.list<!vm.ref<?>>, i32, !vm.ref<?>)
+    // CHECK: %[[REF:.+]] = emitc.call "VM_ARRAY_ELEMENT_ADDRESS"() {args = ["local_refs", 0 : i32]} : () -> !vm.ref<?>
+    // CHECK: emitc.call "iree_vm_list_get_ref_retain"(%{{.+}}, %arg1, %[[REF]])
+    %0 = vm.list.get.ref %arg0, %arg1 : (!vm.list<!vm.ref<?>>, i32) -> !vm.ref<?>
+    vm.return %0 : !vm.ref<?>
+  }
+}
+
+// -----
+
+vm.module @my_module {
+  // CHECK-LABEL: vm.func @list_alloc_ref
+  vm.func @list_alloc_ref(%arg0 : i32) -> !vm.list<!vm.list<i32>> {
+    // CHECK: emitc.call "iree_vm_type_def_make_ref_type"() {args = ["iree_vm_list_type_id()"]}
+    %0 = vm.list.alloc %arg0 : (i32) -> !vm.list<!vm.list<i32>>
+    vm.return %0 : !vm.list<!vm.list<i32>>
+  }
+}
+
+// -----
+
+vm.module @my_module {
+  // CHECK-LABEL: vm.func @list_get_set_f32
+  vm.func @list_get_set_f32(%arg0 : !vm.list<f32>, %arg1 : i32, %arg2 : f32) -> f32 {
+    // CHECK: emitc.call "iree_vm_value_make_f32"(%arg2)
+    vm.list.set.f32 %arg0, %arg1, %arg2 : (!vm.list<f32>, i32, f32)
+    // CHECK: emitc.call "iree_vm_value_get_f32"
+    %0 = vm.list.get.f32 %arg0, %arg1 : (!vm.list<f32>, i32) -> f32
+    vm.return %0 : f32
+  }
+}
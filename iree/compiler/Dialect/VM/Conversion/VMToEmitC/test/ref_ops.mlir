@@ -0,0 +1,44 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='vm.module(iree-convert-vm-to-emitc)' %s | IreeFileCheck %s
+
+vm.module @my_module {
+  vm.global.ref @g0 mutable : !vm.ref<?>
+
+  // CHECK-LABEL: vm.func @global_ref
+  // CHECK-SAME: vm.emitc.local_ref_count = 1 : i32
+  vm.func @global_ref(%arg0 : !vm.ref<?>) -> !vm.ref<?> {
+    // CHECK: emitc.call "vm_global_store_ref"(%arg0) {args = ["state->refs", 0 : ui32, 0 : index]} : (!vm.ref<?>) -> ()
+    vm.global.store.ref %arg0, @g0 : !vm.ref<?>
+    // CHECK-NEXT: %[[REF:.+]] = emitc.call "VM_ARRAY_ELEMENT_ADDRESS"() {args = ["local_refs", 0 : i32]} : () -> !vm.ref<?>
+    // CHECK-NEXT: emitc.call "vm_global_load_ref"(%[[REF]]) {args = ["state->refs", 0 : ui32, 0 : index]} : (!vm.ref<?>) -> ()
+    %0 = vm.global.load.ref @g0 : !vm.ref<?>
+    // CHECK-NEXT: vm.return %[[REF]] : !vm.ref<?>
+    vm.return %0 : !vm.ref<?>
+  }
+}
+
+// -----
+
+vm.module @my_module {
+  // CHECK-LABEL: vm.func @select_ref
+  vm.func @select_ref(%arg0 : i32, %arg1 : !vm.ref<?>, %arg2 : !vm.ref<?>) -> !vm.ref<?> {
+    // CHECK: %[[REF:.+]] = emitc.call "VM_ARRAY_ELEMENT_ADDRESS"() {args = ["local_refs", 0 : i32]} : () -> !vm.ref<?>
+    // CHECK-NEXT: emitc.call "vm_select_ref"(%arg0, %arg1, %arg2, %[[REF]]) : (i32, !vm.ref<?>, !vm.ref<?>, !vm.ref<?>) -> ()
+    %0 = vm.select.ref %arg0, %arg1, %arg2 : !vm.ref<?>
+    vm.return %0 : !vm.ref<?>
+  }
+}
+
+// -----
+
+vm.module @my_module {
+  // CHECK-LABEL: vm.func @cmp_ref
+  vm.func @cmp_ref(%arg0 : !vm.ref<?>, %arg1 : !vm.ref<?>) -> (i32, i32, i32) {
+    // CHECK: %0 = emitc.call "vm_cmp_eq_ref"(%arg0, %arg1) : (!vm.ref<?>, !vm.ref<?>) -> i32
+    %0 = vm.cmp.eq.ref %arg0, %arg1 : !vm.ref<?>
+    // CHECK-NEXT: %1 = emitc.call "vm_cmp_ne_ref"(%arg0, %arg1) : (!vm.ref<?>, !vm.ref<?>) -> i32
+    %1 = vm.cmp.ne.ref %arg0, %arg1 : !vm.ref<?>
+    // CHECK-NEXT: %2 = emitc.call "vm_cmp_nz_ref"(%arg0) : (!vm.ref<?>) -> i32
+    %2 = vm.cmp.nz.ref %arg0 : !vm.ref<?>
+    vm.return %0, %1, %2 : i32, i32, i32
+  }
+}
@@ -14,10 +14,10 @@
 
 #include "iree/compiler/Dialect/VM/Target/C/CModuleTarget.h"
 
+#include "emitc/Dialect/EmitC/EmitCDialect.h"
 #include "emitc/Target/Cpp.h"
 #include "iree/compiler/Dialect/IREE/IR/IREEOps.h"
 #include "iree/compiler/Dialect/IREE/Transforms/Passes.h"
-#include "iree/compiler/Dialect/VM/Analysis/RegisterAllocation.h"
 #include "iree/compiler/Dialect/VM/Conversion/VMToEmitC/ConvertVMToEmitC.h"
 #include "iree/compiler/Dialect/VM/Target/CallingConventionUtils.h"
 #include "iree/compiler/Dialect/VM/Transforms/Passes.h"
@@ -29,15 +29,6 @@ namespace iree_compiler {
 namespace IREE {
 namespace VM {
 
-static std::string buildFunctionName(IREE::VM::ModuleOp &moduleOp,
-                                     IREE::VM::FuncOp &funcOp,
-                                     bool implSuffix) {
-  std::string functionName =
-      std::string(moduleOp.getName()) + "_" + std::string(funcOp.getName());
-
-  return implSuffix ? functionName + "_impl" : functionName;
-}
-
 static void printModuleComment(IREE::VM::ModuleOp &moduleOp,
                                llvm::raw_ostream &output) {
   output << "//" << std::string(77, '=') << "\n"
@@ -70,6 +61,10 @@ static LogicalResult printStructDefinitions(IREE::VM::ModuleOp &moduleOp,
          << moduleOp.ordinal_counts().getValue().global_bytes() << "];\n";
   output << "iree_vm_ref_t refs["
          << moduleOp.ordinal_counts().getValue().global_refs() << "];\n";
+  int importCount = moduleOp.ordinal_counts().getValue().import_funcs();
+  if (importCount > 0) {
+    output << "iree_vm_function_t imports[" << importCount << "];\n";
+  }
   output << "};\n";
 
   output << "typedef struct " << moduleName << "_s " << moduleName << "_t;\n";
@@ -91,11 +86,22 @@ static LogicalResult printShim(IREE::VM::FuncOp &funcOp,
   return success();
 }
 
+// Ref values are passed around as pointers to the `local_refs` slot (or
+// result storage) holding the ref.
+static LogicalResult printTypeOrRefPointer(Type type,
+                                           mlir::emitc::CppEmitter &emitter) {
+  if (type.isa<IREE::VM::RefType>()) {
+    emitter.ostream() << "iree_vm_ref_t*";
+    return success();
+  }
+  return emitter.emitType(type);
+}
+
 static LogicalResult printFuncOpArguments(IREE::VM::FuncOp &funcOp,
                                           mlir::emitc::CppEmitter &emitter) {
   return mlir::emitc::interleaveCommaWithError(
       funcOp.getArguments(), emitter.ostream(), [&](auto arg) -> LogicalResult {
-        if (failed(emitter.emitType(arg.getType()))) {
+        if (failed(printTypeOrRefPointer(arg.getType(), emitter))) {
           return failure();
         }
         emitter.ostream() << " " << emitter.getOrCreateName(arg);
@@ -106,14 +112,16 @@ static LogicalResult printFuncOpArguments(IREE::VM::FuncOp &funcOp,
 // Function results get propagated through pointer arguments
 static LogicalResult printFuncOpResults(
     IREE::VM::FuncOp &funcOp, mlir::emitc::CppEmitter &emitter,
-    SmallVector<std::string, 4> &resultNames) {
+    ArrayRef<std::string> resultNames) {
   return mlir::emitc::interleaveCommaWithError(
       llvm::zip(funcOp.getType().getResults(), resultNames), emitter.ostream(),
       [&](std::tuple<Type, std::string> tuple) -> LogicalResult {
         Type type = std::get<0>(tuple);
         std::string resultName = std::get<1>(tuple);
 
-        if (failed(emitter.emitType(type))) {
+        if (type.isa<IREE::VM::RefType>()) {
+          emitter.ostream() << "iree_vm_ref_t";
+        } else if (failed(emitter.emitType(type))) {
           return failure();
         }
         emitter.ostream() << " *" << resultName;
@@ -121,17 +129,17 @@ static LogicalResult printFuncOpResults(
       });
 }
 
-static LogicalResult initializeGlobals(IREE::VM::ModuleOp moduleOp,
-                                       mlir::emitc::CppEmitter &emitter) {
-  llvm::raw_ostream &output = emitter.ostream();
-
-  for (auto globalOp : moduleOp.getOps<IREE::VM::GlobalI32Op>()) {
+template <typename GlobalOpTy>
+static LogicalResult initializePrimitiveGlobals(
+    IREE::VM::ModuleOp moduleOp, StringRef storeFuncName,
+    mlir::emitc::CppEmitter &emitter) {
+  for (auto globalOp : moduleOp.getOps<GlobalOpTy>()) {
     Optional<Attribute> initialValue = globalOp.initial_value();
     Optional<StringRef> initializer = globalOp.initializer();
     if (initialValue.hasValue()) {
       // TODO(simon-camp): We can't represent structs in emitc (yet maybe), so
       // the struct argument name here must not be changed.
-      emitter.ostream() << "vm_global_store_i32(state->rwdata, "
+      emitter.ostream() << storeFuncName << "(state->rwdata, "
                         << globalOp.ordinal() << ", ";
       if (failed(emitter.emitAttribute(initialValue.getValue()))) {
         return globalOp.emitError() << "Unable to emit initial_value";
@@ -142,79 +150,192 @@ static LogicalResult initializeGlobals(IREE::VM::ModuleOp moduleOp,
              << "Initializers for globals not supported yet";
     }
   }
+  return success();
+}
 
-  // TODO(simon-camp): Support vm.global.i64 and vm.global.ref
+static LogicalResult initializeGlobals(IREE::VM::ModuleOp moduleOp,
+                                       mlir::emitc::CppEmitter &emitter) {
+  if (failed(initializePrimitiveGlobals<IREE::VM::GlobalI32Op>(
+          moduleOp, "vm_global_store_i32", emitter)) ||
+      failed(initializePrimitiveGlobals<IREE::VM::GlobalI64Op>(
+          moduleOp, "vm_global_store_i64", emitter)) ||
+      failed(initializePrimitiveGlobals<IREE::VM::GlobalF32Op>(
+          moduleOp, "vm_global_store_f32", emitter))) {
+    return failure();
+  }
+
+  // Ref globals start out null as the state is zero initialized.
+  for (auto globalOp : moduleOp.getOps<IREE::VM::GlobalRefOp>()) {
+    if (globalOp.initializer().hasValue()) {
+      return globalOp.emitError()
+             << "Initializers for globals not supported yet";
+    }
+  }
 
   return success();
 }
 
-static LogicalResult translateBranchOp(IREE::VM::BranchOp branchOp,
-                                       mlir::emitc::CppEmitter &emitter) {
+static Optional<std::string> getCType(Type type) {
+  if (type.isInteger(32)) return std::string("int32_t");
+  if (type.isInteger(64)) return std::string("int64_t");
+  if (type.isF32()) return std::string("float");
+  if (type.isa<IREE::VM::RefType>()) return std::string("iree_vm_ref_t");
+  return None;
+}
+
+// Emits a function issuing calls to |importOp|. The arguments are packed into
+// the buffer layout of the VM calling convention (see iree/vm/module.h) and
+// the results unpacked after the call the same way the bytecode interpreter
+// does for its imports. The signature matches the `_impl` functions so that
+// vm.call lowers to both the same way.
+static LogicalResult printImportFunction(IREE::VM::ModuleOp &moduleOp,
+                                         IREE::VM::ImportOp &importOp,
+                                         llvm::raw_ostream &output) {
+  if (importOp.isVariadic()) {
+    return importOp.emitError() << "Variadic imports not supported yet";
+  }
+  std::string moduleName = moduleOp.getName().str();
+  FunctionType functionType = importOp.getType();
+
+  SmallVector<std::string, 4> argumentTypes;
+  for (Type type : functionType.getInputs()) {
+    Optional<std::string> cType = getCType(type);
+    if (!cType.hasValue()) {
+      return importOp.emitError() << "Unsupported argument type " << type;
+    }
+    argumentTypes.push_back(cType.getValue());
+  }
+  SmallVector<std::string, 4> resultTypes;
+  for (Type type : functionType.getResults()) {
+    Optional<std::string> cType = getCType(type);
+    if (!cType.hasValue()) {
+      return importOp.emitError() << "Unsupported result type " << type;
+    }
+    resultTypes.push_back(cType.getValue());
+  }
+
+  output << "static iree_status_t "
+         << buildImportFunctionName(moduleOp, importOp)
+         << "(iree_vm_stack_t* stack";
+  for (auto type : llvm::enumerate(argumentTypes)) {
+    output << ", " << type.value()
+           << (type.value() == "iree_vm_ref_t" ? "* arg" : " arg")
+           << type.index();
+  }
+  for (auto type : llvm::enumerate(resultTypes)) {
+    output << ", " << type.value() << " *res" << type.index();
+  }
+  output << ", " << moduleName << "_state_t* state) {\n";
+
+  output << "const iree_vm_function_t* import = &state->imports["
+         << importOp.ordinal().getValue().getZExtValue() << "];\n"
+         << "iree_vm_function_call_t call;\n"
+         << "memset(&call, 0, sizeof(call));\n"
+         << "call.function = *import;\n";
+
+  auto printStorage = [&](StringRef name, ArrayRef<std::string> types) {
+    if (types.empty()) return;
+    SmallVector<std::string, 4> sizes;
+    for (auto &type : types) sizes.push_back("sizeof(" + type + ")");
+    output << "uint8_t " << name << "[" << llvm::join(sizes, " + ") << "];\n"
+           << "memset(" << name << ", 0, sizeof(" << name << "));\n"
+           << "call." << name << " = iree_make_byte_span(" << name
+           << ", sizeof(" << name << "));\n"
+           << "uint8_t* " << name << "_ptr = " << name << ";\n";
+  };
+  printStorage("arguments", argumentTypes);
+  printStorage("results", resultTypes);
+
+  // Ref arguments are borrowed by the callee.
+  for (auto type : llvm::enumerate(argumentTypes)) {
+    if (type.value() == "iree_vm_ref_t") {
+      output << "iree_vm_ref_assign(arg" << type.index()
+             << ", (iree_vm_ref_t*)arguments_ptr);\n";
+    } else {
+      output << "memcpy(arguments_ptr, &arg" << type.index() << ", sizeof("
+             << type.value() << "));\n";
+    }
+    output << "arguments_ptr += sizeof(" << type.value() << ");\n";
+  }
+
+  output << "iree_vm_execution_result_t result;\n"
+         << "iree_status_t status = import->module->begin_call("
+            "import->module->self, stack, &call, &result);\n"
+         << "if (!iree_status_is_ok(status)) {\n"
+         << "return iree_status_annotate(status, "
+            "iree_make_cstring_view(\"while calling import\"));\n"
+         << "}\n";
+
+  // Ref results are owned by the results buffer and moved out of it.
+  for (auto type : llvm::enumerate(resultTypes)) {
+    if (type.value() == "iree_vm_ref_t") {
+      output << "iree_vm_ref_move((iree_vm_ref_t*)results_ptr, res"
+             << type.index() << ");\n";
+    } else {
+      output << "memcpy(res" << type.index() << ", results_ptr, sizeof("
+             << type.value() << "));\n";
+    }
+    output << "results_ptr += sizeof(" << type.value() << ");\n";
+  }
+
+  output << "return iree_ok_status();\n"
+         << "}\n";
+  return success();
+}
+
+// Assigns the successor operands of a branch to the block arguments. Ref
+// block arguments own their `local_refs` slot so the ref is retained into it.
+static LogicalResult printBlockArgumentAssignments(
+    Operation *op, OperandRange operands, Block &successor,
+    mlir::emitc::CppEmitter &emitter) {
   auto &output = emitter.ostream();
-  Block &successor = *branchOp.getSuccessor();
 
-  for (auto pair :
-       llvm::zip(branchOp.getOperands(), successor.getArguments())) {
-    auto &operand = std::get<0>(pair);
-    auto &argument = std::get<1>(pair);
-    output << emitter.getOrCreateName(argument) << " = "
-           << emitter.getOrCreateName(operand) << ";\n";
+  for (auto pair : llvm::zip(operands, successor.getArguments())) {
+    Value operand = std::get<0>(pair);
+    BlockArgument argument = std::get<1>(pair);
+    if (argument.getType().isa<IREE::VM::RefType>()) {
+      output << "vm_ref_retain(" << emitter.getOrCreateName(operand) << ", "
+             << emitter.getOrCreateName(argument) << ");\n";
+    } else {
+      output << emitter.getOrCreateName(argument) << " = "
+             << emitter.getOrCreateName(operand) << ";\n";
+    }
   }
 
   output << "goto ";
   if (!(emitter.hasBlockLabel(successor))) {
-    return branchOp.emitOpError() << "Unable to find label for successor block";
+    return op->emitOpError() << "Unable to find label for successor block";
   }
   output << emitter.getOrCreateName(successor) << ";\n";
   return success();
 }
 
-static LogicalResult translateCallOpToC(IREE::VM::CallOp callOp,
-                                        mlir::emitc::CppEmitter &emitter) {
-  return success();
+static LogicalResult translateBranchOp(IREE::VM::BranchOp branchOp,
+                                       mlir::emitc::CppEmitter &emitter) {
+  return printBlockArgumentAssignments(branchOp, branchOp.getOperands(),
+                                       *branchOp.getSuccessor(), emitter);
 }
 
 static LogicalResult translateCondBranchOp(IREE::VM::CondBranchOp condBranchOp,
                                            mlir::emitc::CppEmitter &emitter) {
   llvm::raw_ostream &output = emitter.ostream();
 
-  Block &trueSuccessor = *condBranchOp.getTrueDest();
-  Block &falseSuccessor = *condBranchOp.getFalseDest();
-
   output << "if (" << emitter.getOrCreateName(condBranchOp.getCondition())
          << ") {\n";
 
   // If condition is true.
-  for (auto pair : llvm::zip(condBranchOp.getTrueOperands(),
-                             trueSuccessor.getArguments())) {
-    auto &operand = std::get<0>(pair);
-    auto &argument = std::get<1>(pair);
-    output << emitter.getOrCreateName(argument) << " = "
-           << emitter.getOrCreateName(operand) << ";\n";
-  }
-
-  output << "goto ";
-  if (!(emitter.hasBlockLabel(trueSuccessor))) {
-    return condBranchOp.emitOpError()
-           << "Unable to find label for successor block";
+  if (failed(printBlockArgumentAssignments(
+          condBranchOp, condBranchOp.getTrueOperands(),
+          *condBranchOp.getTrueDest(), emitter))) {
+    return failure();
   }
-  output << emitter.getOrCreateName(trueSuccessor) << ";\n";
   output << "} else {\n";
   // If condition is false.
-  for (auto pair : llvm::zip(condBranchOp.getFalseOperands(),
-                             falseSuccessor.getArguments())) {
-    auto &operand = std::get<0>(pair);
-    auto &argument = std::get<1>(pair);
-    output << emitter.getOrCreateName(argument) << " = "
-           << emitter.getOrCreateName(operand) << ";\n";
-  }
-
-  output << "goto ";
-  if (!(emitter.hasBlockLabel(falseSuccessor))) {
-    return condBranchOp.emitOpError()
-           << "Unable to find label for successor block";
+  if (failed(printBlockArgumentAssignments(
+          condBranchOp, condBranchOp.getFalseOperands(),
+          *condBranchOp.getFalseDest(), emitter))) {
+    return failure();
   }
-  output << emitter.getOrCreateName(falseSuccessor) << ";\n";
   output << "}\n";
   return success();
 }
@@ -244,8 +365,13 @@ static LogicalResult translateReturnOpToC(
        llvm::zip(returnOp.getOperands(), resultNames)) {
     Value operand = std::get<0>(tuple);
     std::string resultName = std::get<1>(tuple);
-    output << "*" << resultName << " = " << emitter.getOrCreateName(operand)
-           << ";\n";
+    if (operand.getType().isa<IREE::VM::RefType>()) {
+      output << "vm_ref_retain(" << emitter.getOrCreateName(operand) << ", "
+             << resultName << ");\n";
+    } else {
+      output << "*" << resultName << " = " << emitter.getOrCreateName(operand)
+             << ";\n";
+    }
   }
 
   if (hasRefs) {
@@ -263,8 +389,6 @@ static LogicalResult translateOpToC(Operation &op,
                                     bool hasRefs) {
   if (auto branchOp = dyn_cast<IREE::VM::BranchOp>(op))
     return translateBranchOp(branchOp, emitter);
-  if (auto callOp = dyn_cast<IREE::VM::CallOp>(op))
-    return translateCallOpToC(callOp, emitter);
   if (auto condBranchOp = dyn_cast<IREE::VM::CondBranchOp>(op))
     return translateCondBranchOp(condBranchOp, emitter);
   if (auto failOp = dyn_cast<IREE::VM::FailOp>(op))
@@ -279,18 +403,19 @@ static LogicalResult translateOpToC(Operation &op,
   return failure();
 }
 
-static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
-                                          IREE::VM::FuncOp &funcOp,
-                                          mlir::emitc::CppEmitter &emitter) {
+// Prints the signature of the `_impl` function for |funcOp| without a
+// trailing `;` or body.
+static LogicalResult printFunctionSignature(
+    IREE::VM::ModuleOp &moduleOp, IREE::VM::FuncOp &funcOp,
+    mlir::emitc::CppEmitter &emitter, ArrayRef<std::string> resultNames) {
   std::string moduleName = moduleOp.getName().str();
-  emitc::CppEmitter::Scope scope(emitter);
   llvm::raw_ostream &output = emitter.ostream();
 
   // this function later gets wrapped with argument marshalling code
   std::string functionName =
       buildFunctionName(moduleOp, funcOp, /*implSuffix=*/true);
 
-  output << "iree_status_t " << functionName << "(";
+  output << "iree_status_t " << functionName << "(iree_vm_stack_t* stack, ";
 
   if (failed(printFuncOpArguments(funcOp, emitter))) {
     return failure();
@@ -300,12 +425,6 @@ static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
     output << ", ";
   }
 
-  SmallVector<std::string, 4> resultNames;
-  for (unsigned int idx = 0; idx < funcOp.getNumResults(); idx++) {
-    std::string resultName = "out" + std::to_string(idx);
-    resultNames.push_back(resultName);
-  }
-
   if (failed(printFuncOpResults(funcOp, emitter, resultNames))) {
     return failure();
   }
@@ -316,14 +435,52 @@ static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
 
   // TODO(simon-camp): We can't represent structs in emitc (yet maybe), so the
   // struct argument name here must not be changed.
-  output << moduleName << "_state_t* state) {\n";
+  output << moduleName << "_state_t* state)";
+  return success();
+}
+
+static SmallVector<std::string, 4> buildResultNames(IREE::VM::FuncOp &funcOp) {
+  SmallVector<std::string, 4> resultNames;
+  for (unsigned int idx = 0; idx < funcOp.getNumResults(); idx++) {
+    std::string resultName = "out" + std::to_string(idx);
+    resultNames.push_back(resultName);
+  }
+  return resultNames;
+}
+
+static LogicalResult printFunctionDeclaration(
+    IREE::VM::ModuleOp &moduleOp, IREE::VM::FuncOp &funcOp,
+    mlir::emitc::CppEmitter &emitter) {
+  emitc::CppEmitter::Scope scope(emitter);
+  if (failed(printFunctionSignature(moduleOp, funcOp, emitter,
+                                    buildResultNames(funcOp)))) {
+    return failure();
+  }
+  emitter.ostream() << ";\n";
+  return success();
+}
 
-  // We forward declare all result variables except for the ones with RefType.
+static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
+                                          IREE::VM::FuncOp &funcOp,
+                                          mlir::emitc::CppEmitter &emitter) {
+  emitc::CppEmitter::Scope scope(emitter);
+  llvm::raw_ostream &output = emitter.ostream();
+
+  SmallVector<std::string, 4> resultNames = buildResultNames(funcOp);
+  if (failed(printFunctionSignature(moduleOp, funcOp, emitter, resultNames))) {
+    return failure();
+  }
+  output << " {\n";
+
+  // We forward declare all result variables. Values with RefType point into
+  // the local_refs array declared below.
   output << "// VARIABLE DECLARATIONS\n";
   output << "// RESULTS\n";
   for (auto &op : funcOp.getOps()) {
     for (auto result : op.getResults()) {
       if (result.getType().isa<IREE::VM::RefType>()) {
+        output << "iree_vm_ref_t* " << emitter.getOrCreateName(result)
+               << ";\n";
         continue;
       }
       if (failed(emitter.emitVariableDeclaration(result,
@@ -341,6 +498,7 @@ static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
   }
 
   // Emit variables for basic block arguments (omitting the first).
+  SmallVector<BlockArgument, 4> refBlockArgs;
   for (auto it = std::next(blocks.begin()); it != blocks.end(); ++it) {
     Block &block = *it;
     for (auto &arg : block.getArguments()) {
@@ -348,7 +506,10 @@ static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
         // This shouldn't happen
         return failure();
       }
-      if (failed(emitter.emitType(arg.getType()))) {
+      if (arg.getType().isa<IREE::VM::RefType>()) {
+        refBlockArgs.push_back(arg);
+      }
+      if (failed(printTypeOrRefPointer(arg.getType(), emitter))) {
         return failure();
       }
       output << " " << emitter.getOrCreateName(arg) << ";\n";
@@ -357,15 +518,25 @@ static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
 
   output << "// END VARIABLE DECLARATIONS\n";
 
-  // We reuse the register allocation pass and emit an array for all Values with
-  // ref type instead of generating one variable per Value. This makes the
-  // deallocation process easier for us.
-  RegisterAllocation registerAllocation;
-  if (failed(registerAllocation.recalculate(funcOp))) {
-    return funcOp.emitOpError() << "unable to perform register allocation";
-  }
-
-  const size_t numRefs = registerAllocation.getMaxRefRegisterOrdinal() + 1;
+  // We emit an array for all Values with ref type instead of generating one
+  // variable per Value. This makes the deallocation process easier for us.
+  // The conversion to EmitC assigned the slots of values defined by ops and
+  // the ref block arguments get a slot each after those.
+  auto localRefCountAttr =
+      funcOp->getAttrOfType<IntegerAttr>(kLocalRefCountAttrName);
+  if (!localRefCountAttr) {
+    return funcOp.emitOpError() << "missing local ref slot count";
+  }
+  const size_t numOpRefs = localRefCountAttr.getInt();
+  size_t numRefs = numOpRefs + refBlockArgs.size();
+
+  // Error handling after calls releases the array, so functions without refs
+  // still get an (empty) array to release if they contain failable calls.
+  bool hasFailableCalls = false;
+  funcOp.walk([&](emitc::CallOp callOp) {
+    if (callOp.callee() == "VM_RETURN_IF_ERROR") hasFailableCalls = true;
+  });
+  if (numRefs == 0 && hasFailableCalls) numRefs = 1;
   const bool hasRefs = numRefs > 0;
 
   if (hasRefs) {
@@ -373,6 +544,11 @@ static LogicalResult translateFunctionToC(IREE::VM::ModuleOp &moduleOp,
     output << "iree_vm_ref_t local_refs[" << numRefs << "] = {"
            << llvm::join(ref_initializers, ", ") << "};\n";
   }
+  for (auto arg : llvm::enumerate(refBlockArgs)) {
+    output << emitter.getOrCreateName(arg.value())
+           << " = VM_ARRAY_ELEMENT_ADDRESS(local_refs, "
+           << numOpRefs + arg.index() << ");\n";
+  }
 
   for (auto &block : blocks) {
     // Only print a label if there is more than one block.
@@ -434,7 +610,7 @@ static LogicalResult buildModuleDescriptors(IREE::VM::ModuleOp &moduleOp,
            << "return "
            << buildFunctionName(moduleOp, funcOp,
                                 /*implSufffix=*/true)
-           << "(";
+           << "(stack, ";
 
     SmallVector<std::string, 4> argNames;
     for (Value &argument : funcOp.getArguments()) {
@@ -495,11 +671,12 @@ static LogicalResult buildModuleDescriptors(IREE::VM::ModuleOp &moduleOp,
   output << "static const iree_vm_native_import_descriptor_t " << importName
          << "[] = {\n";
 
-  // sort import ops
+  // sort import ops by ordinal as that is the index they are resolved with
   SmallVector<IREE::VM::ImportOp, 4> importOps(
       moduleOp.getOps<IREE::VM::ImportOp>());
   llvm::sort(importOps, [](auto &lhs, auto &rhs) {
-    return lhs.getName().compare(rhs.getName()) < 0;
+    return lhs.ordinal().getValue().getZExtValue() <
+           rhs.ordinal().getValue().getZExtValue();
   });
 
   for (auto importOp : importOps) {
@@ -580,12 +757,30 @@ static LogicalResult buildModuleDescriptors(IREE::VM::ModuleOp &moduleOp,
          << "_free_state(void* self, iree_vm_module_state_t* "
             "module_state) {\n"
          << moduleName << "_state_t* state = (" << moduleName
-         << "_state_t*)module_state;\n"
-         << "iree_allocator_free(state->allocator, state);\n"
+         << "_state_t*)module_state;\n";
+  if (moduleOp.ordinal_counts().getValue().global_refs() > 0) {
+    output << "VM_REF_ARRAY_RELEASE(state->refs);\n";
+  }
+  output << "iree_allocator_free(state->allocator, state);\n"
          << "}\n";
 
-  // resolve_imports
-  // TODO(simon-camp):
+  // resolve_import
+  if (!importOps.empty()) {
+    output << "static iree_status_t " << moduleName
+           << "_resolve_import(void* self, iree_vm_module_state_t* "
+              "module_state, iree_host_size_t ordinal, const "
+              "iree_vm_function_t* function, const "
+              "iree_vm_function_signature_t* signature) {\n"
+           << moduleName << "_state_t* state = (" << moduleName
+           << "_state_t*)module_state;\n"
+           << "if (ordinal >= IREE_ARRAYSIZE(state->imports)) {\n"
+           << "return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "
+              "\"import ordinal out of range\");\n"
+           << "}\n"
+           << "state->imports[ordinal] = *function;\n"
+           << "return iree_ok_status();\n"
+           << "}\n";
+  }
 
   // create
   output << "static iree_status_t " << moduleName << "_create("
@@ -597,7 +792,9 @@ static LogicalResult buildModuleDescriptors(IREE::VM::ModuleOp &moduleOp,
          << "interface.destroy = NULL;\n"
          << "interface.alloc_state = " << moduleName << "_alloc_state;\n"
          << "interface.free_state = " << moduleName << "_free_state;\n"
-         << "interface.resolve_import = NULL;\n"
+         << "interface.resolve_import = "
+         << (importOps.empty() ? "NULL" : moduleName + "_resolve_import")
+         << ";\n"
          << "return iree_vm_native_module_create(&interface, "
             "&"
          << descriptorName << ", allocator, out_module);\n"
@@ -712,6 +909,23 @@ LogicalResult translateModuleToC(IREE::VM::ModuleOp moduleOp,
     return failure();
   }
 
+  // build functions calling imports
+  for (auto importOp : moduleOp.getOps<IREE::VM::ImportOp>()) {
+    if (failed(printImportFunction(moduleOp, importOp, output))) {
+      return failure();
+    }
+
+    output << "\n";
+  }
+
+  // forward declare functions so they can call each other in any order
+  for (auto funcOp : moduleOp.getOps<IREE::VM::FuncOp>()) {
+    if (failed(printFunctionDeclaration(moduleOp, funcOp, emitter))) {
+      return failure();
+    }
+  }
+  output << "\n";
+
   // translate functions
   for (auto funcOp : moduleOp.getOps<IREE::VM::FuncOp>()) {
     if (failed(translateFunctionToC(moduleOp, funcOp, emitter))) {
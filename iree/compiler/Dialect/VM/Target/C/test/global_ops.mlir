@@ -12,7 +12,7 @@ vm.module @global_ops {
   vm.global.i32 @c107_mut mutable 107 : i32
 
   vm.export @test_global_load_i32
-  // CHECK-LABEL: iree_status_t global_ops_test_global_load_i32_impl(
+  // CHECK-LABEL: iree_status_t global_ops_test_global_load_i32_impl(iree_vm_stack_t* stack, int32_t *out0, global_ops_state_t* state) {
   vm.func @test_global_load_i32() -> i32 {
     // CHECK-NEXT: VARIABLE DECLARATIONS
     // CHECK-NEXT: RESULTS
@@ -25,7 +25,7 @@ vm.module @global_ops {
   }
 
   vm.export @test_global_store_i32
-  // CHECK-LABEL: iree_status_t global_ops_test_global_store_i32_impl(
+  // CHECK-LABEL: iree_status_t global_ops_test_global_store_i32_impl(iree_vm_stack_t* stack, int32_t *out0, global_ops_state_t* state) {
   vm.func @test_global_store_i32() -> i32 {
     // CHECK-NEXT: VARIABLE DECLARATIONS
     // CHECK-NEXT: RESULTS
@@ -0,0 +1,34 @@
+// RUN: iree-translate -iree-vm-ir-to-c-module -iree-vm-c-module-optimize=false %s | IreeFileCheck %s
+
+vm.module @import_ops {
+  // CHECK-LABEL: struct import_ops_state_s {
+  // CHECK: iree_vm_function_t imports[1];
+  // CHECK-NEXT: };
+
+  // CHECK-LABEL: static iree_status_t import_ops_call_other_module_fn(iree_vm_stack_t* stack, iree_vm_ref_t* arg0, int32_t arg1, iree_vm_ref_t *res0, import_ops_state_t* state) {
+  // CHECK-NEXT: const iree_vm_function_t* import = &state->imports[0];
+  // CHECK: uint8_t arguments[sizeof(iree_vm_ref_t) + sizeof(int32_t)];
+  // CHECK: uint8_t results[sizeof(iree_vm_ref_t)];
+  // CHECK: iree_vm_ref_assign(arg0, (iree_vm_ref_t*)arguments_ptr);
+  // CHECK: memcpy(arguments_ptr, &arg1, sizeof(int32_t));
+  // CHECK: import->module->begin_call(import->module->self, stack, &call, &result);
+  // CHECK: iree_vm_ref_move((iree_vm_ref_t*)results_ptr, res0);
+  vm.import @other_module.fn(%arg0 : !vm.list<i32>, %arg1 : i32) -> !vm.list<i32>
+
+  // CHECK-LABEL: iree_status_t import_ops_call_import_impl(iree_vm_stack_t* stack, iree_vm_ref_t* v1, iree_vm_ref_t *out0, import_ops_state_t* state) {
+  vm.func @call_import(%arg0 : !vm.list<i32>) -> !vm.list<i32> {
+    // CHECK: iree_vm_ref_t* [[RESULT:[^ ]*]];
+    // CHECK: iree_vm_ref_t local_refs[1] = {{[{][{]}}0{{[}][}]}};
+    // CHECK: [[RESULT]] = VM_ARRAY_ELEMENT_ADDRESS(local_refs, 0);
+    // CHECK: import_ops_call_other_module_fn(stack, v1, {{[^ ]*}}, [[RESULT]], state);
+    %c1 = vm.const.i32 1 : i32
+    %0 = vm.call @other_module.fn(%arg0, %c1) : (!vm.list<i32>, i32) -> !vm.list<i32>
+    // CHECK: vm_ref_retain([[RESULT]], out0);
+    // CHECK-NEXT: VM_REF_ARRAY_RELEASE(local_refs);
+    vm.return %0 : !vm.list<i32>
+  }
+
+  // CHECK-LABEL: static iree_status_t import_ops_resolve_import(
+  // CHECK: state->imports[ordinal] = *function;
+  // CHECK: interface.resolve_import = import_ops_resolve_import;
+}
@@ -0,0 +1,24 @@
+// RUN: iree-translate -iree-vm-ir-to-c-module -iree-vm-c-module-optimize=false %s | IreeFileCheck %s
+
+vm.module @ref_ops {
+  // CHECK-LABEL: iree_status_t ref_ops_ref_block_args_impl(iree_vm_stack_t* stack, int32_t v1, iree_vm_ref_t* v2, iree_vm_ref_t* v3, iree_vm_ref_t *out0, ref_ops_state_t* state) {
+  vm.func @ref_block_args(%cond : i32, %a : !vm.ref<?>, %b : !vm.ref<?>) -> !vm.ref<?> {
+    // CHECK: BASIC BLOCK ARGUMENTS
+    // CHECK-NEXT: iree_vm_ref_t* [[ARG:[^ ]*]];
+    // CHECK-NEXT: END VARIABLE DECLARATIONS
+    // CHECK-NEXT: iree_vm_ref_t local_refs[1] = {{[{][{]}}0{{[}][}]}};
+    // CHECK-NEXT: [[ARG]] = VM_ARRAY_ELEMENT_ADDRESS(local_refs, 0);
+    // CHECK: if (v1) {
+    // CHECK-NEXT: vm_ref_retain(v2, [[ARG]]);
+    // CHECK-NEXT: goto
+    // CHECK-NEXT: } else {
+    // CHECK-NEXT: vm_ref_retain(v3, [[ARG]]);
+    // CHECK-NEXT: goto
+    vm.cond_br %cond, ^bb1(%a : !vm.ref<?>), ^bb1(%b : !vm.ref<?>)
+  ^bb1(%c : !vm.ref<?>):
+    // CHECK: vm_ref_retain([[ARG]], out0);
+    // CHECK-NEXT: VM_REF_ARRAY_RELEASE(local_refs);
+    // CHECK-NEXT: return iree_ok_status();
+    vm.return %c : !vm.ref<?>
+  }
+}
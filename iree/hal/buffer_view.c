@@ -690,45 +690,60 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_format(
   return status;
 }
 
-// TODO(benvanik): streaming all the way down (needs string_util updates).
-IREE_API_EXPORT iree_status_t iree_hal_buffer_view_fprint(
-    FILE* file, const iree_hal_buffer_view_t* buffer_view,
-    iree_host_size_t max_element_count) {
-  IREE_ASSERT_ARGUMENT(file);
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_format_to_sink(
+    const iree_hal_buffer_view_t* buffer_view,
+    iree_host_size_t max_element_count, iree_hal_string_sink_t sink) {
   IREE_ASSERT_ARGUMENT(buffer_view);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Query the string length (in characters).
-  iree_host_size_t buffer_length = 0;
-  iree_status_t status = iree_hal_buffer_view_format(
-      buffer_view, max_element_count, 0, NULL, &buffer_length);
-  if (!iree_status_is_out_of_range(status)) {
-    IREE_TRACE_ZONE_END(z0);
-    return status;
+  // Shape and element type: 1x2x3xf32=
+  // These are tiny and written directly before the chunked element contents.
+  char scratch[32];
+  iree_status_t status = iree_ok_status();
+  const iree_hal_dim_t* shape = iree_hal_buffer_view_shape_dims(buffer_view);
+  iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  for (iree_host_size_t i = 0; i < shape_rank && iree_status_is_ok(status);
+       ++i) {
+    int n = snprintf(scratch, sizeof(scratch), "%dx", shape[i]);
+    status = sink.write(sink.self, iree_make_string_view(scratch, n));
+  }
+  iree_host_size_t element_type_length = 0;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_format_element_type(
+        iree_hal_buffer_view_element_type(buffer_view), sizeof(scratch) - 1,
+        scratch, &element_type_length);
   }
-
-  // Allocate scratch space to format in to.
-  // We should be streaming.
-  iree_allocator_t host_allocator = iree_hal_allocator_host_allocator(
-      iree_hal_buffer_allocator(iree_hal_buffer_view_buffer(buffer_view)));
-  iree_host_size_t buffer_capacity = buffer_length + 1;  // NUL
-  char* buffer = NULL;
-  status =
-      iree_allocator_malloc(host_allocator, buffer_capacity, (void**)&buffer);
-
-  // Format the buffer into the string storage.
   if (iree_status_is_ok(status)) {
-    status =
-        iree_hal_buffer_view_format(buffer_view, max_element_count,
-                                    buffer_capacity, buffer, &buffer_length);
+    scratch[element_type_length++] = '=';
+    status = sink.write(sink.self,
+                        iree_make_string_view(scratch, element_type_length));
   }
 
-  // Dump to the file.
+  // Buffer contents: 0 1 2 3 ...
+  iree_hal_buffer_mapping_t buffer_mapping;
   if (iree_status_is_ok(status)) {
-    fprintf(file, "%.*s", (int)buffer_length, buffer);
+    status = iree_hal_buffer_map_range(
+        iree_hal_buffer_view_buffer(buffer_view), IREE_HAL_MEMORY_ACCESS_READ,
+        0, IREE_WHOLE_BUFFER, &buffer_mapping);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_format_buffer_elements_to_sink(
+        iree_make_const_byte_span(buffer_mapping.contents.data,
+                                  buffer_mapping.contents.data_length),
+        shape, shape_rank, iree_hal_buffer_view_element_type(buffer_view),
+        max_element_count, sink);
+    iree_hal_buffer_unmap_range(&buffer_mapping);
   }
 
-  iree_allocator_free(host_allocator, buffer);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_fprint(
+    FILE* file, const iree_hal_buffer_view_t* buffer_view,
+    iree_host_size_t max_element_count) {
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_ASSERT_ARGUMENT(buffer_view);
+  return iree_hal_buffer_view_format_to_sink(
+      buffer_view, max_element_count, iree_hal_string_sink_file(file));
+}
@@ -174,6 +174,18 @@ IREE_API_EXPORT iree_status_t iree_hal_executable_cache_prepare_executable(
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
+// Prepares |executable_count| executables defined by |executable_specs| as with
+// iree_hal_executable_cache_prepare_executable and returns them in the
+// matching elements of |out_executables|. Implementations may prepare the
+// executables concurrently and callers with many executables to prepare
+// should prefer this to preparing them one at a time. If any executable fails
+// to prepare then the first error is returned and no executables are.
+IREE_API_EXPORT iree_status_t iree_hal_executable_cache_prepare_executables(
+    iree_hal_executable_cache_t* executable_cache,
+    iree_host_size_t executable_count,
+    const iree_hal_executable_spec_t* executable_specs,
+    iree_hal_executable_t** out_executables);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_executable_cache_t implementation details
 //===----------------------------------------------------------------------===//
@@ -193,6 +205,14 @@ typedef struct {
       iree_hal_executable_cache_t* executable_cache,
       const iree_hal_executable_spec_t* executable_spec,
       iree_hal_executable_t** out_executable);
+
+  // Optional; executables are prepared serially with prepare_executable if
+  // omitted.
+  iree_status_t(IREE_API_PTR* prepare_executables)(
+      iree_hal_executable_cache_t* executable_cache,
+      iree_host_size_t executable_count,
+      const iree_hal_executable_spec_t* executable_specs,
+      iree_hal_executable_t** out_executables);
 } iree_hal_executable_cache_vtable_t;
 
 IREE_API_EXPORT void iree_hal_executable_cache_destroy(
@@ -0,0 +1,85 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/cpu_features.h"
+
+#include <cpuinfo.h>
+
+typedef struct {
+  // LLVM target feature name without the +/- prefix.
+  const char* name;
+  bool (*query)(void);
+} iree_hal_cpu_feature_t;
+
+// Maps LLVM target feature names to cpuinfo queries. The cpuinfo queries are
+// defined on all architectures and return false when not applicable.
+static const iree_hal_cpu_feature_t iree_hal_cpu_features[] = {
+    // x86/x86-64:
+    {"sse", cpuinfo_has_x86_sse},
+    {"sse2", cpuinfo_has_x86_sse2},
+    {"sse3", cpuinfo_has_x86_sse3},
+    {"ssse3", cpuinfo_has_x86_ssse3},
+    {"sse4.1", cpuinfo_has_x86_sse4_1},
+    {"sse4.2", cpuinfo_has_x86_sse4_2},
+    {"popcnt", cpuinfo_has_x86_popcnt},
+    {"lzcnt", cpuinfo_has_x86_lzcnt},
+    {"bmi", cpuinfo_has_x86_bmi},
+    {"bmi2", cpuinfo_has_x86_bmi2},
+    {"f16c", cpuinfo_has_x86_f16c},
+    {"fma", cpuinfo_has_x86_fma3},
+    {"avx", cpuinfo_has_x86_avx},
+    {"avx2", cpuinfo_has_x86_avx2},
+    {"avx512f", cpuinfo_has_x86_avx512f},
+    {"avx512cd", cpuinfo_has_x86_avx512cd},
+    {"avx512dq", cpuinfo_has_x86_avx512dq},
+    {"avx512bw", cpuinfo_has_x86_avx512bw},
+    {"avx512vl", cpuinfo_has_x86_avx512vl},
+    {"avx512vnni", cpuinfo_has_x86_avx512vnni},
+    // ARM/AArch64:
+    {"neon", cpuinfo_has_arm_neon},
+    {"fullfp16", cpuinfo_has_arm_neon_fp16_arith},
+    {"dotprod", cpuinfo_has_arm_neon_dot},
+};
+
+static bool iree_hal_cpu_supports_feature(iree_string_view_t feature) {
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(iree_hal_cpu_features);
+       ++i) {
+    if (iree_string_view_equal(
+            feature, iree_make_cstring_view(iree_hal_cpu_features[i].name))) {
+      return iree_hal_cpu_features[i].query();
+    }
+  }
+  return false;
+}
+
+bool iree_hal_cpu_supports_features(iree_string_view_t cpu_features) {
+  cpu_features = iree_string_view_trim(cpu_features);
+  if (iree_string_view_is_empty(cpu_features)) return true;
+
+  // NOTE: initialization is cached by cpuinfo and cheap after the first call.
+  if (!cpuinfo_initialize()) return false;
+
+  while (!iree_string_view_is_empty(cpu_features)) {
+    iree_string_view_t feature = iree_string_view_empty();
+    iree_string_view_split(cpu_features, ',', &feature, &cpu_features);
+    feature = iree_string_view_trim(feature);
+    if (iree_string_view_is_empty(feature) ||
+        iree_string_view_starts_with(feature, iree_make_cstring_view("-"))) {
+      continue;
+    }
+    iree_string_view_consume_prefix(&feature, iree_make_cstring_view("+"));
+    if (!iree_hal_cpu_supports_feature(feature)) return false;
+  }
+  return true;
+}
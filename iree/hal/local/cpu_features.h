@@ -0,0 +1,39 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_HAL_LOCAL_CPU_FEATURES_H_
+#define IREE_HAL_LOCAL_CPU_FEATURES_H_
+
+#include <stdbool.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Returns true if the host CPU supports all of the given comma-separated
+// LLVM-style CPU features (such as `+avx2,+fma`).
+//
+// Features prefixed with `-` only disable codegen and are ignored. Features
+// that are not known to the runtime are treated as unsupported so that we never
+// select code that may execute illegal instructions. An empty feature string
+// is always supported.
+bool iree_hal_cpu_supports_features(iree_string_view_t cpu_features);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_CPU_FEATURES_H_
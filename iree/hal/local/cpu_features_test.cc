@@ -0,0 +1,79 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/cpu_features.h"
+
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/base/target_platform.h"
+#include "iree/testing/gtest.h"
+
+namespace {
+
+// A feature every host of the architecture supports, if we know of one.
+#if defined(IREE_ARCH_X86_64)
+#define IREE_TEST_BASELINE_FEATURE "sse2"
+#elif defined(IREE_ARCH_ARM_64)
+#define IREE_TEST_BASELINE_FEATURE "neon"
+#endif  // IREE_ARCH_*
+
+bool SupportsFeatures(const std::string& cpu_features) {
+  return iree_hal_cpu_supports_features(
+      iree_make_string_view(cpu_features.data(), cpu_features.size()));
+}
+
+TEST(CpuFeaturesTest, EmptyIsSupported) {
+  EXPECT_TRUE(iree_hal_cpu_supports_features(iree_string_view_empty()));
+  EXPECT_TRUE(SupportsFeatures(" "));
+  EXPECT_TRUE(SupportsFeatures(",, ,"));
+}
+
+TEST(CpuFeaturesTest, UnknownIsUnsupported) {
+  EXPECT_FALSE(SupportsFeatures("iree-unknown-feature"));
+  EXPECT_FALSE(SupportsFeatures("+iree-unknown-feature"));
+  // Names are matched exactly.
+  EXPECT_FALSE(SupportsFeatures("+AVX2"));
+  EXPECT_FALSE(SupportsFeatures("+avx2x"));
+}
+
+TEST(CpuFeaturesTest, DisabledFeaturesAreIgnored) {
+  EXPECT_TRUE(SupportsFeatures("-iree-unknown-feature"));
+  EXPECT_TRUE(SupportsFeatures("-avx512f,-neon"));
+  EXPECT_TRUE(SupportsFeatures(" -avx512f , -iree-unknown-feature "));
+}
+
+TEST(CpuFeaturesTest, PlusPrefixIsOptional) {
+  for (const char* feature : {"sse2", "avx2", "fma", "neon", "dotprod"}) {
+    EXPECT_EQ(SupportsFeatures(feature),
+              SupportsFeatures(std::string("+") + feature))
+        << feature;
+  }
+}
+
+TEST(CpuFeaturesTest, AllFeaturesMustBeSupported) {
+  EXPECT_FALSE(SupportsFeatures("+iree-unknown-feature,-avx2"));
+  EXPECT_FALSE(SupportsFeatures("-avx2,+iree-unknown-feature"));
+#if defined(IREE_TEST_BASELINE_FEATURE)
+  EXPECT_TRUE(SupportsFeatures("+" IREE_TEST_BASELINE_FEATURE));
+  EXPECT_TRUE(SupportsFeatures("+" IREE_TEST_BASELINE_FEATURE
+                               ",-iree-unknown-feature"));
+  EXPECT_FALSE(SupportsFeatures("+" IREE_TEST_BASELINE_FEATURE
+                                ",+iree-unknown-feature"));
+  EXPECT_FALSE(SupportsFeatures("+iree-unknown-feature,"
+                                "+" IREE_TEST_BASELINE_FEATURE));
+#endif  // IREE_TEST_BASELINE_FEATURE
+}
+
+}  // namespace
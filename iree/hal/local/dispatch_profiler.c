@@ -0,0 +1,358 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/dispatch_profiler.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// Aggregated results for all dispatches sharing the same executable, entry
+// point, and workgroup count. The names are stored immediately following the
+// entry in the same allocation.
+typedef struct {
+  iree_string_view_t executable_name;
+  iree_string_view_t entry_point_name;
+  uint32_t workgroup_count[3];
+  uint64_t dispatch_count;
+  uint64_t tile_count;
+  iree_duration_t total_wall_time_ns;
+  iree_duration_t min_wall_time_ns;
+  iree_duration_t max_wall_time_ns;
+  iree_duration_t worker_busy_ns[IREE_HAL_DISPATCH_PROFILER_MAX_WORKER_COUNT];
+} iree_hal_dispatch_profile_entry_t;
+
+struct iree_hal_dispatch_profiler_s {
+  iree_atomic_int32_t enabled;
+
+  iree_slim_mutex_t mutex;
+  iree_host_size_t entry_count IREE_GUARDED_BY(mutex);
+  iree_host_size_t entry_capacity IREE_GUARDED_BY(mutex);
+  iree_hal_dispatch_profile_entry_t** entries IREE_GUARDED_BY(mutex);
+};
+
+static iree_hal_dispatch_profiler_t iree_hal_dispatch_profiler_default_;
+static iree_once_flag iree_hal_dispatch_profiler_default_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_hal_dispatch_profiler_default_initialize(void) {
+  memset(&iree_hal_dispatch_profiler_default_, 0,
+         sizeof(iree_hal_dispatch_profiler_default_));
+  iree_slim_mutex_initialize(&iree_hal_dispatch_profiler_default_.mutex);
+}
+
+iree_hal_dispatch_profiler_t* iree_hal_dispatch_profiler_default(void) {
+  iree_call_once(&iree_hal_dispatch_profiler_default_flag_,
+                 iree_hal_dispatch_profiler_default_initialize);
+  return &iree_hal_dispatch_profiler_default_;
+}
+
+void iree_hal_dispatch_profiler_set_enabled(
+    iree_hal_dispatch_profiler_t* profiler, bool enabled) {
+  iree_atomic_store_int32(&profiler->enabled, enabled ? 1 : 0,
+                          iree_memory_order_release);
+}
+
+bool iree_hal_dispatch_profiler_is_enabled(
+    iree_hal_dispatch_profiler_t* profiler) {
+  return iree_atomic_load_int32(&profiler->enabled,
+                                iree_memory_order_acquire) != 0;
+}
+
+// Returns the entry matching |record| or NULL if none has been recorded yet.
+// Must be called with the profiler mutex held.
+static iree_hal_dispatch_profile_entry_t* iree_hal_dispatch_profiler_find(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_dispatch_profile_record_t* record) {
+  for (iree_host_size_t i = 0; i < profiler->entry_count; ++i) {
+    iree_hal_dispatch_profile_entry_t* entry = profiler->entries[i];
+    if (memcmp(entry->workgroup_count, record->workgroup_count,
+               sizeof(entry->workgroup_count)) == 0 &&
+        iree_string_view_equal(entry->entry_point_name,
+                               record->entry_point_name) &&
+        iree_string_view_equal(entry->executable_name,
+                               record->executable_name)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Allocates a new zeroed entry for |record| and appends it to the list.
+// Must be called with the profiler mutex held.
+static iree_status_t iree_hal_dispatch_profiler_append(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_dispatch_profile_record_t* record,
+    iree_hal_dispatch_profile_entry_t** out_entry) {
+  iree_allocator_t allocator = iree_allocator_system();
+  if (profiler->entry_count == profiler->entry_capacity) {
+    iree_host_size_t new_capacity = iree_max(16, profiler->entry_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        allocator, new_capacity * sizeof(*profiler->entries),
+        (void**)&profiler->entries));
+    profiler->entry_capacity = new_capacity;
+  }
+
+  iree_hal_dispatch_profile_entry_t* entry = NULL;
+  iree_host_size_t total_size = sizeof(*entry) +
+                                record->executable_name.size +
+                                record->entry_point_name.size;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, total_size, (void**)&entry));
+  memset(entry, 0, sizeof(*entry));
+  char* name_ptr = (char*)entry + sizeof(*entry);
+  memcpy(name_ptr, record->executable_name.data, record->executable_name.size);
+  entry->executable_name =
+      iree_make_string_view(name_ptr, record->executable_name.size);
+  name_ptr += record->executable_name.size;
+  memcpy(name_ptr, record->entry_point_name.data,
+         record->entry_point_name.size);
+  entry->entry_point_name =
+      iree_make_string_view(name_ptr, record->entry_point_name.size);
+  memcpy(entry->workgroup_count, record->workgroup_count,
+         sizeof(entry->workgroup_count));
+  entry->min_wall_time_ns = IREE_DURATION_INFINITE;
+
+  profiler->entries[profiler->entry_count++] = entry;
+  *out_entry = entry;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_dispatch_profiler_record(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_dispatch_profile_record_t* record) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_ASSERT_ARGUMENT(record);
+  iree_slim_mutex_lock(&profiler->mutex);
+
+  iree_status_t status = iree_ok_status();
+  iree_hal_dispatch_profile_entry_t* entry =
+      iree_hal_dispatch_profiler_find(profiler, record);
+  if (!entry) {
+    status = iree_hal_dispatch_profiler_append(profiler, record, &entry);
+  }
+
+  if (iree_status_is_ok(status)) {
+    ++entry->dispatch_count;
+    entry->tile_count += record->tile_count;
+    entry->total_wall_time_ns += record->wall_time_ns;
+    entry->min_wall_time_ns =
+        iree_min(entry->min_wall_time_ns, record->wall_time_ns);
+    entry->max_wall_time_ns =
+        iree_max(entry->max_wall_time_ns, record->wall_time_ns);
+    iree_host_size_t worker_count =
+        iree_min(record->worker_count,
+                 IREE_HAL_DISPATCH_PROFILER_MAX_WORKER_COUNT);
+    for (iree_host_size_t i = 0; i < worker_count; ++i) {
+      entry->worker_busy_ns[i] += record->worker_busy_ns[i];
+    }
+  }
+
+  iree_slim_mutex_unlock(&profiler->mutex);
+  return status;
+}
+
+void iree_hal_dispatch_profiler_reset(iree_hal_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  iree_slim_mutex_lock(&profiler->mutex);
+  for (iree_host_size_t i = 0; i < profiler->entry_count; ++i) {
+    iree_allocator_free(iree_allocator_system(), profiler->entries[i]);
+  }
+  iree_allocator_free(iree_allocator_system(), profiler->entries);
+  profiler->entries = NULL;
+  profiler->entry_count = 0;
+  profiler->entry_capacity = 0;
+  iree_slim_mutex_unlock(&profiler->mutex);
+}
+
+//===----------------------------------------------------------------------===//
+// Summary output
+//===----------------------------------------------------------------------===//
+
+static int iree_hal_dispatch_profile_entry_compare(const void* lhs_ptr,
+                                                   const void* rhs_ptr) {
+  const iree_hal_dispatch_profile_entry_t* lhs =
+      *(const iree_hal_dispatch_profile_entry_t* const*)lhs_ptr;
+  const iree_hal_dispatch_profile_entry_t* rhs =
+      *(const iree_hal_dispatch_profile_entry_t* const*)rhs_ptr;
+  if (lhs->total_wall_time_ns != rhs->total_wall_time_ns) {
+    return lhs->total_wall_time_ns > rhs->total_wall_time_ns ? -1 : 1;
+  }
+  return iree_string_view_compare(lhs->entry_point_name, rhs->entry_point_name);
+}
+
+// Derived summary values for an entry.
+typedef struct {
+  iree_duration_t total_busy_ns;
+  iree_duration_t max_worker_busy_ns;
+  iree_host_size_t active_worker_count;
+  // Index one past the last worker that executed any tiles.
+  iree_host_size_t worker_limit;
+} iree_hal_dispatch_profile_summary_t;
+
+static iree_hal_dispatch_profile_summary_t iree_hal_dispatch_profile_summarize(
+    const iree_hal_dispatch_profile_entry_t* entry) {
+  iree_hal_dispatch_profile_summary_t summary;
+  memset(&summary, 0, sizeof(summary));
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(entry->worker_busy_ns);
+       ++i) {
+    iree_duration_t busy_ns = entry->worker_busy_ns[i];
+    if (!busy_ns) continue;
+    summary.total_busy_ns += busy_ns;
+    summary.max_worker_busy_ns = iree_max(summary.max_worker_busy_ns, busy_ns);
+    ++summary.active_worker_count;
+    summary.worker_limit = i + 1;
+  }
+  return summary;
+}
+
+// Fraction of the wall time the active workers spent executing tiles.
+static double iree_hal_dispatch_profile_efficiency(
+    const iree_hal_dispatch_profile_entry_t* entry,
+    const iree_hal_dispatch_profile_summary_t* summary) {
+  if (!entry->total_wall_time_ns || !summary->active_worker_count) return 0.0;
+  return (double)summary->total_busy_ns /
+         ((double)entry->total_wall_time_ns *
+          (double)summary->active_worker_count);
+}
+
+// Writes |value| as a quoted string escaping the characters that are
+// significant in |format|.
+static void iree_hal_dispatch_profile_print_string(
+    iree_hal_dispatch_profile_format_t format, iree_string_view_t value,
+    FILE* file) {
+  fputc('"', file);
+  for (iree_host_size_t i = 0; i < value.size; ++i) {
+    char c = value.data[i];
+    if (c == '"') {
+      fputs(format == IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV ? "\"\"" : "\\\"",
+            file);
+    } else if (c == '\\' && format == IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON) {
+      fputs("\\\\", file);
+    } else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+static void iree_hal_dispatch_profile_dump_csv(
+    iree_host_size_t entry_count,
+    iree_hal_dispatch_profile_entry_t* const* entries, FILE* file) {
+  fprintf(file,
+          "executable,entry_point,workgroup_count,dispatches,tiles,"
+          "total_wall_ms,mean_wall_us,min_wall_us,max_wall_us,total_busy_ms,"
+          "workers,max_worker_busy_ms,efficiency\n");
+  for (iree_host_size_t i = 0; i < entry_count; ++i) {
+    const iree_hal_dispatch_profile_entry_t* entry = entries[i];
+    iree_hal_dispatch_profile_summary_t summary =
+        iree_hal_dispatch_profile_summarize(entry);
+    iree_hal_dispatch_profile_print_string(IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV,
+                                           entry->executable_name, file);
+    fputc(',', file);
+    iree_hal_dispatch_profile_print_string(IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV,
+                                           entry->entry_point_name, file);
+    fprintf(file,
+            ",%ux%ux%u,%" PRIu64 ",%" PRIu64
+            ",%.3f,%.3f,%.3f,%.3f,%.3f,%zu,%.3f,%.3f\n",
+            entry->workgroup_count[0], entry->workgroup_count[1],
+            entry->workgroup_count[2], entry->dispatch_count,
+            entry->tile_count, entry->total_wall_time_ns / 1e6,
+            entry->total_wall_time_ns / 1e3 / entry->dispatch_count,
+            entry->min_wall_time_ns / 1e3, entry->max_wall_time_ns / 1e3,
+            summary.total_busy_ns / 1e6, summary.active_worker_count,
+            summary.max_worker_busy_ns / 1e6,
+            iree_hal_dispatch_profile_efficiency(entry, &summary));
+  }
+}
+
+static void iree_hal_dispatch_profile_dump_json(
+    iree_host_size_t entry_count,
+    iree_hal_dispatch_profile_entry_t* const* entries, FILE* file) {
+  fprintf(file, "[\n");
+  for (iree_host_size_t i = 0; i < entry_count; ++i) {
+    const iree_hal_dispatch_profile_entry_t* entry = entries[i];
+    iree_hal_dispatch_profile_summary_t summary =
+        iree_hal_dispatch_profile_summarize(entry);
+    fprintf(file, "  {\"executable\": ");
+    iree_hal_dispatch_profile_print_string(
+        IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON, entry->executable_name, file);
+    fprintf(file, ", \"entry_point\": ");
+    iree_hal_dispatch_profile_print_string(
+        IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON, entry->entry_point_name, file);
+    fprintf(file,
+            ", \"workgroup_count\": [%u, %u, %u], \"dispatches\": %" PRIu64
+            ", \"tiles\": %" PRIu64
+            ", \"total_wall_ms\": %.3f, \"mean_wall_us\": %.3f"
+            ", \"min_wall_us\": %.3f, \"max_wall_us\": %.3f"
+            ", \"total_busy_ms\": %.3f, \"workers\": %zu"
+            ", \"efficiency\": %.3f, \"worker_busy_ms\": [",
+            entry->workgroup_count[0], entry->workgroup_count[1],
+            entry->workgroup_count[2], entry->dispatch_count,
+            entry->tile_count, entry->total_wall_time_ns / 1e6,
+            entry->total_wall_time_ns / 1e3 / entry->dispatch_count,
+            entry->min_wall_time_ns / 1e3, entry->max_wall_time_ns / 1e3,
+            summary.total_busy_ns / 1e6, summary.active_worker_count,
+            iree_hal_dispatch_profile_efficiency(entry, &summary));
+    for (iree_host_size_t j = 0; j < summary.worker_limit; ++j) {
+      fprintf(file, "%s%.3f", j ? ", " : "", entry->worker_busy_ns[j] / 1e6);
+    }
+    fprintf(file, "]}%s\n", i + 1 < entry_count ? "," : "");
+  }
+  fprintf(file, "]\n");
+}
+
+iree_status_t iree_hal_dispatch_profiler_dump(
+    iree_hal_dispatch_profiler_t* profiler,
+    iree_hal_dispatch_profile_format_t format, FILE* file) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->mutex);
+
+  // Lookup doesn't depend on order so we can sort in place.
+  if (profiler->entry_count) {
+    qsort(profiler->entries, profiler->entry_count,
+          sizeof(*profiler->entries), iree_hal_dispatch_profile_entry_compare);
+  }
+
+  iree_status_t status = iree_ok_status();
+  switch (format) {
+    case IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV:
+      iree_hal_dispatch_profile_dump_csv(profiler->entry_count,
+                                         profiler->entries, file);
+      break;
+    case IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON:
+      iree_hal_dispatch_profile_dump_json(profiler->entry_count,
+                                          profiler->entries, file);
+      break;
+    default:
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "unsupported dispatch profile format %d",
+                                (int)format);
+      break;
+  }
+
+  iree_slim_mutex_unlock(&profiler->mutex);
+  if (iree_status_is_ok(status) && ferror(file)) {
+    status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "failed to write dispatch profile");
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
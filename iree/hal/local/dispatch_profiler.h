@@ -0,0 +1,99 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_HAL_LOCAL_DISPATCH_PROFILER_H_
+#define IREE_HAL_LOCAL_DISPATCH_PROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of workers that busy time can be attributed to.
+// Matches IREE_TASK_EXECUTOR_MAX_WORKER_COUNT.
+#define IREE_HAL_DISPATCH_PROFILER_MAX_WORKER_COUNT 64
+
+//===----------------------------------------------------------------------===//
+// iree_hal_dispatch_profiler_t
+//===----------------------------------------------------------------------===//
+
+// Timing of a single completed dispatch as observed by a local device.
+typedef struct {
+  // Name of the executable library containing the entry point.
+  iree_string_view_t executable_name;
+  // Name of the dispatched entry point.
+  iree_string_view_t entry_point_name;
+  // XYZ workgroup count the dispatch was issued with.
+  uint32_t workgroup_count[3];
+  // Total number of tiles executed.
+  uint32_t tile_count;
+  // Wall time from the first tile starting until the last tile completed.
+  iree_duration_t wall_time_ns;
+  // Time each worker spent executing tiles of the dispatch, indexed by worker.
+  iree_host_size_t worker_count;
+  const iree_duration_t* worker_busy_ns;
+} iree_hal_dispatch_profile_record_t;
+
+typedef enum {
+  // Comma-separated values with one row per dispatch and a header row.
+  IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV = 0,
+  // JSON array with one object per dispatch including per-worker busy time.
+  IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON = 1,
+} iree_hal_dispatch_profile_format_t;
+
+// Process-wide aggregator of per-dispatch timing from local devices.
+// Recording is opt-in: devices check iree_hal_dispatch_profiler_is_enabled
+// when recording commands and only pay for timing when it is set.
+//
+// Records are aggregated by executable, entry point, and workgroup count so
+// that the summary stays small regardless of how many times each dispatch is
+// issued. Thread-safe.
+typedef struct iree_hal_dispatch_profiler_s iree_hal_dispatch_profiler_t;
+
+// Returns the process-wide default profiler.
+iree_hal_dispatch_profiler_t* iree_hal_dispatch_profiler_default(void);
+
+// Enables or disables recording. Only commands recorded while the profiler is
+// enabled are timed.
+void iree_hal_dispatch_profiler_set_enabled(
+    iree_hal_dispatch_profiler_t* profiler, bool enabled);
+
+// Returns true if recording is enabled.
+bool iree_hal_dispatch_profiler_is_enabled(
+    iree_hal_dispatch_profiler_t* profiler);
+
+// Merges |record| into the aggregated results.
+iree_status_t iree_hal_dispatch_profiler_record(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_dispatch_profile_record_t* record);
+
+// Drops all aggregated results.
+void iree_hal_dispatch_profiler_reset(iree_hal_dispatch_profiler_t* profiler);
+
+// Writes the aggregated results to |file| in |format| sorted by descending
+// total wall time.
+iree_status_t iree_hal_dispatch_profiler_dump(
+    iree_hal_dispatch_profiler_t* profiler,
+    iree_hal_dispatch_profile_format_t format, FILE* file);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_DISPATCH_PROFILER_H_
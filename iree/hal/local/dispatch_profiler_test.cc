@@ -0,0 +1,124 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/dispatch_profiler.h"
+
+#include <cstdio>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+class DispatchProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    profiler_ = iree_hal_dispatch_profiler_default();
+    iree_hal_dispatch_profiler_reset(profiler_);
+  }
+  void TearDown() override {
+    iree_hal_dispatch_profiler_set_enabled(profiler_, false);
+    iree_hal_dispatch_profiler_reset(profiler_);
+  }
+
+  void Record(const char* entry_point_name, uint32_t workgroup_x,
+              iree_duration_t wall_time_ns,
+              std::initializer_list<iree_duration_t> worker_busy_ns) {
+    iree_hal_dispatch_profile_record_t record;
+    record.executable_name = iree_make_cstring_view("module_dispatch");
+    record.entry_point_name = iree_make_cstring_view(entry_point_name);
+    record.workgroup_count[0] = workgroup_x;
+    record.workgroup_count[1] = 1;
+    record.workgroup_count[2] = 1;
+    record.tile_count = workgroup_x;
+    record.wall_time_ns = wall_time_ns;
+    record.worker_count = worker_busy_ns.size();
+    record.worker_busy_ns = worker_busy_ns.begin();
+    IREE_ASSERT_OK(iree_hal_dispatch_profiler_record(profiler_, &record));
+  }
+
+  std::string Dump(iree_hal_dispatch_profile_format_t format) {
+    FILE* file = tmpfile();
+    IREE_EXPECT_OK(iree_hal_dispatch_profiler_dump(profiler_, format, file));
+    std::string contents(ftell(file), '\0');
+    rewind(file);
+    EXPECT_EQ(contents.size(),
+              fread(&contents[0], 1, contents.size(), file));
+    fclose(file);
+    return contents;
+  }
+
+  iree_hal_dispatch_profiler_t* profiler_ = nullptr;
+};
+
+TEST_F(DispatchProfilerTest, Enable) {
+  EXPECT_FALSE(iree_hal_dispatch_profiler_is_enabled(profiler_));
+  iree_hal_dispatch_profiler_set_enabled(profiler_, true);
+  EXPECT_TRUE(iree_hal_dispatch_profiler_is_enabled(profiler_));
+  iree_hal_dispatch_profiler_set_enabled(profiler_, false);
+  EXPECT_FALSE(iree_hal_dispatch_profiler_is_enabled(profiler_));
+}
+
+TEST_F(DispatchProfilerTest, EmptyCsv) {
+  EXPECT_EQ(
+      "executable,entry_point,workgroup_count,dispatches,tiles,"
+      "total_wall_ms,mean_wall_us,min_wall_us,max_wall_us,total_busy_ms,"
+      "workers,max_worker_busy_ms,efficiency\n",
+      Dump(IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV));
+}
+
+TEST_F(DispatchProfilerTest, AggregatesAndSortsCsv) {
+  // Two dispatches of the same entry point and workgroup count aggregate.
+  Record("fast", 4, 1000000, {1000000, 0, 1000000});
+  Record("slow", 2, 3000000, {3000000, 3000000});
+  Record("fast", 4, 3000000, {3000000, 0, 1000000});
+  // Different workgroup counts are reported separately.
+  Record("fast", 8, 500000, {500000});
+
+  std::string lines = Dump(IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV);
+  size_t header_end = lines.find('\n');
+  ASSERT_NE(std::string::npos, header_end);
+  EXPECT_EQ(
+      "\"module_dispatch\",\"fast\",4x1x1,2,8,4.000,2000.000,1000.000,"
+      "3000.000,6.000,2,4.000,0.750\n"
+      "\"module_dispatch\",\"slow\",2x1x1,1,2,3.000,3000.000,3000.000,"
+      "3000.000,6.000,2,3.000,1.000\n"
+      "\"module_dispatch\",\"fast\",8x1x1,1,8,0.500,500.000,500.000,"
+      "500.000,0.500,1,0.500,1.000\n",
+      lines.substr(header_end + 1));
+}
+
+TEST_F(DispatchProfilerTest, Json) {
+  Record("entry\"quoted", 2, 2000000, {1000000, 0, 2000000});
+  EXPECT_EQ(
+      "[\n"
+      "  {\"executable\": \"module_dispatch\", "
+      "\"entry_point\": \"entry\\\"quoted\", \"workgroup_count\": [2, 1, 1], "
+      "\"dispatches\": 1, \"tiles\": 2, \"total_wall_ms\": 2.000, "
+      "\"mean_wall_us\": 2000.000, \"min_wall_us\": 2000.000, "
+      "\"max_wall_us\": 2000.000, \"total_busy_ms\": 3.000, \"workers\": 2, "
+      "\"efficiency\": 0.750, \"worker_busy_ms\": [1.000, 0.000, 2.000]}\n"
+      "]\n",
+      Dump(IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON));
+}
+
+TEST_F(DispatchProfilerTest, Reset) {
+  Record("entry", 1, 1000, {1000});
+  iree_hal_dispatch_profiler_reset(profiler_);
+  EXPECT_EQ("[\n]\n", Dump(IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON));
+}
+
+}  // namespace
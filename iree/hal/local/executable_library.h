@@ -153,7 +153,8 @@ typedef struct {
 
   // Total number of available 4 byte push constant values in |push_constants|.
   size_t push_constant_count;
-  // |push_constant_count| values.
+  // |push_constant_count| values. All values declared by the executable layout
+  // are provided contiguously regardless of how many there are.
   const uint32_t* push_constants;
 
   // Total number of binding base pointers in |binding_ptrs| and
@@ -59,7 +59,7 @@ struct {
   int32_t push_constant_count;
   union {
     uint32_t ui32;
-  } push_constants[IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT];
+  } push_constants[IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT];
 
   int32_t binding_count;
   iree_string_view_t bindings[IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT];
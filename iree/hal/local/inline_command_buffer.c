@@ -57,6 +57,12 @@ typedef struct {
     // during recording to allow for partial push_constants updates.
     uint32_t push_constants[IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT];
 
+    // Storage for all IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT push
+    // constants allocated the first time a push or dispatch needs more than
+    // the inline |push_constants|. Once allocated it holds the inline values
+    // as well and replaces |push_constants|.
+    uint32_t* extended_push_constants;
+
     // Cached and initialized dispatch state reused for all dispatches.
     // Individual dispatches must populate the dynamically changing fields like
     // push_constant_count and binding_count.
@@ -75,6 +81,8 @@ static iree_hal_inline_command_buffer_t* iree_hal_inline_command_buffer_cast(
 
 static void iree_hal_inline_command_buffer_reset(
     iree_hal_inline_command_buffer_t* command_buffer) {
+  iree_allocator_free(iree_hal_device_host_allocator(command_buffer->device),
+                      command_buffer->state.extended_push_constants);
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
 
   // Setup the cached dispatch state pointers that don't change.
@@ -287,6 +295,32 @@ static iree_status_t iree_hal_inline_command_buffer_copy_buffer(
 //===----------------------------------------------------------------------===//
 // NOTE: command buffer state change only; enqueues no tasks.
 
+// Returns the push constant storage with room for at least |count| values.
+// Switches to the extended push constant storage if the inline storage is too
+// small such that executables always see a single contiguous array.
+static iree_status_t iree_hal_inline_command_buffer_push_constant_storage(
+    iree_hal_inline_command_buffer_t* command_buffer, iree_host_size_t count,
+    uint32_t** out_push_constants) {
+  *out_push_constants = NULL;
+  if (command_buffer->state.extended_push_constants) {
+    *out_push_constants = command_buffer->state.extended_push_constants;
+  } else if (count <= IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT) {
+    *out_push_constants = command_buffer->state.push_constants;
+  } else {
+    // NOTE: the allocation is zero-initialized.
+    uint32_t* extended_push_constants = NULL;
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        iree_hal_device_host_allocator(command_buffer->device),
+        IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT * sizeof(uint32_t),
+        (void**)&extended_push_constants));
+    memcpy(extended_push_constants, command_buffer->state.push_constants,
+           sizeof(command_buffer->state.push_constants));
+    command_buffer->state.extended_push_constants = extended_push_constants;
+    *out_push_constants = extended_push_constants;
+  }
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_inline_command_buffer_push_constants(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
@@ -294,15 +328,21 @@ static iree_status_t iree_hal_inline_command_buffer_push_constants(
   iree_hal_inline_command_buffer_t* command_buffer =
       iree_hal_inline_command_buffer_cast(base_command_buffer);
 
-  if (IREE_UNLIKELY(offset + values_length >=
-                    sizeof(command_buffer->state.push_constants))) {
+  if (IREE_UNLIKELY(offset + values_length >
+                    IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT *
+                        sizeof(uint32_t))) {
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "push constant range %zu (length=%zu) out of range",
                             offset, values_length);
   }
 
-  memcpy((uint8_t*)&command_buffer->state.push_constants + offset, values,
-         values_length);
+  uint32_t* push_constants = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_inline_command_buffer_push_constant_storage(
+      command_buffer,
+      iree_host_align(offset + values_length, sizeof(uint32_t)) /
+          sizeof(uint32_t),
+      &push_constants));
+  memcpy((uint8_t*)push_constants + offset, values, values_length);
 
   return iree_ok_status();
 }
@@ -403,7 +443,11 @@ static iree_status_t iree_hal_inline_command_buffer_dispatch(
   // Push constants are pulled directly from the command buffer state, but we
   // only allow the dispatch to read what we know is initialized based on the
   // layout.
+  uint32_t* push_constants = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_inline_command_buffer_push_constant_storage(
+      command_buffer, local_layout->push_constants, &push_constants));
   dispatch_state->push_constant_count = local_layout->push_constants;
+  dispatch_state->push_constants = push_constants;
 
   // Produce the dense binding list based on the declared bindings used.
   // This allows us to change the descriptor sets and bindings counts supported
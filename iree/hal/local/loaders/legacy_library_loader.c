@@ -164,6 +164,11 @@ static iree_status_t iree_hal_legacy_executable_query_library(
   }
 
   executable->identifier = iree_make_cstring_view(header->name);
+  executable->base.identifier = executable->identifier;
+  executable->base.entry_point_count =
+      executable->library.v0->entry_point_count;
+  executable->base.entry_point_names =
+      executable->library.v0->entry_point_names;
 
   return iree_ok_status();
 }
@@ -63,6 +63,11 @@ static iree_status_t iree_hal_static_executable_create(
         &executable->base);
     executable->library.header = library_header;
     executable->identifier = iree_make_cstring_view(library_header->name);
+    executable->base.identifier = executable->identifier;
+    executable->base.entry_point_count =
+        executable->library.v0->entry_point_count;
+    executable->base.entry_point_names =
+        executable->library.v0->entry_point_names;
     *out_executable = (iree_hal_executable_t*)executable;
   }
 
@@ -28,6 +28,10 @@ void iree_hal_local_executable_initialize(
   iree_hal_resource_initialize(vtable, &out_base_executable->resource);
   out_base_executable->host_allocator = host_allocator;
 
+  out_base_executable->identifier = iree_string_view_empty();
+  out_base_executable->entry_point_count = 0;
+  out_base_executable->entry_point_names = NULL;
+
   out_base_executable->executable_layout_count = executable_layout_count;
   out_base_executable->executable_layouts = target_executable_layouts;
   for (iree_host_size_t i = 0; i < executable_layout_count; ++i) {
@@ -51,6 +55,16 @@ iree_hal_local_executable_t* iree_hal_local_executable_cast(
   return (iree_hal_local_executable_t*)base_value;
 }
 
+iree_string_view_t iree_hal_local_executable_entry_point_name(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal) {
+  if (!executable->entry_point_names ||
+      ordinal >= executable->entry_point_count ||
+      !executable->entry_point_names[ordinal]) {
+    return iree_string_view_empty();
+  }
+  return iree_make_cstring_view(executable->entry_point_names[ordinal]);
+}
+
 iree_status_t iree_hal_local_executable_issue_call(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
@@ -67,11 +81,18 @@ iree_status_t iree_hal_local_executable_issue_dispatch_inline(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  // TODO(benvanik): annotate with executable name to calculate total time.
 
   const iree_hal_vec3_t workgroup_count = dispatch_state->workgroup_count;
 
 #if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  // Annotate with the entry point name so that total time per entry point can
+  // be calculated.
+  iree_string_view_t entry_point_name =
+      iree_hal_local_executable_entry_point_name(executable, ordinal);
+  if (!iree_string_view_is_empty(entry_point_name)) {
+    IREE_TRACE_ZONE_APPEND_TEXT_STRING_VIEW(z0, entry_point_name.data,
+                                            entry_point_name.size);
+  }
   char xyz_string[32];
   int xyz_string_length =
       snprintf(xyz_string, IREE_ARRAYSIZE(xyz_string), "%ux%ux%u",
@@ -29,6 +29,13 @@ typedef struct {
   iree_allocator_t host_allocator;
   iree_host_size_t executable_layout_count;
   iree_hal_local_executable_layout_t** executable_layouts;
+
+  // Optional names used for attributing time in tracing and profiling.
+  // Populated by loaders that have the information available; the storage is
+  // owned by the loaded library and valid for the lifetime of the executable.
+  iree_string_view_t identifier;
+  iree_host_size_t entry_point_count;
+  const char* const* entry_point_names;
 } iree_hal_local_executable_t;
 
 typedef struct {
@@ -56,6 +63,11 @@ void iree_hal_local_executable_deinitialize(
 iree_hal_local_executable_t* iree_hal_local_executable_cast(
     iree_hal_executable_t* base_value);
 
+// Returns the name of the entry point at |ordinal| or an empty string view if
+// the loader did not provide names.
+iree_string_view_t iree_hal_local_executable_entry_point_name(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal);
+
 iree_status_t iree_hal_local_executable_issue_call(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
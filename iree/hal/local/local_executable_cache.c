@@ -15,11 +15,30 @@
 #include "iree/hal/local/local_executable_cache.h"
 
 #include "iree/base/tracing.h"
+#include "iree/hal/local/cpu_features.h"
+
+// flatcc schemas:
+#include "iree/base/internal/flatcc.h"
+#include "iree/schemas/executable_variants_def_reader.h"
+#include "iree/schemas/executable_variants_def_verifier.h"
+
+// Executable format of a bundle of CPU feature variants of the same executable.
+// The cache selects the first variant supported by the host and prepares that
+// using the registered loaders.
+#define IREE_HAL_LOCAL_EXECUTABLE_VARIANTS_FORMAT "EX_VARIANTS"
+
+static bool iree_hal_executable_format_is_variants(
+    iree_string_view_t executable_format) {
+  return iree_string_view_equal(
+      executable_format,
+      iree_make_cstring_view(IREE_HAL_LOCAL_EXECUTABLE_VARIANTS_FORMAT));
+}
 
 typedef struct {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
   iree_string_view_t identifier;
+  iree_hal_local_parallel_for_t parallel_for;
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_local_executable_cache_t;
@@ -35,7 +54,8 @@ static iree_hal_local_executable_cache_t* iree_hal_local_executable_cache_cast(
 
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_local_parallel_for_t parallel_for, iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(out_executable_cache);
@@ -56,6 +76,7 @@ iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_append_to_buffer(
         identifier, &executable_cache->identifier,
         (char*)executable_cache + total_size - identifier.size);
+    executable_cache->parallel_for = parallel_for;
 
     executable_cache->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
@@ -64,6 +85,8 @@ iree_status_t iree_hal_local_executable_cache_create(
     }
 
     *out_executable_cache = (iree_hal_executable_cache_t*)executable_cache;
+  } else if (parallel_for.release) {
+    parallel_for.release(parallel_for.self);
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -80,6 +103,9 @@ static void iree_hal_local_executable_cache_destroy(
   for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
     iree_hal_executable_loader_release(executable_cache->loaders[i]);
   }
+  if (executable_cache->parallel_for.release) {
+    executable_cache->parallel_for.release(executable_cache->parallel_for.self);
+  }
   iree_allocator_free(host_allocator, executable_cache);
 
   IREE_TRACE_ZONE_END(z0);
@@ -91,6 +117,11 @@ static bool iree_hal_local_executable_cache_can_prepare_format(
     iree_string_view_t executable_format) {
   iree_hal_local_executable_cache_t* executable_cache =
       iree_hal_local_executable_cache_cast(base_executable_cache);
+  if (iree_hal_executable_format_is_variants(executable_format)) {
+    // Whether any variant is usable depends on the contents; we'll find out
+    // when preparing.
+    return true;
+  }
   for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
     if (iree_hal_executable_loader_query_support(
             executable_cache->loaders[i], caching_mode, executable_format)) {
@@ -100,12 +131,120 @@ static bool iree_hal_local_executable_cache_can_prepare_format(
   return false;
 }
 
+// Verifies the structure of the variants flatbuffer so that we can avoid doing
+// so during selection.
+static iree_status_t iree_hal_executable_variants_flatbuffer_verify(
+    iree_const_byte_span_t flatbuffer_data) {
+  if (!flatbuffer_data.data || flatbuffer_data.data_length < 16) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "flatbuffer data is not present or less than 16 bytes (%zu total)",
+        flatbuffer_data.data_length);
+  }
+
+  // Run flatcc generated verification. This ensures all pointers are in-bounds
+  // and that we can safely walk the file, but not that the actual contents of
+  // the flatbuffer meet our expectations.
+  int verify_ret = iree_ExecutableVariantsDef_verify_as_root(
+      flatbuffer_data.data, flatbuffer_data.data_length);
+  if (verify_ret != flatcc_verify_ok) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flatbuffer verification failed: %s",
+                            flatcc_verify_error_string(verify_ret));
+  }
+
+  iree_ExecutableVariantsDef_table_t variants_def =
+      iree_ExecutableVariantsDef_as_root(flatbuffer_data.data);
+  iree_ExecutableVariantDef_vec_t variants_vec =
+      iree_ExecutableVariantsDef_variants_get(variants_def);
+  for (size_t i = 0; i < iree_ExecutableVariantDef_vec_len(variants_vec);
+       ++i) {
+    iree_ExecutableVariantDef_table_t variant_def =
+        iree_ExecutableVariantDef_vec_at(variants_vec, i);
+    if (!flatbuffers_string_len(
+            iree_ExecutableVariantDef_executable_format_get(variant_def)) ||
+        !flatbuffers_uint8_vec_len(
+            iree_ExecutableVariantDef_executable_data_get(variant_def))) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "executable variant %zu format/data is missing",
+                              i);
+    }
+  }
+
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_local_executable_cache_prepare_executable(
+    iree_hal_executable_cache_t* base_executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable);
+
+// Selects the first variant in the bundle that the host CPU supports and that
+// any of the loaders can handle and prepares it.
+static iree_status_t iree_hal_local_executable_cache_prepare_variant(
+    iree_hal_executable_cache_t* base_executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  IREE_RETURN_IF_ERROR(iree_hal_executable_variants_flatbuffer_verify(
+      executable_spec->executable_data));
+  iree_ExecutableVariantsDef_table_t variants_def =
+      iree_ExecutableVariantsDef_as_root(
+          executable_spec->executable_data.data);
+  iree_ExecutableVariantDef_vec_t variants_vec =
+      iree_ExecutableVariantsDef_variants_get(variants_def);
+  for (size_t i = 0; i < iree_ExecutableVariantDef_vec_len(variants_vec);
+       ++i) {
+    iree_ExecutableVariantDef_table_t variant_def =
+        iree_ExecutableVariantDef_vec_at(variants_vec, i);
+    flatbuffers_string_t cpu_features =
+        iree_ExecutableVariantDef_cpu_features_get(variant_def);
+    if (!iree_hal_cpu_supports_features(iree_make_string_view(
+            cpu_features, flatbuffers_string_len(cpu_features)))) {
+      continue;
+    }
+    flatbuffers_string_t executable_format =
+        iree_ExecutableVariantDef_executable_format_get(variant_def);
+    iree_string_view_t variant_format = iree_make_string_view(
+        executable_format, flatbuffers_string_len(executable_format));
+    if (iree_hal_executable_format_is_variants(variant_format)) {
+      // No nesting; otherwise we'd need to guard against cycles.
+      continue;
+    }
+    if (!iree_hal_local_executable_cache_can_prepare_format(
+            base_executable_cache, executable_spec->caching_mode,
+            variant_format)) {
+      continue;
+    }
+    flatbuffers_uint8_vec_t executable_data =
+        iree_ExecutableVariantDef_executable_data_get(variant_def);
+    iree_hal_executable_spec_t variant_spec = *executable_spec;
+    variant_spec.executable_format = variant_format;
+    variant_spec.executable_data = iree_make_const_byte_span(
+        executable_data, flatbuffers_uint8_vec_len(executable_data));
+    IREE_TRACE_ZONE_BEGIN(z0);
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, cpu_features,
+                                flatbuffers_string_len(cpu_features));
+    iree_status_t status = iree_hal_local_executable_cache_prepare_executable(
+        base_executable_cache, &variant_spec, out_executable);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  return iree_make_status(IREE_STATUS_NOT_FOUND,
+                          "no executable variant is supported by the host CPU "
+                          "and the registered executable loaders");
+}
+
 static iree_status_t iree_hal_local_executable_cache_prepare_executable(
     iree_hal_executable_cache_t* base_executable_cache,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable) {
   iree_hal_local_executable_cache_t* executable_cache =
       iree_hal_local_executable_cache_cast(base_executable_cache);
+  if (iree_hal_executable_format_is_variants(
+          executable_spec->executable_format)) {
+    return iree_hal_local_executable_cache_prepare_variant(
+        base_executable_cache, executable_spec, out_executable);
+  }
   for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
     if (!iree_hal_executable_loader_query_support(
             executable_cache->loaders[i], executable_spec->caching_mode,
@@ -134,6 +273,72 @@ static iree_status_t iree_hal_local_executable_cache_prepare_executable(
       executable_spec->executable_format.data);
 }
 
+// Shared state for a batch of executables prepared concurrently.
+typedef struct {
+  iree_hal_executable_cache_t* executable_cache;
+  const iree_hal_executable_spec_t* executable_specs;
+  iree_hal_executable_t** executables;
+  iree_status_t* statuses;
+} iree_hal_local_executable_cache_batch_t;
+
+static void iree_hal_local_executable_cache_prepare_index(
+    void* user_data, iree_host_size_t index) {
+  iree_hal_local_executable_cache_batch_t* batch =
+      (iree_hal_local_executable_cache_batch_t*)user_data;
+  // Failures are reported per executable so that one failing does not prevent
+  // releasing what the others prepared.
+  batch->statuses[index] = iree_hal_local_executable_cache_prepare_executable(
+      batch->executable_cache, &batch->executable_specs[index],
+      &batch->executables[index]);
+}
+
+static iree_status_t iree_hal_local_executable_cache_prepare_executables(
+    iree_hal_executable_cache_t* base_executable_cache,
+    iree_host_size_t executable_count,
+    const iree_hal_executable_spec_t* executable_specs,
+    iree_hal_executable_t** out_executables) {
+  iree_hal_local_executable_cache_t* executable_cache =
+      iree_hal_local_executable_cache_cast(base_executable_cache);
+
+  // Without workers (or anything to parallelize) we prepare inline.
+  if (!executable_cache->parallel_for.fn || executable_count < 2) {
+    for (iree_host_size_t i = 0; i < executable_count; ++i) {
+      IREE_RETURN_IF_ERROR(iree_hal_local_executable_cache_prepare_executable(
+          base_executable_cache, &executable_specs[i], &out_executables[i]));
+    }
+    return iree_ok_status();
+  }
+
+  iree_status_t* statuses = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      executable_cache->host_allocator, executable_count * sizeof(*statuses),
+      (void**)&statuses));
+  for (iree_host_size_t i = 0; i < executable_count; ++i) {
+    statuses[i] = iree_ok_status();
+  }
+
+  iree_hal_local_executable_cache_batch_t batch = {
+      .executable_cache = base_executable_cache,
+      .executable_specs = executable_specs,
+      .executables = out_executables,
+      .statuses = statuses,
+  };
+  iree_status_t status = executable_cache->parallel_for.fn(
+      executable_cache->parallel_for.self, executable_count,
+      iree_hal_local_executable_cache_prepare_index, &batch);
+
+  // Report the first failure in spec order to keep errors deterministic.
+  for (iree_host_size_t i = 0; i < executable_count; ++i) {
+    if (iree_status_is_ok(status)) {
+      status = statuses[i];
+    } else {
+      iree_status_ignore(statuses[i]);
+    }
+  }
+  iree_allocator_free(executable_cache->host_allocator, statuses);
+  return status;
+}
+
 static const iree_hal_executable_cache_vtable_t
     iree_hal_local_executable_cache_vtable = {
         .destroy = iree_hal_local_executable_cache_destroy,
@@ -141,4 +346,6 @@ static const iree_hal_executable_cache_vtable_t
             iree_hal_local_executable_cache_can_prepare_format,
         .prepare_executable =
             iree_hal_local_executable_cache_prepare_executable,
+        .prepare_executables =
+            iree_hal_local_executable_cache_prepare_executables,
 };
@@ -31,9 +31,42 @@ extern "C" {
 // one device is the same JIT'ed executable in another, and in multi-tenant
 // situations we're likely to want that isolation _and_ sharing.
 
+// Function run by iree_hal_local_parallel_for_t for each index.
+typedef void (*iree_hal_local_parallel_for_index_fn_t)(void* user_data,
+                                                        iree_host_size_t index);
+
+// Runs work across the threads of a device.
+// This lets the cache parallelize without depending on any particular
+// threading implementation; devices without threads provide none.
+typedef struct {
+  // Opaque state passed to the functions below.
+  void* self;
+  // Calls |index_fn| once for each index in [0, count) and returns once all
+  // calls have completed. Calls may run concurrently in any order. Errors are
+  // only returned if not all indices could be run.
+  iree_status_t (*fn)(void* self, iree_host_size_t count,
+                      iree_hal_local_parallel_for_index_fn_t index_fn,
+                      void* user_data);
+  // Releases |self| when the owner no longer needs it. May be NULL.
+  void (*release)(void* self);
+} iree_hal_local_parallel_for_t;
+
+// Returns a parallel-for that is not available; work runs on the caller.
+static inline iree_hal_local_parallel_for_t iree_hal_local_parallel_for_null(
+    void) {
+  iree_hal_local_parallel_for_t v = {NULL, NULL, NULL};
+  return v;
+}
+
+// Creates an executable cache preparing executables with |loaders|.
+// If a |parallel_for| is provided batches of executables prepared with
+// iree_hal_executable_cache_prepare_executables are loaded concurrently with
+// it. The cache takes ownership of |parallel_for| and releases it when
+// destroyed, including if creation fails.
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_local_parallel_for_t parallel_for, iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache);
 
 #ifdef __cplusplus
@@ -0,0 +1,352 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/local_executable_cache.h"
+
+#include <atomic>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+// NOTE: order matters here as flatcc requires its headers first.
+// clang-format off
+#include "iree/base/internal/flatcc.h"
+#include "iree/schemas/executable_variants_def_builder.h"
+// clang-format on
+
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+//===----------------------------------------------------------------------===//
+// Test executables and loader
+//===----------------------------------------------------------------------===//
+
+// Executable that remembers the data it was loaded from.
+struct TestExecutable {
+  iree_hal_resource_t resource;
+  std::string data;
+  std::atomic<int>* live_count;
+};
+
+static void TestExecutableDestroy(iree_hal_executable_t* base_executable) {
+  auto* executable = reinterpret_cast<TestExecutable*>(base_executable);
+  --*executable->live_count;
+  delete executable;
+}
+
+static const iree_hal_executable_vtable_t test_executable_vtable = {
+    /*.destroy=*/TestExecutableDestroy,
+};
+
+// Loader accepting the "TEST" format. Executables whose data starts with
+// "fail" fail to load.
+struct TestLoader {
+  iree_hal_executable_loader_t base;
+  std::atomic<int> live_count{0};
+};
+
+static void TestLoaderDestroy(iree_hal_executable_loader_t* base_loader) {
+  delete reinterpret_cast<TestLoader*>(base_loader);
+}
+
+static bool TestLoaderQuerySupport(
+    iree_hal_executable_loader_t* base_loader,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_string_view_t executable_format) {
+  return iree_string_view_equal(executable_format,
+                                iree_make_cstring_view("TEST"));
+}
+
+static iree_status_t TestLoaderTryLoad(
+    iree_hal_executable_loader_t* base_loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  auto* loader = reinterpret_cast<TestLoader*>(base_loader);
+  std::string data(
+      reinterpret_cast<const char*>(executable_spec->executable_data.data),
+      executable_spec->executable_data.data_length);
+  if (data.compare(0, 4, "fail") == 0) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS, "failing executable '%s'",
+                            data.c_str());
+  }
+  auto* executable = new TestExecutable();
+  iree_hal_resource_initialize(&test_executable_vtable, &executable->resource);
+  executable->data = data;
+  executable->live_count = &loader->live_count;
+  ++loader->live_count;
+  *out_executable = reinterpret_cast<iree_hal_executable_t*>(executable);
+  return iree_ok_status();
+}
+
+static const iree_hal_executable_loader_vtable_t test_loader_vtable = {
+    /*.destroy=*/TestLoaderDestroy,
+    /*.query_support=*/TestLoaderQuerySupport,
+    /*.try_load=*/TestLoaderTryLoad,
+};
+
+struct Variant {
+  const char* cpu_features;
+  const char* executable_format;
+  const char* executable_data;
+};
+
+// Returns an EX_VARIANTS flatbuffer containing |variants| in order.
+std::vector<uint8_t> BuildVariants(std::initializer_list<Variant> variants) {
+  flatcc_builder_t builder;
+  flatcc_builder_init(&builder);
+  iree_ExecutableVariantsDef_start_as_root(&builder);
+  iree_ExecutableVariantsDef_variants_start(&builder);
+  for (const Variant& variant : variants) {
+    iree_ExecutableVariantsDef_variants_push_start(&builder);
+    iree_ExecutableVariantDef_cpu_features_create_str(&builder,
+                                                      variant.cpu_features);
+    iree_ExecutableVariantDef_executable_format_create_str(
+        &builder, variant.executable_format);
+    iree_ExecutableVariantDef_executable_data_create(
+        &builder, reinterpret_cast<const uint8_t*>(variant.executable_data),
+        strlen(variant.executable_data));
+    iree_ExecutableVariantsDef_variants_push_end(&builder);
+  }
+  iree_ExecutableVariantsDef_variants_end(&builder);
+  iree_ExecutableVariantsDef_end_as_root(&builder);
+  size_t size = 0;
+  void* data = flatcc_builder_finalize_aligned_buffer(&builder, &size);
+  std::vector<uint8_t> buffer(static_cast<uint8_t*>(data),
+                              static_cast<uint8_t*>(data) + size);
+  flatcc_builder_aligned_free(data);
+  flatcc_builder_clear(&builder);
+  return buffer;
+}
+
+class LocalExecutableCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    loader_ = new TestLoader();
+    iree_hal_executable_loader_initialize(&test_loader_vtable, &loader_->base);
+    iree_hal_executable_loader_t* loaders[] = {&loader_->base};
+    IREE_ASSERT_OK(iree_hal_local_executable_cache_create(
+        iree_make_cstring_view("test"), IREE_ARRAYSIZE(loaders), loaders,
+        iree_hal_local_parallel_for_null(), iree_allocator_system(),
+        &executable_cache_));
+  }
+
+  void TearDown() override {
+    iree_hal_executable_cache_release(executable_cache_);
+    iree_hal_executable_cache_release(task_executable_cache_);
+    iree_hal_device_release(task_device_);
+    iree_task_executor_release(executor_);
+    EXPECT_EQ(0, loader_->live_count);
+    iree_hal_executable_loader_release(&loader_->base);
+  }
+
+  // Returns the executable cache of a task device that prepares batches on the
+  // workers of its executor.
+  iree_hal_executable_cache_t* GetTaskExecutableCache() {
+    if (task_executable_cache_) return task_executable_cache_;
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(4, &topology);
+    IREE_CHECK_OK(iree_task_executor_create(IREE_TASK_SCHEDULING_MODE_RESERVED,
+                                            &topology, iree_allocator_system(),
+                                            &executor_));
+    iree_task_topology_deinitialize(&topology);
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    iree_hal_executable_loader_t* loaders[] = {&loader_->base};
+    IREE_CHECK_OK(iree_hal_task_device_create(
+        iree_make_cstring_view("task"), &params, executor_,
+        IREE_ARRAYSIZE(loaders), loaders, iree_allocator_system(),
+        &task_device_));
+    IREE_CHECK_OK(iree_hal_executable_cache_create(
+        task_device_, iree_make_cstring_view("test"),
+        &task_executable_cache_));
+    return task_executable_cache_;
+  }
+
+  // Prepares one TEST executable for each of |datas| with |executable_cache|
+  // and returns the data each was loaded from in |out_datas|.
+  iree_status_t PrepareBatch(iree_hal_executable_cache_t* executable_cache,
+                             const std::vector<std::string>& datas,
+                             std::vector<std::string>* out_datas) {
+    std::vector<iree_hal_executable_spec_t> specs(datas.size());
+    for (size_t i = 0; i < datas.size(); ++i) {
+      iree_hal_executable_spec_initialize(&specs[i]);
+      specs[i].executable_format = iree_make_cstring_view("TEST");
+      specs[i].executable_data = iree_make_const_byte_span(
+          datas[i].data(), datas[i].size());
+    }
+    std::vector<iree_hal_executable_t*> executables(datas.size(), nullptr);
+    iree_status_t status = iree_hal_executable_cache_prepare_executables(
+        executable_cache, specs.size(), specs.data(), executables.data());
+    out_datas->clear();
+    for (iree_hal_executable_t* executable : executables) {
+      if (!iree_status_is_ok(status)) {
+        // All executables must be released on failure.
+        EXPECT_EQ(nullptr, executable);
+        continue;
+      }
+      out_datas->push_back(reinterpret_cast<TestExecutable*>(executable)->data);
+      iree_hal_executable_release(executable);
+    }
+    return status;
+  }
+
+  iree_status_t PrepareVariants(const std::vector<uint8_t>& bundle,
+                                iree_hal_executable_t** out_executable) {
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = iree_make_cstring_view("EX_VARIANTS");
+    spec.executable_data =
+        iree_make_const_byte_span(bundle.data(), bundle.size());
+    return iree_hal_executable_cache_prepare_executable(executable_cache_,
+                                                        &spec, out_executable);
+  }
+
+  // Prepares |bundle| and returns the data of the selected variant.
+  std::string SelectVariant(const std::vector<uint8_t>& bundle) {
+    iree_hal_executable_t* executable = NULL;
+    IREE_EXPECT_OK(PrepareVariants(bundle, &executable));
+    if (!executable) return "";
+    std::string data = reinterpret_cast<TestExecutable*>(executable)->data;
+    iree_hal_executable_release(executable);
+    return data;
+  }
+
+  TestLoader* loader_ = nullptr;
+  iree_hal_executable_cache_t* executable_cache_ = nullptr;
+  iree_task_executor_t* executor_ = nullptr;
+  iree_hal_device_t* task_device_ = nullptr;
+  iree_hal_executable_cache_t* task_executable_cache_ = nullptr;
+};
+
+// Returns |count| distinct executable datas.
+std::vector<std::string> MakeDatas(size_t count) {
+  std::vector<std::string> datas;
+  for (size_t i = 0; i < count; ++i) {
+    datas.push_back("executable" + std::to_string(i));
+  }
+  return datas;
+}
+
+TEST_F(LocalExecutableCacheTest, SelectsFirstSupportedVariant) {
+  EXPECT_EQ("a", SelectVariant(BuildVariants({
+                     {"-avx512f", "TEST", "a"},
+                     {"", "TEST", "b"},
+                 })));
+  EXPECT_EQ("b", SelectVariant(BuildVariants({
+                     {"+iree-unknown-feature", "TEST", "a"},
+                     {"", "TEST", "b"},
+                     {"", "TEST", "c"},
+                 })));
+}
+
+TEST_F(LocalExecutableCacheTest, SkipsVariantsWithoutLoader) {
+  EXPECT_EQ("b", SelectVariant(BuildVariants({
+                     {"", "UNKNOWN_FORMAT", "a"},
+                     {"", "TEST", "b"},
+                 })));
+}
+
+TEST_F(LocalExecutableCacheTest, SkipsNestedVariants) {
+  EXPECT_EQ("b", SelectVariant(BuildVariants({
+                     {"", "EX_VARIANTS", "a"},
+                     {"", "TEST", "b"},
+                 })));
+}
+
+TEST_F(LocalExecutableCacheTest, NoSupportedVariant) {
+  iree_hal_executable_t* executable = NULL;
+  EXPECT_THAT(iree::Status(PrepareVariants(
+                  BuildVariants({
+                      {"+iree-unknown-feature", "TEST", "a"},
+                      {"", "UNKNOWN_FORMAT", "b"},
+                  }),
+                  &executable)),
+              StatusIs(iree::StatusCode::kNotFound));
+  EXPECT_EQ(NULL, executable);
+}
+
+TEST_F(LocalExecutableCacheTest, SelectedVariantLoadFailure) {
+  // Load failures of the selected variant are reported instead of falling back
+  // to later variants.
+  iree_hal_executable_t* executable = NULL;
+  EXPECT_THAT(iree::Status(PrepareVariants(BuildVariants({
+                                               {"", "TEST", "fail"},
+                                               {"", "TEST", "b"},
+                                           }),
+                                           &executable)),
+              StatusIs(iree::StatusCode::kDataLoss));
+  EXPECT_EQ(NULL, executable);
+}
+
+TEST_F(LocalExecutableCacheTest, MalformedVariants) {
+  const uint8_t garbage[32] = {0};
+  iree_hal_executable_spec_t spec;
+  iree_hal_executable_spec_initialize(&spec);
+  spec.executable_format = iree_make_cstring_view("EX_VARIANTS");
+  spec.executable_data = iree_make_const_byte_span(garbage, sizeof(garbage));
+  iree_hal_executable_t* executable = NULL;
+  EXPECT_THAT(iree::Status(iree_hal_executable_cache_prepare_executable(
+                  executable_cache_, &spec, &executable)),
+              StatusIs(iree::StatusCode::kInvalidArgument));
+}
+
+TEST_F(LocalExecutableCacheTest, PrepareExecutablesInline) {
+  std::vector<std::string> datas = MakeDatas(5);
+  std::vector<std::string> prepared_datas;
+  IREE_EXPECT_OK(PrepareBatch(executable_cache_, datas, &prepared_datas));
+  EXPECT_EQ(datas, prepared_datas);
+}
+
+TEST_F(LocalExecutableCacheTest, PrepareExecutablesOnExecutor) {
+  // More executables than workers so that some prepare more than one.
+  std::vector<std::string> datas = MakeDatas(20);
+  std::vector<std::string> prepared_datas;
+  IREE_EXPECT_OK(
+      PrepareBatch(GetTaskExecutableCache(), datas, &prepared_datas));
+  EXPECT_EQ(datas, prepared_datas);
+}
+
+TEST_F(LocalExecutableCacheTest, PrepareExecutablesInlineFailure) {
+  std::vector<std::string> datas = MakeDatas(5);
+  datas[2] = "fail";
+  std::vector<std::string> prepared_datas;
+  EXPECT_THAT(
+      iree::Status(PrepareBatch(executable_cache_, datas, &prepared_datas)),
+      StatusIs(iree::StatusCode::kDataLoss));
+  EXPECT_EQ(0, loader_->live_count);
+}
+
+TEST_F(LocalExecutableCacheTest, PrepareExecutablesOnExecutorFailure) {
+  // Executables prepared concurrently with the failing one are released.
+  std::vector<std::string> datas = MakeDatas(20);
+  datas[7] = "fail";
+  std::vector<std::string> prepared_datas;
+  EXPECT_THAT(iree::Status(PrepareBatch(GetTaskExecutableCache(), datas,
+                                        &prepared_datas)),
+              StatusIs(iree::StatusCode::kDataLoss));
+  EXPECT_EQ(0, loader_->live_count);
+}
+
+}  // namespace
@@ -40,11 +40,11 @@ iree_status_t iree_hal_local_executable_layout_create(
                             set_layout_count,
                             IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT);
   }
-  if (push_constants > IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT) {
+  if (push_constants > IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT) {
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "push constant count %zu over the limit of %d",
                             push_constants,
-                            IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT);
+                            IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT);
   }
 
   IREE_TRACE_ZONE_BEGIN(z0);
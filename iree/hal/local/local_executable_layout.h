@@ -23,8 +23,16 @@ extern "C" {
 #endif  // __cplusplus
 
 #define IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT 2
+
+// Number of push constants stored inline in command buffer state.
 #define IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT 64
 
+// Total number of push constants an executable layout may declare. Constants
+// beyond IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT are stored in an extended
+// range owned by the command buffer and passed to executables in the same
+// contiguous push constant array.
+#define IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT 1024
+
 typedef uint64_t iree_hal_local_binding_mask_t;
 
 #define IREE_HAL_LOCAL_BINDING_MASK_BITS \
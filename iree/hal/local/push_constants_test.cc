@@ -0,0 +1,349 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the push constants seen by executables dispatched from the inline
+// (sync device) and task (task device) command buffers, including the
+// extended push constants beyond IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/local_executable.h"
+#include "iree/hal/local/local_executable_layout.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using ::iree::testing::status::StatusIs;
+using ::testing::ElementsAreArray;
+
+//===----------------------------------------------------------------------===//
+// Test executables and loader
+//===----------------------------------------------------------------------===//
+
+// Executable with a single entry point that records the push constants of the
+// last dispatch.
+struct TestExecutable {
+  iree_hal_local_executable_t base;
+  iree_hal_local_executable_layout_t* layouts[1];
+  std::vector<uint32_t>* observed_push_constants;
+};
+
+static void TestExecutableDestroy(iree_hal_executable_t* base_executable) {
+  auto* executable = reinterpret_cast<TestExecutable*>(base_executable);
+  iree_hal_local_executable_deinitialize(&executable->base);
+  delete executable;
+}
+
+static iree_status_t TestExecutableIssueCall(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id) {
+  auto* executable = reinterpret_cast<TestExecutable*>(base_executable);
+  executable->observed_push_constants->assign(
+      dispatch_state->push_constants,
+      dispatch_state->push_constants + dispatch_state->push_constant_count);
+  return iree_ok_status();
+}
+
+static const iree_hal_local_executable_vtable_t test_executable_vtable = {
+    /*.base=*/
+    {
+        /*.destroy=*/TestExecutableDestroy,
+    },
+    /*.issue_call=*/TestExecutableIssueCall,
+};
+
+// Loader accepting the "TEST" format.
+struct TestLoader {
+  iree_hal_executable_loader_t base;
+  std::vector<uint32_t> observed_push_constants;
+};
+
+static void TestLoaderDestroy(iree_hal_executable_loader_t* base_loader) {
+  delete reinterpret_cast<TestLoader*>(base_loader);
+}
+
+static bool TestLoaderQuerySupport(
+    iree_hal_executable_loader_t* base_loader,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_string_view_t executable_format) {
+  return iree_string_view_equal(executable_format,
+                                iree_make_cstring_view("TEST"));
+}
+
+static iree_status_t TestLoaderTryLoad(
+    iree_hal_executable_loader_t* base_loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  auto* loader = reinterpret_cast<TestLoader*>(base_loader);
+  if (executable_spec->executable_layout_count != 1) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "expected one executable layout");
+  }
+  auto* executable = new TestExecutable();
+  iree_hal_local_executable_initialize(
+      &test_executable_vtable, executable_spec->executable_layout_count,
+      executable_spec->executable_layouts, executable->layouts,
+      iree_allocator_system(), &executable->base);
+  executable->observed_push_constants = &loader->observed_push_constants;
+  *out_executable = reinterpret_cast<iree_hal_executable_t*>(executable);
+  return iree_ok_status();
+}
+
+static const iree_hal_executable_loader_vtable_t test_loader_vtable = {
+    /*.destroy=*/TestLoaderDestroy,
+    /*.query_support=*/TestLoaderQuerySupport,
+    /*.try_load=*/TestLoaderTryLoad,
+};
+
+//===----------------------------------------------------------------------===//
+// Tests
+//===----------------------------------------------------------------------===//
+
+enum class DeviceType {
+  kSync,  // inline command buffers
+  kTask,  // task command buffers
+};
+
+// Returns |count| distinct nonzero values starting at |first|.
+std::vector<uint32_t> MakeValues(uint32_t first, iree_host_size_t count) {
+  std::vector<uint32_t> values(count);
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    values[i] = 0xC0DE0000u + first + i;
+  }
+  return values;
+}
+
+class PushConstantsTest : public ::testing::TestWithParam<DeviceType> {
+ protected:
+  void SetUp() override {
+    loader_ = new TestLoader();
+    iree_hal_executable_loader_initialize(&test_loader_vtable, &loader_->base);
+    iree_hal_executable_loader_t* loaders[] = {&loader_->base};
+    if (GetParam() == DeviceType::kTask) {
+      iree_task_topology_t topology;
+      iree_task_topology_initialize_from_group_count(1, &topology);
+      IREE_ASSERT_OK(iree_task_executor_create(
+          IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+          iree_allocator_system(), &executor_));
+      iree_task_topology_deinitialize(&topology);
+      iree_hal_task_device_params_t params;
+      iree_hal_task_device_params_initialize(&params);
+      IREE_ASSERT_OK(iree_hal_task_device_create(
+          iree_make_cstring_view("task"), &params, executor_,
+          IREE_ARRAYSIZE(loaders), loaders, iree_allocator_system(),
+          &device_));
+    } else {
+      iree_hal_sync_device_params_t params;
+      iree_hal_sync_device_params_initialize(&params);
+      IREE_ASSERT_OK(iree_hal_sync_device_create(
+          iree_make_cstring_view("sync"), &params, IREE_ARRAYSIZE(loaders),
+          loaders, iree_allocator_system(), &device_));
+    }
+    IREE_ASSERT_OK(iree_hal_executable_cache_create(
+        device_, iree_make_cstring_view("test"), &executable_cache_));
+  }
+
+  void TearDown() override {
+    iree_hal_executable_cache_release(executable_cache_);
+    iree_hal_device_release(device_);
+    iree_task_executor_release(executor_);
+    iree_hal_executable_loader_release(&loader_->base);
+  }
+
+  // Creates a layout with |push_constant_count| push constants and an
+  // executable using it.
+  void PrepareExecutable(iree_host_size_t push_constant_count) {
+    IREE_ASSERT_OK(iree_hal_executable_layout_create(
+        device_, push_constant_count, /*set_layout_count=*/0,
+        /*set_layouts=*/NULL, &executable_layout_));
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = iree_make_cstring_view("TEST");
+    spec.executable_layout_count = 1;
+    spec.executable_layouts = &executable_layout_;
+    IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executable(
+        executable_cache_, &spec, &executable_));
+  }
+
+  void ReleaseExecutable() {
+    iree_hal_executable_release(executable_);
+    executable_ = NULL;
+    iree_hal_executable_layout_release(executable_layout_);
+    executable_layout_ = NULL;
+  }
+
+  void BeginCommandBuffer() {
+    IREE_ASSERT_OK(iree_hal_command_buffer_create(
+        device_,
+        IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+            IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+        IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &command_buffer_));
+    IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  }
+
+  iree_status_t PushConstants(iree_host_size_t first_constant,
+                              const std::vector<uint32_t>& values) {
+    return iree_hal_command_buffer_push_constants(
+        command_buffer_, executable_layout_,
+        first_constant * sizeof(uint32_t), values.data(),
+        values.size() * sizeof(uint32_t));
+  }
+
+  // Dispatches the executable, submits the command buffer and returns the
+  // push constants the executable observed.
+  std::vector<uint32_t> DispatchAndSubmit() {
+    IREE_EXPECT_OK(iree_hal_command_buffer_dispatch(command_buffer_,
+                                                    executable_, 0, 1, 1, 1));
+    IREE_EXPECT_OK(iree_hal_command_buffer_end(command_buffer_));
+
+    iree_hal_semaphore_t* semaphore = NULL;
+    IREE_EXPECT_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore));
+    iree_hal_submission_batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.command_buffer_count = 1;
+    batch.command_buffers = &command_buffer_;
+    uint64_t signal_value = 1ull;
+    batch.signal_semaphores.count = 1;
+    batch.signal_semaphores.semaphores = &semaphore;
+    batch.signal_semaphores.payload_values = &signal_value;
+    IREE_EXPECT_OK(iree_hal_device_submit_and_wait(
+        device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
+        IREE_HAL_QUEUE_AFFINITY_ANY, 1, &batch, semaphore, signal_value,
+        iree_infinite_timeout()));
+    iree_hal_semaphore_release(semaphore);
+
+    iree_hal_command_buffer_release(command_buffer_);
+    command_buffer_ = NULL;
+    return loader_->observed_push_constants;
+  }
+
+  TestLoader* loader_ = nullptr;
+  iree_task_executor_t* executor_ = nullptr;
+  iree_hal_device_t* device_ = nullptr;
+  iree_hal_executable_cache_t* executable_cache_ = nullptr;
+  iree_hal_executable_layout_t* executable_layout_ = nullptr;
+  iree_hal_executable_t* executable_ = nullptr;
+  iree_hal_command_buffer_t* command_buffer_ = nullptr;
+};
+
+TEST_P(PushConstantsTest, InlineConstants) {
+  PrepareExecutable(IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT);
+  BeginCommandBuffer();
+  auto values = MakeValues(0, IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT);
+  IREE_ASSERT_OK(PushConstants(0, values));
+  EXPECT_THAT(DispatchAndSubmit(), ElementsAreArray(values));
+  ReleaseExecutable();
+}
+
+TEST_P(PushConstantsTest, ExtendedConstants) {
+  const iree_host_size_t count = IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT + 36;
+  PrepareExecutable(count);
+  BeginCommandBuffer();
+  auto values = MakeValues(0, count);
+  IREE_ASSERT_OK(PushConstants(0, values));
+  EXPECT_THAT(DispatchAndSubmit(), ElementsAreArray(values));
+  ReleaseExecutable();
+}
+
+TEST_P(PushConstantsTest, MaxExtendedConstants) {
+  PrepareExecutable(IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT);
+  BeginCommandBuffer();
+  auto values = MakeValues(0, IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT);
+  IREE_ASSERT_OK(PushConstants(0, values));
+  EXPECT_THAT(DispatchAndSubmit(), ElementsAreArray(values));
+  ReleaseExecutable();
+}
+
+TEST_P(PushConstantsTest, PartialPushCrossingInlineLimit) {
+  // The first push fits in the inline storage and must be preserved when the
+  // second push crossing the inline limit switches to the extended storage.
+  const iree_host_size_t count = IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT + 16;
+  const iree_host_size_t split = IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT - 4;
+  PrepareExecutable(count);
+  BeginCommandBuffer();
+  auto values = MakeValues(0, count);
+  IREE_ASSERT_OK(PushConstants(
+      0, std::vector<uint32_t>(values.begin(), values.begin() + split)));
+  IREE_ASSERT_OK(PushConstants(
+      split, std::vector<uint32_t>(values.begin() + split, values.end())));
+  EXPECT_THAT(DispatchAndSubmit(), ElementsAreArray(values));
+  ReleaseExecutable();
+}
+
+TEST_P(PushConstantsTest, ExtendedConstantsPersistAcrossDispatches) {
+  // Push constants are command buffer state: a partial update before the
+  // second dispatch only changes the updated range.
+  const iree_host_size_t count = IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT + 8;
+  PrepareExecutable(count);
+  BeginCommandBuffer();
+  auto values = MakeValues(0, count);
+  IREE_ASSERT_OK(PushConstants(0, values));
+  IREE_ASSERT_OK(iree_hal_command_buffer_dispatch(command_buffer_, executable_,
+                                                  0, 1, 1, 1));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer_, IREE_HAL_EXECUTION_STAGE_DISPATCH,
+      IREE_HAL_EXECUTION_STAGE_DISPATCH, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      0, NULL, 0, NULL));
+  auto update = MakeValues(0x1000, 4);
+  const iree_host_size_t update_offset =
+      IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT - 2;
+  IREE_ASSERT_OK(PushConstants(update_offset, update));
+  std::copy(update.begin(), update.end(), values.begin() + update_offset);
+  EXPECT_THAT(DispatchAndSubmit(), ElementsAreArray(values));
+  ReleaseExecutable();
+}
+
+TEST_P(PushConstantsTest, OutOfRange) {
+  PrepareExecutable(IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT);
+  BeginCommandBuffer();
+  EXPECT_THAT(
+      iree::Status(PushConstants(
+          IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT - 2, MakeValues(0, 4))),
+      StatusIs(iree::StatusCode::kInvalidArgument));
+  iree_hal_command_buffer_release(command_buffer_);
+  command_buffer_ = NULL;
+  ReleaseExecutable();
+}
+
+TEST_P(PushConstantsTest, LayoutOverLimit) {
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  EXPECT_THAT(iree::Status(iree_hal_executable_layout_create(
+                  device_, IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT + 1,
+                  /*set_layout_count=*/0, /*set_layouts=*/NULL,
+                  &executable_layout)),
+              StatusIs(iree::StatusCode::kInvalidArgument));
+  EXPECT_EQ(NULL, executable_layout);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllCommandBuffers, PushConstantsTest,
+    ::testing::Values(DeviceType::kSync, DeviceType::kTask),
+    [](const ::testing::TestParamInfo<DeviceType>& info) {
+      return info.param == DeviceType::kSync ? "Inline" : "Task";
+    });
+
+}  // namespace
@@ -196,6 +196,7 @@ static iree_status_t iree_hal_sync_device_create_executable_cache(
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
   return iree_hal_local_executable_cache_create(
       identifier, device->loader_count, device->loaders,
+      iree_hal_local_parallel_for_null(),
       iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
@@ -14,13 +14,16 @@
 
 #include "iree/hal/local/task_command_buffer.h"
 
+#include "iree/base/internal/atomics.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/local/dispatch_profiler.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
 #include "iree/task/list.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
+#include "iree/task/tuning.h"
 
 //===----------------------------------------------------------------------===//
 // iree_hal_task_command_buffer_t
@@ -92,6 +95,12 @@ typedef struct {
     // Reset only with the command buffer and otherwise will maintain its values
     // during recording to allow for partial push_constants updates.
     uint32_t push_constants[IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT];
+
+    // Storage for all IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT push
+    // constants allocated from the arena the first time a push or dispatch
+    // needs more than the inline |push_constants|. Once allocated it holds
+    // the inline values as well and replaces |push_constants|.
+    uint32_t* extended_push_constants;
   } state;
 } iree_hal_task_command_buffer_t;
 
@@ -621,6 +630,35 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
 //===----------------------------------------------------------------------===//
 // NOTE: command buffer state change only; enqueues no tasks.
 
+// Returns the push constant storage with room for at least |count| values.
+// Switches to the extended push constant storage if the inline storage is too
+// small such that executables always see a single contiguous array.
+static iree_status_t iree_hal_task_command_buffer_push_constant_storage(
+    iree_hal_task_command_buffer_t* command_buffer, iree_host_size_t count,
+    uint32_t** out_push_constants) {
+  *out_push_constants = NULL;
+  if (command_buffer->state.extended_push_constants) {
+    *out_push_constants = command_buffer->state.extended_push_constants;
+  } else if (count <= IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT) {
+    *out_push_constants = command_buffer->state.push_constants;
+  } else {
+    uint32_t* extended_push_constants = NULL;
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(
+        &command_buffer->arena,
+        IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT * sizeof(uint32_t),
+        (void**)&extended_push_constants));
+    memcpy(extended_push_constants, command_buffer->state.push_constants,
+           sizeof(command_buffer->state.push_constants));
+    memset(extended_push_constants + IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT, 0,
+           (IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT -
+            IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT) *
+               sizeof(uint32_t));
+    command_buffer->state.extended_push_constants = extended_push_constants;
+    *out_push_constants = extended_push_constants;
+  }
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_task_command_buffer_push_constants(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
@@ -628,15 +666,21 @@ static iree_status_t iree_hal_task_command_buffer_push_constants(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  if (IREE_UNLIKELY(offset + values_length >=
-                    sizeof(command_buffer->state.push_constants))) {
+  if (IREE_UNLIKELY(offset + values_length >
+                    IREE_HAL_LOCAL_MAX_EXTENDED_PUSH_CONSTANT_COUNT *
+                        sizeof(uint32_t))) {
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "push constant range %zu (length=%zu) out of range",
                             offset, values_length);
   }
 
-  memcpy((uint8_t*)&command_buffer->state.push_constants + offset, values,
-         values_length);
+  uint32_t* push_constants = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_push_constant_storage(
+      command_buffer,
+      iree_host_align(offset + values_length, sizeof(uint32_t)) /
+          sizeof(uint32_t),
+      &push_constants));
+  memcpy((uint8_t*)push_constants + offset, values, values_length);
 
   return iree_ok_status();
 }
@@ -708,11 +752,28 @@ static iree_status_t iree_hal_task_command_buffer_bind_descriptor_set(
 // iree_hal_command_buffer_dispatch
 //===----------------------------------------------------------------------===//
 
+static_assert(IREE_HAL_DISPATCH_PROFILER_MAX_WORKER_COUNT >=
+                  IREE_TASK_EXECUTOR_MAX_WORKER_COUNT,
+              "dispatch profiler must be able to track all workers");
+
+// Timing state for a dispatch recorded while the dispatch profiler was enabled.
+// The counters are reset by the last tile to complete so that the command
+// buffer can be executed multiple times.
+typedef struct {
+  iree_atomic_int32_t tiles_started;
+  iree_atomic_int32_t tiles_completed;
+  iree_atomic_int64_t start_time_ns;
+  iree_atomic_int64_t worker_busy_ns[IREE_TASK_EXECUTOR_MAX_WORKER_COUNT];
+} iree_hal_cmd_dispatch_profile_t;
+
 typedef struct {
   iree_task_dispatch_t task;
   iree_hal_local_executable_t* executable;
   int32_t ordinal;
 
+  // Timing state when profiling or NULL when the dispatch is not profiled.
+  iree_hal_cmd_dispatch_profile_t* profile;
+
   // Total number of available 4 byte push constant values in |push_constants|.
   uint16_t push_constant_count;
 
@@ -727,6 +788,58 @@ typedef struct {
   // - const size_t binding_lengths[binding_count];
 } iree_hal_cmd_dispatch_t;
 
+// Accounts for a tile of |cmd| that started at |tile_start_ns| and has just
+// completed. The last tile of the dispatch to complete reports the dispatch to
+// the profiler.
+static void iree_hal_cmd_dispatch_profile_tile(
+    const iree_hal_cmd_dispatch_t* cmd,
+    const iree_task_tile_context_t* tile_context, iree_time_t tile_start_ns) {
+  iree_hal_cmd_dispatch_profile_t* profile = cmd->profile;
+  iree_time_t tile_end_ns = iree_time_now();
+  if (tile_context->worker_id < IREE_ARRAYSIZE(profile->worker_busy_ns)) {
+    iree_atomic_fetch_add_int64(
+        &profile->worker_busy_ns[tile_context->worker_id],
+        tile_end_ns - tile_start_ns, iree_memory_order_relaxed);
+  }
+
+  const uint32_t tile_count = tile_context->workgroup_count[0] *
+                              tile_context->workgroup_count[1] *
+                              tile_context->workgroup_count[2];
+  if (iree_atomic_fetch_add_int32(&profile->tiles_completed, 1,
+                                  iree_memory_order_acq_rel) +
+          1 !=
+      (int32_t)tile_count) {
+    return;
+  }
+
+  // Last tile: all other tiles have published their busy time.
+  iree_duration_t worker_busy_ns[IREE_TASK_EXECUTOR_MAX_WORKER_COUNT];
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(worker_busy_ns); ++i) {
+    worker_busy_ns[i] = iree_atomic_exchange_int64(
+        &profile->worker_busy_ns[i], 0, iree_memory_order_relaxed);
+  }
+  iree_hal_dispatch_profile_record_t record;
+  record.executable_name = cmd->executable->identifier;
+  record.entry_point_name =
+      iree_hal_local_executable_entry_point_name(cmd->executable, cmd->ordinal);
+  memcpy(record.workgroup_count, tile_context->workgroup_count,
+         sizeof(record.workgroup_count));
+  record.tile_count = tile_count;
+  record.wall_time_ns =
+      tile_end_ns - iree_atomic_load_int64(&profile->start_time_ns,
+                                           iree_memory_order_relaxed);
+  record.worker_count = IREE_ARRAYSIZE(worker_busy_ns);
+  record.worker_busy_ns = worker_busy_ns;
+  iree_atomic_store_int32(&profile->tiles_started, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&profile->tiles_completed, 0,
+                          iree_memory_order_release);
+
+  // Profiling is best-effort; failing to record must not fail the dispatch.
+  iree_status_ignore(iree_hal_dispatch_profiler_record(
+      iree_hal_dispatch_profiler_default(), &record));
+}
+
 static iree_status_t iree_hal_cmd_dispatch_tile(
     uintptr_t user_context, const iree_task_tile_context_t* tile_context,
     iree_task_submission_t* pending_submission) {
@@ -734,6 +847,16 @@ static iree_status_t iree_hal_cmd_dispatch_tile(
       (const iree_hal_cmd_dispatch_t*)user_context;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_time_t tile_start_ns = 0;
+  if (IREE_UNLIKELY(cmd->profile)) {
+    tile_start_ns = iree_time_now();
+    if (iree_atomic_fetch_add_int32(&cmd->profile->tiles_started, 1,
+                                    iree_memory_order_relaxed) == 0) {
+      iree_atomic_store_int64(&cmd->profile->start_time_ns, tile_start_ns,
+                              iree_memory_order_relaxed);
+    }
+  }
+
   iree_hal_executable_dispatch_state_v0_t state;
   memset(&state, 0, sizeof(state));
   memcpy(state.workgroup_count.value, tile_context->workgroup_count,
@@ -762,6 +885,10 @@ static iree_status_t iree_hal_cmd_dispatch_tile(
       cmd->executable, cmd->ordinal, &state,
       (const iree_hal_vec3_t*)tile_context->workgroup_xyz);
 
+  if (IREE_UNLIKELY(cmd->profile)) {
+    iree_hal_cmd_dispatch_profile_tile(cmd, tile_context, tile_start_ns);
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -800,6 +927,14 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
 
   cmd->executable = local_executable;
   cmd->ordinal = entry_point;
+  cmd->profile = NULL;
+  if (IREE_UNLIKELY(iree_hal_dispatch_profiler_is_enabled(
+          iree_hal_dispatch_profiler_default()))) {
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                             sizeof(*cmd->profile),
+                                             (void**)&cmd->profile));
+    memset(cmd->profile, 0, sizeof(*cmd->profile));
+  }
   cmd->push_constant_count = push_constant_count;
   cmd->binding_count = used_binding_count;
 
@@ -811,10 +946,15 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
                                     iree_hal_cmd_dispatch_tile, (uintptr_t)cmd),
                                 workgroup_size, workgroup_count, &cmd->task);
 
-  // Copy only the push constant range used by the executable.
+  // Copy only the push constant range used by the executable. Extended push
+  // constants are copied along with the inline ones so that the dispatch
+  // reads them from the command arena without any additional buffer.
+  uint32_t* source_push_constants = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_push_constant_storage(
+      command_buffer, push_constant_count, &source_push_constants));
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
   uint32_t* push_constants = (uint32_t*)cmd_ptr;
-  memcpy(push_constants, command_buffer->state.push_constants,
+  memcpy(push_constants, source_push_constants,
          push_constant_count * sizeof(*push_constants));
   cmd_ptr += push_constant_count * sizeof(*push_constants);
 
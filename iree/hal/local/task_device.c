@@ -26,6 +26,9 @@
 #include "iree/hal/local/task_event.h"
 #include "iree/hal/local/task_queue.h"
 #include "iree/hal/local/task_semaphore.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
 
 #define IREE_HAL_LOCAL_TASK_EVENT_POOL_CAPACITY 32
 
@@ -261,12 +264,82 @@ static iree_status_t iree_hal_task_device_create_event(
                                     out_event);
 }
 
+// Index function and its user data run by each tile of a parallel-for.
+typedef struct {
+  iree_hal_local_parallel_for_index_fn_t index_fn;
+  void* user_data;
+} iree_hal_task_device_parallel_for_closure_t;
+
+static iree_status_t iree_hal_task_device_parallel_for_tile(
+    uintptr_t user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  iree_hal_task_device_parallel_for_closure_t* closure =
+      (iree_hal_task_device_parallel_for_closure_t*)user_context;
+  closure->index_fn(closure->user_data, tile_context->workgroup_xyz[0]);
+  return iree_ok_status();
+}
+
+// Runs each index as a tile of a dispatch on the executor in |self| and waits
+// for them to complete. The caller must not be running on one of its workers.
+static iree_status_t iree_hal_task_device_parallel_for(
+    void* self, iree_host_size_t count,
+    iree_hal_local_parallel_for_index_fn_t index_fn, void* user_data) {
+  iree_task_executor_t* executor = (iree_task_executor_t*)self;
+  iree_hal_task_device_parallel_for_closure_t closure = {
+      .index_fn = index_fn,
+      .user_data = user_data,
+  };
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("parallel_for"), &scope);
+
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {(uint32_t)count, 1, 1};
+  iree_task_dispatch_t dispatch_task;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(iree_hal_task_device_parallel_for_tile,
+                                      (uintptr_t)&closure),
+      workgroup_size, workgroup_count, &dispatch_task);
+
+  iree_task_fence_t* fence = NULL;
+  iree_status_t status =
+      iree_task_executor_acquire_fence(executor, &scope, &fence);
+  if (iree_status_is_ok(status)) {
+    iree_task_set_completion_task(&dispatch_task.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch_task.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    status = iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_task_scope_consume_status(&scope);
+  }
+
+  iree_task_scope_deinitialize(&scope);
+  return status;
+}
+
+static void iree_hal_task_device_parallel_for_release(void* self) {
+  iree_task_executor_release((iree_task_executor_t*)self);
+}
+
 static iree_status_t iree_hal_task_device_create_executable_cache(
     iree_hal_device_t* base_device, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  // Batches of executables are prepared across the executor workers. Caches
+  // may outlive the device so they keep the executor alive.
+  iree_hal_local_parallel_for_t parallel_for = {
+      .self = device->executor,
+      .fn = iree_hal_task_device_parallel_for,
+      .release = iree_hal_task_device_parallel_for_release,
+  };
+  iree_task_executor_retain(device->executor);
   return iree_hal_local_executable_cache_create(
-      identifier, device->loader_count, device->loaders,
+      identifier, device->loader_count, device->loaders, parallel_for,
       iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
@@ -187,11 +187,36 @@ typedef struct {
   // if we are the last issue pending.
   iree_hal_task_queue_t* queue;
 
+  // Issue task of the next submission to the queue, if any, that must wait for
+  // this issue to complete. Guarded by the queue mutex. This can't use the
+  // completion task as that is the retire command of this submission.
+  iree_task_t* next_issue_task;
+
   // Command buffers to be issued in the order the appeared in the submission.
   iree_host_size_t command_buffer_count;
   iree_hal_command_buffer_t* command_buffers[];
 } iree_hal_task_queue_issue_cmd_t;
 
+// Removes |cmd| from the FIFO issue order of its queue and releases the
+// dependency the next issue has on it. Returns the next issue if it is now
+// ready and must be enqueued by the caller.
+static iree_task_t* iree_hal_task_queue_issue_cmd_release_next(
+    iree_hal_task_queue_issue_cmd_t* cmd) {
+  iree_slim_mutex_lock(&cmd->queue->mutex);
+  if (cmd->queue->tail_issue_task == &cmd->task.header) {
+    cmd->queue->tail_issue_task = NULL;
+  }
+  iree_task_t* next_issue_task = cmd->next_issue_task;
+  cmd->next_issue_task = NULL;
+  iree_slim_mutex_unlock(&cmd->queue->mutex);
+  if (next_issue_task &&
+      iree_atomic_fetch_sub_int32(&next_issue_task->pending_dependency_count, 1,
+                                  iree_memory_order_acq_rel) == 1) {
+    return next_issue_task;
+  }
+  return NULL;
+}
+
 // Issues a set of command buffers without waiting for them to complete.
 static iree_status_t iree_hal_task_queue_issue_cmd(
     uintptr_t user_context, iree_task_t* task,
@@ -212,6 +237,13 @@ static iree_status_t iree_hal_task_queue_issue_cmd(
     }
   }
 
+  // The next submission may issue now that we have.
+  iree_task_t* next_issue_task =
+      iree_hal_task_queue_issue_cmd_release_next(cmd);
+  if (next_issue_task) {
+    iree_task_submission_enqueue(pending_submission, next_issue_task);
+  }
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -222,11 +254,13 @@ static void iree_hal_task_queue_issue_cmd_cleanup(iree_task_t* task,
                                                   iree_status_t status) {
   iree_hal_task_queue_issue_cmd_t* cmd = (iree_hal_task_queue_issue_cmd_t*)task;
 
-  // Reset queue tail issue task if it was us.
+  // Reset queue tail issue task if it was us. This has already happened if the
+  // issue ran and otherwise the task was discarded along with the queue.
   iree_slim_mutex_lock(&cmd->queue->mutex);
   if (cmd->queue->tail_issue_task == task) {
     cmd->queue->tail_issue_task = NULL;
   }
+  cmd->next_issue_task = NULL;
   iree_slim_mutex_unlock(&cmd->queue->mutex);
 }
 
@@ -249,6 +283,7 @@ static iree_status_t iree_hal_task_queue_issue_cmd_allocate(
                            iree_hal_task_queue_issue_cmd_cleanup);
   cmd->arena = arena;
   cmd->queue = queue;
+  cmd->next_issue_task = NULL;
 
   cmd->command_buffer_count = command_buffer_count;
   memcpy(cmd->command_buffers, command_buffers,
@@ -469,9 +504,6 @@ static iree_status_t iree_hal_task_queue_submit_batch(
     iree_task_set_completion_task(&wait_cmd->task.header,
                                   &issue_cmd->task.header);
     iree_task_submission_enqueue(&submission, &wait_cmd->task.header);
-  } else {
-    // No waits needed; directly enqueue.
-    iree_task_submission_enqueue(&submission, &issue_cmd->task.header);
   }
 
   iree_slim_mutex_lock(&queue->mutex);
@@ -479,15 +511,24 @@ static iree_status_t iree_hal_task_queue_submit_batch(
   // If there is an in-flight issue pending then we need to chain onto that
   // so that we ensure FIFO submission order is preserved. Note that we are only
   // waiting for the issue to complete and *not* all of the commands that are
-  // issued.
-  if (queue->tail_issue_task != NULL) {
-    iree_task_set_completion_task(queue->tail_issue_task,
-                                  &issue_cmd->task.header);
+  // issued. The prior issue enqueues ours once it completes.
+  bool has_prior_issue = queue->tail_issue_task != NULL;
+  if (has_prior_issue) {
+    iree_atomic_fetch_add_int32(
+        &issue_cmd->task.header.pending_dependency_count, 1,
+        iree_memory_order_acq_rel);
+    ((iree_hal_task_queue_issue_cmd_t*)queue->tail_issue_task)
+        ->next_issue_task = &issue_cmd->task.header;
   }
   queue->tail_issue_task = &issue_cmd->task.header;
 
   iree_slim_mutex_unlock(&queue->mutex);
 
+  // No waits or prior issues; directly enqueue.
+  if (wait_cmd == NULL && !has_prior_issue) {
+    iree_task_submission_enqueue(&submission, &issue_cmd->task.header);
+  }
+
   // Submit the tasks immediately. The executor may queue them up until we
   // force the flush after all batches have been processed.
   iree_task_executor_submit(queue->executor, &submission);
@@ -405,92 +405,194 @@ IREE_API_EXPORT iree_status_t iree_hal_format_element(
 IREE_API_EXPORT iree_status_t iree_hal_parse_buffer_elements(
     iree_string_view_t data_str, iree_hal_element_type_t element_type,
     iree_byte_span_t data_ptr) {
-  iree_host_size_t element_size = iree_hal_element_byte_count(element_type);
-  iree_host_size_t element_capacity = data_ptr.data_length / element_size;
-  if (iree_string_view_is_empty(data_str)) {
-    memset(data_ptr.data, 0, data_ptr.data_length);
+  iree_hal_buffer_elements_parser_t parser;
+  iree_hal_buffer_elements_parser_initialize(element_type, data_ptr, &parser);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_buffer_elements_parser_append(&parser, data_str));
+  return iree_hal_buffer_elements_parser_finish(&parser);
+}
+
+//===----------------------------------------------------------------------===//
+// Streaming formatting
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_hal_string_sink_file_write(void* self,
+                                                     iree_string_view_t chunk) {
+  FILE* file = (FILE*)self;
+  if (chunk.size && fwrite(chunk.data, 1, chunk.size, file) != chunk.size) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "failed to write %zu characters to file",
+                            chunk.size);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_hal_string_sink_t iree_hal_string_sink_file(FILE* file) {
+  iree_hal_string_sink_t sink = {
+      (void*)file,
+      iree_hal_string_sink_file_write,
+  };
+  return sink;
+}
+
+// Fixed-size staging buffer that is flushed to a sink whenever it fills.
+typedef struct {
+  iree_hal_string_sink_t sink;
+  iree_host_size_t length;
+  char data[IREE_HAL_STRING_CHUNK_CAPACITY];
+} iree_hal_string_chunk_t;
+
+static iree_status_t iree_hal_string_chunk_flush(
+    iree_hal_string_chunk_t* chunk) {
+  if (!chunk->length) return iree_ok_status();
+  iree_status_t status = chunk->sink.write(
+      chunk->sink.self, iree_make_string_view(chunk->data, chunk->length));
+  chunk->length = 0;
+  return status;
+}
+
+// Ensures that |length| characters plus a NUL terminator (as written by
+// snprintf) can be appended without overflowing the chunk.
+static inline iree_status_t iree_hal_string_chunk_reserve(
+    iree_hal_string_chunk_t* chunk, iree_host_size_t length) {
+  if (chunk->length + length + 1 <= IREE_HAL_STRING_CHUNK_CAPACITY) {
     return iree_ok_status();
   }
-  size_t src_i = 0;
-  size_t dst_i = 0;
-  size_t token_start = IREE_STRING_VIEW_NPOS;
-  while (src_i < data_str.size) {
-    char c = data_str.data[src_i++];
-    bool is_separator = isspace(c) || c == ',' || c == '[' || c == ']';
-    if (token_start == IREE_STRING_VIEW_NPOS) {
-      if (!is_separator) {
-        token_start = src_i - 1;
-      }
-      continue;
-    } else if (token_start != IREE_STRING_VIEW_NPOS && !is_separator) {
-      continue;
-    }
-    if (dst_i >= element_capacity) {
-      return iree_make_status(
-          IREE_STATUS_OUT_OF_RANGE,
-          "output data buffer overflow: element_capacity=%zu < dst_i=%zu+",
-          element_capacity, dst_i);
-    }
-    IREE_RETURN_IF_ERROR(iree_hal_parse_element_unsafe(
-        iree_make_string_view(data_str.data + token_start,
-                              src_i - 2 - token_start + 1),
-        element_type, data_ptr.data + dst_i * element_size));
-    ++dst_i;
-    token_start = IREE_STRING_VIEW_NPOS;
-  }
-  if (token_start != IREE_STRING_VIEW_NPOS) {
-    if (dst_i >= element_capacity) {
-      return iree_make_status(
-          IREE_STATUS_OUT_OF_RANGE,
-          "output data overflow: element_capacity=%zu < dst_i=%zu",
-          element_capacity, dst_i);
-    }
-    IREE_RETURN_IF_ERROR(iree_hal_parse_element_unsafe(
-        iree_make_string_view(data_str.data + token_start,
-                              data_str.size - token_start),
-        element_type, data_ptr.data + dst_i * element_size));
-    ++dst_i;
+  return iree_hal_string_chunk_flush(chunk);
+}
+
+static inline iree_status_t iree_hal_string_chunk_append_char(
+    iree_hal_string_chunk_t* chunk, char c) {
+  IREE_RETURN_IF_ERROR(iree_hal_string_chunk_reserve(chunk, 1));
+  chunk->data[chunk->length++] = c;
+  return iree_ok_status();
+}
+
+// Writes the decimal representation of |value| to |out| and returns the number
+// of characters written (at most 20). Two digits are produced per division.
+static iree_host_size_t iree_hal_format_uint64(uint64_t value, char* out) {
+  static const char kDigitPairs[201] =
+      "00010203040506070809"
+      "10111213141516171819"
+      "20212223242526272829"
+      "30313233343536373839"
+      "40414243444546474849"
+      "50515253545556575859"
+      "60616263646566676869"
+      "70717273747576777879"
+      "80818283848586878889"
+      "90919293949596979899";
+  char scratch[20];
+  char* p = scratch + sizeof(scratch);
+  while (value >= 100) {
+    uint64_t quotient = value / 100;
+    uint32_t pair = (uint32_t)(value - quotient * 100);
+    p -= 2;
+    memcpy(p, &kDigitPairs[pair * 2], 2);
+    value = quotient;
+  }
+  if (value >= 10) {
+    p -= 2;
+    memcpy(p, &kDigitPairs[value * 2], 2);
+  } else {
+    *--p = (char)('0' + value);
   }
-  if (dst_i == 1 && element_capacity > 1) {
-    // Splat the single value we got to the entire buffer.
-    uint8_t* p = data_ptr.data + element_size;
-    for (int i = 1; i < element_capacity; ++i, p += element_size) {
-      memcpy(p, data_ptr.data, element_size);
-    }
-  } else if (dst_i < element_capacity) {
-    return iree_make_status(
-        IREE_STATUS_OUT_OF_RANGE,
-        "input data string underflow: dst_i=%zu < element_capacity=%zu", dst_i,
-        element_capacity);
+  iree_host_size_t length = (iree_host_size_t)(scratch + sizeof(scratch) - p);
+  memcpy(out, p, length);
+  return length;
+}
+
+static iree_host_size_t iree_hal_format_int64(int64_t value, char* out) {
+  if (value < 0) {
+    out[0] = '-';
+    return 1 + iree_hal_format_uint64(0 - (uint64_t)value, out + 1);
   }
-  return iree_ok_status();
+  return iree_hal_format_uint64((uint64_t)value, out);
 }
 
-#define APPEND_CHAR(c)                           \
-  {                                              \
-    if (buffer) {                                \
-      if (buffer_length < buffer_capacity - 1) { \
-        buffer[buffer_length] = c;               \
-        buffer[buffer_length + 1] = '\0';        \
-      } else {                                   \
-        buffer = NULL;                           \
-      }                                          \
-    }                                            \
-    ++buffer_length;                             \
+// Formats |count| contiguous elements separated by spaces into |chunk|.
+// The element type is resolved once per run instead of once per element and
+// integers bypass snprintf so each loop body is a short conversion.
+static iree_status_t iree_hal_format_element_run(
+    const uint8_t* data, iree_host_size_t count,
+    iree_hal_element_type_t element_type, iree_hal_string_chunk_t* chunk) {
+#define IREE_HAL_FORMAT_RUN(type, format_expr)                               \
+  for (iree_host_size_t i = 0; i < count; ++i) {                             \
+    IREE_RETURN_IF_ERROR(iree_hal_string_chunk_reserve(                      \
+        chunk, 1 + IREE_HAL_ELEMENT_STRING_MAX_LENGTH));                     \
+    if (i > 0) chunk->data[chunk->length++] = ' ';                           \
+    type value;                                                              \
+    memcpy(&value, data + i * sizeof(type), sizeof(type));                   \
+    char* out = chunk->data + chunk->length;                                 \
+    iree_host_size_t out_capacity =                                          \
+        IREE_HAL_STRING_CHUNK_CAPACITY - chunk->length;                      \
+    (void)out_capacity;                                                      \
+    int n = (int)(format_expr);                                              \
+    if (n < 0) {                                                             \
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,               \
+                              "snprintf failed");                            \
+    }                                                                        \
+    chunk->length += n;                                                      \
+  }                                                                          \
+  return iree_ok_status();
+
+  switch (element_type) {
+    case IREE_HAL_ELEMENT_TYPE_SINT_8:
+      IREE_HAL_FORMAT_RUN(int8_t, iree_hal_format_int64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_UINT_8:
+      IREE_HAL_FORMAT_RUN(uint8_t, iree_hal_format_uint64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_SINT_16:
+      IREE_HAL_FORMAT_RUN(int16_t, iree_hal_format_int64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_UINT_16:
+      IREE_HAL_FORMAT_RUN(uint16_t, iree_hal_format_uint64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_SINT_32:
+      IREE_HAL_FORMAT_RUN(int32_t, iree_hal_format_int64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_UINT_32:
+      IREE_HAL_FORMAT_RUN(uint32_t, iree_hal_format_uint64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_SINT_64:
+      IREE_HAL_FORMAT_RUN(int64_t, iree_hal_format_int64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_UINT_64:
+      IREE_HAL_FORMAT_RUN(uint64_t, iree_hal_format_uint64(value, out));
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_16:
+      IREE_HAL_FORMAT_RUN(
+          uint16_t,
+          snprintf(out, out_capacity, "%G", iree_math_f16_to_f32(value)));
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_32:
+      IREE_HAL_FORMAT_RUN(float, snprintf(out, out_capacity, "%G", value));
+    case IREE_HAL_ELEMENT_TYPE_FLOAT_64:
+      IREE_HAL_FORMAT_RUN(double, snprintf(out, out_capacity, "%G", value));
+    default:
+      break;
   }
+#undef IREE_HAL_FORMAT_RUN
+
+  // Treat any unknown format as binary.
+  iree_host_size_t element_size = iree_hal_element_byte_count(element_type);
+  if (element_size * 2 > IREE_HAL_ELEMENT_STRING_MAX_LENGTH) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "opaque element of %zu bytes too large to format",
+                            element_size);
+  }
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_string_chunk_reserve(
+        chunk, 1 + IREE_HAL_ELEMENT_STRING_MAX_LENGTH));
+    if (i > 0) chunk->data[chunk->length++] = ' ';
+    iree_hal_bytes_to_hex_string(data + i * element_size,
+                                 chunk->data + chunk->length, element_size);
+    chunk->length += element_size * 2;
+  }
+  return iree_ok_status();
+}
 
 static iree_status_t iree_hal_format_buffer_elements_recursive(
     iree_const_byte_span_t data, const iree_hal_dim_t* shape,
     iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
-    iree_host_size_t* max_element_count, iree_host_size_t buffer_capacity,
-    char* buffer, iree_host_size_t* out_buffer_length) {
-  iree_host_size_t buffer_length = 0;
+    iree_host_size_t* max_element_count, iree_hal_string_chunk_t* chunk) {
   if (shape_rank == 0) {
     // Scalar value; recurse to get on to the leaf dimension path.
     const iree_hal_dim_t one = 1;
     return iree_hal_format_buffer_elements_recursive(
-        data, &one, 1, element_type, max_element_count, buffer_capacity, buffer,
-        out_buffer_length);
+        data, &one, 1, element_type, max_element_count, chunk);
   } else if (shape_rank > 1) {
     // Nested dimension; recurse into the next innermost dimension.
     iree_hal_dim_t dim_length = 1;
@@ -509,20 +611,12 @@ static iree_status_t iree_hal_format_buffer_elements_recursive(
     subdata.data = data.data;
     subdata.data_length = dim_stride;
     for (iree_hal_dim_t i = 0; i < shape[0]; ++i) {
-      APPEND_CHAR('[');
-      iree_host_size_t actual_length = 0;
-      iree_status_t status = iree_hal_format_buffer_elements_recursive(
+      IREE_RETURN_IF_ERROR(iree_hal_string_chunk_append_char(chunk, '['));
+      IREE_RETURN_IF_ERROR(iree_hal_format_buffer_elements_recursive(
           subdata, shape + 1, shape_rank - 1, element_type, max_element_count,
-          buffer ? buffer_capacity - buffer_length : 0,
-          buffer ? buffer + buffer_length : NULL, &actual_length);
-      buffer_length += actual_length;
-      if (iree_status_is_out_of_range(status)) {
-        buffer = NULL;
-      } else if (!iree_status_is_ok(status)) {
-        return status;
-      }
+          chunk));
       subdata.data += dim_stride;
-      APPEND_CHAR(']');
+      IREE_RETURN_IF_ERROR(iree_hal_string_chunk_append_char(chunk, ']'));
     }
   } else {
     // Leaf dimension; output data.
@@ -537,34 +631,56 @@ static iree_status_t iree_hal_format_buffer_elements_recursive(
           data.data_length, (iree_host_size_t)(max_count * element_stride));
     }
     *max_element_count -= max_count;
-    iree_const_byte_span_t subdata;
-    subdata.data = data.data;
-    subdata.data_length = element_stride;
-    for (iree_hal_dim_t i = 0; i < max_count; ++i) {
-      if (i > 0) APPEND_CHAR(' ');
-      iree_host_size_t actual_length = 0;
-      iree_status_t status = iree_hal_format_element(
-          subdata, element_type, buffer ? buffer_capacity - buffer_length : 0,
-          buffer ? buffer + buffer_length : NULL, &actual_length);
-      subdata.data += element_stride;
-      buffer_length += actual_length;
-      if (iree_status_is_out_of_range(status)) {
-        buffer = NULL;
-      } else if (!iree_status_is_ok(status)) {
-        return status;
-      }
-    }
+    IREE_RETURN_IF_ERROR(iree_hal_format_element_run(data.data, max_count,
+                                                     element_type, chunk));
     if (max_count < shape[0]) {
-      APPEND_CHAR('.');
-      APPEND_CHAR('.');
-      APPEND_CHAR('.');
+      IREE_RETURN_IF_ERROR(iree_hal_string_chunk_reserve(chunk, 3));
+      memcpy(chunk->data + chunk->length, "...", 3);
+      chunk->length += 3;
     }
   }
-  if (out_buffer_length) {
-    *out_buffer_length = buffer_length;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_format_buffer_elements_to_sink(
+    iree_const_byte_span_t data, const iree_hal_dim_t* shape,
+    iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
+    iree_host_size_t max_element_count, iree_hal_string_sink_t sink) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_string_chunk_t chunk;
+  chunk.sink = sink;
+  chunk.length = 0;
+  iree_status_t status = iree_hal_format_buffer_elements_recursive(
+      data, shape, shape_rank, element_type, &max_element_count, &chunk);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_string_chunk_flush(&chunk);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Sink that copies into a fixed caller-provided buffer following the standard
+// API string formatting rules. Once the buffer overflows |buffer| is cleared
+// and only the required length continues to be tracked.
+typedef struct {
+  char* buffer;
+  iree_host_size_t buffer_capacity;
+  iree_host_size_t buffer_length;
+} iree_hal_string_buffer_sink_t;
+
+static iree_status_t iree_hal_string_buffer_sink_write(
+    void* self, iree_string_view_t chunk) {
+  iree_hal_string_buffer_sink_t* sink = (iree_hal_string_buffer_sink_t*)self;
+  if (sink->buffer) {
+    if (sink->buffer_length + chunk.size < sink->buffer_capacity) {
+      memcpy(sink->buffer + sink->buffer_length, chunk.data, chunk.size);
+      sink->buffer[sink->buffer_length + chunk.size] = '\0';
+    } else {
+      sink->buffer = NULL;
+    }
   }
-  return buffer ? iree_ok_status()
-                : iree_status_from_code(IREE_STATUS_OUT_OF_RANGE);
+  sink->buffer_length += chunk.size;
+  return iree_ok_status();
 }
 
 IREE_API_EXPORT iree_status_t iree_hal_format_buffer_elements(
@@ -578,7 +694,143 @@ IREE_API_EXPORT iree_status_t iree_hal_format_buffer_elements(
   if (buffer && buffer_capacity) {
     buffer[0] = '\0';
   }
-  return iree_hal_format_buffer_elements_recursive(
-      data, shape, shape_rank, element_type, &max_element_count,
-      buffer_capacity, buffer, out_buffer_length);
+  iree_hal_string_buffer_sink_t buffer_sink = {
+      buffer_capacity ? buffer : NULL,
+      buffer_capacity,
+      0,
+  };
+  iree_hal_string_sink_t sink = {
+      &buffer_sink,
+      iree_hal_string_buffer_sink_write,
+  };
+  IREE_RETURN_IF_ERROR(iree_hal_format_buffer_elements_to_sink(
+      data, shape, shape_rank, element_type, max_element_count, sink));
+  if (out_buffer_length) {
+    *out_buffer_length = buffer_sink.buffer_length;
+  }
+  return buffer_sink.buffer ? iree_ok_status()
+                            : iree_status_from_code(IREE_STATUS_OUT_OF_RANGE);
+}
+
+//===----------------------------------------------------------------------===//
+// Streaming parsing
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_hal_buffer_elements_parser_initialize(
+    iree_hal_element_type_t element_type, iree_byte_span_t data_ptr,
+    iree_hal_buffer_elements_parser_t* out_parser) {
+  IREE_ASSERT_ARGUMENT(out_parser);
+  memset(out_parser, 0, sizeof(*out_parser));
+  out_parser->element_type = element_type;
+  out_parser->data_ptr = data_ptr;
+}
+
+static inline bool iree_hal_is_element_separator(char c) {
+  return isspace(c) || c == ',' || c == '[' || c == ']';
+}
+
+static iree_status_t iree_hal_buffer_elements_parser_emit(
+    iree_hal_buffer_elements_parser_t* parser, iree_string_view_t token) {
+  iree_host_size_t element_size =
+      iree_hal_element_byte_count(parser->element_type);
+  iree_host_size_t element_capacity =
+      parser->data_ptr.data_length / element_size;
+  if (parser->element_count >= element_capacity) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "output data buffer overflow: element_capacity=%zu < dst_i=%zu+",
+        element_capacity, parser->element_count);
+  }
+  IREE_RETURN_IF_ERROR(iree_hal_parse_element_unsafe(
+      token, parser->element_type,
+      parser->data_ptr.data + parser->element_count * element_size));
+  ++parser->element_count;
+  return iree_ok_status();
+}
+
+// Stashes a partial element that may be continued by the next chunk.
+static iree_status_t iree_hal_buffer_elements_parser_stash(
+    iree_hal_buffer_elements_parser_t* parser, const char* data,
+    iree_host_size_t length) {
+  if (parser->token_length + length > sizeof(parser->token)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "element exceeds %d characters",
+                            (int)sizeof(parser->token));
+  }
+  memcpy(parser->token + parser->token_length, data, length);
+  parser->token_length += length;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_buffer_elements_parser_append(
+    iree_hal_buffer_elements_parser_t* parser, iree_string_view_t chunk) {
+  IREE_ASSERT_ARGUMENT(parser);
+  if (iree_string_view_is_empty(chunk)) return iree_ok_status();
+  parser->has_input = true;
+
+  iree_host_size_t i = 0;
+  if (parser->token_length > 0) {
+    // Complete the element carried over from the previous chunk.
+    while (i < chunk.size && !iree_hal_is_element_separator(chunk.data[i])) {
+      ++i;
+    }
+    IREE_RETURN_IF_ERROR(
+        iree_hal_buffer_elements_parser_stash(parser, chunk.data, i));
+    if (i == chunk.size) return iree_ok_status();
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_elements_parser_emit(
+        parser, iree_make_string_view(parser->token, parser->token_length)));
+    parser->token_length = 0;
+  }
+
+  // Elements wholly contained within the chunk are parsed in-place.
+  while (i < chunk.size) {
+    while (i < chunk.size && iree_hal_is_element_separator(chunk.data[i])) {
+      ++i;
+    }
+    iree_host_size_t token_start = i;
+    while (i < chunk.size && !iree_hal_is_element_separator(chunk.data[i])) {
+      ++i;
+    }
+    if (i == token_start) break;
+    if (i == chunk.size) {
+      return iree_hal_buffer_elements_parser_stash(
+          parser, chunk.data + token_start, i - token_start);
+    }
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_elements_parser_emit(
+        parser, iree_make_string_view(chunk.data + token_start,
+                                      i - token_start)));
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_buffer_elements_parser_finish(
+    iree_hal_buffer_elements_parser_t* parser) {
+  IREE_ASSERT_ARGUMENT(parser);
+  if (parser->token_length > 0) {
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_elements_parser_emit(
+        parser, iree_make_string_view(parser->token, parser->token_length)));
+    parser->token_length = 0;
+  }
+  iree_byte_span_t data_ptr = parser->data_ptr;
+  if (!parser->has_input) {
+    memset(data_ptr.data, 0, data_ptr.data_length);
+    return iree_ok_status();
+  }
+  iree_host_size_t element_size =
+      iree_hal_element_byte_count(parser->element_type);
+  iree_host_size_t element_capacity = data_ptr.data_length / element_size;
+  if (parser->element_count == 1 && element_capacity > 1) {
+    // Splat the single value we got to the entire buffer.
+    uint8_t* p = data_ptr.data + element_size;
+    for (iree_host_size_t i = 1; i < element_capacity;
+         ++i, p += element_size) {
+      memcpy(p, data_ptr.data, element_size);
+    }
+  } else if (parser->element_count < element_capacity) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "input data string underflow: dst_i=%zu < element_capacity=%zu",
+        parser->element_count, element_capacity);
+  }
+  return iree_ok_status();
 }
@@ -17,6 +17,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "iree/base/api.h"
 #include "iree/hal/buffer.h"
@@ -105,6 +106,93 @@ IREE_API_EXPORT iree_status_t iree_hal_format_buffer_elements(
     iree_host_size_t max_element_count, iree_host_size_t buffer_capacity,
     char* buffer, iree_host_size_t* out_buffer_length);
 
+//===----------------------------------------------------------------------===//
+// Streaming formatting and parsing
+//===----------------------------------------------------------------------===//
+
+// Capacity in characters of the chunks produced by the streaming formatters.
+#define IREE_HAL_STRING_CHUNK_CAPACITY 4096
+
+// Maximum length in characters of a single serialized element. The longest
+// elements are opaque types of up to 255 bits written as 64 hex digits.
+#define IREE_HAL_ELEMENT_STRING_MAX_LENGTH 96
+
+// Consumes a chunk of formatted characters. |chunk| is not NUL terminated and
+// is only valid for the duration of the call.
+typedef iree_status_t(IREE_API_PTR* iree_hal_string_sink_write_fn_t)(
+    void* self, iree_string_view_t chunk);
+
+// A destination for streamed string output.
+typedef struct {
+  // User-defined pointer passed to |write|.
+  void* self;
+  // Writes a chunk of output. Failures abort formatting and are returned to
+  // the caller of the formatting function.
+  iree_hal_string_sink_write_fn_t write;
+} iree_hal_string_sink_t;
+
+// Returns a sink that writes all chunks to |file|.
+IREE_API_EXPORT iree_hal_string_sink_t iree_hal_string_sink_file(FILE* file);
+
+// Streams a shaped buffer of |element_type| elements to |sink|.
+// The output is identical to that of iree_hal_format_buffer_elements but is
+// produced in a single pass in chunks of up to IREE_HAL_STRING_CHUNK_CAPACITY
+// characters so that the full string is never materialized.
+IREE_API_EXPORT iree_status_t iree_hal_format_buffer_elements_to_sink(
+    iree_const_byte_span_t data, const iree_hal_dim_t* shape,
+    iree_host_size_t shape_rank, iree_hal_element_type_t element_type,
+    iree_host_size_t max_element_count, iree_hal_string_sink_t sink);
+
+// Streams the buffer view elements in the same fully-specified string-form
+// format as iree_hal_buffer_view_format (like `2x4xi16=[[1 2][3 4]]`) to
+// |sink| without materializing the full string.
+//
+// |max_element_count| can be used to limit the total number of elements printed
+// when the count may be large. Elided elements will be replaced with `...`.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_view_format_to_sink(
+    const iree_hal_buffer_view_t* buffer_view,
+    iree_host_size_t max_element_count, iree_hal_string_sink_t sink);
+
+// Incrementally parses serialized buffer elements provided in arbitrarily
+// split chunks. Accepts the same format as iree_hal_parse_buffer_elements.
+//
+// Usage:
+//   iree_hal_buffer_elements_parser_t parser;
+//   iree_hal_buffer_elements_parser_initialize(element_type, data_ptr,
+//                                              &parser);
+//   while (...read chunk...) {
+//     IREE_RETURN_IF_ERROR(
+//         iree_hal_buffer_elements_parser_append(&parser, chunk));
+//   }
+//   IREE_RETURN_IF_ERROR(iree_hal_buffer_elements_parser_finish(&parser));
+typedef struct {
+  iree_hal_element_type_t element_type;
+  iree_byte_span_t data_ptr;
+  // Total number of elements parsed into |data_ptr| so far.
+  iree_host_size_t element_count;
+  // True if any characters have been appended.
+  bool has_input;
+  // Partial element split across the end of the last appended chunk.
+  iree_host_size_t token_length;
+  char token[IREE_HAL_ELEMENT_STRING_MAX_LENGTH];
+} iree_hal_buffer_elements_parser_t;
+
+// Initializes |out_parser| to parse elements of |element_type| into
+// |data_ptr|. No resources are held and no deinitialization is required.
+IREE_API_EXPORT void iree_hal_buffer_elements_parser_initialize(
+    iree_hal_element_type_t element_type, iree_byte_span_t data_ptr,
+    iree_hal_buffer_elements_parser_t* out_parser);
+
+// Parses all complete elements in |chunk|. An element running up to the end
+// of the chunk is retained and completed by the following chunk.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_elements_parser_append(
+    iree_hal_buffer_elements_parser_t* parser, iree_string_view_t chunk);
+
+// Parses any pending element and verifies the output was fully populated.
+// Handles zero fill and splats as with iree_hal_parse_buffer_elements.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_elements_parser_finish(
+    iree_hal_buffer_elements_parser_t* parser);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
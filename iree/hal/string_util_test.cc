@@ -901,6 +901,113 @@ TEST(BufferElementsStringUtilTest, FormatBufferElementsElided) {
               IsOkAndHolds("[1 2][3 4]"));
 }
 
+// Streams the elements of |data| through a sink and returns the chunks.
+template <typename T>
+StatusOr<std::vector<std::string>> FormatBufferElementsToChunks(
+    absl::Span<const T> data, const Shape& shape) {
+  std::vector<std::string> chunks;
+  iree_hal_string_sink_t sink = {
+      &chunks, +[](void* self, iree_string_view_t chunk) {
+        static_cast<std::vector<std::string>*>(self)->emplace_back(chunk.data,
+                                                                  chunk.size);
+        return iree_ok_status();
+      }};
+  IREE_RETURN_IF_ERROR(iree_hal_format_buffer_elements_to_sink(
+      iree_const_byte_span_t{reinterpret_cast<const uint8_t*>(data.data()),
+                             data.size() * sizeof(T)},
+      shape.data(), shape.size(), ElementTypeFromCType<T>::value, SIZE_MAX,
+      sink));
+  return std::move(chunks);
+}
+
+// Parses |chunks| in order with a single streaming parser.
+template <typename T>
+Status ParseBufferElementChunks(const std::vector<std::string>& chunks,
+                                absl::Span<T> buffer) {
+  iree_hal_buffer_elements_parser_t parser;
+  iree_hal_buffer_elements_parser_initialize(
+      ElementTypeFromCType<T>::value,
+      iree_byte_span_t{reinterpret_cast<uint8_t*>(buffer.data()),
+                       buffer.size() * sizeof(T)},
+      &parser);
+  for (const auto& chunk : chunks) {
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_elements_parser_append(
+        &parser, iree_string_view_t{chunk.data(), chunk.size()}));
+  }
+  return iree_hal_buffer_elements_parser_finish(&parser);
+}
+
+TEST(BufferElementsStringUtilTest, FormatBufferElementsToSink) {
+  std::vector<int64_t> data(4000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int64_t)(i * i * 7919) * (i % 2 ? -1 : 1);
+  }
+  data[1] = INT64_MIN;
+  data[2] = INT64_MAX;
+  Shape shape = {40, 100};
+  IREE_ASSERT_OK_AND_ASSIGN(
+      auto chunks,
+      FormatBufferElementsToChunks<int64_t>(absl::MakeConstSpan(data), shape));
+  ASSERT_GT(chunks.size(), 1);
+  std::string streamed;
+  for (const auto& chunk : chunks) {
+    EXPECT_LT(chunk.size(), IREE_HAL_STRING_CHUNK_CAPACITY);
+    streamed += chunk;
+  }
+  EXPECT_THAT(FormatBufferElements<int64_t>(data, shape),
+              IsOkAndHolds(streamed));
+  EXPECT_EQ(0, streamed.find("[0 -9223372036854775808 9223372036854775807 "
+                             "-71271 126704 "));
+}
+
+TEST(BufferElementsStringUtilTest, FormatBufferElementsIntegerLimits) {
+  EXPECT_THAT(FormatBufferElements<int8_t>({INT8_MIN, 0, INT8_MAX}, Shape{3}),
+              IsOkAndHolds("-128 0 127"));
+  EXPECT_THAT(FormatBufferElements<uint8_t>({0, 9, 10, 99, 100, UINT8_MAX},
+                                            Shape{6}),
+              IsOkAndHolds("0 9 10 99 100 255"));
+  EXPECT_THAT(FormatBufferElements<int32_t>({INT32_MIN, INT32_MAX}, Shape{2}),
+              IsOkAndHolds("-2147483648 2147483647"));
+  EXPECT_THAT(FormatBufferElements<uint64_t>({UINT64_MAX}, Shape{1}),
+              IsOkAndHolds("18446744073709551615"));
+  EXPECT_THAT(FormatBufferElements<float>({0.5f, -1e20f, 3.0f}, Shape{3}),
+              IsOkAndHolds("0.5 -1E+20 3"));
+}
+
+TEST(BufferElementsStringUtilTest, ParseBufferElementsChunked) {
+  const std::string value = "[0 -1 22 333] [4444,55 6\n77]";
+  const std::vector<int32_t> expected = {0, -1, 22, 333, 4444, 55, 6, 77};
+  // Every possible split into two chunks.
+  for (size_t i = 0; i <= value.size(); ++i) {
+    std::vector<int32_t> buffer(8);
+    IREE_EXPECT_OK(ParseBufferElementChunks<int32_t>(
+        {value.substr(0, i), value.substr(i)}, absl::MakeSpan(buffer)));
+    EXPECT_THAT(buffer, Eq(expected));
+  }
+  // One character at a time.
+  std::vector<std::string> chars;
+  for (char c : value) chars.push_back(std::string(1, c));
+  std::vector<int32_t> buffer(8);
+  IREE_EXPECT_OK(ParseBufferElementChunks<int32_t>(chars,
+                                                   absl::MakeSpan(buffer)));
+  EXPECT_THAT(buffer, Eq(expected));
+}
+
+TEST(BufferElementsStringUtilTest, ParseBufferElementsChunkedSplatAndFill) {
+  std::vector<int16_t> buffer(4, 7);
+  IREE_EXPECT_OK(ParseBufferElementChunks<int16_t>({}, absl::MakeSpan(buffer)));
+  EXPECT_THAT(buffer, Eq(std::vector<int16_t>{0, 0, 0, 0}));
+  IREE_EXPECT_OK(
+      ParseBufferElementChunks<int16_t>({"1", "2"}, absl::MakeSpan(buffer)));
+  EXPECT_THAT(buffer, Eq(std::vector<int16_t>{12, 12, 12, 12}));
+  EXPECT_THAT(
+      ParseBufferElementChunks<int16_t>({"1 ", "2"}, absl::MakeSpan(buffer)),
+      StatusIs(StatusCode::kOutOfRange));
+  EXPECT_THAT(ParseBufferElementChunks<int16_t>(
+                  {std::string(200, '1')}, absl::MakeSpan(buffer)),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
 TEST(BufferViewStringUtilTest, Parse) {
   IREE_ASSERT_OK_AND_ASSIGN(auto allocator, Allocator::CreateHostLocal());
 
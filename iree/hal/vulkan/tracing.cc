@@ -14,7 +14,8 @@
 
 #include "iree/hal/vulkan/tracing.h"
 
-#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+#if (IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION) && \
+    defined(TRACY_ENABLE)
 
 #include "iree/base/api.h"
 #include "iree/base/target_platform.h"
@@ -645,4 +646,4 @@ void iree_hal_vulkan_tracing_zone_end_impl(
   tracy::Profiler::QueueSerialFinish();
 }
 
-#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+#endif  // IREE_TRACING_FEATURE_INSTRUMENTATION && TRACY_ENABLE
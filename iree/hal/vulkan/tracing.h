@@ -74,7 +74,8 @@ extern "C" {
 typedef struct iree_hal_vulkan_tracing_context_s
     iree_hal_vulkan_tracing_context_t;
 
-#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+#if (IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION) && \
+    defined(TRACY_ENABLE)
 
 // Allocates a tracing context for the given Vulkan queue.
 // Each context must only be used with the queue it was created with.
@@ -170,7 +171,7 @@ inline void iree_hal_vulkan_tracing_context_collect(
     function_name_length, name, name_length)
 #define IREE_VULKAN_TRACE_ZONE_END(context, command_buffer)
 
-#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+#endif  // IREE_TRACING_FEATURE_INSTRUMENTATION && TRACY_ENABLE
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -45,17 +45,17 @@ absl::Span<const T> AbslSpan(iree_byte_span_t bytes) {
                        bytes.data_length / sizeof(T));
 }
 
+// iree_hal_string_sink_t write function appending chunks to a std::string.
+iree_status_t AppendToString(void* self, iree_string_view_t chunk) {
+  static_cast<std::string*>(self)->append(chunk.data, chunk.size);
+  return iree_ok_status();
+}
+
 StatusOr<std::string> BufferViewToString(iree_hal_buffer_view_t* buffer_view) {
-  std::string result_str(4096, '\0');
-  iree_status_t status;
-  do {
-    iree_host_size_t actual_length = 0;
-    status = iree_hal_buffer_view_format(
-        buffer_view, /*max_element_count=*/1024, result_str.size() + 1,
-        &result_str[0], &actual_length);
-    result_str.resize(actual_length);
-  } while (iree_status_is_out_of_range(status));
-  IREE_RETURN_IF_ERROR(std::move(status));
+  std::string result_str;
+  iree_hal_string_sink_t sink = {&result_str, AppendToString};
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_format_to_sink(
+      buffer_view, /*max_element_count=*/1024, sink));
   return std::move(result_str);
 }
 
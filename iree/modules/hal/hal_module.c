@@ -18,6 +18,8 @@
 #include <stdio.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/vm/api.h"
@@ -26,6 +28,10 @@
 // in the future but right now guards the stack from blowing up during calls.
 #define IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT ((iree_host_size_t)32)
 
+// Maximum size of the key identifying a shared resource. Resources whose
+// creation arguments don't fit are created per-context.
+#define IREE_HAL_MODULE_MAX_RESOURCE_KEY_LENGTH ((iree_host_size_t)512)
+
 //===----------------------------------------------------------------------===//
 // Type registration
 //===----------------------------------------------------------------------===//
@@ -118,17 +124,62 @@ IREE_VM_DEFINE_TYPE_ADAPTERS(iree_hal_semaphore, iree_hal_semaphore_t);
 // Module type definitions
 //===----------------------------------------------------------------------===//
 
+typedef struct {
+  // Opaque bytes identifying the resource kind and its creation arguments.
+  iree_host_size_t key_length;
+  uint8_t* key;
+  // Retained resource.
+  iree_vm_ref_t value;
+} iree_hal_module_resource_t;
+
+// Immutable resources shared across all contexts the module is registered
+// with. Programs create these in their initializers and keep them in globals
+// so the number of entries is small and lookups are linear.
+typedef struct {
+  iree_slim_mutex_t mutex;
+  iree_host_size_t count;
+  iree_host_size_t capacity;
+  iree_hal_module_resource_t* entries;
+} iree_hal_module_resource_cache_t;
+
 typedef struct {
   iree_allocator_t host_allocator;
   iree_hal_device_t* shared_device;
-  // TODO(benvanik): types.
+  iree_hal_module_flags_t flags;
+  iree_hal_module_resource_cache_t resource_cache;
 } iree_hal_module_t;
 
 #define IREE_HAL_MODULE_CAST(module) \
   (iree_hal_module_t*)((uint8_t*)(module) + iree_vm_native_module_size());
 
+// A command buffer submitted by the program while a batch is active.
+typedef struct {
+  iree_host_size_t slot;
+  iree_hal_command_buffer_t* command_buffer;
+} iree_hal_module_deferred_submission_t;
+
+// Submissions deferred across independent invocations so that they can be
+// issued to the device together; see iree_hal_module_state_begin_batch.
+// Each slot (invocation) has its own timeline semaphore: command buffers from
+// the same slot are chained in submission order while those from different
+// slots have no dependencies and may execute concurrently.
+typedef struct {
+  bool active;
+  iree_host_size_t current_slot;
+  // Number of slots used by the current batch.
+  iree_host_size_t slot_count;
+  iree_host_size_t slot_capacity;
+  iree_hal_semaphore_t** slot_semaphores;
+  uint64_t* slot_values;
+  iree_status_t* slot_statuses;
+  iree_host_size_t submission_count;
+  iree_host_size_t submission_capacity;
+  iree_hal_module_deferred_submission_t* submissions;
+} iree_hal_module_batch_t;
+
 typedef struct {
   iree_allocator_t host_allocator;
+  iree_hal_module_t* module;
   iree_hal_device_t* shared_device;
   iree_hal_executable_cache_t* executable_cache;
 
@@ -137,10 +188,29 @@ typedef struct {
 
   void* deferred_lru[6];
   iree_vm_list_t* deferred_releases;
+
+  iree_hal_module_batch_t batch;
+
+  // Retained executable placeholders created by this state that may not yet
+  // have been prepared.
+  iree_host_size_t pending_executable_count;
+  iree_host_size_t pending_executable_capacity;
+  iree_hal_executable_t** pending_executables;
 } iree_hal_module_state_t;
 
+static void iree_hal_module_batch_reset(iree_hal_module_state_t* state);
+static void iree_hal_module_reset_pending_executables(
+    iree_hal_module_state_t* state);
+
 static void IREE_API_PTR iree_hal_module_destroy(void* base_module) {
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
+  iree_hal_module_resource_cache_t* cache = &module->resource_cache;
+  for (iree_host_size_t i = 0; i < cache->count; ++i) {
+    iree_vm_ref_release(&cache->entries[i].value);
+    iree_allocator_free(module->host_allocator, cache->entries[i].key);
+  }
+  iree_allocator_free(module->host_allocator, cache->entries);
+  iree_slim_mutex_deinitialize(&cache->mutex);
   iree_hal_device_release(module->shared_device);
 }
 
@@ -153,6 +223,7 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
       iree_allocator_malloc(host_allocator, sizeof(*state), (void**)&state));
   memset(state, 0, sizeof(*state));
   state->host_allocator = host_allocator;
+  state->module = module;
   state->shared_device = module->shared_device;
   iree_hal_device_retain(state->shared_device);
 
@@ -175,6 +246,16 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
 static void IREE_API_PTR
 iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  iree_hal_module_reset_pending_executables(state);
+  iree_allocator_free(state->host_allocator, state->pending_executables);
+  iree_hal_module_batch_reset(state);
+  for (iree_host_size_t i = 0; i < state->batch.slot_capacity; ++i) {
+    iree_hal_semaphore_release(state->batch.slot_semaphores[i]);
+  }
+  iree_allocator_free(state->host_allocator, state->batch.slot_semaphores);
+  iree_allocator_free(state->host_allocator, state->batch.slot_values);
+  iree_allocator_free(state->host_allocator, state->batch.slot_statuses);
+  iree_allocator_free(state->host_allocator, state->batch.submissions);
   iree_hal_semaphore_release(state->submit_semaphore);
   iree_vm_list_release(state->deferred_releases);
   iree_hal_executable_cache_release(state->executable_cache);
@@ -182,6 +263,631 @@ iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_allocator_free(state->host_allocator, state);
 }
 
+//===----------------------------------------------------------------------===//
+// Shared resources
+//===----------------------------------------------------------------------===//
+// When IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES is set the exports that
+// create immutable resources first build a key from their arguments and return
+// the resource created by any prior call with the same key, possibly from
+// another context. Source data (executable binaries, constant contents) is
+// keyed by address and is only shared when it lives in the rodata of program
+// modules (IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE) that are shared along with this
+// module. Buffers created by the host or guest at runtime may be freed and
+// their address reused for different contents so resources created from them
+// are never shared.
+
+typedef enum {
+  IREE_HAL_MODULE_RESOURCE_KIND_CONSTANT_BUFFER = 0,
+  IREE_HAL_MODULE_RESOURCE_KIND_DESCRIPTOR_SET_LAYOUT,
+  IREE_HAL_MODULE_RESOURCE_KIND_EXECUTABLE,
+  IREE_HAL_MODULE_RESOURCE_KIND_EXECUTABLE_LAYOUT,
+} iree_hal_module_resource_kind_t;
+
+typedef struct {
+  iree_host_size_t length;
+  uint8_t data[IREE_HAL_MODULE_MAX_RESOURCE_KEY_LENGTH];
+} iree_hal_module_resource_key_t;
+
+static void iree_hal_module_resource_key_initialize(
+    iree_hal_module_resource_kind_t kind,
+    iree_hal_module_resource_key_t* out_key) {
+  uint32_t kind_value = (uint32_t)kind;
+  memcpy(out_key->data, &kind_value, sizeof(kind_value));
+  out_key->length = sizeof(kind_value);
+}
+
+// Appends |length| bytes to |key|. Keys that overflow are marked invalid by
+// setting their length past the maximum and will never be cached.
+static void iree_hal_module_resource_key_append(
+    iree_hal_module_resource_key_t* key, const void* value,
+    iree_host_size_t length) {
+  if (key->length + length <= IREE_ARRAYSIZE(key->data)) {
+    memcpy(&key->data[key->length], value, length);
+  }
+  key->length += length;
+}
+
+#define iree_hal_module_resource_key_append_value(key, value) \
+  iree_hal_module_resource_key_append(key, &(value), sizeof(value))
+
+// Returns true if |source| is program module rodata that remains valid and
+// unchanged for as long as the module is loaded.
+static bool iree_hal_module_is_shareable_source(
+    const iree_vm_buffer_t* source) {
+  return iree_all_bits_set(source->access,
+                           IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE);
+}
+
+static bool iree_hal_module_resource_key_is_valid(
+    const iree_hal_module_resource_key_t* key) {
+  return key->length <= IREE_ARRAYSIZE(key->data);
+}
+
+// Returns true if |state| may share the resource identified by |key|.
+static bool iree_hal_module_can_share(
+    iree_hal_module_state_t* state, const iree_hal_module_resource_key_t* key) {
+  return iree_all_bits_set(state->module->flags,
+                           IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES) &&
+         iree_hal_module_resource_key_is_valid(key);
+}
+
+// Must be called with the cache mutex held.
+static iree_hal_module_resource_t* iree_hal_module_resource_cache_find(
+    iree_hal_module_resource_cache_t* cache,
+    const iree_hal_module_resource_key_t* key) {
+  for (iree_host_size_t i = 0; i < cache->count; ++i) {
+    iree_hal_module_resource_t* entry = &cache->entries[i];
+    if (entry->key_length == key->length &&
+        memcmp(entry->key, key->data, key->length) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Returns a retained reference to the resource matching |key| if one has been
+// created by any context and otherwise a null reference.
+static iree_vm_ref_t iree_hal_module_resource_cache_lookup(
+    iree_hal_module_state_t* state, const iree_hal_module_resource_key_t* key) {
+  iree_vm_ref_t ref = {0};
+  if (!iree_hal_module_can_share(state, key)) return ref;
+  iree_hal_module_resource_cache_t* cache = &state->module->resource_cache;
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_hal_module_resource_t* entry =
+      iree_hal_module_resource_cache_find(cache, key);
+  if (entry) iree_vm_ref_retain(&entry->value, &ref);
+  iree_slim_mutex_unlock(&cache->mutex);
+  return ref;
+}
+
+// Makes the newly created resource in |ref| available to all contexts under
+// |key| and returns the resource the caller should use, taking ownership of
+// |ref|. If another context raced and inserted the same key first that
+// resource is returned instead so that all contexts observe the same one.
+// Failing to insert is not an error: the resource is just not shared.
+static iree_vm_ref_t iree_hal_module_resource_cache_insert(
+    iree_hal_module_state_t* state, const iree_hal_module_resource_key_t* key,
+    iree_vm_ref_t ref) {
+  if (!iree_hal_module_can_share(state, key)) return ref;
+  iree_hal_module_t* module = state->module;
+  iree_hal_module_resource_cache_t* cache = &module->resource_cache;
+  iree_slim_mutex_lock(&cache->mutex);
+  iree_hal_module_resource_t* entry =
+      iree_hal_module_resource_cache_find(cache, key);
+  if (entry) {
+    iree_vm_ref_release(&ref);
+    iree_vm_ref_retain(&entry->value, &ref);
+    iree_slim_mutex_unlock(&cache->mutex);
+    return ref;
+  }
+  iree_status_t status = iree_ok_status();
+  if (cache->count == cache->capacity) {
+    iree_host_size_t new_capacity = iree_max(16, cache->capacity * 2);
+    status = iree_allocator_realloc(module->host_allocator,
+                                    new_capacity * sizeof(cache->entries[0]),
+                                    (void**)&cache->entries);
+    if (iree_status_is_ok(status)) cache->capacity = new_capacity;
+  }
+  uint8_t* key_data = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(module->host_allocator, key->length,
+                                   (void**)&key_data);
+  }
+  if (iree_status_is_ok(status)) {
+    entry = &cache->entries[cache->count++];
+    memcpy(key_data, key->data, key->length);
+    entry->key = key_data;
+    entry->key_length = key->length;
+    memset(&entry->value, 0, sizeof(entry->value));
+    iree_vm_ref_retain(&ref, &entry->value);
+  }
+  iree_slim_mutex_unlock(&cache->mutex);
+  iree_status_ignore(status);
+  return ref;
+}
+
+//===----------------------------------------------------------------------===//
+// Batched submission
+//===----------------------------------------------------------------------===//
+// While a batch is active hal.ex.submit_and_wait appends the command buffer to
+// the deferred submission list of the current slot and returns immediately.
+// Everything deferred is issued with a single queue submission when the batch
+// ends or when the program needs to observe device results from the host.
+
+// Ensures that slots [0, slot_count) are tracked by the batch.
+static iree_status_t iree_hal_module_batch_reserve_slots(
+    iree_hal_module_state_t* state, iree_host_size_t slot_count) {
+  iree_hal_module_batch_t* batch = &state->batch;
+  if (slot_count <= batch->slot_capacity) return iree_ok_status();
+  iree_host_size_t new_capacity = iree_max(16, batch->slot_capacity * 2);
+  while (new_capacity < slot_count) new_capacity *= 2;
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      state->host_allocator, new_capacity * sizeof(batch->slot_semaphores[0]),
+      (void**)&batch->slot_semaphores));
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      state->host_allocator, new_capacity * sizeof(batch->slot_values[0]),
+      (void**)&batch->slot_values));
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      state->host_allocator, new_capacity * sizeof(batch->slot_statuses[0]),
+      (void**)&batch->slot_statuses));
+  iree_host_size_t added_count = new_capacity - batch->slot_capacity;
+  memset(&batch->slot_semaphores[batch->slot_capacity], 0,
+         added_count * sizeof(batch->slot_semaphores[0]));
+  memset(&batch->slot_values[batch->slot_capacity], 0,
+         added_count * sizeof(batch->slot_values[0]));
+  memset(&batch->slot_statuses[batch->slot_capacity], 0,
+         added_count * sizeof(batch->slot_statuses[0]));
+  batch->slot_capacity = new_capacity;
+  return iree_ok_status();
+}
+
+// Drops the semaphore of |slot| such that a new one is created on next use.
+// Failed semaphores remain failed forever and cannot be reused.
+static void iree_hal_module_batch_drop_slot_semaphore(
+    iree_hal_module_state_t* state, iree_host_size_t slot) {
+  iree_hal_semaphore_release(state->batch.slot_semaphores[slot]);
+  state->batch.slot_semaphores[slot] = NULL;
+  state->batch.slot_values[slot] = 0ull;
+}
+
+// Appends |command_buffer| to the deferred submissions of the current slot.
+static iree_status_t iree_hal_module_batch_defer(
+    iree_hal_module_state_t* state, iree_hal_command_buffer_t* command_buffer) {
+  iree_hal_module_batch_t* batch = &state->batch;
+  iree_host_size_t slot = batch->current_slot;
+  if (!batch->slot_semaphores[slot]) {
+    batch->slot_values[slot] = 0ull;
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_create(
+        state->shared_device, batch->slot_values[slot],
+        &batch->slot_semaphores[slot]));
+  }
+  if (batch->submission_count == batch->submission_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(16, batch->submission_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        state->host_allocator, new_capacity * sizeof(batch->submissions[0]),
+        (void**)&batch->submissions));
+    batch->submission_capacity = new_capacity;
+  }
+  iree_hal_module_deferred_submission_t* submission =
+      &batch->submissions[batch->submission_count++];
+  submission->slot = slot;
+  submission->command_buffer = command_buffer;
+  iree_hal_command_buffer_retain(command_buffer);
+  return iree_ok_status();
+}
+
+// Issues all deferred submissions with a single queue submission.
+// Each command buffer gets its own submission batch waiting on the prior value
+// of its slot semaphore and signaling the next value.
+static iree_status_t iree_hal_module_batch_submit(
+    iree_hal_module_state_t* state) {
+  iree_hal_module_batch_t* batch = &state->batch;
+  iree_host_size_t count = batch->submission_count;
+
+  iree_hal_submission_batch_t* batches = NULL;
+  iree_host_size_t total_size =
+      count * (sizeof(batches[0]) + 2 * sizeof(uint64_t));
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(state->host_allocator, total_size,
+                                             (void**)&batches));
+  uint64_t* wait_values = (uint64_t*)(batches + count);
+  uint64_t* signal_values = wait_values + count;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_hal_module_deferred_submission_t* submission = &batch->submissions[i];
+    iree_host_size_t slot = submission->slot;
+    wait_values[i] = batch->slot_values[slot];
+    signal_values[i] = ++batch->slot_values[slot];
+    batches[i].wait_semaphores.count = 1;
+    batches[i].wait_semaphores.semaphores = &batch->slot_semaphores[slot];
+    batches[i].wait_semaphores.payload_values = &wait_values[i];
+    batches[i].command_buffer_count = 1;
+    batches[i].command_buffers = &submission->command_buffer;
+    batches[i].signal_semaphores.count = 1;
+    batches[i].signal_semaphores.semaphores = &batch->slot_semaphores[slot];
+    batches[i].signal_semaphores.payload_values = &signal_values[i];
+  }
+
+  iree_status_t status = iree_hal_device_queue_submit(
+      state->shared_device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, count, batches);
+
+  iree_allocator_free(state->host_allocator, batches);
+  return status;
+}
+
+// Submits all deferred work and waits for it to complete. Failures of the work
+// in each slot are recorded in the slot status and only failures to submit are
+// returned.
+static iree_status_t iree_hal_module_batch_flush(
+    iree_hal_module_state_t* state) {
+  iree_hal_module_batch_t* batch = &state->batch;
+  if (!batch->submission_count) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)batch->submission_count);
+
+  iree_status_t status = iree_hal_module_batch_submit(state);
+  for (iree_host_size_t slot = 0; slot < batch->slot_count; ++slot) {
+    if (!batch->slot_semaphores[slot]) continue;
+    if (!iree_status_is_ok(status)) {
+      // Nothing was submitted and the payload values are no longer in sync.
+      iree_hal_module_batch_drop_slot_semaphore(state, slot);
+      continue;
+    }
+    iree_status_t slot_status = iree_hal_semaphore_wait(
+        batch->slot_semaphores[slot], batch->slot_values[slot],
+        iree_infinite_timeout());
+    if (!iree_status_is_ok(slot_status)) {
+      if (iree_status_is_ok(batch->slot_statuses[slot])) {
+        batch->slot_statuses[slot] = slot_status;
+      } else {
+        iree_status_ignore(slot_status);
+      }
+      iree_hal_module_batch_drop_slot_semaphore(state, slot);
+    }
+  }
+
+  // The command buffers are no longer in flight.
+  for (iree_host_size_t i = 0; i < batch->submission_count; ++i) {
+    iree_hal_command_buffer_release(batch->submissions[i].command_buffer);
+  }
+  batch->submission_count = 0;
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_list_resize(state->deferred_releases, 0);
+    memset(state->deferred_lru, 0, sizeof(state->deferred_lru));
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Flushes deferred work prior to the program accessing device results from the
+// host. Returns the failure of any prior work in the current slot.
+static iree_status_t iree_hal_module_batch_flush_for_host_access(
+    iree_hal_module_state_t* state) {
+  if (!state->batch.active) return iree_ok_status();
+  IREE_RETURN_IF_ERROR(iree_hal_module_batch_flush(state));
+  iree_host_size_t slot = state->batch.current_slot;
+  return iree_status_clone(state->batch.slot_statuses[slot]);
+}
+
+// Drops all deferred work and slot statuses and deactivates the batch.
+static void iree_hal_module_batch_reset(iree_hal_module_state_t* state) {
+  iree_hal_module_batch_t* batch = &state->batch;
+  for (iree_host_size_t i = 0; i < batch->submission_count; ++i) {
+    iree_hal_command_buffer_release(batch->submissions[i].command_buffer);
+  }
+  batch->submission_count = 0;
+  for (iree_host_size_t slot = 0; slot < batch->slot_count; ++slot) {
+    iree_status_ignore(batch->slot_statuses[slot]);
+    batch->slot_statuses[slot] = iree_ok_status();
+  }
+  batch->slot_count = 0;
+  batch->current_slot = 0;
+  batch->active = false;
+}
+
+//===----------------------------------------------------------------------===//
+// Startup profiling
+//===----------------------------------------------------------------------===//
+
+static bool iree_hal_module_startup_profiling_enabled(void) {
+  return iree_vm_startup_profiler_is_enabled(
+      iree_vm_startup_profiler_default());
+}
+
+// Attributes the time since |start_ns| to |phase| of the HAL module.
+static void iree_hal_module_record_startup_phase(iree_vm_startup_phase_t phase,
+                                                 iree_time_t start_ns,
+                                                 uint64_t byte_length) {
+  iree_status_ignore(iree_vm_startup_profiler_record(
+      iree_vm_startup_profiler_default(), iree_make_cstring_view("hal"), phase,
+      iree_time_now() - start_ns, byte_length));
+}
+
+//===----------------------------------------------------------------------===//
+// Lazy executables
+//===----------------------------------------------------------------------===//
+// When IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES is set hal.executable.create
+// returns a placeholder that captures the preparation arguments and the
+// executable is prepared the first time it is dispatched. Programs create all
+// of their executables in initializers even if only a few are used by the
+// functions called so this moves the (often dominant) preparation cost out of
+// context creation and skips it entirely for executables that are never used.
+//
+// IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES uses the same placeholders and the
+// first dispatch of any of them prepares all those not yet prepared with a
+// single iree_hal_executable_cache_prepare_executables call that devices can
+// spread across their workers. Placeholders are tracked on the module state in
+// both modes so that iree_hal_module_state_prepare_executables can prepare
+// them ahead of time. They are dropped from tracking once prepared so that
+// the state does not keep executables alive after programs release them.
+//
+// The placeholder is exposed to programs as a hal.executable so that it can be
+// stored in globals and passed around like any other. Only the dispatch
+// exports ever look inside of executables and they resolve the placeholder to
+// the prepared executable before recording.
+
+typedef struct {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_executable_cache_t* executable_cache;
+  iree_vm_buffer_t* executable_format;
+  iree_vm_buffer_t* executable_data;
+  iree_hal_executable_caching_mode_t caching_mode;
+
+  // Guards preparation so that concurrent first dispatches only prepare once.
+  iree_slim_mutex_t mutex;
+  // Prepared iree_hal_executable_t*, or 0 until first use.
+  iree_atomic_intptr_t executable;
+
+  iree_host_size_t executable_layout_count;
+  iree_hal_executable_layout_t* executable_layouts[];
+} iree_hal_module_lazy_executable_t;
+
+static const iree_hal_executable_vtable_t
+    iree_hal_module_lazy_executable_vtable;
+
+static iree_status_t iree_hal_module_lazy_executable_create(
+    iree_hal_executable_cache_t* executable_cache,
+    iree_vm_buffer_t* executable_format, iree_vm_buffer_t* executable_data,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_host_size_t executable_layout_count,
+    iree_hal_executable_layout_t** executable_layouts,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+  iree_hal_module_lazy_executable_t* lazy_executable = NULL;
+  iree_host_size_t total_size =
+      sizeof(*lazy_executable) +
+      executable_layout_count * sizeof(lazy_executable->executable_layouts[0]);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(host_allocator, total_size,
+                                             (void**)&lazy_executable));
+  iree_hal_resource_initialize(&iree_hal_module_lazy_executable_vtable,
+                               &lazy_executable->resource);
+  lazy_executable->host_allocator = host_allocator;
+  lazy_executable->executable_cache = executable_cache;
+  iree_hal_executable_cache_retain(executable_cache);
+  lazy_executable->executable_format = executable_format;
+  iree_vm_buffer_retain(executable_format);
+  lazy_executable->executable_data = executable_data;
+  iree_vm_buffer_retain(executable_data);
+  lazy_executable->caching_mode = caching_mode;
+  iree_slim_mutex_initialize(&lazy_executable->mutex);
+  iree_atomic_store_intptr(&lazy_executable->executable, 0,
+                           iree_memory_order_relaxed);
+  lazy_executable->executable_layout_count = executable_layout_count;
+  for (iree_host_size_t i = 0; i < executable_layout_count; ++i) {
+    lazy_executable->executable_layouts[i] = executable_layouts[i];
+    iree_hal_executable_layout_retain(executable_layouts[i]);
+  }
+  *out_executable = (iree_hal_executable_t*)lazy_executable;
+  return iree_ok_status();
+}
+
+static void iree_hal_module_lazy_executable_destroy(
+    iree_hal_executable_t* base_executable) {
+  iree_hal_module_lazy_executable_t* lazy_executable =
+      (iree_hal_module_lazy_executable_t*)base_executable;
+  iree_hal_executable_release((iree_hal_executable_t*)iree_atomic_load_intptr(
+      &lazy_executable->executable, iree_memory_order_acquire));
+  for (iree_host_size_t i = 0; i < lazy_executable->executable_layout_count;
+       ++i) {
+    iree_hal_executable_layout_release(lazy_executable->executable_layouts[i]);
+  }
+  iree_slim_mutex_deinitialize(&lazy_executable->mutex);
+  iree_vm_buffer_release(lazy_executable->executable_data);
+  iree_vm_buffer_release(lazy_executable->executable_format);
+  iree_hal_executable_cache_release(lazy_executable->executable_cache);
+  iree_allocator_free(lazy_executable->host_allocator, lazy_executable);
+}
+
+static const iree_hal_executable_vtable_t
+    iree_hal_module_lazy_executable_vtable = {
+        .destroy = iree_hal_module_lazy_executable_destroy,
+};
+
+// Returns the prepared executable or NULL if not yet prepared.
+static iree_hal_executable_t* iree_hal_module_lazy_executable_get(
+    iree_hal_module_lazy_executable_t* lazy_executable) {
+  return (iree_hal_executable_t*)iree_atomic_load_intptr(
+      &lazy_executable->executable, iree_memory_order_acquire);
+}
+
+// Populates |out_spec| with the arguments captured at creation.
+static void iree_hal_module_lazy_executable_spec(
+    iree_hal_module_lazy_executable_t* lazy_executable,
+    iree_hal_executable_spec_t* out_spec) {
+  iree_hal_executable_spec_initialize(out_spec);
+  out_spec->caching_mode = lazy_executable->caching_mode;
+  out_spec->executable_format =
+      iree_vm_buffer_as_string(lazy_executable->executable_format);
+  iree_vm_buffer_t* executable_data = lazy_executable->executable_data;
+  out_spec->executable_data = iree_make_const_byte_span(
+      executable_data->data.data, executable_data->data.data_length);
+  out_spec->executable_layout_count = lazy_executable->executable_layout_count;
+  out_spec->executable_layouts = lazy_executable->executable_layouts;
+}
+
+// Stores the prepared |executable| (taking ownership) unless another thread
+// has already done so, in which case |executable| is dropped.
+static void iree_hal_module_lazy_executable_publish(
+    iree_hal_module_lazy_executable_t* lazy_executable,
+    iree_hal_executable_t* executable) {
+  intptr_t expected = 0;
+  if (!iree_atomic_compare_exchange_strong_intptr(
+          &lazy_executable->executable, &expected, (intptr_t)executable,
+          iree_memory_order_acq_rel, iree_memory_order_acquire)) {
+    iree_hal_executable_release(executable);
+  }
+}
+
+// Prepares the executable captured by |lazy_executable| if it has not been
+// prepared yet.
+static iree_status_t iree_hal_module_lazy_executable_prepare(
+    iree_hal_module_lazy_executable_t* lazy_executable) {
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&lazy_executable->mutex);
+  if (!iree_hal_module_lazy_executable_get(lazy_executable)) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    const bool profile_startup = iree_hal_module_startup_profiling_enabled();
+    iree_time_t start_ns = profile_startup ? iree_time_now() : 0;
+
+    iree_hal_executable_spec_t spec;
+    iree_hal_module_lazy_executable_spec(lazy_executable, &spec);
+    iree_hal_executable_t* executable = NULL;
+    status = iree_hal_executable_cache_prepare_executable(
+        lazy_executable->executable_cache, &spec, &executable);
+    if (iree_status_is_ok(status)) {
+      iree_hal_module_lazy_executable_publish(lazy_executable, executable);
+    }
+
+    if (profile_startup) {
+      iree_hal_module_record_startup_phase(
+          IREE_VM_STARTUP_PHASE_EXECUTABLE_PREPARE, start_ns, 0);
+    }
+    IREE_TRACE_ZONE_END(z0);
+  }
+  iree_slim_mutex_unlock(&lazy_executable->mutex);
+  return status;
+}
+
+// Tracks |executable| (a placeholder) as pending preparation in the batch.
+static iree_status_t iree_hal_module_append_pending_executable(
+    iree_hal_module_state_t* state, iree_hal_executable_t* executable) {
+  if (state->pending_executable_count == state->pending_executable_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(16, state->pending_executable_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        state->host_allocator,
+        new_capacity * sizeof(*state->pending_executables),
+        (void**)&state->pending_executables));
+    state->pending_executable_capacity = new_capacity;
+  }
+  iree_hal_executable_retain(executable);
+  state->pending_executables[state->pending_executable_count++] = executable;
+  return iree_ok_status();
+}
+
+// Releases all pending placeholders without preparing them.
+static void iree_hal_module_reset_pending_executables(
+    iree_hal_module_state_t* state) {
+  for (iree_host_size_t i = 0; i < state->pending_executable_count; ++i) {
+    iree_hal_executable_release(state->pending_executables[i]);
+  }
+  state->pending_executable_count = 0;
+}
+
+// Releases pending placeholders that have already been prepared individually
+// so that they are freed once the program no longer uses them.
+static void iree_hal_module_prune_pending_executables(
+    iree_hal_module_state_t* state) {
+  iree_host_size_t count = 0;
+  for (iree_host_size_t i = 0; i < state->pending_executable_count; ++i) {
+    iree_hal_executable_t* executable = state->pending_executables[i];
+    if (iree_hal_module_lazy_executable_get(
+            (iree_hal_module_lazy_executable_t*)executable)) {
+      iree_hal_executable_release(executable);
+    } else {
+      state->pending_executables[count++] = executable;
+    }
+  }
+  state->pending_executable_count = count;
+}
+
+// Prepares all pending placeholders with a single batch. Placeholders are no
+// longer pending afterward even on failure and any that failed to prepare as
+// part of the batch will be prepared individually when next dispatched.
+static iree_status_t iree_hal_module_prepare_pending_executables(
+    iree_hal_module_state_t* state) {
+  iree_hal_module_prune_pending_executables(state);
+  iree_host_size_t count = state->pending_executable_count;
+  if (!count) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)count);
+  const bool profile_startup = iree_hal_module_startup_profiling_enabled();
+  iree_time_t start_ns = profile_startup ? iree_time_now() : 0;
+
+  iree_hal_executable_spec_t* specs = NULL;
+  iree_hal_executable_t** executables = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      state->host_allocator, count * (sizeof(*specs) + sizeof(*executables)),
+      (void**)&specs);
+  if (iree_status_is_ok(status)) {
+    executables = (iree_hal_executable_t**)(specs + count);
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      iree_hal_module_lazy_executable_spec(
+          (iree_hal_module_lazy_executable_t*)state->pending_executables[i],
+          &specs[i]);
+    }
+    status = iree_hal_executable_cache_prepare_executables(
+        state->executable_cache, count, specs, executables);
+  }
+  if (iree_status_is_ok(status)) {
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      iree_hal_module_lazy_executable_publish(
+          (iree_hal_module_lazy_executable_t*)state->pending_executables[i],
+          executables[i]);
+    }
+  }
+  iree_allocator_free(state->host_allocator, specs);
+  iree_hal_module_reset_pending_executables(state);
+
+  if (profile_startup) {
+    iree_hal_module_record_startup_phase(
+        IREE_VM_STARTUP_PHASE_EXECUTABLE_PREPARE, start_ns, 0);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Returns the executable to record into command buffers for |executable|,
+// preparing it first if it is a placeholder.
+static iree_status_t iree_hal_module_resolve_executable(
+    iree_hal_module_state_t* state, iree_hal_executable_t* executable,
+    iree_hal_executable_t** out_executable) {
+  if (!iree_hal_resource_is(executable,
+                            &iree_hal_module_lazy_executable_vtable)) {
+    *out_executable = executable;
+    return iree_ok_status();
+  }
+  iree_hal_module_lazy_executable_t* lazy_executable =
+      (iree_hal_module_lazy_executable_t*)executable;
+  *out_executable = iree_hal_module_lazy_executable_get(lazy_executable);
+  if (*out_executable) return iree_ok_status();
+  if (iree_all_bits_set(state->module->flags,
+                        IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES)) {
+    // A failure of the batch is not necessarily a failure of this executable;
+    // it is prepared individually below and reports its own errors (as will
+    // any others in the batch when dispatched).
+    iree_status_ignore(iree_hal_module_prepare_pending_executables(state));
+    *out_executable = iree_hal_module_lazy_executable_get(lazy_executable);
+    if (*out_executable) return iree_ok_status();
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_lazy_executable_prepare(lazy_executable));
+  *out_executable = iree_hal_module_lazy_executable_get(lazy_executable);
+  // The placeholder no longer needs tracking for ahead-of-time preparation.
+  iree_hal_module_prune_pending_executables(state);
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // Experimental APIs
 //===----------------------------------------------------------------------===//
@@ -228,6 +934,12 @@ IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_and_wait,  //
   IREE_RETURN_IF_ERROR(
       iree_hal_command_buffer_check_deref(args->r1, &command_buffer));
 
+  // Defer the submission if the invocation is part of a batch. The program
+  // only observes the results from the host via exports that flush first.
+  if (state->batch.active && device == state->shared_device) {
+    return iree_hal_module_batch_defer(state, command_buffer);
+  }
+
   // Batch with our single command buffer.
   iree_hal_submission_batch_t batch;
   memset(&batch, 0, sizeof(batch));
@@ -253,6 +965,8 @@ IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_and_wait,  //
   // Drop all pending deferred releases (references to everything in flight).
   // This will be replaced with resource sets in the future that are attached to
   // each command buffer.
+  // Work deferred by an active batch may still reference them.
+  if (state->batch.active) return iree_ok_status();
   IREE_RETURN_IF_ERROR(iree_vm_list_resize(state->deferred_releases, 0));
   memset(state->deferred_lru, 0, sizeof(state->deferred_lru));
 
@@ -305,6 +1019,28 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
         (offset + length - 1), buffer_length);
   }
 
+  // Buffers with constant usage wrapping module rodata are never updated once
+  // defined and may be shared across contexts.
+  const bool is_constant =
+      iree_all_bits_set(buffer_usage, IREE_HAL_BUFFER_USAGE_CONSTANT) &&
+      iree_hal_module_is_shareable_source(source);
+  iree_hal_module_resource_key_t key;
+  iree_hal_module_resource_key_initialize(
+      IREE_HAL_MODULE_RESOURCE_KIND_CONSTANT_BUFFER, &key);
+  if (is_constant) {
+    const uint8_t* source_data = source->data.data + offset;
+    iree_hal_module_resource_key_append_value(&key, allocator);
+    iree_hal_module_resource_key_append_value(&key, memory_types);
+    iree_hal_module_resource_key_append_value(&key, buffer_usage);
+    iree_hal_module_resource_key_append_value(&key, source_data);
+    iree_hal_module_resource_key_append_value(&key, length);
+    rets->r0 = iree_hal_module_resource_cache_lookup(state, &key);
+    if (rets->r0.ptr) return iree_ok_status();
+  }
+
+  const bool profile_startup = iree_hal_module_startup_profiling_enabled();
+  iree_time_t start_ns = profile_startup ? iree_time_now() : 0;
+
   iree_hal_buffer_t* buffer = NULL;
   IREE_RETURN_IF_ERROR(
       iree_hal_allocator_allocate_buffer(allocator, memory_types, buffer_usage,
@@ -313,8 +1049,15 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
 
   iree_status_t status =
       iree_hal_buffer_write_data(buffer, 0, source->data.data + offset, length);
+  if (profile_startup) {
+    iree_hal_module_record_startup_phase(IREE_VM_STARTUP_PHASE_CONSTANT_UPLOAD,
+                                         start_ns, (uint64_t)length);
+  }
   if (iree_status_is_ok(status)) {
     rets->r0 = iree_hal_buffer_move_ref(buffer);
+    if (is_constant) {
+      rets->r0 = iree_hal_module_resource_cache_insert(state, &key, rets->r0);
+    }
   } else {
     iree_hal_buffer_release(buffer);
   }
@@ -365,6 +1108,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_load,  //
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "load length byte count %d exceeds max", length);
   }
+  IREE_RETURN_IF_ERROR(iree_hal_module_batch_flush_for_host_access(state));
 
   IREE_RETURN_IF_ERROR(iree_hal_buffer_read_data(source_buffer, source_offset,
                                                  &target_buffer, length));
@@ -393,6 +1137,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_store,  //
         ")",
         target_offset, length, iree_hal_buffer_byte_length(target_buffer));
   }
+  IREE_RETURN_IF_ERROR(iree_hal_module_batch_flush_for_host_access(state));
 
   return iree_hal_buffer_write_data(target_buffer, target_offset, &value,
                                     length);
@@ -480,6 +1225,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_trace,  //
   iree_vm_buffer_t* key = NULL;
   IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r0, &key));
   iree_string_view_t key_str = iree_vm_buffer_as_string(key);
+  IREE_RETURN_IF_ERROR(iree_hal_module_batch_flush_for_host_access(state));
 
   fprintf(stderr, "=== %.*s ===\n", (int)key_str.size, key_str.data);
   for (iree_host_size_t i = 0; i < args->a1_count; ++i) {
@@ -488,29 +1234,10 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_trace,  //
         iree_hal_buffer_view_check_deref(args->a1[i].r0, &buffer_view));
 
     // NOTE: this export is for debugging only and a no-op in min-size builds.
-    // We heap-alloc here because at the point this export is used performance
-    // is not a concern.
-
-    // Query total length (excluding NUL terminator).
-    iree_host_size_t result_length = 0;
-    iree_status_t status = iree_hal_buffer_view_format(buffer_view, SIZE_MAX, 0,
-                                                       NULL, &result_length);
-    if (!iree_status_is_out_of_range(status)) {
-      return status;
-    }
-    ++result_length;  // include NUL
-
-    // Allocate scratch heap memory to contain the result and format into it.
-    char* result_str = NULL;
-    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
-        state->host_allocator, result_length, (void**)&result_str));
-    status = iree_hal_buffer_view_format(buffer_view, SIZE_MAX, result_length,
-                                         result_str, &result_length);
-    if (iree_status_is_ok(status)) {
-      fprintf(stderr, "%.*s\n", (int)result_length, result_str);
-    }
-    iree_allocator_free(state->host_allocator, result_str);
-    IREE_RETURN_IF_ERROR(status);
+    // Contents are streamed in chunks so large buffers need no scratch memory.
+    IREE_RETURN_IF_ERROR(
+        iree_hal_buffer_view_fprint(stderr, buffer_view, SIZE_MAX));
+    fprintf(stderr, "\n");
   }
   fprintf(stderr, "\n");
 
@@ -709,6 +1436,8 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch,  //
       iree_hal_command_buffer_check_deref(args->r0, &command_buffer));
   iree_hal_executable_t* executable = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(args->r1, &executable));
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_resolve_executable(state, executable, &executable));
   uint32_t entry_point = (uint32_t)args->i2;
   uint32_t workgroup_x = (uint32_t)args->i3;
   uint32_t workgroup_y = (uint32_t)args->i4;
@@ -729,6 +1458,8 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch_indirect,  //
       iree_hal_command_buffer_check_deref(args->r0, &command_buffer));
   iree_hal_executable_t* executable = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(args->r1, &executable));
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_resolve_executable(state, executable, &executable));
   uint32_t entry_point = (uint32_t)args->i2;
   iree_hal_buffer_t* workgroups_buffer = NULL;
   IREE_RETURN_IF_ERROR(
@@ -809,10 +1540,21 @@ IREE_VM_ABI_EXPORT(iree_hal_module_descriptor_set_layout_create,  //
     bindings[i].access = (iree_hal_memory_access_t)args->a2[i].i2;
   }
 
+  iree_hal_module_resource_key_t key;
+  iree_hal_module_resource_key_initialize(
+      IREE_HAL_MODULE_RESOURCE_KIND_DESCRIPTOR_SET_LAYOUT, &key);
+  iree_hal_module_resource_key_append_value(&key, device);
+  iree_hal_module_resource_key_append_value(&key, usage_type);
+  iree_hal_module_resource_key_append(&key, bindings,
+                                      binding_count * sizeof(bindings[0]));
+  rets->r0 = iree_hal_module_resource_cache_lookup(state, &key);
+  if (rets->r0.ptr) return iree_ok_status();
+
   iree_hal_descriptor_set_layout_t* descriptor_set_layout = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_descriptor_set_layout_create(
       device, usage_type, binding_count, bindings, &descriptor_set_layout));
   rets->r0 = iree_hal_descriptor_set_layout_move_ref(descriptor_set_layout);
+  rets->r0 = iree_hal_module_resource_cache_insert(state, &key, rets->r0);
   return iree_ok_status();
 }
 
@@ -889,6 +1631,29 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
     if (!iree_status_is_ok(status)) break;
   }
 
+  iree_hal_module_resource_key_t key;
+  iree_hal_module_resource_key_initialize(
+      IREE_HAL_MODULE_RESOURCE_KIND_EXECUTABLE, &key);
+  iree_hal_module_resource_key_append_value(&key, device);
+  iree_hal_module_resource_key_append_value(&key, executable_format_str.size);
+  iree_hal_module_resource_key_append(&key, executable_format_str.data,
+                                      executable_format_str.size);
+  iree_hal_module_resource_key_append_value(&key, executable_data->data.data);
+  iree_hal_module_resource_key_append_value(&key,
+                                            executable_data->data.data_length);
+  iree_hal_module_resource_key_append(
+      &key, executable_layouts,
+      executable_layout_count * sizeof(executable_layouts[0]));
+  const bool is_shareable =
+      iree_hal_module_is_shareable_source(executable_data);
+  if (iree_status_is_ok(status) && is_shareable) {
+    rets->r0 = iree_hal_module_resource_cache_lookup(state, &key);
+    if (rets->r0.ptr) {
+      iree_allocator_free(state->host_allocator, executable_layouts);
+      return iree_ok_status();
+    }
+  }
+
   iree_hal_executable_t* executable = NULL;
   if (iree_status_is_ok(status)) {
     iree_hal_executable_spec_t spec;
@@ -897,17 +1662,39 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
         executable_data->access == IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE
             ? IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA
             : 0;
-    spec.executable_format = executable_format_str;
-    spec.executable_data = iree_make_const_byte_span(
-        executable_data->data.data, executable_data->data.data_length);
-    spec.executable_layout_count = executable_layout_count;
-    spec.executable_layouts = executable_layouts;
-    status = iree_hal_executable_cache_prepare_executable(
-        state->executable_cache, &spec, &executable);
+    if (iree_any_bit_set(state->module->flags,
+                         IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES |
+                             IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES)) {
+      status = iree_hal_module_lazy_executable_create(
+          state->executable_cache, executable_format, executable_data,
+          spec.caching_mode, executable_layout_count, executable_layouts,
+          state->host_allocator, &executable);
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_module_append_pending_executable(state, executable);
+      }
+    } else {
+      const bool profile_startup =
+          iree_hal_module_startup_profiling_enabled();
+      iree_time_t start_ns = profile_startup ? iree_time_now() : 0;
+      spec.executable_format = executable_format_str;
+      spec.executable_data = iree_make_const_byte_span(
+          executable_data->data.data, executable_data->data.data_length);
+      spec.executable_layout_count = executable_layout_count;
+      spec.executable_layouts = executable_layouts;
+      status = iree_hal_executable_cache_prepare_executable(
+          state->executable_cache, &spec, &executable);
+      if (profile_startup) {
+        iree_hal_module_record_startup_phase(
+            IREE_VM_STARTUP_PHASE_EXECUTABLE_PREPARE, start_ns, 0);
+      }
+    }
   }
 
   iree_allocator_free(state->host_allocator, executable_layouts);
   rets->r0 = iree_hal_executable_move_ref(executable);
+  if (iree_status_is_ok(status) && is_shareable) {
+    rets->r0 = iree_hal_module_resource_cache_insert(state, &key, rets->r0);
+  }
   return status;
 }
 
@@ -927,11 +1714,22 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_layout_create,  //
                               iree_hal_descriptor_set_layout, 32,
                               &set_layout_count, &set_layouts);
 
+  iree_hal_module_resource_key_t key;
+  iree_hal_module_resource_key_initialize(
+      IREE_HAL_MODULE_RESOURCE_KIND_EXECUTABLE_LAYOUT, &key);
+  iree_hal_module_resource_key_append_value(&key, device);
+  iree_hal_module_resource_key_append_value(&key, push_constants);
+  iree_hal_module_resource_key_append(
+      &key, set_layouts, set_layout_count * sizeof(set_layouts[0]));
+  rets->r0 = iree_hal_module_resource_cache_lookup(state, &key);
+  if (rets->r0.ptr) return iree_ok_status();
+
   iree_hal_executable_layout_t* executable_layout = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_executable_layout_create(
       device, push_constants, set_layout_count, set_layouts,
       &executable_layout));
   rets->r0 = iree_hal_executable_layout_move_ref(executable_layout);
+  rets->r0 = iree_hal_module_resource_cache_insert(state, &key, rets->r0);
   return iree_ok_status();
 }
 
@@ -1057,10 +1855,24 @@ static const iree_vm_native_module_descriptor_t iree_hal_module_descriptor_ = {
 IREE_API_EXPORT iree_status_t
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module) {
+  return iree_hal_module_create_with_flags(device, IREE_HAL_MODULE_FLAG_NONE,
+                                           allocator, out_module);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_module_create_with_flags(
+    iree_hal_device_t* device, iree_hal_module_flags_t flags,
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
   IREE_ASSERT_ARGUMENT(device);
   IREE_ASSERT_ARGUMENT(out_module);
   *out_module = NULL;
 
+  if (iree_all_bits_set(flags, IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES |
+                                   IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "lazy and batched executable preparation are "
+                            "mutually exclusive");
+  }
+
   // Setup the interface with the functions we implement ourselves. Any function
   // we omit will be handled by the base native module.
   static const iree_vm_module_t interface = {
@@ -1087,6 +1899,8 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
   module->host_allocator = allocator;
   module->shared_device = device;
   iree_hal_device_retain(module->shared_device);
+  module->flags = flags;
+  iree_slim_mutex_initialize(&module->resource_cache.mutex);
 
   *out_module = base_module;
   return iree_ok_status();
@@ -1098,6 +1912,68 @@ IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
   return state->shared_device;
 }
 
+IREE_API_EXPORT iree_status_t iree_hal_module_state_prepare_executables(
+    iree_vm_module_state_t* module_state) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  return iree_hal_module_prepare_pending_executables(state);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_module_state_begin_batch(iree_vm_module_state_t* module_state) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  if (state->batch.active) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "a batch is already active");
+  }
+  state->batch.active = true;
+  iree_status_t status = iree_hal_module_state_set_batch_slot(module_state, 0);
+  if (!iree_status_is_ok(status)) state->batch.active = false;
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_module_state_set_batch_slot(
+    iree_vm_module_state_t* module_state, iree_host_size_t slot) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  if (!state->batch.active) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "no batch is active");
+  }
+  IREE_RETURN_IF_ERROR(iree_hal_module_batch_reserve_slots(state, slot + 1));
+  state->batch.current_slot = slot;
+  state->batch.slot_count = iree_max(state->batch.slot_count, slot + 1);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_module_state_end_batch(
+    iree_vm_module_state_t* module_state, iree_host_size_t slot_count,
+    iree_status_t* out_slot_statuses) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  IREE_ASSERT_ARGUMENT(!slot_count || out_slot_statuses);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  if (!state->batch.active) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "no batch is active");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_hal_module_batch_flush(state);
+  for (iree_host_size_t slot = 0; slot < slot_count; ++slot) {
+    if (slot < state->batch.slot_count) {
+      out_slot_statuses[slot] = state->batch.slot_statuses[slot];
+      state->batch.slot_statuses[slot] = iree_ok_status();
+    } else {
+      out_slot_statuses[slot] = iree_ok_status();
+    }
+  }
+  iree_hal_module_batch_reset(state);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===--------------------------------------------------------------------===//
 // Utilities
 //===--------------------------------------------------------------------===//
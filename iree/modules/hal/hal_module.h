@@ -47,6 +47,40 @@ extern "C" {
 // WARNING: not thread-safe; call at startup before using.
 IREE_API_EXPORT iree_status_t iree_hal_module_register_types(void);
 
+enum iree_hal_module_flag_e {
+  IREE_HAL_MODULE_FLAG_NONE = 0u,
+
+  // Shares immutable resources created by programs across all contexts the
+  // module is registered with: executables, executable layouts, descriptor
+  // set layouts, and constant buffers (those wrapped with
+  // IREE_HAL_BUFFER_USAGE_CONSTANT). The first context to create a resource
+  // populates the module-level cache and later contexts creating one with the
+  // same arguments receive the same object. Per-context state such as
+  // semaphores and in-flight submissions is unaffected.
+  //
+  // Resources are identified in part by the address of their source data in
+  // program module rodata. All contexts using the module must register the
+  // same program modules and those modules must remain loaded for the
+  // lifetime of this module.
+  IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES = 1u << 0,
+
+  // Defers preparing executables until they are first dispatched instead of
+  // when programs create them in their initializers. This reduces context
+  // creation time when programs contain many executables and avoids preparing
+  // those that are never used at the cost of a one-time delay on the first
+  // dispatch of each. Preparation failures are reported by the dispatch.
+  IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES = 1u << 1,
+
+  // Defers preparing executables as with IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES
+  // but prepares all executables created so far together when any of them is
+  // first dispatched. Devices that support it (such as those backed by a task
+  // executor) prepare the batch concurrently, which reduces the time to first
+  // result for programs with many executables. Cannot be combined with
+  // IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES.
+  IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES = 1u << 2,
+};
+typedef uint32_t iree_hal_module_flags_t;
+
 // Creates the HAL module initialized to use a specific |device|.
 // Each context using this module will share the device and have compatible
 // allocations.
@@ -54,11 +88,52 @@ IREE_API_EXPORT iree_status_t
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module);
 
+// Creates the HAL module as with iree_hal_module_create with the behavior
+// customized by |flags|.
+IREE_API_EXPORT iree_status_t iree_hal_module_create_with_flags(
+    iree_hal_device_t* device, iree_hal_module_flags_t flags,
+    iree_allocator_t allocator, iree_vm_module_t** out_module);
+
 // Returns the device currently in use by the HAL module.
 // Returns NULL if no device has been initialized yet.
 IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
     iree_vm_module_state_t* module_state);
 
+// Prepares all executables created by programs using |module_state| whose
+// preparation was deferred with IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES or
+// IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES. They are prepared together as with
+// the batch mode so that applications can move the cost out of their first
+// invocation. Has no effect if nothing is pending.
+IREE_API_EXPORT iree_status_t iree_hal_module_state_prepare_executables(
+    iree_vm_module_state_t* module_state);
+
+// Begins deferring device submissions made by programs using |module_state|.
+// While a batch is active command buffers submitted by programs are queued
+// instead of executed and the program continues without waiting. All deferred
+// work is issued with a single queue submission when the batch ends, which
+// amortizes submission and scheduling overhead across many small invocations.
+//
+// Submissions are attributed to the slot selected with
+// iree_hal_module_state_set_batch_slot (initially slot 0). Each independent
+// invocation in a batch must use its own slot: work within a slot executes in
+// submission order while work in different slots may execute concurrently.
+// Deferred work is flushed early if a program reads or writes buffer contents
+// from the host so that programs observe the same results as when unbatched.
+IREE_API_EXPORT iree_status_t
+iree_hal_module_state_begin_batch(iree_vm_module_state_t* module_state);
+
+// Selects the batch slot that subsequent submissions are attributed to.
+IREE_API_EXPORT iree_status_t iree_hal_module_state_set_batch_slot(
+    iree_vm_module_state_t* module_state, iree_host_size_t slot);
+
+// Ends the active batch by submitting all deferred work and waiting for it to
+// complete. |out_slot_statuses| receives the status of the work in each of
+// the first |slot_count| slots and the caller must consume or ignore each.
+// Returns an error only if the work could not be submitted.
+IREE_API_EXPORT iree_status_t iree_hal_module_state_end_batch(
+    iree_vm_module_state_t* module_state, iree_host_size_t slot_count,
+    iree_status_t* out_slot_statuses);
+
 // TODO(benvanik): generate these list helpers:
 
 IREE_API_EXPORT iree_hal_buffer_view_t* iree_vm_list_get_buffer_view_assign(
@@ -0,0 +1,671 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests the HAL module exports that create executables and constant buffers
+// when called from multiple contexts, as programs do from their initializers,
+// along with deferred executable preparation and batched submissions.
+
+#include "iree/modules/hal/hal_module.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/local_executable.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/shims.h"
+
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+//===----------------------------------------------------------------------===//
+// Test executables and loader
+//===----------------------------------------------------------------------===//
+
+// Executable with entry points that do nothing.
+struct TestExecutable {
+  iree_hal_local_executable_t base;
+  iree_hal_local_executable_layout_t* layouts[1];
+  std::atomic<int>* live_count;
+};
+
+static void TestExecutableDestroy(iree_hal_executable_t* base_executable) {
+  auto* executable = reinterpret_cast<TestExecutable*>(base_executable);
+  --*executable->live_count;
+  iree_hal_local_executable_deinitialize(&executable->base);
+  delete executable;
+}
+
+static iree_status_t TestExecutableIssueCall(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id) {
+  return iree_ok_status();
+}
+
+static const iree_hal_local_executable_vtable_t test_executable_vtable = {
+    /*.base=*/
+    {
+        /*.destroy=*/TestExecutableDestroy,
+    },
+    /*.issue_call=*/TestExecutableIssueCall,
+};
+
+// Loader accepting the "TEST" format that counts the executables it loads and
+// how many of those are still alive. Executables whose data starts with "fail"
+// fail to load.
+struct TestLoader {
+  iree_hal_executable_loader_t base;
+  std::atomic<int> load_count{0};
+  std::atomic<int> live_count{0};
+};
+
+static void TestLoaderDestroy(iree_hal_executable_loader_t* base_loader) {
+  delete reinterpret_cast<TestLoader*>(base_loader);
+}
+
+static bool TestLoaderQuerySupport(
+    iree_hal_executable_loader_t* base_loader,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_string_view_t executable_format) {
+  return iree_string_view_equal(executable_format,
+                                iree_make_cstring_view("TEST"));
+}
+
+static iree_status_t TestLoaderTryLoad(
+    iree_hal_executable_loader_t* base_loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  auto* loader = reinterpret_cast<TestLoader*>(base_loader);
+  iree_const_byte_span_t data = executable_spec->executable_data;
+  if (data.data_length >= 4 && memcmp(data.data, "fail", 4) == 0) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS, "failing executable");
+  }
+  if (executable_spec->executable_layout_count > 1) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "expected at most one executable layout");
+  }
+  auto* executable = new TestExecutable();
+  iree_hal_local_executable_initialize(
+      &test_executable_vtable, executable_spec->executable_layout_count,
+      executable_spec->executable_layouts, executable->layouts,
+      iree_allocator_system(), &executable->base);
+  executable->live_count = &loader->live_count;
+  ++loader->load_count;
+  ++loader->live_count;
+  *out_executable = reinterpret_cast<iree_hal_executable_t*>(executable);
+  return iree_ok_status();
+}
+
+static const iree_hal_executable_loader_vtable_t test_loader_vtable = {
+    /*.destroy=*/TestLoaderDestroy,
+    /*.query_support=*/TestLoaderQuerySupport,
+    /*.try_load=*/TestLoaderTryLoad,
+};
+
+//===----------------------------------------------------------------------===//
+// Tests
+//===----------------------------------------------------------------------===//
+
+// Program data, standing in for the rodata of a program module.
+static const uint8_t kExecutableData[16] = {0x12, 0x34, 0x56, 0x78};
+static const uint8_t kFailingExecutableData[16] = {'f', 'a', 'i', 'l'};
+static const uint8_t kConstantData[64] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+class HalModuleTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_CHECK_OK(iree_vm_register_builtin_types());
+    IREE_CHECK_OK(iree_hal_module_register_types());
+  }
+
+  void SetUp() override {
+    loader_ = new TestLoader();
+    iree_hal_executable_loader_initialize(&test_loader_vtable, &loader_->base);
+    iree_hal_executable_loader_t* loaders[] = {&loader_->base};
+    IREE_ASSERT_OK(CreateDevice(IREE_ARRAYSIZE(loaders), loaders, &device_));
+    IREE_ASSERT_OK(iree_hal_executable_layout_create(
+        device_, /*push_constants=*/0, /*set_layout_count=*/0,
+        /*set_layouts=*/NULL, &executable_layout_));
+    InitializeBuffer(IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE, kExecutableData,
+                     sizeof(kExecutableData), &module_executable_data_);
+    InitializeBuffer(IREE_VM_BUFFER_ACCESS_ORIGIN_HOST, kExecutableData,
+                     sizeof(kExecutableData), &host_executable_data_);
+    InitializeBuffer(IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE,
+                     kFailingExecutableData, sizeof(kFailingExecutableData),
+                     &failing_executable_data_);
+    InitializeBuffer(IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE, kConstantData,
+                     sizeof(kConstantData), &module_constant_data_);
+    InitializeBuffer(IREE_VM_BUFFER_ACCESS_ORIGIN_HOST, kConstantData,
+                     sizeof(kConstantData), &host_constant_data_);
+  }
+
+  void TearDown() override {
+    for (iree_vm_context_t* context : contexts_) {
+      iree_vm_context_release(context);
+    }
+    iree_vm_module_release(hal_module_);
+    iree_vm_buffer_deinitialize(&module_executable_data_);
+    iree_vm_buffer_deinitialize(&host_executable_data_);
+    iree_vm_buffer_deinitialize(&failing_executable_data_);
+    iree_vm_buffer_deinitialize(&module_constant_data_);
+    iree_vm_buffer_deinitialize(&host_constant_data_);
+    iree_hal_executable_layout_release(executable_layout_);
+    iree_hal_device_release(device_);
+    iree_hal_executable_loader_release(&loader_->base);
+  }
+
+  virtual iree_status_t CreateDevice(iree_host_size_t loader_count,
+                                     iree_hal_executable_loader_t** loaders,
+                                     iree_hal_device_t** out_device) {
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    return iree_hal_sync_device_create(iree_make_cstring_view("sync"), &params,
+                                       loader_count, loaders,
+                                       iree_allocator_system(), out_device);
+  }
+
+  static void InitializeBuffer(iree_vm_buffer_access_t access,
+                               const uint8_t* data, iree_host_size_t length,
+                               iree_vm_buffer_t* out_buffer) {
+    iree_vm_buffer_initialize(
+        access, iree_make_byte_span(const_cast<uint8_t*>(data), length),
+        iree_allocator_null(), out_buffer);
+  }
+
+  // Creates a HAL module with |flags| and |context_count| contexts using it.
+  void CreateContexts(iree_hal_module_flags_t flags,
+                      iree_host_size_t context_count) {
+    IREE_ASSERT_OK(iree_hal_module_create_with_flags(
+        device_, flags, iree_allocator_system(), &hal_module_));
+    for (iree_host_size_t i = 0; i < context_count; ++i) {
+      iree_vm_context_t* context = NULL;
+      IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+          /*instance=*/NULL, &hal_module_, 1, iree_allocator_system(),
+          &context));
+      contexts_.push_back(context);
+    }
+  }
+
+  // Calls the HAL module export |name| in |context| with the ABI |arguments|
+  // and stores the ABI results in |results|.
+  iree_status_t Call(iree_vm_context_t* context, const char* name,
+                     iree_byte_span_t arguments, iree_byte_span_t results) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_module_lookup_function_by_name(
+        hal_module_, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_cstring_view(name), &function));
+    iree_vm_function_call_t call;
+    memset(&call, 0, sizeof(call));
+    call.function = function;
+    call.arguments = arguments;
+    call.results = results;
+    IREE_VM_INLINE_STACK_INITIALIZE(stack,
+                                    iree_vm_context_state_resolver(context),
+                                    iree_allocator_system());
+    iree_vm_execution_result_t execution_result;
+    iree_status_t status = function.module->begin_call(
+        function.module->self, stack, &call, &execution_result);
+    iree_vm_stack_deinitialize(stack);
+    return status;
+  }
+
+  // Calls the HAL module export |name| in |context| with the ABI |arguments|
+  // and returns its single ref result in |out_result|.
+  iree_status_t Call(iree_vm_context_t* context, const char* name,
+                     iree_byte_span_t arguments, iree_vm_ref_t* out_result) {
+    iree_vm_abi_r_t results;
+    memset(&results, 0, sizeof(results));
+    iree_status_t status = Call(context, name, arguments,
+                                iree_make_byte_span(&results, sizeof(results)));
+    iree_vm_ref_move(&results.r0, out_result);
+    return status;
+  }
+
+  // Calls hal.executable.create in |context| with |data| as the executable
+  // data. The returned executable is retained by |references_|.
+  iree_hal_executable_t* CreateExecutable(iree_vm_context_t* context,
+                                          iree_vm_buffer_t* data) {
+    iree_vm_buffer_t* format = NULL;
+    IREE_CHECK_OK(iree_vm_buffer_create(
+        IREE_VM_BUFFER_ACCESS_ORIGIN_HOST, 4, iree_allocator_system(),
+        &format));
+    memcpy(format->data.data, "TEST", 4);
+    struct {
+      iree_vm_abi_rrrCrD_t base;
+      iree_vm_abi_r_t a3[1];
+    } arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.base.r0 = iree_hal_device_retain_ref(device_);
+    arguments.base.r1 = iree_vm_buffer_move_ref(format);
+    arguments.base.r2 = iree_vm_buffer_retain_ref(data);
+    arguments.base.a3_count = IREE_ARRAYSIZE(arguments.a3);
+    arguments.a3[0].r0 = iree_hal_executable_layout_retain_ref(
+        executable_layout_);
+    iree_vm_ref_t result = {0};
+    IREE_EXPECT_OK(Call(context, "executable.create",
+                        iree_make_byte_span(&arguments, sizeof(arguments)),
+                        &result));
+    iree_vm_ref_release(&arguments.base.r0);
+    iree_vm_ref_release(&arguments.base.r1);
+    iree_vm_ref_release(&arguments.base.r2);
+    iree_vm_ref_release(&arguments.a3[0].r0);
+    references_.push_back(result);
+    return iree_hal_executable_deref(result);
+  }
+
+  // Calls hal.allocator.wrap.byte_buffer in |context| with all of |source|.
+  // The returned buffer is retained by |references_|.
+  iree_hal_buffer_t* WrapByteBuffer(iree_vm_context_t* context,
+                                    iree_hal_buffer_usage_t buffer_usage,
+                                    iree_vm_buffer_t* source) {
+    iree_vm_abi_riirii_t arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.r0 =
+        iree_hal_allocator_retain_ref(iree_hal_device_allocator(device_));
+    arguments.i1 =
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    arguments.i2 = buffer_usage;
+    arguments.r3 = iree_vm_buffer_retain_ref(source);
+    arguments.i4 = 0;
+    arguments.i5 = -1;
+    iree_vm_ref_t result = {0};
+    IREE_EXPECT_OK(Call(context, "allocator.wrap.byte_buffer",
+                        iree_make_byte_span(&arguments, sizeof(arguments)),
+                        &result));
+    iree_vm_ref_release(&arguments.r0);
+    iree_vm_ref_release(&arguments.r3);
+    references_.push_back(result);
+    return iree_hal_buffer_deref(result);
+  }
+
+  // Calls hal.command_buffer.dispatch in |context| to record a dispatch of
+  // |executable| into a new command buffer.
+  iree_status_t Dispatch(iree_vm_context_t* context,
+                         iree_hal_executable_t* executable) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_command_buffer_create(
+        device_,
+        IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+            IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+        IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+    iree_vm_abi_rriiii_t arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.r0 = iree_hal_command_buffer_move_ref(command_buffer);
+    arguments.r1 = iree_hal_executable_retain_ref(executable);
+    arguments.i2 = 0;
+    arguments.i3 = 1;
+    arguments.i4 = 1;
+    arguments.i5 = 1;
+    iree_vm_abi_v_t results;
+    iree_status_t status =
+        Call(context, "command_buffer.dispatch",
+             iree_make_byte_span(&arguments, sizeof(arguments)),
+             iree_make_byte_span(&results, sizeof(results)));
+    iree_vm_ref_release(&arguments.r0);
+    iree_vm_ref_release(&arguments.r1);
+    return status;
+  }
+
+  // Releases all resources returned to the test, as when the programs using
+  // them are unloaded.
+  void ReleaseReferences() {
+    for (iree_vm_ref_t& reference : references_) {
+      iree_vm_ref_release(&reference);
+    }
+    references_.clear();
+  }
+
+  TestLoader* loader_ = nullptr;
+  iree_hal_device_t* device_ = nullptr;
+  iree_hal_executable_layout_t* executable_layout_ = nullptr;
+  iree_vm_module_t* hal_module_ = nullptr;
+  std::vector<iree_vm_context_t*> contexts_;
+  std::vector<iree_vm_ref_t> references_;
+  iree_vm_buffer_t module_executable_data_;
+  iree_vm_buffer_t host_executable_data_;
+  iree_vm_buffer_t failing_executable_data_;
+  iree_vm_buffer_t module_constant_data_;
+  iree_vm_buffer_t host_constant_data_;
+};
+
+TEST_F(HalModuleTest, SharesModuleExecutablesAcrossContexts) {
+  CreateContexts(IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES, 2);
+  iree_hal_executable_t* executable0 =
+      CreateExecutable(contexts_[0], &module_executable_data_);
+  iree_hal_executable_t* executable1 =
+      CreateExecutable(contexts_[1], &module_executable_data_);
+  ASSERT_NE(nullptr, executable0);
+  EXPECT_EQ(executable0, executable1);
+  EXPECT_EQ(1, loader_->load_count);
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleTest, DoesNotShareHostExecutables) {
+  // Data created at runtime may be freed and its address reused so it must
+  // never be shared.
+  CreateContexts(IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES, 2);
+  iree_hal_executable_t* executable0 =
+      CreateExecutable(contexts_[0], &host_executable_data_);
+  iree_hal_executable_t* executable1 =
+      CreateExecutable(contexts_[1], &host_executable_data_);
+  ASSERT_NE(nullptr, executable0);
+  ASSERT_NE(nullptr, executable1);
+  EXPECT_NE(executable0, executable1);
+  EXPECT_EQ(2, loader_->load_count);
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleTest, DoesNotShareByDefault) {
+  CreateContexts(IREE_HAL_MODULE_FLAG_NONE, 2);
+  iree_hal_executable_t* executable0 =
+      CreateExecutable(contexts_[0], &module_executable_data_);
+  iree_hal_executable_t* executable1 =
+      CreateExecutable(contexts_[1], &module_executable_data_);
+  ASSERT_NE(nullptr, executable0);
+  ASSERT_NE(nullptr, executable1);
+  EXPECT_NE(executable0, executable1);
+  EXPECT_EQ(2, loader_->load_count);
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleTest, SharesModuleConstantsAcrossContexts) {
+  CreateContexts(IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES, 2);
+  const iree_hal_buffer_usage_t constant_usage =
+      IREE_HAL_BUFFER_USAGE_CONSTANT | IREE_HAL_BUFFER_USAGE_TRANSFER |
+      IREE_HAL_BUFFER_USAGE_DISPATCH;
+  iree_hal_buffer_t* buffer0 =
+      WrapByteBuffer(contexts_[0], constant_usage, &module_constant_data_);
+  iree_hal_buffer_t* buffer1 =
+      WrapByteBuffer(contexts_[1], constant_usage, &module_constant_data_);
+  ASSERT_NE(nullptr, buffer0);
+  EXPECT_EQ(buffer0, buffer1);
+  std::vector<uint8_t> contents(sizeof(kConstantData));
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(buffer1, 0, contents.data(),
+                                           contents.size()));
+  EXPECT_EQ(0, memcmp(contents.data(), kConstantData, contents.size()));
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleTest, DoesNotShareMutableOrHostBuffers) {
+  CreateContexts(IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES, 2);
+  // Buffers without constant usage may be written by the program.
+  const iree_hal_buffer_usage_t mutable_usage =
+      IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_DISPATCH;
+  EXPECT_NE(
+      WrapByteBuffer(contexts_[0], mutable_usage, &module_constant_data_),
+      WrapByteBuffer(contexts_[1], mutable_usage, &module_constant_data_));
+  // Constants wrapping data created at runtime may be freed and reused.
+  const iree_hal_buffer_usage_t constant_usage =
+      IREE_HAL_BUFFER_USAGE_CONSTANT | mutable_usage;
+  EXPECT_NE(WrapByteBuffer(contexts_[0], constant_usage, &host_constant_data_),
+            WrapByteBuffer(contexts_[1], constant_usage, &host_constant_data_));
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleTest, LazyExecutablesArePreparedOnFirstDispatch) {
+  CreateContexts(IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES, 1);
+  iree_hal_executable_t* executable =
+      CreateExecutable(contexts_[0], &module_executable_data_);
+  ASSERT_NE(nullptr, executable);
+  EXPECT_EQ(0, loader_->load_count);
+  IREE_EXPECT_OK(Dispatch(contexts_[0], executable));
+  EXPECT_EQ(1, loader_->load_count);
+  IREE_EXPECT_OK(Dispatch(contexts_[0], executable));
+  EXPECT_EQ(1, loader_->load_count);
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleTest, LazyExecutablePreparationFailsAtDispatch) {
+  // Creation only captures the arguments so the failure to prepare surfaces
+  // when the program first dispatches the executable.
+  CreateContexts(IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES, 1);
+  iree_hal_executable_t* executable =
+      CreateExecutable(contexts_[0], &failing_executable_data_);
+  ASSERT_NE(nullptr, executable);
+  EXPECT_THAT(iree::Status(Dispatch(contexts_[0], executable)),
+              StatusIs(iree::StatusCode::kDataLoss));
+  EXPECT_THAT(iree::Status(Dispatch(contexts_[0], executable)),
+              StatusIs(iree::StatusCode::kDataLoss));
+  EXPECT_EQ(0, loader_->load_count);
+  ReleaseReferences();
+}
+
+//===----------------------------------------------------------------------===//
+// Batches
+//===----------------------------------------------------------------------===//
+
+// Uses the task device as its submissions only execute when issued to the
+// device queue, unlike those of the sync device that execute while recorded.
+class HalModuleBatchTest : public HalModuleTest {
+ protected:
+  void TearDown() override {
+    HalModuleTest::TearDown();
+    iree_task_executor_release(executor_);
+  }
+
+  iree_status_t CreateDevice(iree_host_size_t loader_count,
+                             iree_hal_executable_loader_t** loaders,
+                             iree_hal_device_t** out_device) override {
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(1, &topology);
+    iree_status_t status = iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology, iree_allocator_system(),
+        &executor_);
+    iree_task_topology_deinitialize(&topology);
+    IREE_RETURN_IF_ERROR(status);
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    return iree_hal_task_device_create(
+        iree_make_cstring_view("task"), &params, executor_, loader_count,
+        loaders, iree_allocator_system(), out_device);
+  }
+
+  void CreateBatchContext() {
+    CreateContexts(IREE_HAL_MODULE_FLAG_NONE, 1);
+    IREE_ASSERT_OK(iree_vm_context_resolve_module_state(
+        contexts_[0], hal_module_, &hal_module_state_));
+  }
+
+  // Allocates a zeroed buffer of |length| bytes.
+  iree_hal_buffer_t* AllocateBuffer(iree_host_size_t length) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device_),
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, length, &buffer));
+    IREE_CHECK_OK(iree_hal_buffer_zero(buffer, 0, IREE_WHOLE_BUFFER));
+    return buffer;
+  }
+
+  // Fills |buffer| with |pattern| on the device by submitting a command buffer
+  // with hal.ex.submit_and_wait as programs do.
+  iree_status_t SubmitFill(iree_hal_buffer_t* buffer, uint32_t pattern) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_command_buffer_create(
+        device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+        IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_fill_buffer(
+        command_buffer, buffer, 0, iree_hal_buffer_byte_length(buffer),
+        &pattern, sizeof(pattern)));
+    IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer));
+    iree_vm_abi_rr_t arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.r0 = iree_hal_device_retain_ref(device_);
+    arguments.r1 = iree_hal_command_buffer_move_ref(command_buffer);
+    iree_vm_abi_v_t results;
+    iree_status_t status =
+        Call(contexts_[0], "ex.submit_and_wait",
+             iree_make_byte_span(&arguments, sizeof(arguments)),
+             iree_make_byte_span(&results, sizeof(results)));
+    iree_vm_ref_release(&arguments.r0);
+    iree_vm_ref_release(&arguments.r1);
+    return status;
+  }
+
+  // Returns the first 4 bytes of |buffer| as read by the program with
+  // hal.buffer.load.
+  uint32_t Load(iree_hal_buffer_t* buffer) {
+    iree_vm_abi_rii_t arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.r0 = iree_hal_buffer_retain_ref(buffer);
+    arguments.i1 = 0;
+    arguments.i2 = sizeof(uint32_t);
+    iree_vm_abi_i_t results;
+    memset(&results, 0, sizeof(results));
+    IREE_EXPECT_OK(Call(contexts_[0], "buffer.load",
+                        iree_make_byte_span(&arguments, sizeof(arguments)),
+                        iree_make_byte_span(&results, sizeof(results))));
+    iree_vm_ref_release(&arguments.r0);
+    return (uint32_t)results.i0;
+  }
+
+  // Returns the first 4 bytes of |buffer| as read directly by the host.
+  static uint32_t Read(iree_hal_buffer_t* buffer) {
+    uint32_t value = 0;
+    IREE_CHECK_OK(iree_hal_buffer_read_data(buffer, 0, &value, sizeof(value)));
+    return value;
+  }
+
+  iree_task_executor_t* executor_ = nullptr;
+  iree_vm_module_state_t* hal_module_state_ = nullptr;
+};
+
+TEST_F(HalModuleBatchTest, BatchedSubmissionsMatchSequential) {
+  CreateBatchContext();
+  // More slots than are initially reserved by the batch.
+  const iree_host_size_t kSlotCount = 20;
+  std::vector<iree_hal_buffer_t*> sequential_buffers(kSlotCount);
+  std::vector<iree_hal_buffer_t*> batched_buffers(kSlotCount);
+  for (iree_host_size_t i = 0; i < kSlotCount; ++i) {
+    sequential_buffers[i] = AllocateBuffer(64);
+    batched_buffers[i] = AllocateBuffer(64);
+    IREE_ASSERT_OK(SubmitFill(sequential_buffers[i], 0x1000u + i));
+  }
+
+  IREE_ASSERT_OK(iree_hal_module_state_begin_batch(hal_module_state_));
+  for (iree_host_size_t i = 0; i < kSlotCount; ++i) {
+    IREE_ASSERT_OK(iree_hal_module_state_set_batch_slot(hal_module_state_, i));
+    IREE_ASSERT_OK(SubmitFill(batched_buffers[i], 0x1000u + i));
+  }
+  // Nothing is issued to the device until the batch ends.
+  for (iree_host_size_t i = 0; i < kSlotCount; ++i) {
+    EXPECT_EQ(0u, Read(batched_buffers[i]));
+  }
+  std::vector<iree_status_t> slot_statuses(kSlotCount);
+  IREE_ASSERT_OK(iree_hal_module_state_end_batch(
+      hal_module_state_, kSlotCount, slot_statuses.data()));
+
+  for (iree_host_size_t i = 0; i < kSlotCount; ++i) {
+    IREE_EXPECT_OK(slot_statuses[i]);
+    EXPECT_EQ(Read(sequential_buffers[i]), Read(batched_buffers[i]));
+    iree_hal_buffer_release(sequential_buffers[i]);
+    iree_hal_buffer_release(batched_buffers[i]);
+  }
+}
+
+TEST_F(HalModuleBatchTest, BufferLoadFlushesBatch) {
+  CreateBatchContext();
+  iree_hal_buffer_t* buffer0 = AllocateBuffer(64);
+  iree_hal_buffer_t* buffer1 = AllocateBuffer(64);
+  IREE_ASSERT_OK(iree_hal_module_state_begin_batch(hal_module_state_));
+  IREE_ASSERT_OK(iree_hal_module_state_set_batch_slot(hal_module_state_, 0));
+  IREE_ASSERT_OK(SubmitFill(buffer0, 0xCAFEu));
+  IREE_ASSERT_OK(iree_hal_module_state_set_batch_slot(hal_module_state_, 1));
+  IREE_ASSERT_OK(SubmitFill(buffer1, 0xF00Du));
+  EXPECT_EQ(0u, Read(buffer1));
+  // The program reading back results must observe the work deferred by all
+  // slots so far.
+  EXPECT_EQ(0xF00Du, Load(buffer1));
+  EXPECT_EQ(0xCAFEu, Read(buffer0));
+  // Work deferred after the flush is still batched.
+  IREE_ASSERT_OK(SubmitFill(buffer1, 0xBEEFu));
+  EXPECT_EQ(0xF00Du, Read(buffer1));
+  iree_status_t slot_statuses[2];
+  IREE_ASSERT_OK(iree_hal_module_state_end_batch(
+      hal_module_state_, IREE_ARRAYSIZE(slot_statuses), slot_statuses));
+  IREE_EXPECT_OK(slot_statuses[0]);
+  IREE_EXPECT_OK(slot_statuses[1]);
+  EXPECT_EQ(0xBEEFu, Read(buffer1));
+  iree_hal_buffer_release(buffer0);
+  iree_hal_buffer_release(buffer1);
+}
+
+TEST_F(HalModuleBatchTest, BatchExecutablesArePreparedOnFirstDispatch) {
+  CreateContexts(IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES, 1);
+  iree_hal_executable_t* executables[3];
+  for (iree_hal_executable_t*& executable : executables) {
+    executable = CreateExecutable(contexts_[0], &module_executable_data_);
+    ASSERT_NE(nullptr, executable);
+  }
+  EXPECT_EQ(0, loader_->load_count);
+  // The first dispatch of any of them prepares all of them on the executor.
+  IREE_EXPECT_OK(Dispatch(contexts_[0], executables[1]));
+  EXPECT_EQ(3, loader_->load_count);
+  for (iree_hal_executable_t* executable : executables) {
+    IREE_EXPECT_OK(Dispatch(contexts_[0], executable));
+  }
+  EXPECT_EQ(3, loader_->load_count);
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleBatchTest, BatchExecutableFailuresSurfaceAtTheirDispatch) {
+  // A batch containing an executable that fails to prepare does not fail the
+  // dispatch of the others.
+  CreateContexts(IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES, 1);
+  iree_hal_executable_t* executable0 =
+      CreateExecutable(contexts_[0], &module_executable_data_);
+  iree_hal_executable_t* failing_executable =
+      CreateExecutable(contexts_[0], &failing_executable_data_);
+  iree_hal_executable_t* executable1 =
+      CreateExecutable(contexts_[0], &module_executable_data_);
+  IREE_EXPECT_OK(Dispatch(contexts_[0], executable0));
+  EXPECT_THAT(iree::Status(Dispatch(contexts_[0], failing_executable)),
+              StatusIs(iree::StatusCode::kDataLoss));
+  IREE_EXPECT_OK(Dispatch(contexts_[0], executable1));
+  ReleaseReferences();
+}
+
+TEST_F(HalModuleBatchTest, LazyExecutablesAreNotRetainedOnceDispatched) {
+  CreateContexts(IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES, 1);
+  iree_hal_executable_t* executable =
+      CreateExecutable(contexts_[0], &module_executable_data_);
+  ASSERT_NE(nullptr, executable);
+  IREE_EXPECT_OK(Dispatch(contexts_[0], executable));
+  EXPECT_EQ(1, loader_->live_count);
+  // Submitting drops the references held for work in flight, after which the
+  // executable is freed when the program releases it even though the context
+  // is still alive.
+  iree_hal_buffer_t* buffer = AllocateBuffer(64);
+  IREE_EXPECT_OK(SubmitFill(buffer, 0));
+  iree_hal_buffer_release(buffer);
+  ReleaseReferences();
+  EXPECT_EQ(0, loader_->live_count);
+}
+
+}  // namespace
@@ -101,6 +101,44 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
                                    call->outputs);
 }
 
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_batch(
+    iree_host_size_t call_count, iree_runtime_call_t* calls,
+    iree_runtime_call_flags_t flags, iree_status_t* out_call_statuses) {
+  if (!call_count) return iree_ok_status();
+  IREE_ASSERT_ARGUMENT(calls);
+  IREE_ASSERT_ARGUMENT(out_call_statuses);
+  iree_runtime_session_t* session = calls[0].session;
+  for (iree_host_size_t i = 1; i < call_count; ++i) {
+    if (calls[i].session != session) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "all batched calls must use the same session");
+    }
+  }
+
+  // Split the calls into the parallel arrays used by the session.
+  iree_allocator_t host_allocator =
+      iree_runtime_session_host_allocator(session);
+  iree_vm_function_t* functions = NULL;
+  iree_host_size_t total_size =
+      call_count * (sizeof(functions[0]) + 2 * sizeof(iree_vm_list_t*));
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, total_size, (void**)&functions));
+  iree_vm_list_t** input_lists = (iree_vm_list_t**)(functions + call_count);
+  iree_vm_list_t** output_lists = input_lists + call_count;
+  for (iree_host_size_t i = 0; i < call_count; ++i) {
+    functions[i] = calls[i].function;
+    input_lists[i] = calls[i].inputs;
+    output_lists[i] = calls[i].outputs;
+  }
+
+  iree_status_t status = iree_runtime_session_call_batch(
+      session, call_count, functions, input_lists, output_lists,
+      out_call_statuses);
+
+  iree_allocator_free(host_allocator, functions);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // Helpers for defining call I/O
 //===----------------------------------------------------------------------===//
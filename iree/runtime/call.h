@@ -98,6 +98,20 @@ IREE_API_EXPORT iree_vm_list_t* iree_runtime_call_outputs(
 IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
     iree_runtime_call_t* call, iree_runtime_call_flags_t flags);
 
+// Synchronously invokes |call_count| independent calls as a batch.
+// All calls must be within the same session. Device work submitted by the
+// calls is issued together once all calls have run and the function returns
+// when it has completed; see iree_runtime_session_call_batch for details.
+// As with iree_runtime_call_invoke the inputs lists remain unchanged and the
+// output lists are populated with the results of each call.
+//
+// |out_call_statuses| receives the status of each call and the caller must
+// consume or ignore each. Returns an error only if the batch as a whole could
+// not be executed.
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_batch(
+    iree_host_size_t call_count, iree_runtime_call_t* calls,
+    iree_runtime_call_flags_t flags, iree_status_t* out_call_statuses);
+
 //===----------------------------------------------------------------------===//
 // Helpers for defining call I/O
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,129 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/runtime/api.h"
+#include "iree/runtime/testdata/simple_mul_module_c.h"
+
+namespace {
+
+// Session with simple_mul loaded shared by all benchmarks.
+static iree_runtime_session_t* GetSession() {
+  static iree_runtime_session_t* session = [] {
+    iree_runtime_instance_options_t instance_options;
+    iree_runtime_instance_options_initialize(IREE_API_VERSION_LATEST,
+                                             &instance_options);
+    iree_runtime_instance_options_use_all_available_drivers(&instance_options);
+    iree_runtime_instance_t* instance = NULL;
+    IREE_CHECK_OK(iree_runtime_instance_create(
+        &instance_options, iree_allocator_system(), &instance));
+
+    iree_hal_device_t* device = NULL;
+    IREE_CHECK_OK(iree_runtime_instance_try_create_default_device(
+        instance, iree_make_cstring_view("vmla"), &device));
+
+    iree_runtime_session_options_t session_options;
+    iree_runtime_session_options_initialize(&session_options);
+    iree_runtime_session_t* session = NULL;
+    IREE_CHECK_OK(iree_runtime_session_create_with_device(
+        instance, &session_options, device,
+        iree_runtime_instance_host_allocator(instance), &session));
+    iree_hal_device_release(device);
+    iree_runtime_instance_release(instance);
+
+    const iree_file_toc_t* module_file =
+        iree_runtime_testdata_simple_mul_module_create();
+    IREE_CHECK_OK(iree_runtime_session_append_bytecode_module_from_memory(
+        session,
+        iree_make_const_byte_span(module_file->data, module_file->size),
+        iree_allocator_null()));
+
+    // Exclude first-use costs from the measurements.
+    iree_runtime_session_prepare_options_t prepare_options;
+    iree_runtime_session_prepare_options_initialize(&prepare_options);
+    IREE_CHECK_OK(iree_runtime_session_prepare(session, &prepare_options));
+    return session;
+  }();
+  return session;
+}
+
+// Initializes |call_count| independent calls to simple_mul each with their
+// own inputs and outputs, as if issued by concurrent requests.
+static std::vector<iree_runtime_call_t> CreateCalls(
+    iree_runtime_session_t* session, int call_count) {
+  static const iree_hal_dim_t shape[1] = {4};
+  static const float lhs_data[4] = {1.0f, 1.1f, 1.2f, 1.3f};
+  static const float rhs_data[4] = {10.0f, 100.0f, 1000.0f, 10000.0f};
+  std::vector<iree_runtime_call_t> calls(call_count);
+  for (auto& call : calls) {
+    IREE_CHECK_OK(iree_runtime_call_initialize_by_name(
+        session, iree_make_cstring_view("module.simple_mul"), &call));
+    for (const float* data : {lhs_data, rhs_data}) {
+      iree_hal_buffer_view_t* arg = NULL;
+      IREE_CHECK_OK(iree_hal_buffer_view_clone_heap_buffer(
+          iree_runtime_session_device_allocator(session), shape,
+          IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+          IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
+              IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+          IREE_HAL_BUFFER_USAGE_ALL,
+          iree_make_const_byte_span(data, sizeof(lhs_data)), &arg));
+      IREE_CHECK_OK(iree_runtime_call_inputs_push_back_buffer_view(&call, arg));
+      iree_hal_buffer_view_release(arg);
+    }
+  }
+  return calls;
+}
+
+static void DestroyCalls(std::vector<iree_runtime_call_t>& calls) {
+  for (auto& call : calls) {
+    iree_runtime_call_deinitialize(&call);
+  }
+}
+
+// K calls issued one after another, each waiting for its device work.
+static void BM_SequentialCalls(benchmark::State& state) {
+  auto calls = CreateCalls(GetSession(), state.range(0));
+  while (state.KeepRunningBatch(state.range(0))) {
+    for (auto& call : calls) {
+      IREE_CHECK_OK(iree_vm_list_resize(iree_runtime_call_outputs(&call), 0));
+      IREE_CHECK_OK(iree_runtime_call_invoke(&call, /*flags=*/0));
+    }
+  }
+  DestroyCalls(calls);
+}
+BENCHMARK(BM_SequentialCalls)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// K calls issued as a batch with a single device submission.
+static void BM_BatchedCalls(benchmark::State& state) {
+  auto calls = CreateCalls(GetSession(), state.range(0));
+  std::vector<iree_status_t> call_statuses(calls.size());
+  while (state.KeepRunningBatch(state.range(0))) {
+    for (auto& call : calls) {
+      IREE_CHECK_OK(iree_vm_list_resize(iree_runtime_call_outputs(&call), 0));
+    }
+    IREE_CHECK_OK(iree_runtime_call_invoke_batch(
+        calls.size(), calls.data(), /*flags=*/0, call_statuses.data()));
+    for (iree_status_t call_status : call_statuses) {
+      IREE_CHECK_OK(call_status);
+    }
+  }
+  DestroyCalls(calls);
+}
+BENCHMARK(BM_BatchedCalls)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+}  // namespace
@@ -56,6 +56,11 @@ struct iree_runtime_session_s {
   // synchronized.
   iree_vm_context_t* context;
 
+  // The HAL module registered first in |context|. Sessions created with
+  // iree_runtime_session_create_shared register the same module so that
+  // immutable resources it caches are shared.
+  iree_vm_module_t* hal_module;
+
   // The HAL module state bound to the target devices.
   // This is used internally by the loaded modules to interact with the devices
   // but can also be used by the caller to perform allocation and custom device
@@ -65,8 +70,30 @@ struct iree_runtime_session_s {
   // lookup. An application directly using the API may never need this, or could
   // perform VM calls into HAL module exports to gain more portability.
   iree_vm_module_state_t* hal_module_state;
+
+  // Contents of the bytecode modules appended to the session, used when
+  // prefaulting. The memory is owned by the modules registered in |context|.
+  iree_host_size_t module_data_count;
+  iree_host_size_t module_data_capacity;
+  iree_const_byte_span_t* module_data;
 };
 
+// Records |data| as the contents of a bytecode module registered with the
+// session.
+static iree_status_t iree_runtime_session_append_module_data(
+    iree_runtime_session_t* session, iree_const_byte_span_t data) {
+  if (session->module_data_count == session->module_data_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(4, session->module_data_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        session->host_allocator, new_capacity * sizeof(*session->module_data),
+        (void**)&session->module_data));
+    session->module_data_capacity = new_capacity;
+  }
+  session->module_data[session->module_data_count++] = data;
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
     iree_runtime_instance_t* instance,
     const iree_runtime_session_options_t* options, iree_hal_device_t* device,
@@ -95,18 +122,77 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
 
   // Add the HAL module; it is always required when using the runtime API.
   // Lower-level usage of the VM can avoid the HAL if it's not required.
-  iree_vm_module_t* hal_module = NULL;
+  // When requested immutable resources are cached on the module so that they
+  // can be shared with sessions created with iree_runtime_session_create_shared.
   if (iree_status_is_ok(status)) {
-    status = iree_hal_module_create(device, host_allocator, &hal_module);
+    iree_hal_module_flags_t hal_module_flags =
+        options->share_immutable_resources
+            ? IREE_HAL_MODULE_FLAG_SHARE_IMMUTABLE_RESOURCES
+            : IREE_HAL_MODULE_FLAG_NONE;
+    status = iree_hal_module_create_with_flags(
+        device, hal_module_flags, host_allocator, &session->hal_module);
   }
   if (iree_status_is_ok(status)) {
-    status = iree_vm_context_register_modules(session->context, &hal_module, 1);
+    status = iree_vm_context_register_modules(session->context,
+                                              &session->hal_module, 1);
   }
   if (iree_status_is_ok(status)) {
-    status = iree_vm_context_resolve_module_state(session->context, hal_module,
-                                                  &session->hal_module_state);
+    status = iree_vm_context_resolve_module_state(
+        session->context, session->hal_module, &session->hal_module_state);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_session = session;
+  } else {
+    iree_runtime_session_release(session);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_create_shared(
+    iree_runtime_session_t* base_session, iree_allocator_t host_allocator,
+    iree_runtime_session_t** out_session) {
+  IREE_ASSERT_ARGUMENT(base_session);
+  IREE_ASSERT_ARGUMENT(out_session);
+  *out_session = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Allocate the session state.
+  iree_runtime_session_t* session = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*session),
+                                (void**)&session));
+  session->host_allocator = host_allocator;
+  iree_atomic_ref_count_init(&session->ref_count);
+
+  session->instance = base_session->instance;
+  iree_runtime_instance_retain(session->instance);
+  session->hal_module = base_session->hal_module;
+  iree_vm_module_retain(session->hal_module);
+
+  // Register the same module instances (starting with the HAL module) in a new
+  // context. Each module allocates fresh state for the context while the
+  // module itself - and any resources cached on it - is shared.
+  iree_host_size_t module_count =
+      iree_vm_context_module_count(base_session->context);
+  iree_vm_module_t** modules =
+      (iree_vm_module_t**)iree_alloca(module_count * sizeof(modules[0]));
+  for (iree_host_size_t i = 0; i < module_count; ++i) {
+    modules[i] = iree_vm_context_module_at(base_session->context, i);
+  }
+  iree_status_t status = iree_vm_context_create_with_modules(
+      /*instance=*/NULL, modules, module_count, host_allocator,
+      &session->context);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_context_resolve_module_state(
+        session->context, session->hal_module, &session->hal_module_state);
+  }
+  for (iree_host_size_t i = 0;
+       i < base_session->module_data_count && iree_status_is_ok(status); ++i) {
+    status = iree_runtime_session_append_module_data(
+        session, base_session->module_data[i]);
   }
-  iree_vm_module_release(hal_module);
 
   if (iree_status_is_ok(status)) {
     *out_session = session;
@@ -122,7 +208,9 @@ static void iree_runtime_session_destroy(iree_runtime_session_t* session) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_vm_context_release(session->context);
+  iree_vm_module_release(session->hal_module);
   iree_runtime_instance_release(session->instance);
+  iree_allocator_free(session->host_allocator, session->module_data);
 
   iree_allocator_free(session->host_allocator, session);
 
@@ -196,6 +284,11 @@ iree_runtime_session_append_bytecode_module_from_memory(
   IREE_ASSERT_ARGUMENT(session);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Record the contents first so that the module is not left registered
+  // without them if recording fails.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_session_append_module_data(session, flatbuffer_data));
+
   iree_vm_module_t* module = NULL;
   iree_status_t status = iree_vm_bytecode_module_create(
       flatbuffer_data, flatbuffer_allocator,
@@ -203,6 +296,7 @@ iree_runtime_session_append_bytecode_module_from_memory(
   if (iree_status_is_ok(status)) {
     status = iree_runtime_session_append_module(session, module);
   }
+  if (!iree_status_is_ok(status)) --session->module_data_count;
   iree_vm_module_release(module);
 
   IREE_TRACE_ZONE_END(z0);
@@ -216,14 +310,14 @@ iree_runtime_session_append_bytecode_module_from_file(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_TEXT(z0, file_path);
 
-  // TODO(#3909): actually map the memory here. For now we just load the
-  // contents.
-  iree_allocator_t flatbuffer_allocator =
-      iree_runtime_session_host_allocator(session);
+  // The contents are mapped and only paged in as the module accesses them; see
+  // IREE_RUNTIME_SESSION_PREPARE_FLAG_PREFAULT_MODULES.
+  iree_allocator_t flatbuffer_allocator = iree_allocator_null();
   iree_byte_span_t flatbuffer_data;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_file_read_contents(file_path, flatbuffer_allocator,
-                                  &flatbuffer_data));
+      z0, iree_file_map_contents(file_path,
+                                 iree_runtime_session_host_allocator(session),
+                                 &flatbuffer_data, &flatbuffer_allocator));
 
   iree_status_t status =
       iree_runtime_session_append_bytecode_module_from_memory(
@@ -269,6 +363,63 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call(
   return status;
 }
 
+IREE_API_EXPORT iree_status_t iree_runtime_session_call_batch(
+    iree_runtime_session_t* session, iree_host_size_t call_count,
+    const iree_vm_function_t* functions, iree_vm_list_t* const* input_lists,
+    iree_vm_list_t* const* output_lists, iree_status_t* out_call_statuses) {
+  IREE_ASSERT_ARGUMENT(session);
+  if (!call_count) return iree_ok_status();
+  IREE_ASSERT_ARGUMENT(functions);
+  IREE_ASSERT_ARGUMENT(out_call_statuses);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)call_count);
+
+  iree_status_t* slot_statuses = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(session->host_allocator,
+                                call_count * sizeof(slot_statuses[0]),
+                                (void**)&slot_statuses));
+
+  // Each call is assigned its own slot so that its device work is ordered
+  // independently of the others.
+  iree_status_t status =
+      iree_hal_module_state_begin_batch(session->hal_module_state);
+  if (iree_status_is_ok(status)) {
+    for (iree_host_size_t i = 0; i < call_count; ++i) {
+      out_call_statuses[i] = iree_ok_status();
+    }
+    for (iree_host_size_t i = 0; i < call_count; ++i) {
+      status =
+          iree_hal_module_state_set_batch_slot(session->hal_module_state, i);
+      if (!iree_status_is_ok(status)) break;
+      out_call_statuses[i] = iree_runtime_session_call(
+          session, &functions[i], input_lists ? input_lists[i] : NULL,
+          output_lists ? output_lists[i] : NULL);
+    }
+
+    // Submit all deferred work and wait for it to complete. Failures of the
+    // device work are reported on calls that otherwise succeeded.
+    iree_status_t end_status = iree_hal_module_state_end_batch(
+        session->hal_module_state, call_count, slot_statuses);
+    if (iree_status_is_ok(status)) {
+      status = end_status;
+    } else {
+      iree_status_ignore(end_status);
+    }
+    for (iree_host_size_t i = 0; i < call_count; ++i) {
+      if (iree_status_is_ok(out_call_statuses[i])) {
+        out_call_statuses[i] = slot_statuses[i];
+      } else {
+        iree_status_ignore(slot_statuses[i]);
+      }
+    }
+  }
+
+  iree_allocator_free(session->host_allocator, slot_statuses);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 IREE_API_EXPORT iree_status_t iree_runtime_session_call_by_name(
     iree_runtime_session_t* session, iree_string_view_t full_name,
     iree_vm_list_t* input_list, iree_vm_list_t* output_list) {
@@ -302,3 +453,136 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call_direct(
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_fprint_profile(
+    FILE* file, const iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_ASSERT_ARGUMENT(session);
+  return iree_vm_bytecode_module_fprint_profile(
+      file, iree_runtime_session_context(session),
+      iree_runtime_session_host_allocator(session));
+}
+
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_reset_profile(const iree_runtime_session_t* session) {
+  IREE_ASSERT_ARGUMENT(session);
+  return iree_vm_bytecode_module_reset_profile(
+      iree_runtime_session_context(session));
+}
+
+//===----------------------------------------------------------------------===//
+// Warm-up
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_runtime_session_prepare_options_initialize(
+    iree_runtime_session_prepare_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->flags = IREE_RUNTIME_SESSION_PREPARE_FLAG_PREFAULT_MODULES |
+                       IREE_RUNTIME_SESSION_PREPARE_FLAG_PREPARE_EXECUTABLES;
+}
+
+// Populates |inputs| with zeros for each argument of |function|.
+static iree_status_t iree_runtime_session_make_synthetic_inputs(
+    const iree_vm_function_t* function, iree_vm_list_t* inputs) {
+  iree_vm_function_signature_t signature = iree_vm_function_signature(function);
+  iree_string_view_t arguments, results;
+  IREE_RETURN_IF_ERROR(iree_vm_function_call_get_cconv_fragments(
+      &signature, &arguments, &results));
+  for (iree_host_size_t i = 0; i < arguments.size; ++i) {
+    iree_vm_value_t value;
+    switch (arguments.data[i]) {
+      case IREE_VM_CCONV_TYPE_VOID:
+        continue;
+      case IREE_VM_CCONV_TYPE_I32:
+        value = iree_vm_value_make_i32(0);
+        break;
+      case IREE_VM_CCONV_TYPE_I64:
+        value = iree_vm_value_make_i64(0);
+        break;
+      case IREE_VM_CCONV_TYPE_F32:
+        value = iree_vm_value_make_f32(0.0f);
+        break;
+      case IREE_VM_CCONV_TYPE_F64:
+        value = iree_vm_value_make_f64(0.0);
+        break;
+      default:
+        return iree_make_status(
+            IREE_STATUS_INVALID_ARGUMENT,
+            "cannot synthesize warmup inputs for calling convention '%.*s'; "
+            "warmup_inputs must be provided",
+            (int)arguments.size, arguments.data);
+    }
+    IREE_RETURN_IF_ERROR(iree_vm_list_push_value(inputs, &value));
+  }
+  return iree_ok_status();
+}
+
+// Invokes the warmup function the requested number of times.
+static iree_status_t iree_runtime_session_warmup(
+    iree_runtime_session_t* session,
+    const iree_runtime_session_prepare_options_t* options) {
+  iree_vm_function_t function;
+  IREE_RETURN_IF_ERROR(iree_runtime_session_lookup_function(
+      session, options->warmup_function, &function));
+
+  iree_vm_list_t* inputs = options->warmup_inputs;
+  iree_vm_list_t* synthetic_inputs = NULL;
+  iree_vm_list_t* outputs = NULL;
+  iree_status_t status = iree_ok_status();
+  if (!inputs) {
+    status = iree_vm_list_create(/*element_type=*/NULL, /*initial_capacity=*/4,
+                                 session->host_allocator, &synthetic_inputs);
+    if (iree_status_is_ok(status)) {
+      status = iree_runtime_session_make_synthetic_inputs(&function,
+                                                          synthetic_inputs);
+    }
+    inputs = synthetic_inputs;
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_list_create(/*element_type=*/NULL, /*initial_capacity=*/4,
+                                 session->host_allocator, &outputs);
+  }
+  for (iree_host_size_t i = 0;
+       i < options->warmup_iteration_count && iree_status_is_ok(status); ++i) {
+    status = iree_runtime_session_call(session, &function, inputs, outputs);
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_list_resize(outputs, 0);
+    }
+  }
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(synthetic_inputs);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_prepare(
+    iree_runtime_session_t* session,
+    const iree_runtime_session_prepare_options_t* options) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Fault in module contents first: executables and constants are read from
+  // them by the following steps.
+  if (iree_all_bits_set(options->flags,
+                        IREE_RUNTIME_SESSION_PREPARE_FLAG_PREFAULT_MODULES)) {
+    for (iree_host_size_t i = 0; i < session->module_data_count; ++i) {
+      iree_file_prefault_contents(session->module_data[i]);
+    }
+  }
+
+  iree_status_t status = iree_ok_status();
+  if (iree_all_bits_set(
+          options->flags,
+          IREE_RUNTIME_SESSION_PREPARE_FLAG_PREPARE_EXECUTABLES)) {
+    status =
+        iree_hal_module_state_prepare_executables(session->hal_module_state);
+  }
+
+  if (iree_status_is_ok(status) && options->warmup_iteration_count &&
+      !iree_string_view_is_empty(options->warmup_function)) {
+    status = iree_runtime_session_warmup(session, options);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
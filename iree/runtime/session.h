@@ -16,6 +16,7 @@
 #define IREE_RUNTIME_SESSION_H_
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
@@ -66,6 +67,13 @@ typedef struct {
   // Session creation will fail if a requested module is not built into the
   // runtime binary.
   iree_runtime_session_builtins_t builtin_modules;
+
+  // Caches immutable resources created by the program initializers - such as
+  // executables and constant buffers wrapping module rodata - so that they can
+  // be reused by sessions created with iree_runtime_session_create_shared.
+  // Cached resources live as long as the session and all sessions sharing with
+  // it. Defaults to false.
+  bool share_immutable_resources;
 } iree_runtime_session_options_t;
 
 // Initializes |out_options| to its default values.
@@ -93,6 +101,29 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
     const iree_runtime_session_options_t* options, iree_hal_device_t* device,
     iree_allocator_t host_allocator, iree_runtime_session_t** out_session);
 
+// Creates a new session that shares the device and all modules loaded into
+// |base_session| at the time of the call but has its own VM context.
+//
+// Mutable program state such as module globals is per-session while module
+// bytecode and rodata are loaded once and shared. If |base_session| was created
+// with iree_runtime_session_options_t.share_immutable_resources the
+// executables, executable layouts, descriptor set layouts, and constant buffers
+// created by the program initializers of one session are also reused by all
+// sessions sharing with it. This allows running many concurrent sessions of the
+// same program without paying for the immutable state of each.
+//
+// The new session is frozen: modules cannot be appended to it. Modules
+// appended to |base_session| later are not visible to the new session.
+// Sessions are thread-compatible and |base_session| must not be modified
+// concurrently with this call; once created each session may be used from a
+// different thread.
+//
+// |host_allocator| will be used to allocate the session and its mutable state.
+// |out_session| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_runtime_session_create_shared(
+    iree_runtime_session_t* base_session, iree_allocator_t host_allocator,
+    iree_runtime_session_t** out_session);
+
 // Retains the given |session| for the caller.
 IREE_API_EXPORT void iree_runtime_session_retain(
     iree_runtime_session_t* session);
@@ -197,6 +228,24 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call(
     iree_runtime_session_t* session, const iree_vm_function_t* function,
     iree_vm_list_t* input_list, iree_vm_list_t* output_list);
 
+// Synchronously issues |call_count| independent function calls as a batch.
+// Call i invokes |functions|[i] with |input_lists|[i] and populates
+// |output_lists|[i] as with iree_runtime_session_call.
+//
+// The calls are executed by the VM in order but the device work they submit
+// is deferred and issued together in a single queue submission once all calls
+// have run. Device work from different calls may execute concurrently so
+// calls must not depend on each other's results. This amortizes the fixed
+// submission and scheduling overhead across many small concurrent requests.
+//
+// |out_call_statuses| receives the status of each call and the caller must
+// consume or ignore each. Returns an error only if the batch as a whole could
+// not be executed.
+IREE_API_EXPORT iree_status_t iree_runtime_session_call_batch(
+    iree_runtime_session_t* session, iree_host_size_t call_count,
+    const iree_vm_function_t* functions, iree_vm_list_t* const* input_lists,
+    iree_vm_list_t* const* output_lists, iree_status_t* out_call_statuses);
+
 // Synchronously issues a generic function call by fully-qualified name.
 // This is equivalent to performing a iree_runtime_session_lookup_function
 // followed by a iree_runtime_session_call. When calling the same function
@@ -217,6 +266,75 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call_by_name(
 IREE_API_EXPORT iree_status_t iree_runtime_session_call_direct(
     iree_runtime_session_t* session, const iree_vm_function_call_t* call);
 
+// Prints the execution profile of all bytecode functions called within the
+// session as a JSON hot-function report ordered by descending inclusive time.
+// Counters accumulate across all calls since the session was created or last
+// reset with iree_runtime_session_reset_profile.
+//
+// Returns IREE_STATUS_UNAVAILABLE if the runtime was built without
+// IREE_VM_EXECUTION_PROFILING_ENABLE. See iree_vm_bytecode_module_fprint_profile
+// for the output format.
+IREE_API_EXPORT iree_status_t iree_runtime_session_fprint_profile(
+    FILE* file, const iree_runtime_session_t* session);
+
+// Resets the execution profile counters of all bytecode functions within the
+// session. Useful to exclude warmup calls from a subsequent profile.
+IREE_API_EXPORT iree_status_t
+iree_runtime_session_reset_profile(const iree_runtime_session_t* session);
+
+//===----------------------------------------------------------------------===//
+// Warm-up
+//===----------------------------------------------------------------------===//
+
+// Controls which work iree_runtime_session_prepare performs.
+enum iree_runtime_session_prepare_flag_e {
+  IREE_RUNTIME_SESSION_PREPARE_FLAG_NONE = 0u,
+
+  // Makes the contents of bytecode modules loaded with
+  // iree_runtime_session_append_bytecode_module_from_memory or _from_file
+  // resident. This includes their constant pools and any embedded executables.
+  // Modules loaded from files are memory mapped and otherwise page in from
+  // storage on first access.
+  IREE_RUNTIME_SESSION_PREPARE_FLAG_PREFAULT_MODULES = 1u << 0,
+
+  // Prepares device executables whose preparation was deferred until first use
+  // (see IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES).
+  IREE_RUNTIME_SESSION_PREPARE_FLAG_PREPARE_EXECUTABLES = 1u << 1,
+};
+typedef uint32_t iree_runtime_session_prepare_flags_t;
+
+// Options used to configure iree_runtime_session_prepare.
+typedef struct {
+  iree_runtime_session_prepare_flags_t flags;
+
+  // Fully-qualified name of a function to invoke as a dry run after any other
+  // preparation, or empty to skip. Dry runs warm up everything that the other
+  // steps cannot reach such as device allocator pools and transient arenas.
+  iree_string_view_t warmup_function;
+
+  // Inputs passed to each dry run. If NULL synthetic inputs are used: all
+  // arguments are zero and only functions taking primitive values are
+  // supported. Functions taking buffers need inputs of the shapes they would
+  // receive in production to warm up the same allocation sizes.
+  iree_vm_list_t* warmup_inputs;
+
+  // Number of times to invoke |warmup_function|. The outputs are discarded.
+  iree_host_size_t warmup_iteration_count;
+} iree_runtime_session_prepare_options_t;
+
+// Initializes |out_options| to its default values: modules are prefaulted and
+// deferred executables are prepared but no dry run is performed.
+IREE_API_EXPORT void iree_runtime_session_prepare_options_initialize(
+    iree_runtime_session_prepare_options_t* out_options);
+
+// Performs work that would otherwise happen during the first invocations of
+// the session so that subsequent calls run at steady-state latency. Intended
+// to be called once after all modules have been appended and before the
+// session is reported as ready to serve.
+IREE_API_EXPORT iree_status_t iree_runtime_session_prepare(
+    iree_runtime_session_t* session,
+    const iree_runtime_session_prepare_options_t* options);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,282 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/runtime/session.h"
+
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/runtime/api.h"
+#include "iree/runtime/testdata/shared_state_module_c.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+class SessionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_runtime_instance_options_t instance_options;
+    iree_runtime_instance_options_initialize(IREE_API_VERSION_LATEST,
+                                             &instance_options);
+    iree_runtime_instance_options_use_all_available_drivers(&instance_options);
+    IREE_ASSERT_OK(iree_runtime_instance_create(
+        &instance_options, iree_allocator_system(), &instance_));
+    IREE_ASSERT_OK(iree_runtime_instance_try_create_default_device(
+        instance_, iree_make_cstring_view("vmla"), &device_));
+  }
+
+  void TearDown() override {
+    iree_hal_device_release(device_);
+    iree_runtime_instance_release(instance_);
+  }
+
+  // Creates a session with the shared_state module loaded.
+  iree_runtime_session_t* CreateSession(bool share_immutable_resources) {
+    iree_runtime_session_options_t session_options;
+    iree_runtime_session_options_initialize(&session_options);
+    session_options.share_immutable_resources = share_immutable_resources;
+    iree_runtime_session_t* session = NULL;
+    IREE_CHECK_OK(iree_runtime_session_create_with_device(
+        instance_, &session_options, device_,
+        iree_runtime_instance_host_allocator(instance_), &session));
+    const iree_file_toc_t* module_file =
+        iree_runtime_testdata_shared_state_module_create();
+    IREE_CHECK_OK(iree_runtime_session_append_bytecode_module_from_memory(
+        session,
+        iree_make_const_byte_span(module_file->data, module_file->size),
+        iree_allocator_null()));
+    return session;
+  }
+
+  // Initializes |out_call| to call |function_name| in |session| with the
+  // optional f32 |input|.
+  void InitializeCall(iree_runtime_session_t* session,
+                      const char* function_name,
+                      const std::vector<float>& input,
+                      iree_runtime_call_t* out_call) {
+    IREE_CHECK_OK(iree_runtime_call_initialize_by_name(
+        session, iree_make_cstring_view(function_name), out_call));
+    if (input.empty()) return;
+    const iree_hal_dim_t shape[1] = {(iree_hal_dim_t)input.size()};
+    iree_hal_buffer_view_t* arg = NULL;
+    IREE_CHECK_OK(iree_hal_buffer_view_clone_heap_buffer(
+        iree_runtime_session_device_allocator(session), shape,
+        IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL,
+        iree_make_const_byte_span(input.data(), input.size() * sizeof(float)),
+        &arg));
+    IREE_CHECK_OK(
+        iree_runtime_call_inputs_push_back_buffer_view(out_call, arg));
+    iree_hal_buffer_view_release(arg);
+  }
+
+  // Returns the f32 contents of the single result of |call|.
+  std::vector<float> ReadResult(iree_runtime_call_t* call) {
+    iree_hal_buffer_view_t* result = NULL;
+    IREE_CHECK_OK(
+        iree_runtime_call_outputs_pop_front_buffer_view(call, &result));
+    std::vector<float> contents(iree_hal_buffer_view_element_count(result));
+    IREE_CHECK_OK(iree_hal_buffer_read_data(iree_hal_buffer_view_buffer(result),
+                                            0, contents.data(),
+                                            contents.size() * sizeof(float)));
+    iree_hal_buffer_view_release(result);
+    return contents;
+  }
+
+  // Calls |function_name| in |session| with the optional f32 |input| and
+  // returns the f32 contents of its single result.
+  std::vector<float> CallF32(iree_runtime_session_t* session,
+                             const char* function_name,
+                             const std::vector<float>& input = {}) {
+    iree_runtime_call_t call;
+    InitializeCall(session, function_name, input, &call);
+    IREE_CHECK_OK(iree_runtime_call_invoke(&call, /*flags=*/0));
+    std::vector<float> result = ReadResult(&call);
+    iree_runtime_call_deinitialize(&call);
+    return result;
+  }
+
+  // Invokes |calls| as a batch and returns the f32 result of each call or an
+  // empty result if the call failed.
+  std::vector<std::vector<float>> InvokeBatch(
+      std::vector<iree_runtime_call_t>& calls,
+      std::vector<iree::StatusCode>* out_codes = nullptr) {
+    std::vector<iree_status_t> call_statuses(calls.size());
+    IREE_CHECK_OK(iree_runtime_call_invoke_batch(
+        calls.size(), calls.data(), /*flags=*/0, call_statuses.data()));
+    std::vector<std::vector<float>> results(calls.size());
+    for (size_t i = 0; i < calls.size(); ++i) {
+      if (out_codes) {
+        out_codes->push_back(
+            static_cast<iree::StatusCode>(iree_status_code(call_statuses[i])));
+      }
+      if (iree_status_is_ok(call_statuses[i])) {
+        results[i] = ReadResult(&calls[i]);
+      }
+      iree_status_ignore(call_statuses[i]);
+    }
+    return results;
+  }
+
+  static void DeinitializeCalls(std::vector<iree_runtime_call_t>& calls) {
+    for (auto& call : calls) {
+      iree_runtime_call_deinitialize(&call);
+    }
+  }
+
+  iree_runtime_instance_t* instance_ = nullptr;
+  iree_hal_device_t* device_ = nullptr;
+};
+
+TEST_F(SessionTest, SharedSessionsHaveTheirOwnGlobals) {
+  for (bool share_immutable_resources : {false, true}) {
+    iree_runtime_session_t* base_session =
+        CreateSession(share_immutable_resources);
+    iree_runtime_session_t* shared_session = NULL;
+    IREE_ASSERT_OK(iree_runtime_session_create_shared(
+        base_session, iree_allocator_system(), &shared_session));
+
+    EXPECT_EQ(std::vector<float>({1.0f}),
+              CallF32(base_session, "module.increment"));
+    EXPECT_EQ(std::vector<float>({2.0f}),
+              CallF32(base_session, "module.increment"));
+    EXPECT_EQ(std::vector<float>({1.0f}),
+              CallF32(shared_session, "module.increment"));
+
+    // Executables and constants, shared or not, produce the same results.
+    const std::vector<float> input = {1.0f, 1.0f, 2.0f, 2.0f};
+    const std::vector<float> expected = {1.0f, 2.0f, 6.0f, 8.0f};
+    EXPECT_EQ(expected, CallF32(base_session, "module.scale", input));
+    EXPECT_EQ(expected, CallF32(shared_session, "module.scale", input));
+
+    // Releasing the base session first must keep the shared resources alive.
+    iree_runtime_session_release(base_session);
+    EXPECT_EQ(expected, CallF32(shared_session, "module.scale", input));
+    EXPECT_EQ(std::vector<float>({2.0f}),
+              CallF32(shared_session, "module.increment"));
+    iree_runtime_session_release(shared_session);
+  }
+}
+
+// Returns the input of the |i|-th call in a batch.
+static std::vector<float> BatchInput(int i) {
+  return {1.0f + i, 2.0f * i, -1.0f * i, 0.5f};
+}
+
+TEST_F(SessionTest, InvokeBatchMatchesSequential) {
+  iree_runtime_session_t* session = CreateSession(false);
+  // More calls than the batch initially reserves slots for.
+  const int kCallCount = 20;
+  std::vector<std::vector<float>> sequential_results;
+  std::vector<iree_runtime_call_t> calls(kCallCount);
+  for (int i = 0; i < kCallCount; ++i) {
+    sequential_results.push_back(
+        CallF32(session, "module.scale", BatchInput(i)));
+    InitializeCall(session, "module.scale", BatchInput(i), &calls[i]);
+  }
+  EXPECT_EQ(sequential_results, InvokeBatch(calls));
+  // Calls can be reused for subsequent batches.
+  EXPECT_EQ(sequential_results, InvokeBatch(calls));
+  DeinitializeCalls(calls);
+  iree_runtime_session_release(session);
+}
+
+TEST_F(SessionTest, InvokeBatchReportsPerCallStatus) {
+  iree_runtime_session_t* session = CreateSession(false);
+  std::vector<iree_runtime_call_t> calls(3);
+  InitializeCall(session, "module.scale", BatchInput(0), &calls[0]);
+  // Missing its input and fails.
+  InitializeCall(session, "module.scale", {}, &calls[1]);
+  InitializeCall(session, "module.scale", BatchInput(2), &calls[2]);
+  std::vector<iree::StatusCode> codes;
+  std::vector<std::vector<float>> results = InvokeBatch(calls, &codes);
+  EXPECT_EQ(iree::StatusCode::kOk, codes[0]);
+  EXPECT_NE(iree::StatusCode::kOk, codes[1]);
+  EXPECT_EQ(iree::StatusCode::kOk, codes[2]);
+  EXPECT_EQ(CallF32(session, "module.scale", BatchInput(0)), results[0]);
+  EXPECT_EQ(CallF32(session, "module.scale", BatchInput(2)), results[2]);
+  DeinitializeCalls(calls);
+  iree_runtime_session_release(session);
+}
+
+TEST_F(SessionTest, InvokeBatchFlushesBeforeHostLoads) {
+  // splat_first_scaled reads back the result of a dispatch on the host so the
+  // deferred work of the batch must be flushed for it to see the results.
+  iree_runtime_session_t* session = CreateSession(false);
+  const int kCallCount = 20;
+  std::vector<iree_runtime_call_t> calls(kCallCount);
+  for (int i = 0; i < kCallCount; ++i) {
+    InitializeCall(session, "module.splat_first_scaled", BatchInput(i),
+                   &calls[i]);
+  }
+  std::vector<std::vector<float>> results = InvokeBatch(calls);
+  for (int i = 0; i < kCallCount; ++i) {
+    EXPECT_EQ(std::vector<float>(4, BatchInput(i)[0]), results[i]);
+  }
+  DeinitializeCalls(calls);
+  iree_runtime_session_release(session);
+}
+
+TEST_F(SessionTest, PrepareRunsWarmupIterations) {
+  iree_runtime_session_t* session = CreateSession(false);
+  iree_runtime_session_prepare_options_t options;
+  iree_runtime_session_prepare_options_initialize(&options);
+  options.warmup_function = iree_make_cstring_view("module.tick");
+  options.warmup_iteration_count = 3;
+  // Without warmup_inputs the i32 argument of tick is synthesized.
+  IREE_ASSERT_OK(iree_runtime_session_prepare(session, &options));
+  EXPECT_EQ(std::vector<float>({4.0f}), CallF32(session, "module.increment"));
+  iree_runtime_session_release(session);
+}
+
+TEST_F(SessionTest, PrepareUsesWarmupInputs) {
+  iree_runtime_session_t* session = CreateSession(false);
+  iree_runtime_call_t call;
+  InitializeCall(session, "module.scale", BatchInput(1), &call);
+  iree_runtime_session_prepare_options_t options;
+  iree_runtime_session_prepare_options_initialize(&options);
+  options.warmup_function = iree_make_cstring_view("module.scale");
+  options.warmup_inputs = iree_runtime_call_inputs(&call);
+  options.warmup_iteration_count = 2;
+  IREE_EXPECT_OK(iree_runtime_session_prepare(session, &options));
+  iree_runtime_call_deinitialize(&call);
+  iree_runtime_session_release(session);
+}
+
+TEST_F(SessionTest, PrepareCannotSynthesizeBufferInputs) {
+  iree_runtime_session_t* session = CreateSession(false);
+  iree_runtime_session_prepare_options_t options;
+  iree_runtime_session_prepare_options_initialize(&options);
+  options.warmup_function = iree_make_cstring_view("module.scale");
+  options.warmup_iteration_count = 1;
+  EXPECT_THAT(iree::Status(iree_runtime_session_prepare(session, &options)),
+              StatusIs(iree::StatusCode::kInvalidArgument));
+  iree_runtime_session_release(session);
+}
+
+TEST_F(SessionTest, PrepareWithoutIterationsSkipsWarmup) {
+  iree_runtime_session_t* session = CreateSession(false);
+  iree_runtime_session_prepare_options_t options;
+  iree_runtime_session_prepare_options_initialize(&options);
+  options.warmup_function = iree_make_cstring_view("module.tick");
+  IREE_ASSERT_OK(iree_runtime_session_prepare(session, &options));
+  EXPECT_EQ(std::vector<float>({1.0f}), CallF32(session, "module.increment"));
+  iree_runtime_session_release(session);
+}
+
+}  // namespace
@@ -0,0 +1,35 @@
+flow.variable @counter mutable dense<0.0> : tensor<f32>
+
+func @increment() -> tensor<f32> attributes { iree.module.export } {
+  %0 = flow.variable.load @counter : tensor<f32>
+  %c1 = constant dense<1.0> : tensor<f32>
+  %1 = mhlo.add %0, %c1 : tensor<f32>
+  flow.variable.store %1, @counter : tensor<f32>
+  return %1 : tensor<f32>
+}
+
+func @scale(%arg0: tensor<4xf32>) -> tensor<4xf32>
+    attributes { iree.module.export } {
+  %0 = mhlo.constant dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>
+  %1 = "mhlo.multiply"(%arg0, %0) : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  return %1 : tensor<4xf32>
+}
+
+func @splat_first_scaled(%arg0: tensor<4xf32>) -> tensor<4xf32>
+    attributes { iree.module.export } {
+  %0 = mhlo.constant dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>
+  %1 = "mhlo.multiply"(%arg0, %0) : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  %c0 = constant 0 : index
+  %2 = flow.tensor.load %1[%c0] : tensor<4xf32>
+  %3 = flow.tensor.splat %2 : tensor<4xf32>
+  return %3 : tensor<4xf32>
+}
+
+// Takes a primitive argument so that warmups can synthesize its inputs.
+func @tick(%arg0: i32) -> tensor<f32> attributes { iree.module.export } {
+  %0 = flow.variable.load @counter : tensor<f32>
+  %c1 = constant dense<1.0> : tensor<f32>
+  %1 = mhlo.add %0, %c1 : tensor<f32>
+  flow.variable.store %1, @counter : tensor<f32>
+  return %1 : tensor<f32>
+}
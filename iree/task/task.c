@@ -673,7 +673,7 @@ iree_task_dispatch_slice_t* iree_task_dispatch_slice_allocate(
 }
 
 iree_status_t iree_task_dispatch_slice_execute(
-    iree_task_dispatch_slice_t* task,
+    iree_task_dispatch_slice_t* task, uint32_t worker_id,
     iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_SET_COLOR(z0,
@@ -691,6 +691,7 @@ iree_status_t iree_task_dispatch_slice_execute(
          sizeof(tile_context.workgroup_count));
   tile_context.shared_memory = task->shared_memory;
   tile_context.statistics = &task->slice_statistics;
+  tile_context.worker_id = worker_id;
 
   const uint32_t base_x = task->workgroup_base[0];
   const uint32_t base_y = task->workgroup_base[1];
@@ -773,7 +774,7 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 }
 
 iree_status_t iree_task_dispatch_shard_execute(
-    iree_task_dispatch_shard_t* task,
+    iree_task_dispatch_shard_t* task, uint32_t worker_id,
     iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -789,6 +790,7 @@ iree_status_t iree_task_dispatch_shard_execute(
   memcpy(&tile_context.workgroup_count, dispatch_task->workgroup_count.value,
          sizeof(tile_context.workgroup_count));
   tile_context.shared_memory = shared_state->shared_memory;
+  tile_context.worker_id = worker_id;
   uint32_t workgroup_count_x = tile_context.workgroup_count[0];
   uint32_t workgroup_count_y = tile_context.workgroup_count[1];
 
@@ -439,6 +439,11 @@ typedef iree_alignas(iree_max_align_t) struct {
   // Shared statistics counters for the dispatch slice.
   iree_task_dispatch_statistics_t* statistics;
 
+  // Index of the worker executing the tile in the range
+  // [0, IREE_TASK_EXECUTOR_MAX_WORKER_COUNT). Stable for the lifetime of the
+  // executor and useful for attributing per-worker costs.
+  uint32_t worker_id;
+
   // TODO(benvanik): cpuid uarch.
   // TODO(benvanik): per-tile coroutine storage.
 } iree_task_tile_context_t;
@@ -133,7 +133,7 @@ iree_task_dispatch_slice_t* iree_task_dispatch_slice_allocate(
 // Returns ok if all tiles were successfully executed and otherwise returns
 // an unspecified status (probably the first non-ok status hit).
 iree_status_t iree_task_dispatch_slice_execute(
-    iree_task_dispatch_slice_t* task,
+    iree_task_dispatch_slice_t* task, uint32_t worker_id,
     iree_task_submission_t* pending_submission);
 
 //==============================================================================
@@ -154,7 +154,7 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 // otherwise returns an unspecified status (probably the first non-ok status
 // hit).
 iree_status_t iree_task_dispatch_shard_execute(
-    iree_task_dispatch_shard_t* task,
+    iree_task_dispatch_shard_t* task, uint32_t worker_id,
     iree_task_submission_t* pending_submission);
 
 #ifdef __cplusplus
@@ -184,12 +184,16 @@ static iree_status_t iree_task_worker_execute(
     }
     case IREE_TASK_TYPE_DISPATCH_SLICE: {
       IREE_RETURN_IF_ERROR(iree_task_dispatch_slice_execute(
-          (iree_task_dispatch_slice_t*)task, pending_submission));
+          (iree_task_dispatch_slice_t*)task,
+          iree_task_affinity_set_count_trailing_zeros(worker->worker_bit),
+          pending_submission));
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SHARD: {
       IREE_RETURN_IF_ERROR(iree_task_dispatch_shard_execute(
-          (iree_task_dispatch_shard_t*)task, pending_submission));
+          (iree_task_dispatch_shard_t*)task,
+          iree_task_affinity_set_count_trailing_zeros(worker->worker_bit),
+          pending_submission));
       break;
     }
     default:
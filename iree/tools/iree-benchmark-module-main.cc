@@ -12,7 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "iree/base/internal/file_io.h"
@@ -20,6 +27,7 @@
 #include "iree/base/status.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/drivers/init.h"
+#include "iree/hal/local/dispatch_profiler.h"
 #include "iree/modules/hal/hal_module.h"
 #include "iree/tools/utils/vm_util.h"
 #include "iree/vm/api.h"
@@ -43,6 +51,27 @@ IREE_FLAG(string, entry_function, "",
 
 IREE_FLAG(string, driver, "vmla", "Backend driver to use.");
 
+IREE_FLAG(string, dispatch_profile, "",
+          "Enables per-dispatch timing in local CPU drivers and writes a\n"
+          "summary sorted by total time to the given path when done. Use '-'\n"
+          "for stdout. Paths ending in '.json' produce JSON, otherwise CSV.");
+
+IREE_FLAG(int32_t, concurrency, 0,
+          "When > 0 runs in throughput mode instead of the latency benchmark:\n"
+          "the given number of client threads each invoke --entry_function on\n"
+          "their own context sharing a single device and the aggregate QPS and\n"
+          "latency percentiles are reported.");
+IREE_FLAG(int32_t, throughput_duration_ms, 10000,
+          "Duration of the measured portion of a throughput run.");
+IREE_FLAG(int32_t, throughput_warmup_ms, 1000,
+          "Duration of the unmeasured warmup before a throughput run.");
+IREE_FLAG(double, arrival_rate, 0.0,
+          "When > 0 throughput mode runs open-loop: requests arrive as a\n"
+          "Poisson process with this aggregate rate (requests/second) split\n"
+          "evenly across the client threads and latency includes the time a\n"
+          "request waited for its client to become free. When 0 each client\n"
+          "issues its next request as soon as the previous one completes.");
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -71,6 +100,9 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=1 2 3 4\n"
     "Optionally, brackets may be used to separate the element values:\n"
     "  2x2xi32=[[1 2][3 4]]\n"
+    "Buffers may be loaded from files which are mapped into memory:\n"
+    "  @input.npy\n"
+    "  2x2xf32=@input.bin\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
@@ -84,18 +116,99 @@ static void BenchmarkFunction(const std::string& benchmark_name, int batch_size,
   IREE_TRACE_SCOPE_DYNAMIC(benchmark_name.c_str());
   IREE_TRACE_FRAME_MARK();
 
+  // The output list is reused across iterations so that the list allocation
+  // is not measured; results are dropped before each invocation.
+  vm::ref<iree_vm_list_t> outputs;
+  IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                    iree_allocator_system(), &outputs));
+
   // Benchmarking loop.
   while (state.KeepRunningBatch(batch_size)) {
     IREE_TRACE_SCOPE0("BenchmarkIteration");
     IREE_TRACE_FRAME_MARK_NAMED("Iteration");
-    vm::ref<iree_vm_list_t> outputs;
-    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 16,
-                                      iree_allocator_system(), &outputs));
+    IREE_CHECK_OK(iree_vm_list_resize(outputs.get(), 0));
     IREE_CHECK_OK(iree_vm_invoke(context, function, /*policy=*/nullptr, inputs,
                                  outputs.get(), iree_allocator_system()));
   }
 }
 
+//===----------------------------------------------------------------------===//
+// Throughput mode
+//===----------------------------------------------------------------------===//
+
+using ThroughputClock = std::chrono::steady_clock;
+
+// Latencies and errors observed by a single throughput client.
+struct ThroughputClientResults {
+  std::vector<double> latencies_ms;
+  iree_status_t status = iree_ok_status();
+};
+
+// Runs one throughput client invoking |function| on its own |context| until
+// |end_time|. Only requests issued at or after |measure_time| are recorded.
+static void RunThroughputClient(iree_vm_context_t* context,
+                                iree_vm_function_t function,
+                                iree_vm_list_t* inputs,
+                                double arrival_rate_per_client, uint32_t seed,
+                                ThroughputClock::time_point measure_time,
+                                ThroughputClock::time_point end_time,
+                                ThroughputClientResults* results) {
+  IREE_TRACE_SCOPE0("ThroughputClient");
+  vm::ref<iree_vm_list_t> outputs;
+  results->status = iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                        iree_allocator_system(), &outputs);
+  if (!iree_status_is_ok(results->status)) return;
+
+  // In open-loop mode requests are scheduled independently of completions so
+  // latency is measured from the scheduled arrival time and includes any time
+  // spent queued behind earlier requests from this client.
+  const bool open_loop = arrival_rate_per_client > 0.0;
+  std::mt19937_64 rng(seed);
+  std::exponential_distribution<double> interarrival_s(
+      open_loop ? arrival_rate_per_client : 1.0);
+  auto arrival_time = ThroughputClock::now();
+
+  while (true) {
+    if (open_loop) {
+      arrival_time += std::chrono::duration_cast<ThroughputClock::duration>(
+          std::chrono::duration<double>(interarrival_s(rng)));
+      if (arrival_time >= end_time) break;
+      std::this_thread::sleep_until(arrival_time);
+    } else {
+      arrival_time = ThroughputClock::now();
+      if (arrival_time >= end_time) break;
+    }
+
+    IREE_TRACE_FRAME_MARK_NAMED("Request");
+    iree_status_t status = iree_vm_list_resize(outputs.get(), 0);
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_invoke(context, function, /*policy=*/nullptr, inputs,
+                              outputs.get(), iree_allocator_system());
+    }
+    if (!iree_status_is_ok(status)) {
+      results->status = status;
+      return;
+    }
+    auto completion_time = ThroughputClock::now();
+    if (arrival_time >= measure_time) {
+      results->latencies_ms.push_back(
+          std::chrono::duration<double, std::milli>(completion_time -
+                                                    arrival_time)
+              .count());
+    }
+  }
+}
+
+// Returns the |percentile| (0-100) of the sorted |values| using the
+// nearest-rank method.
+static double GetPercentile(const std::vector<double>& values,
+                            double percentile) {
+  if (values.empty()) return 0.0;
+  size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(values.size())));
+  return values[std::min(std::max<size_t>(rank, 1), values.size()) - 1];
+}
+
 void RegisterModuleBenchmarks(const std::string& function_name,
                               iree_vm_context_t* context,
                               iree_vm_function_t function,
@@ -124,6 +237,19 @@ void RegisterModuleBenchmarks(const std::string& function_name,
       ->Unit(benchmark::kMillisecond);
 }
 
+// Writes the dispatch profile summary to --dispatch_profile, if specified.
+iree_status_t DumpDispatchProfile() {
+  std::string path = std::string(FLAG_dispatch_profile);
+  if (path.empty()) return iree_ok_status();
+  return WriteProfileToFile(path, "dispatch", [](bool is_json, FILE* file) {
+    return iree_hal_dispatch_profiler_dump(
+        iree_hal_dispatch_profiler_default(),
+        is_json ? IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON
+                : IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV,
+        file);
+  });
+}
+
 iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
   IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
   auto module_file = std::string(FLAG_module_file);
@@ -158,6 +284,99 @@ class IREEBenchmark {
     iree_vm_instance_release(instance_);
   };
 
+  // Runs --entry_function in throughput mode with --concurrency client threads
+  // and prints the aggregate results to stdout.
+  iree_status_t RunThroughput() {
+    IREE_TRACE_SCOPE0("IREEBenchmark::RunThroughput");
+
+    if (!instance_ || !device_ || !hal_module_ || !context_ || !input_module_) {
+      IREE_RETURN_IF_ERROR(Init());
+    }
+
+    auto function_name = std::string(FLAG_entry_function);
+    if (function_name.empty()) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "throughput mode requires --entry_function");
+    }
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(input_module_->lookup_function(
+        input_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_string_view_t{function_name.data(), function_name.size()},
+        &function));
+    IREE_RETURN_IF_ERROR(ParseToVariantList(iree_hal_device_allocator(device_),
+                                            FLAG_function_inputs, &inputs_));
+
+    // Contexts are not thread-safe so each client gets its own. The modules
+    // (and through the HAL module the device) are shared.
+    int client_count = FLAG_concurrency;
+    std::vector<iree_vm_context_t*> contexts(client_count, nullptr);
+    iree_status_t status = iree_ok_status();
+    for (int i = 0; i < client_count && iree_status_is_ok(status); ++i) {
+      std::array<iree_vm_module_t*, 2> modules = {hal_module_, input_module_};
+      status = iree_vm_context_create_with_modules(
+          instance_, modules.data(), modules.size(), iree_allocator_system(),
+          &contexts[i]);
+    }
+
+    std::vector<ThroughputClientResults> results(client_count);
+    if (iree_status_is_ok(status)) {
+      double arrival_rate_per_client = FLAG_arrival_rate / client_count;
+      auto measure_time =
+          ThroughputClock::now() +
+          std::chrono::milliseconds(FLAG_throughput_warmup_ms);
+      auto end_time = measure_time +
+                      std::chrono::milliseconds(FLAG_throughput_duration_ms);
+      std::vector<std::thread> threads;
+      threads.reserve(client_count);
+      for (int i = 0; i < client_count; ++i) {
+        threads.emplace_back(RunThroughputClient, contexts[i], function,
+                             inputs_.get(), arrival_rate_per_client,
+                             /*seed=*/static_cast<uint32_t>(i), measure_time,
+                             end_time, &results[i]);
+      }
+      for (auto& thread : threads) thread.join();
+    }
+
+    for (auto* context : contexts) iree_vm_context_release(context);
+    IREE_RETURN_IF_ERROR(status);
+
+    std::vector<double> latencies_ms;
+    for (auto& client_results : results) {
+      if (!iree_status_is_ok(client_results.status)) {
+        // Report the first failure and drop the rest.
+        if (iree_status_is_ok(status)) {
+          status = client_results.status;
+        } else {
+          iree_status_ignore(client_results.status);
+        }
+        continue;
+      }
+      latencies_ms.insert(latencies_ms.end(),
+                          client_results.latencies_ms.begin(),
+                          client_results.latencies_ms.end());
+    }
+    IREE_RETURN_IF_ERROR(status);
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+
+    double duration_s = FLAG_throughput_duration_ms / 1000.0;
+    double qps = latencies_ms.size() * FLAG_batch_size / duration_s;
+    fprintf(stdout, "function: %s\n", function_name.c_str());
+    fprintf(stdout, "mode: %s\n",
+            FLAG_arrival_rate > 0.0 ? "open-loop" : "closed-loop");
+    if (FLAG_arrival_rate > 0.0) {
+      fprintf(stdout, "offered rate: %.2f req/s\n", FLAG_arrival_rate);
+    }
+    fprintf(stdout, "clients: %d\n", client_count);
+    fprintf(stdout, "requests: %zu\n", latencies_ms.size());
+    fprintf(stdout, "throughput: %.2f QPS\n", qps);
+    fprintf(stdout, "latency p50: %.3f ms\n", GetPercentile(latencies_ms, 50));
+    fprintf(stdout, "latency p90: %.3f ms\n", GetPercentile(latencies_ms, 90));
+    fprintf(stdout, "latency p99: %.3f ms\n", GetPercentile(latencies_ms, 99));
+    fprintf(stdout, "latency p999: %.3f ms\n",
+            GetPercentile(latencies_ms, 99.9));
+    return iree_ok_status();
+  }
+
   iree_status_t Register() {
     IREE_TRACE_SCOPE0("IREEBenchmark::Register");
 
@@ -282,8 +501,22 @@ int main(int argc, char** argv) {
 
   IREE_CHECK_OK(iree_hal_register_all_available_drivers(
       iree_hal_driver_registry_default()));
+  if (FLAG_dispatch_profile[0] != '\0') {
+    iree_hal_dispatch_profiler_set_enabled(iree_hal_dispatch_profiler_default(),
+                                           true);
+  }
 
   iree::IREEBenchmark iree_benchmark;
+  if (FLAG_concurrency > 0) {
+    iree_status_t status = iree_benchmark.RunThroughput();
+    if (iree_status_is_ok(status)) status = iree::DumpDispatchProfile();
+    if (!iree_status_is_ok(status)) {
+      int ret = static_cast<int>(iree_status_code(status));
+      std::cout << iree::Status(std::move(status)) << std::endl;
+      return ret;
+    }
+    return 0;
+  }
   iree_status_t status = iree_benchmark.Register();
   if (!iree_status_is_ok(status)) {
     int ret = static_cast<int>(iree_status_code(status));
@@ -291,5 +524,11 @@ int main(int argc, char** argv) {
     return ret;
   }
   ::benchmark::RunSpecifiedBenchmarks();
+  status = iree::DumpDispatchProfile();
+  if (!iree_status_is_ok(status)) {
+    int ret = static_cast<int>(iree_status_code(status));
+    std::cout << iree::Status(std::move(status)) << std::endl;
+    return ret;
+  }
   return 0;
 }
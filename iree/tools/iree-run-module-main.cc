@@ -20,6 +20,7 @@
 #include "iree/base/status.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/drivers/init.h"
+#include "iree/hal/local/dispatch_profiler.h"
 #include "iree/modules/hal/hal_module.h"
 #include "iree/tools/utils/vm_util.h"
 #include "iree/vm/api.h"
@@ -35,6 +36,25 @@ IREE_FLAG(string, entry_function, "",
 
 IREE_FLAG(string, driver, "vmla", "Backend driver to use.");
 
+IREE_FLAG(string, dispatch_profile, "",
+          "Enables per-dispatch timing in local CPU drivers and writes a\n"
+          "summary sorted by total time to the given path when done. Use '-'\n"
+          "for stdout. Paths ending in '.json' produce JSON, otherwise CSV.");
+
+IREE_FLAG(string, startup_profile, "",
+          "Records where time is spent creating the context (module state,\n"
+          "import resolution, initializers, executable preparation and\n"
+          "constant uploads) and writes a per-module summary to the given\n"
+          "path when done. Use '-' for stdout. Paths ending in '.json'\n"
+          "produce JSON, otherwise CSV.");
+
+IREE_FLAG(bool, lazy_executables, false,
+          "Defers preparing executables until they are first dispatched.");
+
+IREE_FLAG(bool, batch_executables, false,
+          "Defers preparing executables until the first dispatch and then\n"
+          "prepares all of them together, concurrently where supported.");
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -63,9 +83,21 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=1 2 3 4\n"
     "Optionally, brackets may be used to separate the element values:\n"
     "  2x2xi32=[[1 2][3 4]]\n"
+    "Buffers may be loaded from files which are mapped into memory:\n"
+    "  @input.npy\n"
+    "  2x2xf32=@input.bin\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
+static std::vector<std::string> FLAG_function_outputs;
+IREE_FLAG_CALLBACK(
+    parse_function_input, print_function_input, &FLAG_function_outputs,
+    function_output,
+    "Where to write the result at the same position as the flag occurrence:\n"
+    "  @output.npy writes a NumPy array\n"
+    "  @output.bin writes the raw buffer contents\n"
+    "An empty value or a missing flag prints the result to stdout.");
+
 namespace iree {
 namespace {
 
@@ -81,6 +113,32 @@ iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
   return iree_ok_status();
 }
 
+// Writes the dispatch profile summary to --dispatch_profile, if specified.
+iree_status_t DumpDispatchProfile() {
+  std::string path = std::string(FLAG_dispatch_profile);
+  if (path.empty()) return iree_ok_status();
+  return WriteProfileToFile(path, "dispatch", [](bool is_json, FILE* file) {
+    return iree_hal_dispatch_profiler_dump(
+        iree_hal_dispatch_profiler_default(),
+        is_json ? IREE_HAL_DISPATCH_PROFILE_FORMAT_JSON
+                : IREE_HAL_DISPATCH_PROFILE_FORMAT_CSV,
+        file);
+  });
+}
+
+// Writes the startup profile summary to --startup_profile, if specified.
+iree_status_t DumpStartupProfile() {
+  std::string path = std::string(FLAG_startup_profile);
+  if (path.empty()) return iree_ok_status();
+  return WriteProfileToFile(path, "startup", [](bool is_json, FILE* file) {
+    return iree_vm_startup_profiler_dump(
+        iree_vm_startup_profiler_default(),
+        is_json ? IREE_VM_STARTUP_PROFILE_FORMAT_JSON
+                : IREE_VM_STARTUP_PROFILE_FORMAT_CSV,
+        file);
+  });
+}
+
 iree_status_t Run() {
   IREE_TRACE_SCOPE0("iree-run-module");
 
@@ -99,7 +157,14 @@ iree_status_t Run() {
   iree_hal_device_t* device = nullptr;
   IREE_RETURN_IF_ERROR(CreateDevice(FLAG_driver, &device));
   iree_vm_module_t* hal_module = nullptr;
-  IREE_RETURN_IF_ERROR(CreateHalModule(device, &hal_module));
+  iree_hal_module_flags_t hal_module_flags = IREE_HAL_MODULE_FLAG_NONE;
+  if (FLAG_lazy_executables) {
+    hal_module_flags |= IREE_HAL_MODULE_FLAG_LAZY_EXECUTABLES;
+  }
+  if (FLAG_batch_executables) {
+    hal_module_flags |= IREE_HAL_MODULE_FLAG_BATCH_EXECUTABLES;
+  }
+  IREE_RETURN_IF_ERROR(CreateHalModule(device, hal_module_flags, &hal_module));
 
   iree_vm_context_t* context = nullptr;
   // Order matters. The input module will likely be dependent on the hal module.
@@ -137,7 +202,11 @@ iree_status_t Run() {
                      outputs.get(), iree_allocator_system()),
       "invoking function '%s'", function_name.c_str());
 
-  IREE_RETURN_IF_ERROR(PrintVariantList(outputs.get()), "printing results");
+  IREE_RETURN_IF_ERROR(
+      OutputVariantList(outputs.get(), FLAG_function_outputs),
+      "outputting results");
+  IREE_RETURN_IF_ERROR(DumpDispatchProfile(), "writing dispatch profile");
+  IREE_RETURN_IF_ERROR(DumpStartupProfile(), "writing startup profile");
 
   inputs.reset();
   outputs.reset();
@@ -155,6 +224,14 @@ extern "C" int main(int argc, char** argv) {
   iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_DEFAULT, &argc, &argv);
   IREE_CHECK_OK(iree_hal_register_all_available_drivers(
       iree_hal_driver_registry_default()));
+  if (FLAG_dispatch_profile[0] != '\0') {
+    iree_hal_dispatch_profiler_set_enabled(iree_hal_dispatch_profiler_default(),
+                                           true);
+  }
+  if (FLAG_startup_profile[0] != '\0') {
+    iree_vm_startup_profiler_set_enabled(iree_vm_startup_profiler_default(),
+                                         true);
+  }
   IREE_CHECK_OK(Run());
   return 0;
 }
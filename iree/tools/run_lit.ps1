@@ -64,6 +64,12 @@ $env:Path = $test_dirs -join ";"
 Write-Debug "Test PATH:"
 Write-Debug "$env:PATH"
 
+# Temporary path prefix unique to the test substituted for '%t'.
+$test_tmp_dir = Join-Path ([System.IO.Path]::GetTempPath()) ([System.IO.Path]::GetRandomFileName())
+New-Item -ItemType Directory -Path $test_tmp_dir | Out-Null
+$test_tmp = Join-Path $test_tmp_dir ((Split-Path -Path $test_file -Leaf) + ".tmp")
+$test_tmp = $test_tmp -replace "\\", "/"
+
 $test_lines = Get-Content -Path $test_file
 foreach ($test_line in $test_lines) {
   if (!$test_line.StartsWith("// RUN:")) {
@@ -71,15 +77,18 @@ foreach ($test_line in $test_lines) {
   }
   $test_line = $test_line.Substring("// RUN: ".Length)
   $test_line = $test_line -replace "%s", $test_file
+  $test_line = $test_line -replace "%t", $test_tmp
   Write-Host -ForegroundColor Blue "Running test command:"
   Write-Host -ForegroundColor Yellow "$test_line"
   & $bashExe -c $test_line | Out-Default
   if ($LASTEXITCODE -gt 0) {
     Write-Host -ForegroundColor Red "Test failed with $LASTEXITCODE, command:"
     Write-Host -ForegroundColor Yellow "$test_line"
+    Remove-Item -Recurse -Force $test_tmp_dir
     exit $LASTEXITCODE
   }
 }
 
+Remove-Item -Recurse -Force $test_tmp_dir
 Write-Debug "All run commands completed successfully"
 exit 0
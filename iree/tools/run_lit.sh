@@ -83,6 +83,14 @@ for runfile_path in $(find_executables "${RUNFILES_DIR}"); do
 done
 #### END OF DEPRECATED IMPLICIT PATH DISCOVERY
 
+# Temporary path prefix unique to the test substituted for '%t'. Bazel provides
+# a per-test TEST_TMPDIR; otherwise we make our own and remove it on exit.
+if [ -z "${TEST_TMPDIR}" ]; then
+  TEST_TMPDIR="$(mktemp -d)"
+  trap 'rm -rf "${TEST_TMPDIR}"' EXIT
+fi
+test_tmp="${TEST_TMPDIR}/$(basename "$src_file").tmp"
+
 echo "run_lit.sh: $src_file"
 echo "PWD=$(pwd)"
 echo "EXPLICIT_PATH=$EXPLICIT_PATH"
@@ -105,8 +113,10 @@ do
     exit 1
   fi
 
-  # Substitute any embedded '%s' with the file name.
+  # Substitute any embedded '%s' with the file name and '%t' with the
+  # temporary path prefix.
   full_command="${command//\%s/$src_file}"
+  full_command="${full_command//\%t/$test_tmp}"
 
   # Run it.
   export PATH="$EXPLICIT_PATH:$IMPLICIT_PATH:$PATH"
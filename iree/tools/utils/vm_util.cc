@@ -14,7 +14,12 @@
 
 #include "iree/tools/utils/vm_util.h"
 
+#include <cerrno>
+#include <cstring>
+#include <limits>
 #include <ostream>
+#include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -70,6 +75,330 @@ Status GetFileContents(const char* path, std::string* out_contents) {
   return status;
 }
 
+namespace {
+
+// NumPy array file type strings (without the byte order) and the element
+// types they map to.
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+struct NpyElementType {
+  const char* descr;
+  iree_hal_element_type_t element_type;
+};
+static const NpyElementType kNpyElementTypes[] = {
+    {"f2", IREE_HAL_ELEMENT_TYPE_FLOAT_16},
+    {"f4", IREE_HAL_ELEMENT_TYPE_FLOAT_32},
+    {"f8", IREE_HAL_ELEMENT_TYPE_FLOAT_64},
+    {"i1", IREE_HAL_ELEMENT_TYPE_SINT_8},
+    {"i2", IREE_HAL_ELEMENT_TYPE_SINT_16},
+    {"i4", IREE_HAL_ELEMENT_TYPE_SINT_32},
+    {"i8", IREE_HAL_ELEMENT_TYPE_SINT_64},
+    {"u1", IREE_HAL_ELEMENT_TYPE_UINT_8},
+    {"u2", IREE_HAL_ELEMENT_TYPE_UINT_16},
+    {"u4", IREE_HAL_ELEMENT_TYPE_UINT_32},
+    {"u8", IREE_HAL_ELEMENT_TYPE_UINT_64},
+};
+
+constexpr char kNpyMagic[] = "\x93NUMPY";
+constexpr size_t kNpyMagicLength = sizeof(kNpyMagic) - 1;
+
+// Returns the value following |key| in the NumPy header dictionary |header|.
+std::string FindNpyHeaderValue(const std::string& header, const char* key) {
+  size_t key_pos = header.find(key);
+  if (key_pos == std::string::npos) return "";
+  size_t colon_pos = header.find(':', key_pos);
+  if (colon_pos == std::string::npos) return "";
+  size_t start = header.find_first_not_of(' ', colon_pos + 1);
+  if (start == std::string::npos) return "";
+  size_t end = header[start] == '(' ? header.find(')', start) + 1
+                                    : header.find_first_of(",}", start);
+  if (end == std::string::npos || end < start) return "";
+  return header.substr(start, end - start);
+}
+
+// Parses the header of the NumPy array file in |contents| and returns the
+// array shape, element type, and the offset of the element data.
+Status ParseNpyHeader(iree_const_byte_span_t contents,
+                      std::vector<iree_hal_dim_t>* out_shape,
+                      iree_hal_element_type_t* out_element_type,
+                      iree_host_size_t* out_data_offset) {
+  const uint8_t* data = contents.data;
+  if (contents.data_length < kNpyMagicLength + 4 ||
+      memcmp(data, kNpyMagic, kNpyMagicLength) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "not a NumPy array file");
+  }
+  uint8_t major_version = data[kNpyMagicLength];
+  iree_host_size_t header_offset = 0;
+  iree_host_size_t header_length = 0;
+  if (major_version == 1) {
+    header_offset = kNpyMagicLength + 4;
+    header_length = data[kNpyMagicLength + 2] |
+                    (data[kNpyMagicLength + 3] << 8);
+  } else if (major_version == 2 || major_version == 3) {
+    header_offset = kNpyMagicLength + 6;
+    if (contents.data_length < header_offset) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "truncated NumPy header");
+    }
+    header_length = data[kNpyMagicLength + 2] |
+                    (data[kNpyMagicLength + 3] << 8) |
+                    (data[kNpyMagicLength + 4] << 16) |
+                    ((iree_host_size_t)data[kNpyMagicLength + 5] << 24);
+  } else {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported NumPy format version %d",
+                            major_version);
+  }
+  if (header_offset + header_length > contents.data_length) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "truncated NumPy header");
+  }
+  std::string header(reinterpret_cast<const char*>(data) + header_offset,
+                     header_length);
+
+  if (FindNpyHeaderValue(header, "'fortran_order'") != "False") {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "only C-order NumPy arrays are supported");
+  }
+
+  // Type strings are like '<f4': byte order, kind, and byte count.
+  std::string descr = FindNpyHeaderValue(header, "'descr'");
+  if (descr.size() != 5 || descr.front() != '\'' || descr.back() != '\'') {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported NumPy type '%s'", descr.c_str());
+  }
+  char byte_order = descr[1];
+  std::string type = descr.substr(2, 2);
+  bool is_big_endian = byte_order == '>';
+  *out_element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  for (const auto& npy_type : kNpyElementTypes) {
+    if (type == npy_type.descr) *out_element_type = npy_type.element_type;
+  }
+  if (*out_element_type == IREE_HAL_ELEMENT_TYPE_NONE ||
+      (is_big_endian && type[1] != '1')) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported NumPy type '%s'", descr.c_str());
+  }
+
+  // Shapes are tuples like (2, 3) or (4,) and () for scalars.
+  std::string shape = FindNpyHeaderValue(header, "'shape'");
+  if (shape.size() < 2 || shape.front() != '(' || shape.back() != ')') {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid NumPy shape '%s'", shape.c_str());
+  }
+  out_shape->clear();
+  iree_string_view_t dims_str =
+      iree_make_string_view(shape.data() + 1, shape.size() - 2);
+  while (!iree_string_view_is_empty(dims_str)) {
+    iree_string_view_t dim_str;
+    iree_string_view_split(dims_str, ',', &dim_str, &dims_str);
+    dim_str = iree_string_view_trim(dim_str);
+    if (iree_string_view_is_empty(dim_str)) continue;
+    int32_t dim = 0;
+    if (!iree_string_view_atoi_int32(dim_str, &dim) || dim < 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "invalid NumPy shape '%s'", shape.c_str());
+    }
+    out_shape->push_back(dim);
+  }
+
+  *out_data_offset = header_offset + header_length;
+  return OkStatus();
+}
+
+// Maps the file at |path| and wraps its element data in a buffer view.
+// |shape_and_type| is the `[shape]xtype` of raw element data or empty if the
+// file is a NumPy array file describing its own shape and type.
+Status LoadBufferViewFromFile(iree_hal_allocator_t* allocator,
+                              iree_string_view_t shape_and_type,
+                              const std::string& path,
+                              iree_hal_buffer_view_t** out_buffer_view) {
+  IREE_TRACE_SCOPE0("LoadBufferViewFromFile");
+  iree_byte_span_t contents;
+  iree_allocator_t deallocator;
+  IREE_RETURN_IF_ERROR(iree_file_map_contents(
+      path.c_str(), iree_allocator_system(), &contents, &deallocator));
+
+  std::vector<iree_hal_dim_t> shape;
+  iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  iree_host_size_t data_offset = 0;
+  iree_status_t status = iree_ok_status();
+  if (iree_string_view_is_empty(shape_and_type)) {
+    status = ParseNpyHeader(
+        iree_make_const_byte_span(contents.data, contents.data_length), &shape,
+        &element_type, &data_offset);
+  } else {
+    // Same `[shape]xtype` form as iree_hal_buffer_view_parse.
+    iree_string_view_t shape_str = iree_string_view_empty();
+    iree_string_view_t type_str = shape_and_type;
+    iree_host_size_t last_x_index = iree_string_view_find_last_of(
+        shape_and_type, IREE_SV("x"), IREE_STRING_VIEW_NPOS);
+    if (last_x_index != IREE_STRING_VIEW_NPOS) {
+      shape_str = iree_string_view_substr(shape_and_type, 0, last_x_index);
+      type_str = iree_string_view_substr(shape_and_type, last_x_index + 1,
+                                         IREE_STRING_VIEW_NPOS);
+    }
+    status = iree_hal_parse_element_type(type_str, &element_type);
+    if (iree_status_is_ok(status)) {
+      iree_host_size_t shape_rank = 0;
+      status = iree_hal_parse_shape(shape_str, 0, NULL, &shape_rank);
+      if (iree_status_is_out_of_range(status)) {
+        shape.resize(shape_rank);
+        status = iree_hal_parse_shape(shape_str, shape.size(), shape.data(),
+                                      &shape_rank);
+      }
+    }
+  }
+
+  // The file must contain exactly the elements described by the shape. Shapes
+  // come from untrusted files so the size must not wrap around to a length
+  // matching the file.
+  iree_host_size_t byte_length = iree_hal_element_byte_count(element_type);
+  const iree_host_size_t max_byte_length =
+      std::numeric_limits<iree_host_size_t>::max();
+  for (iree_hal_dim_t dim : shape) {
+    if (!iree_status_is_ok(status)) break;
+    iree_host_size_t host_dim = static_cast<iree_host_size_t>(dim);
+    if (dim < 0 || (host_dim && byte_length > max_byte_length / host_dim)) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "shape of '%s' is too large", path.c_str());
+      break;
+    }
+    byte_length *= host_dim;
+  }
+  if (iree_status_is_ok(status) &&
+      contents.data_length - data_offset != byte_length) {
+    status = iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "file has %zu bytes of element data but the shape requires %zu",
+        contents.data_length - data_offset, byte_length);
+  }
+
+  // Wrap the mapped memory directly when the allocator can import host memory
+  // and otherwise copy it into a device allocation.
+  if (iree_status_is_ok(status)) {
+    iree_byte_span_t data =
+        iree_make_byte_span(contents.data + data_offset, byte_length);
+    iree_hal_memory_type_t memory_type =
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    iree_hal_buffer_compatibility_t compatibility =
+        iree_hal_allocator_query_buffer_compatibility(
+            allocator, memory_type, IREE_HAL_BUFFER_USAGE_ALL,
+            IREE_HAL_BUFFER_USAGE_ALL, byte_length);
+    if (iree_all_bits_set(compatibility,
+                          IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE)) {
+      status = iree_hal_buffer_view_wrap_heap_buffer(
+          allocator, shape.data(), shape.size(), element_type, memory_type,
+          IREE_HAL_MEMORY_ACCESS_ALL, IREE_HAL_BUFFER_USAGE_ALL, data,
+          deallocator, out_buffer_view);
+      // Ownership of the mapping transferred to the buffer.
+      if (iree_status_is_ok(status)) return OkStatus();
+    } else {
+      status = iree_hal_buffer_view_clone_heap_buffer(
+          allocator, shape.data(), shape.size(), element_type, memory_type,
+          IREE_HAL_BUFFER_USAGE_ALL,
+          iree_make_const_byte_span(data.data, data.data_length),
+          out_buffer_view);
+    }
+  }
+
+  iree_allocator_free(deallocator, contents.data);
+  return status;
+}
+
+// Returns the NumPy array file header for an array of |shape| and
+// |element_type| elements, padded such that the element data that follows it
+// is aligned.
+Status MakeNpyHeader(const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+                     iree_hal_element_type_t element_type,
+                     std::string* out_header) {
+  const char* descr = nullptr;
+  for (const auto& npy_type : kNpyElementTypes) {
+    if (npy_type.element_type == element_type) descr = npy_type.descr;
+  }
+  if (!descr) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "element type %08X has no NumPy equivalent; write "
+                            "raw element data instead",
+                            element_type);
+  }
+  std::string dict = "{'descr': '";
+  dict += iree_hal_element_byte_count(element_type) == 1 ? '|' : '<';
+  dict += descr;
+  dict += "', 'fortran_order': False, 'shape': (";
+  for (iree_host_size_t i = 0; i < shape_rank; ++i) {
+    dict += std::to_string(shape[i]);
+    dict += shape_rank == 1 || i + 1 < shape_rank ? "," : "";
+    dict += i + 1 < shape_rank ? " " : "";
+  }
+  dict += "), }";
+
+  // Version 1.0 headers are the magic, version, a 16-bit header length, and
+  // the dictionary padded with spaces and terminated by a newline.
+  constexpr size_t kPrefixLength = kNpyMagicLength + 4;
+  constexpr size_t kAlignment = 64;
+  size_t total_length =
+      (kPrefixLength + dict.size() + 1 + kAlignment - 1) & ~(kAlignment - 1);
+  size_t header_length = total_length - kPrefixLength;
+  dict.resize(header_length - 1, ' ');
+  dict += '\n';
+  *out_header = std::string(kNpyMagic, kNpyMagicLength);
+  *out_header += static_cast<char>(1);  // major version
+  *out_header += static_cast<char>(0);  // minor version
+  *out_header += static_cast<char>(header_length & 0xFF);
+  *out_header += static_cast<char>((header_length >> 8) & 0xFF);
+  *out_header += dict;
+  return OkStatus();
+}
+
+// iree_hal_string_sink_t write function appending chunks to a std::ostream.
+iree_status_t WriteToOstream(void* self, iree_string_view_t chunk) {
+  static_cast<std::ostream*>(self)->write(chunk.data, chunk.size);
+  return iree_ok_status();
+}
+
+}  // namespace
+
+Status WriteBufferViewToFile(iree_hal_buffer_view_t* buffer_view,
+                             const char* path) {
+  IREE_TRACE_SCOPE0("WriteBufferViewToFile");
+  std::string header;
+  if (iree_string_view_ends_with(iree_make_cstring_view(path),
+                                 IREE_SV(".npy"))) {
+    iree_host_size_t shape_rank = iree_hal_buffer_view_shape_rank(buffer_view);
+    std::vector<iree_hal_dim_t> shape(shape_rank);
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_view_shape(buffer_view, shape.size(),
+                                                    shape.data(), &shape_rank));
+    IREE_RETURN_IF_ERROR(MakeNpyHeader(
+        shape.data(), shape.size(),
+        iree_hal_buffer_view_element_type(buffer_view), &header));
+  }
+
+  // Write directly from the mapped buffer contents.
+  iree_hal_buffer_mapping_t mapping;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      iree_hal_buffer_view_buffer(buffer_view), IREE_HAL_MEMORY_ACCESS_READ, 0,
+      iree_hal_buffer_view_byte_length(buffer_view), &mapping));
+  iree_status_t status = iree_ok_status();
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to open file '%s'", path);
+  }
+  if (iree_status_is_ok(status) &&
+      (fwrite(header.data(), 1, header.size(), file) != header.size() ||
+       fwrite(mapping.contents.data, 1, mapping.contents.data_length, file) !=
+           mapping.contents.data_length)) {
+    status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "unable to write %zu bytes to '%s'",
+                              header.size() + mapping.contents.data_length,
+                              path);
+  }
+  if (file) fclose(file);
+  iree_hal_buffer_unmap_range(&mapping);
+  return status;
+}
+
 Status ParseToVariantList(iree_hal_allocator_t* allocator,
                           absl::Span<const absl::string_view> input_strings,
                           iree_vm_list_t** out_list) {
@@ -81,11 +410,27 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
   for (size_t i = 0; i < input_strings.size(); ++i) {
     iree_string_view_t input_view = iree_string_view_trim(iree_make_string_view(
         input_strings[i].data(), input_strings[i].size()));
+    iree_string_view_t shape_and_type = iree_string_view_empty();
+    iree_string_view_t file_path = iree_string_view_empty();
+    iree_string_view_split(input_view, '@', &shape_and_type, &file_path);
     bool has_equal =
         iree_string_view_find_char(input_view, '=', 0) != IREE_STRING_VIEW_NPOS;
     bool has_x =
         iree_string_view_find_char(input_view, 'x', 0) != IREE_STRING_VIEW_NPOS;
-    if (has_equal || has_x) {
+    if (!iree_string_view_is_empty(file_path)) {
+      // Buffer view loaded from a file (`@file.npy` or `[shape]xtype=@file`).
+      shape_and_type =
+          iree_string_view_strip_suffix(shape_and_type, IREE_SV("="));
+      iree_hal_buffer_view_t* buffer_view = nullptr;
+      IREE_RETURN_IF_ERROR(
+          LoadBufferViewFromFile(allocator, shape_and_type,
+                                 std::string(file_path.data, file_path.size),
+                                 &buffer_view),
+          "loading value '%.*s'", (int)input_view.size, input_view.data);
+      auto buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
+      IREE_RETURN_IF_ERROR(
+          iree_vm_list_push_ref_move(variant_list.get(), &buffer_view_ref));
+    } else if (has_equal || has_x) {
       // Buffer view (either just a shape or a shape=value).
       iree_hal_buffer_view_t* buffer_view = nullptr;
       IREE_RETURN_IF_ERROR(
@@ -134,13 +479,36 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
 }
 
 Status PrintVariantList(iree_vm_list_t* variant_list, std::ostream* os) {
+  return OutputVariantList(variant_list, {}, os);
+}
+
+Status OutputVariantList(iree_vm_list_t* variant_list,
+                         absl::Span<const std::string> output_strings,
+                         std::ostream* os) {
   for (iree_host_size_t i = 0; i < iree_vm_list_size(variant_list); ++i) {
     iree_vm_variant_t variant = iree_vm_variant_empty();
     IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(variant_list, i, &variant),
                          "variant %zu not present", i);
 
     *os << "result[" << i << "]: ";
-    if (iree_vm_variant_is_value(variant)) {
+    absl::string_view output_string;
+    if (i < output_strings.size()) output_string = output_strings[i];
+    if (!output_string.empty() && output_string[0] == '@') {
+      // Written to a file without formatting the contents.
+      if (!iree_vm_variant_is_ref(variant) ||
+          !iree_hal_buffer_view_isa(variant.ref)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "result %zu is not a buffer view and cannot "
+                                "be written to a file",
+                                i);
+      }
+      std::string path(output_string.substr(1));
+      IREE_RETURN_IF_ERROR(
+          WriteBufferViewToFile(iree_hal_buffer_view_deref(variant.ref),
+                                path.c_str()),
+          "writing result %zu", i);
+      *os << "hal.buffer_view written to '" << path << "'\n";
+    } else if (iree_vm_variant_is_value(variant)) {
       switch (variant.type.value_type) {
         case IREE_VM_VALUE_TYPE_I8:
           *os << "i8=" << variant.i8 << "\n";
@@ -170,17 +538,10 @@ Status PrintVariantList(iree_vm_list_t* variant_list, std::ostream* os) {
       *os << std::string(type_name.data, type_name.size) << "\n";
       if (iree_hal_buffer_view_isa(variant.ref)) {
         auto* buffer_view = iree_hal_buffer_view_deref(variant.ref);
-        std::string result_str(4096, '\0');
-        iree_status_t status;
-        do {
-          iree_host_size_t actual_length = 0;
-          status = iree_hal_buffer_view_format(
-              buffer_view, /*max_element_count=*/1024, result_str.size() + 1,
-              &result_str[0], &actual_length);
-          result_str.resize(actual_length);
-        } while (iree_status_is_out_of_range(status));
-        IREE_RETURN_IF_ERROR(status);
-        *os << result_str << "\n";
+        iree_hal_string_sink_t sink = {os, WriteToOstream};
+        IREE_RETURN_IF_ERROR(iree_hal_buffer_view_format_to_sink(
+            buffer_view, /*max_element_count=*/1024, sink));
+        *os << "\n";
       } else {
         // TODO(benvanik): a way for ref types to describe themselves.
         *os << "(no printer)\n";
@@ -193,6 +554,27 @@ Status PrintVariantList(iree_vm_list_t* variant_list, std::ostream* os) {
   return OkStatus();
 }
 
+Status WriteProfileToFile(
+    const std::string& path, const char* kind,
+    const std::function<iree_status_t(bool is_json, FILE* file)>& write_fn) {
+  bool is_json = iree_string_view_ends_with(
+      iree_make_string_view(path.data(), path.size()), IREE_SV(".json"));
+  if (path == "-") return write_fn(is_json, stdout);
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == NULL) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open %s profile output '%s'", kind,
+                            path.c_str());
+  }
+  iree_status_t status = write_fn(is_json, file);
+  if (fclose(file) != 0 && iree_status_is_ok(status)) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to write %s profile output '%s'", kind,
+                              path.c_str());
+  }
+  return status;
+}
+
 Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device) {
   IREE_LOG(INFO) << "Creating driver and device for '" << driver_name << "'...";
   iree_hal_driver_t* driver = nullptr;
@@ -210,8 +592,14 @@ Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device) {
 
 Status CreateHalModule(iree_hal_device_t* device,
                        iree_vm_module_t** out_module) {
+  return CreateHalModule(device, IREE_HAL_MODULE_FLAG_NONE, out_module);
+}
+
+Status CreateHalModule(iree_hal_device_t* device, iree_hal_module_flags_t flags,
+                       iree_vm_module_t** out_module) {
   IREE_RETURN_IF_ERROR(
-      iree_hal_module_create(device, iree_allocator_system(), out_module),
+      iree_hal_module_create_with_flags(device, flags, iree_allocator_system(),
+                                        out_module),
       "creating HAL module");
   return OkStatus();
 }
@@ -15,14 +15,18 @@
 #ifndef IREE_TOOLS_UTILS_VM_UTIL_H_
 #define IREE_TOOLS_UTILS_VM_UTIL_H_
 
+#include <cstdio>
+#include <functional>
 #include <iostream>
 #include <ostream>
+#include <string>
 #include <vector>
 
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "iree/base/status.h"
 #include "iree/hal/api.h"
+#include "iree/modules/hal/hal_module.h"
 #include "iree/vm/api.h"
 #include "iree/vm/ref_cc.h"
 
@@ -39,6 +43,11 @@ Status GetFileContents(const char* path, std::string* out_contents);
 // Buffers should be in the IREE standard shaped buffer format:
 //   [shape]xtype=[value]
 // described in iree/hal/api.h
+// Large buffers can instead be loaded from files without any text parsing:
+//   @path.npy           NumPy array file with the shape and type in its header
+//   [shape]xtype=@path  raw little-endian element data (such as a .bin file)
+// Files are mapped into memory and wrapped as buffers directly when
+// |allocator| can import host memory; otherwise their contents are copied.
 // Uses |allocator| to allocate the buffers.
 // Uses descriptors in |descs| for type information and validation.
 // The returned variant list must be freed by the caller.
@@ -60,6 +69,27 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
 Status PrintVariantList(iree_vm_list_t* variant_list,
                         std::ostream* os = &std::cout);
 
+// Prints a variant list as with PrintVariantList but writes each buffer view
+// result with a corresponding `@path` entry in |output_strings| to that file
+// with WriteBufferViewToFile instead of formatting it.
+Status OutputVariantList(iree_vm_list_t* variant_list,
+                         absl::Span<const std::string> output_strings,
+                         std::ostream* os = &std::cout);
+
+// Writes the contents of |buffer_view| to the file at |path| without
+// formatting them. Paths ending in `.npy` produce a NumPy array file and all
+// others receive the raw element data.
+Status WriteBufferViewToFile(iree_hal_buffer_view_t* buffer_view,
+                             const char* path);
+
+// Writes a profile summary to the file at |path|, or to stdout if |path| is
+// `-`, by calling |write_fn| with the opened file. |write_fn| receives true if
+// the path ends in `.json` and JSON should be written instead of CSV. |kind|
+// names the profile in errors.
+Status WriteProfileToFile(
+    const std::string& path, const char* kind,
+    const std::function<iree_status_t(bool is_json, FILE* file)>& write_fn);
+
 // Creates the default device for |driver| in |out_device|.
 // The returned |out_device| must be released by the caller.
 Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device);
@@ -69,6 +99,10 @@ Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device);
 Status CreateHalModule(iree_hal_device_t* device,
                        iree_vm_module_t** out_module);
 
+// Creates a hal module as above with the behavior customized by |flags|.
+Status CreateHalModule(iree_hal_device_t* device, iree_hal_module_flags_t flags,
+                       iree_vm_module_t** out_module);
+
 // Loads a VM bytecode from an opaque string.
 // The returned |out_module| must be released by the caller.
 Status LoadBytecodeModule(absl::string_view module_data,
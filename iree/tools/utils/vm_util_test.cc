@@ -14,10 +14,14 @@
 
 #include "iree/tools/utils/vm_util.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <sstream>
+#include <string>
 
 #include "absl/strings/str_cat.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
 #include "iree/hal/api.h"
 #include "iree/hal/vmla/registration/driver_module.h"
 #include "iree/modules/hal/hal_module.h"
@@ -28,6 +32,8 @@
 namespace iree {
 namespace {
 
+using ::iree::testing::status::StatusIs;
+
 class VmUtilTest : public ::testing::Test {
  protected:
   static void SetUpTestSuite() {
@@ -89,5 +95,109 @@ TEST_F(VmUtilTest, ParsePrintMultipleBuffers) {
                          "\nresult[1]: hal.buffer_view\n", buf_string2, "\n"));
 }
 
+std::string GetTempPath(const char* name) {
+  const char* test_tmpdir = getenv("TEST_TMPDIR");
+  if (!test_tmpdir) test_tmpdir = getenv("TMPDIR");
+  if (!test_tmpdir) test_tmpdir = "/tmp";
+  return std::string(test_tmpdir) + "/iree_vm_util_test_" + name;
+}
+
+void WriteFile(const std::string& path, const std::string& contents) {
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(contents.data(), contents.size())));
+}
+
+TEST_F(VmUtilTest, ParseRawBinaryFile) {
+  auto path = GetTempPath("raw.bin");
+  int32_t data[4] = {42, 43, 44, 45};
+  WriteFile(path, std::string(reinterpret_cast<const char*>(data),
+                              sizeof(data)));
+  std::string input_string = "2x2xi32=@" + path;
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, {absl::string_view(input_string)}, &variant_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(variant_list.get(), &os));
+  EXPECT_EQ(os.str(), "result[0]: hal.buffer_view\n2x2xi32=[42 43][44 45]\n");
+  remove(path.c_str());
+}
+
+TEST_F(VmUtilTest, ParseRawBinaryFileSizeMismatch) {
+  auto path = GetTempPath("short.bin");
+  int32_t data[3] = {42, 43, 44};
+  WriteFile(path, std::string(reinterpret_cast<const char*>(data),
+                              sizeof(data)));
+  std::string input_string = "2x2xi32=@" + path;
+  vm::ref<iree_vm_list_t> variant_list;
+  EXPECT_THAT(Status(ParseToVariantList(
+                  allocator_, {absl::string_view(input_string)},
+                  &variant_list)),
+              StatusIs(StatusCode::kInvalidArgument));
+  remove(path.c_str());
+}
+
+TEST_F(VmUtilTest, ParseRawBinaryFileShapeOverflow) {
+  // The byte length of the shape wraps around to exactly the 4 bytes of data
+  // in the file on hosts with a 64-bit size_t.
+  auto path = GetTempPath("overflow.bin");
+  WriteFile(path, std::string(4, '\0'));
+  std::string input_string = "2147418113x1718039348x5xi8=@" + path;
+  vm::ref<iree_vm_list_t> variant_list;
+  EXPECT_THAT(Status(ParseToVariantList(
+                  allocator_, {absl::string_view(input_string)},
+                  &variant_list)),
+              StatusIs(StatusCode::kInvalidArgument));
+  remove(path.c_str());
+}
+
+TEST_F(VmUtilTest, ParseNpyFile) {
+  // Header produced by numpy.save for np.array([[1.5, 2], [3, 4]], 'f4').
+  std::string header =
+      "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 2), }";
+  header.resize(128 - 10 - 1, ' ');
+  header += '\n';
+  std::string contents = std::string("\x93NUMPY\x01\x00", 8);
+  contents += static_cast<char>(header.size());
+  contents += '\0';
+  contents += header;
+  float data[4] = {1.5f, 2.0f, 3.0f, 4.0f};
+  contents.append(reinterpret_cast<const char*>(data), sizeof(data));
+  auto path = GetTempPath("input.npy");
+  WriteFile(path, contents);
+
+  std::string input_string = "@" + path;
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, {absl::string_view(input_string)}, &variant_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(variant_list.get(), &os));
+  EXPECT_EQ(os.str(), "result[0]: hal.buffer_view\n2x2xf32=[1.5 2][3 4]\n");
+  remove(path.c_str());
+}
+
+TEST_F(VmUtilTest, WriteAndParseNpyFile) {
+  absl::string_view buf_string = "2x3xi16=[1 2 3][4 5 6]";
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(allocator_, {buf_string}, &variant_list));
+
+  auto path = GetTempPath("output.npy");
+  std::stringstream output_os;
+  IREE_ASSERT_OK(
+      OutputVariantList(variant_list.get(), {"@" + path}, &output_os));
+  EXPECT_EQ(output_os.str(),
+            "result[0]: hal.buffer_view written to '" + path + "'\n");
+
+  std::string input_string = "@" + path;
+  vm::ref<iree_vm_list_t> reparsed_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, {absl::string_view(input_string)}, &reparsed_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(reparsed_list.get(), &os));
+  EXPECT_EQ(os.str(),
+            absl::StrCat("result[0]: hal.buffer_view\n", buf_string, "\n"));
+  remove(path.c_str());
+}
+
 }  // namespace
 }  // namespace iree
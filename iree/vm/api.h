@@ -27,6 +27,7 @@
 #include "iree/vm/ref.h"
 #include "iree/vm/shims.h"
 #include "iree/vm/stack.h"
+#include "iree/vm/startup_profiler.h"
 #include "iree/vm/type_def.h"
 #include "iree/vm/value.h"
 
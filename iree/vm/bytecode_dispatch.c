@@ -173,9 +173,32 @@ static iree_status_t iree_vm_bytecode_function_enter(
   *out_callee_registers =
       iree_vm_bytecode_get_register_storage(*out_callee_frame);
 
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  iree_vm_bytecode_module_state_t* module_state =
+      (iree_vm_bytecode_module_state_t*)(*out_callee_frame)->module_state;
+  ++module_state->function_counter_table[function.ordinal].call_count;
+  stack_storage->entry_time_ns = iree_time_now();
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
   return iree_ok_status();
 }
 
+// Leaves the current bytecode stack frame |callee_frame| and deallocates its
+// storage.
+static iree_status_t iree_vm_bytecode_function_leave(
+    iree_vm_stack_t* stack, iree_vm_stack_frame_t* callee_frame) {
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  const iree_vm_bytecode_frame_storage_t* stack_storage =
+      (iree_vm_bytecode_frame_storage_t*)iree_vm_stack_frame_storage(
+          callee_frame);
+  iree_vm_bytecode_module_state_t* module_state =
+      (iree_vm_bytecode_module_state_t*)callee_frame->module_state;
+  module_state->function_counter_table[callee_frame->function.ordinal]
+      .inclusive_time_ns += iree_time_now() - stack_storage->entry_time_ns;
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+  return iree_vm_stack_function_leave(stack);
+}
+
 // Enters an internal bytecode stack frame from an external caller.
 // A new |out_callee_frame| will be pushed to the stack with storage space for
 // the registers used by the function and |arguments| will be marshaled into the
@@ -270,7 +293,7 @@ static iree_status_t iree_vm_bytecode_external_leave(
   }
 
   // Leave and deallocate bytecode stack frame.
-  return iree_vm_stack_function_leave(stack);
+  return iree_vm_bytecode_function_leave(stack, callee_frame);
 }
 
 // Enters an internal bytecode stack frame from a parent bytecode frame.
@@ -373,7 +396,7 @@ static iree_status_t iree_vm_bytecode_internal_leave(
 
   // Leave and deallocate bytecode stack frame.
   *out_caller_registers = caller_registers;
-  return iree_vm_stack_function_leave(stack);
+  return iree_vm_bytecode_function_leave(stack, callee_frame);
 }
 
 // Populates an import call arguments
@@ -466,17 +489,54 @@ static void iree_vm_bytecode_populate_import_cconv_arguments(
   }
 }
 
+// Resolves the callee module state and direct call target of |import| and
+// caches them in the import table so that subsequent calls can skip the
+// context state lookup and generic begin_call dispatch.
+static iree_status_t iree_vm_bytecode_resolve_import_call_target(
+    iree_vm_stack_t* stack, iree_vm_bytecode_import_t* import) {
+  iree_vm_module_t* module = import->function.module;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_stack_query_module_state(stack, module, &import->module_state));
+  memset(&import->call_target, 0, sizeof(import->call_target));
+  if (module->resolve_call_target) {
+    iree_status_t status = module->resolve_call_target(
+        module->self, &import->function, &import->call_target);
+    if (iree_status_is_unavailable(status)) {
+      // Module requires the call to go through begin_call.
+      iree_status_ignore(status);
+      memset(&import->call_target, 0, sizeof(import->call_target));
+    } else {
+      IREE_RETURN_IF_ERROR(status);
+    }
+  }
+  import->is_call_target_resolved = true;
+  return iree_ok_status();
+}
+
 // Issues a populated import call and marshals the results into |dst_reg_list|.
 static iree_status_t iree_vm_bytecode_issue_import_call(
-    iree_vm_stack_t* stack, const iree_vm_function_call_t call,
-    iree_string_view_t cconv_results,
+    iree_vm_stack_t* stack, iree_vm_bytecode_import_t* import,
+    const iree_vm_function_call_t call, iree_string_view_t cconv_results,
     const iree_vm_register_list_t* IREE_RESTRICT dst_reg_list,
     iree_vm_stack_frame_t** out_caller_frame,
     iree_vm_registers_t* out_caller_registers,
     iree_vm_execution_result_t* out_result) {
-  // Call external function.
-  iree_status_t call_status = call.function.module->begin_call(
-      call.function.module->self, stack, &call, out_result);
+  if (IREE_UNLIKELY(!import->is_call_target_resolved)) {
+    IREE_RETURN_IF_ERROR(
+        iree_vm_bytecode_resolve_import_call_target(stack, import));
+  }
+
+  // Call external function; directly if the callee provided a call target and
+  // otherwise through the generic module interface.
+  iree_status_t call_status;
+  if (IREE_LIKELY(import->call_target.fn)) {
+    call_status = import->call_target.fn(
+        import->call_target.self, import->call_target.target, stack,
+        import->module_state, &call, out_result);
+  } else {
+    call_status = call.function.module->begin_call(
+        call.function.module->self, stack, &call, out_result);
+  }
   if (IREE_UNLIKELY(!iree_status_is_ok(call_status))) {
     // TODO(benvanik): set execution result to failure/capture stack.
     return iree_status_annotate(call_status,
@@ -541,7 +601,7 @@ static iree_status_t iree_vm_bytecode_call_import(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "import ordinal out of range");
   }
-  const iree_vm_bytecode_import_t* import =
+  iree_vm_bytecode_import_t* import =
       &module_state->import_table[import_ordinal];
   iree_vm_function_call_t call;
   memset(&call, 0, sizeof(call));
@@ -560,9 +620,9 @@ static iree_status_t iree_vm_bytecode_call_import(
   call.results.data_length = import->result_buffer_size;
   call.results.data = iree_alloca(call.results.data_length);
   memset(call.results.data, 0, call.results.data_length);
-  return iree_vm_bytecode_issue_import_call(stack, call, import->results,
-                                            dst_reg_list, out_caller_frame,
-                                            out_caller_registers, out_result);
+  return iree_vm_bytecode_issue_import_call(
+      stack, import, call, import->results, dst_reg_list, out_caller_frame,
+      out_caller_registers, out_result);
 }
 
 // Calls a variadic imported function from another module.
@@ -583,7 +643,7 @@ static iree_status_t iree_vm_bytecode_call_import_variadic(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "import ordinal out of range");
   }
-  const iree_vm_bytecode_import_t* import =
+  iree_vm_bytecode_import_t* import =
       &module_state->import_table[import_ordinal];
   iree_vm_function_call_t call;
   memset(&call, 0, sizeof(call));
@@ -606,9 +666,9 @@ static iree_status_t iree_vm_bytecode_call_import_variadic(
   call.results.data_length = import->result_buffer_size;
   call.results.data = iree_alloca(call.results.data_length);
   memset(call.results.data, 0, call.results.data_length);
-  return iree_vm_bytecode_issue_import_call(stack, call, import->results,
-                                            dst_reg_list, out_caller_frame,
-                                            out_caller_registers, out_result);
+  return iree_vm_bytecode_issue_import_call(
+      stack, import, call, import->results, dst_reg_list, out_caller_frame,
+      out_caller_registers, out_result);
 }
 
 //===----------------------------------------------------------------------===//
@@ -649,6 +709,10 @@ iree_status_t iree_vm_bytecode_dispatch(
           .bytecode_offset;
   iree_vm_source_offset_t pc = current_frame->pc;
   const int32_t entry_frame_depth = current_frame->depth;
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  iree_vm_bytecode_function_counters_t* current_counters = NULL;
+  IREE_DISPATCH_PROFILE_FRAME_CHANGED();
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
 
   BEGIN_DISPATCH_CORE() {
     //===------------------------------------------------------------------===//
@@ -746,7 +810,7 @@ iree_status_t iree_vm_bytecode_dispatch(
     });
 
     DISPATCH_OP(CORE, GlobalLoadIndirectRef, {
-      uint32_t global = VM_DecGlobalAttr("global");
+      uint32_t global = VM_DecOperandRegI32("global");
       if (IREE_UNLIKELY(global >= module_state->global_ref_count)) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
@@ -762,7 +826,7 @@ iree_status_t iree_vm_bytecode_dispatch(
     });
 
     DISPATCH_OP(CORE, GlobalStoreIndirectRef, {
-      uint32_t global = VM_DecGlobalAttr("global");
+      uint32_t global = VM_DecOperandRegI32("global");
       if (IREE_UNLIKELY(global >= module_state->global_ref_count)) {
         return iree_make_status(
             IREE_STATUS_OUT_OF_RANGE,
@@ -1417,6 +1481,7 @@ iree_status_t iree_vm_bytecode_dispatch(
             module->bytecode_data.data +
             module->function_descriptor_table[function_ordinal].bytecode_offset;
         pc = current_frame->pc;
+        IREE_DISPATCH_PROFILE_FRAME_CHANGED();
       }
     });
 
@@ -1470,6 +1535,7 @@ iree_status_t iree_vm_bytecode_dispatch(
           module->function_descriptor_table[current_frame->function.ordinal]
               .bytecode_offset;
       pc = current_frame->pc;
+      IREE_DISPATCH_PROFILE_FRAME_CHANGED();
     });
 
     DISPATCH_OP(CORE, Fail, {
@@ -30,16 +30,23 @@
 //
 // Register bounds checking
 // ------------------------
-// All accesses into the register lists are truncated to the valid range for the
-// typed bank. This allows us to directly use the register ordinals from the
-// bytecode without needing to perform any validation at load-time or run-time.
-// The worst that can happen is that the bytecode program being executed doesn't
-// work as intended - which, with a working compiler, shouldn't happen. Though
-// there are cases where the runtime produces the register values and may know
-// that they are in range it's a good habit to always mask the ordinal by the
-// type-specific mask so that it's not possible for out of bounds accesses to
-// sneak in. The iree_vm_registers_t struct is often kept in cache and the
-// masking is cheap relative to any other validation we could be performing.
+// When IREE_VM_BYTECODE_VERIFICATION_ENABLE is set all bytecode is verified at
+// module load time (see bytecode_verifier.c): every register operand decoded by
+// the VM_Dec* macros below is known to be within the function register counts,
+// in the bank matching its use, and naturally aligned for 64-bit values. The
+// ordinals can then be used directly without any per-operand work.
+//
+// Without verification all accesses into the register lists are truncated to
+// the valid range for the typed bank. This allows us to directly use the
+// register ordinals from the bytecode without needing to perform any validation
+// at load-time or run-time. The worst that can happen is that the bytecode
+// program being executed doesn't work as intended - which, with a working
+// compiler, shouldn't happen. The iree_vm_registers_t struct is often kept in
+// cache and the masking is cheap relative to any other validation we could be
+// performing.
+//
+// Register lists (call arguments, branch remapping, etc) do not carry the width
+// of the primitive values they reference and are always masked.
 //
 // Alternative register widths
 // ---------------------------
@@ -98,6 +105,11 @@ typedef struct {
   // Relative byte offsets from the head of this struct.
   iree_host_size_t i32_register_offset;
   iree_host_size_t ref_register_offset;
+
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  // Time the frame was entered; used to accumulate inclusive function time.
+  iree_time_t entry_time_ns;
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
 } iree_vm_bytecode_frame_storage_t;
 
 // Interleaved src-dst register sets for branch register remapping.
@@ -141,6 +153,19 @@ static inline const iree_vm_type_def_t* iree_vm_map_type(
 #define IREE_DISPATCH_LOG_CALL(...)
 #endif  // IREE_DISPATCH_LOGGING
 
+// Execution profiling counts each dispatched op against the function of the
+// active frame. |current_counters| must be refreshed whenever the active frame
+// changes within the dispatch loop.
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+#define IREE_DISPATCH_PROFILE_OP() ++current_counters->op_count
+#define IREE_DISPATCH_PROFILE_FRAME_CHANGED() \
+  current_counters =                          \
+      &module_state->function_counter_table[current_frame->function.ordinal]
+#else
+#define IREE_DISPATCH_PROFILE_OP()
+#define IREE_DISPATCH_PROFILE_FRAME_CHANGED()
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
 #if defined(IREE_COMPILER_MSVC) && !defined(IREE_COMPILER_CLANG)
 #define IREE_DISPATCH_MODE_SWITCH 1
 #else
@@ -236,6 +261,42 @@ static const int kRegSize = sizeof(uint16_t);
   pc +=                                                                       \
       kRegSize + ((const iree_vm_register_list_t*)&bytecode_data[pc])->size * \
                      2 * kRegSize;
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+// Register ordinals were verified at load time and need no masking; ref
+// ordinals only need their type and move bits stripped.
+#define VM_DecOperandRegI32(name) \
+  regs.i32[OP_I16(0)];            \
+  pc += kRegSize;
+#define VM_DecOperandRegI64(name)    \
+  *((int64_t*)&regs.i32[OP_I16(0)]); \
+  pc += kRegSize;
+#define VM_DecOperandRegF32(name)  \
+  *((float*)&regs.i32[OP_I16(0)]); \
+  pc += kRegSize;
+#define VM_DecOperandRegF64(name)   \
+  *((double*)&regs.i32[OP_I16(0)]); \
+  pc += kRegSize;
+#define VM_DecOperandRegRef(name, out_is_move)             \
+  &regs.ref[OP_I16(0) & IREE_REF_REGISTER_MASK];           \
+  *(out_is_move) = OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT; \
+  pc += kRegSize;
+#define VM_DecResultRegI32(name) \
+  &regs.i32[OP_I16(0)];          \
+  pc += kRegSize;
+#define VM_DecResultRegI64(name)    \
+  ((int64_t*)&regs.i32[OP_I16(0)]); \
+  pc += kRegSize;
+#define VM_DecResultRegF32(name)  \
+  ((float*)&regs.i32[OP_I16(0)]); \
+  pc += kRegSize;
+#define VM_DecResultRegF64(name)   \
+  ((double*)&regs.i32[OP_I16(0)]); \
+  pc += kRegSize;
+#define VM_DecResultRegRef(name, out_is_move)              \
+  &regs.ref[OP_I16(0) & IREE_REF_REGISTER_MASK];           \
+  *(out_is_move) = OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT; \
+  pc += kRegSize;
+#else
 #define VM_DecOperandRegI32(name)      \
   regs.i32[OP_I16(0) & regs.i32_mask]; \
   pc += kRegSize;
@@ -252,10 +313,6 @@ static const int kRegSize = sizeof(uint16_t);
   &regs.ref[OP_I16(0) & regs.ref_mask];                    \
   *(out_is_move) = OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT; \
   pc += kRegSize;
-#define VM_DecVariadicOperands(name)                  \
-  (const iree_vm_register_list_t*)&bytecode_data[pc]; \
-  pc += kRegSize +                                    \
-        ((const iree_vm_register_list_t*)&bytecode_data[pc])->size * kRegSize;
 #define VM_DecResultRegI32(name)        \
   &regs.i32[OP_I16(0) & regs.i32_mask]; \
   pc += kRegSize;
@@ -272,6 +329,11 @@ static const int kRegSize = sizeof(uint16_t);
   &regs.ref[OP_I16(0) & regs.ref_mask];                    \
   *(out_is_move) = OP_I16(0) & IREE_REF_REGISTER_MOVE_BIT; \
   pc += kRegSize;
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+#define VM_DecVariadicOperands(name)                  \
+  (const iree_vm_register_list_t*)&bytecode_data[pc]; \
+  pc += kRegSize +                                    \
+        ((const iree_vm_register_list_t*)&bytecode_data[pc])->size * kRegSize;
 #define VM_DecVariadicResults(name) VM_DecVariadicOperands(name)
 
 //===----------------------------------------------------------------------===//
@@ -349,6 +411,7 @@ static const int kRegSize = sizeof(uint16_t);
 
 #define DISPATCH_OP(ext, op_name, body)                             \
   _dispatch_##ext##_##op_name : IREE_DISPATCH_LOG_OPCODE(#op_name); \
+  IREE_DISPATCH_PROFILE_OP();                                       \
   body;                                                             \
   goto* kDispatchTable_CORE[bytecode_data[pc++]];
 
@@ -385,6 +448,7 @@ static const int kRegSize = sizeof(uint16_t);
 #define DISPATCH_OP(ext, op_name, body) \
   case IREE_VM_OP_##ext##_##op_name: {  \
     IREE_DISPATCH_LOG_OPCODE(#op_name); \
+    IREE_DISPATCH_PROFILE_OP();         \
     body;                               \
   } break;
 
@@ -14,6 +14,8 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <inttypes.h>
+
 #include "iree/base/alignment.h"
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
@@ -236,14 +238,14 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
           i, function_descriptor->bytecode_offset,
           flatbuffers_uint8_vec_len(bytecode_data));
     }
-    if (function_descriptor->i32_register_count > IREE_I32_REGISTER_COUNT ||
+    if (function_descriptor->i32_register_count < 0 ||
+        function_descriptor->i32_register_count > IREE_I32_REGISTER_COUNT ||
+        function_descriptor->ref_register_count < 0 ||
         function_descriptor->ref_register_count > IREE_REF_REGISTER_COUNT) {
       return iree_make_status(
           IREE_STATUS_INVALID_ARGUMENT,
           "functions[%zu] descriptor register count out of range", i);
     }
-
-    // TODO(benvanik): run bytecode verifier on contents.
   }
 
   return iree_ok_status();
@@ -520,6 +522,12 @@ static iree_host_size_t iree_vm_bytecode_module_layout_state(
       iree_vm_BytecodeModuleDef_rodata_segments(module_def));
   iree_host_size_t import_function_count = iree_vm_ImportFunctionDef_vec_len(
       iree_vm_BytecodeModuleDef_imported_functions(module_def));
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  iree_host_size_t function_counter_count = iree_vm_FunctionDescriptor_vec_len(
+      iree_vm_BytecodeModuleDef_function_descriptors(module_def));
+#else
+  iree_host_size_t function_counter_count = 0;
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
 
   uint8_t* base_ptr = (uint8_t*)state;
   iree_host_size_t offset =
@@ -550,6 +558,14 @@ static iree_host_size_t iree_vm_bytecode_module_layout_state(
   offset +=
       iree_host_align(import_function_count * sizeof(*state->import_table), 16);
 
+  if (state) {
+    state->function_counter_count = function_counter_count;
+    state->function_counter_table =
+        (iree_vm_bytecode_function_counters_t*)(base_ptr + offset);
+  }
+  offset += iree_host_align(
+      function_counter_count * sizeof(*state->function_counter_table), 16);
+
   return offset;
 }
 
@@ -637,6 +653,12 @@ static iree_status_t iree_vm_bytecode_module_resolve_import(
   iree_vm_bytecode_import_t* import = &state->import_table[ordinal];
   import->function = *function;
 
+  // The call target is resolved lazily on first call; see
+  // iree_vm_bytecode_issue_import_call.
+  import->is_call_target_resolved = false;
+  import->module_state = NULL;
+  memset(&import->call_target, 0, sizeof(import->call_target));
+
   // Split up arguments/results into fragments so that we can avoid scanning
   // during calling.
   IREE_RETURN_IF_ERROR(iree_vm_function_call_get_cconv_fragments(
@@ -797,6 +819,15 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     return resolve_status;
   }
 
+  IREE_TRACE_ZONE_BEGIN_NAMED(z2, "iree_vm_bytecode_module_verify");
+  iree_status_t verify_status = iree_vm_bytecode_module_verify(module);
+  IREE_TRACE_ZONE_END(z2);
+  if (!iree_status_is_ok(verify_status)) {
+    iree_allocator_free(allocator, module);
+    IREE_TRACE_ZONE_END(z0);
+    return verify_status;
+  }
+
   iree_vm_module_initialize(&module->interface, module);
   module->interface.destroy = iree_vm_bytecode_module_destroy;
   module->interface.name = iree_vm_bytecode_module_name;
@@ -814,3 +845,172 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
+
+//===----------------------------------------------------------------------===//
+// Execution profiling
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_query_profile(
+    iree_vm_module_t* module, const iree_vm_context_t* context,
+    iree_host_size_t profile_capacity,
+    iree_vm_bytecode_function_profile_t* out_profiles,
+    iree_host_size_t* out_profile_count) {
+  IREE_ASSERT_ARGUMENT(module);
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_profile_count);
+  *out_profile_count = 0;
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  if (module->destroy != iree_vm_bytecode_module_destroy) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "module is not a bytecode module");
+  }
+  iree_vm_module_state_t* module_state = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_context_resolve_module_state(context, module, &module_state));
+  const iree_vm_bytecode_module_state_t* state =
+      (const iree_vm_bytecode_module_state_t*)module_state;
+
+  *out_profile_count = state->function_counter_count;
+  if (profile_capacity < state->function_counter_count) {
+    // Not an error; just a size query.
+    return iree_status_from_code(IREE_STATUS_OUT_OF_RANGE);
+  }
+  for (iree_host_size_t i = 0; i < state->function_counter_count; ++i) {
+    const iree_vm_bytecode_function_counters_t* counters =
+        &state->function_counter_table[i];
+    iree_vm_bytecode_function_profile_t* profile = &out_profiles[i];
+    profile->function.module = module;
+    profile->function.linkage = IREE_VM_FUNCTION_LINKAGE_INTERNAL;
+    profile->function.ordinal = (uint16_t)i;
+    profile->call_count = counters->call_count;
+    profile->op_count = counters->op_count;
+    profile->inclusive_time_ns = counters->inclusive_time_ns;
+  }
+  return iree_ok_status();
+#else
+  return iree_make_status(
+      IREE_STATUS_UNAVAILABLE,
+      "execution profiling not available; build with "
+      "IREE_VM_EXECUTION_PROFILING_ENABLE=1");
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+}
+
+IREE_API_EXPORT iree_status_t
+iree_vm_bytecode_module_reset_profile(const iree_vm_context_t* context) {
+  IREE_ASSERT_ARGUMENT(context);
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  for (iree_host_size_t i = 0; i < iree_vm_context_module_count(context);
+       ++i) {
+    iree_vm_module_t* module = iree_vm_context_module_at(context, i);
+    if (module->destroy != iree_vm_bytecode_module_destroy) continue;
+    iree_vm_module_state_t* module_state = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_context_resolve_module_state(context, module, &module_state));
+    iree_vm_bytecode_module_state_t* state =
+        (iree_vm_bytecode_module_state_t*)module_state;
+    memset(state->function_counter_table, 0,
+           state->function_counter_count *
+               sizeof(*state->function_counter_table));
+  }
+  return iree_ok_status();
+#else
+  return iree_make_status(
+      IREE_STATUS_UNAVAILABLE,
+      "execution profiling not available; build with "
+      "IREE_VM_EXECUTION_PROFILING_ENABLE=1");
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+}
+
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+// Orders profiles by descending inclusive time and then descending op count.
+static int iree_vm_bytecode_function_profile_compare(const void* lhs_ptr,
+                                                     const void* rhs_ptr) {
+  const iree_vm_bytecode_function_profile_t* lhs =
+      (const iree_vm_bytecode_function_profile_t*)lhs_ptr;
+  const iree_vm_bytecode_function_profile_t* rhs =
+      (const iree_vm_bytecode_function_profile_t*)rhs_ptr;
+  if (lhs->inclusive_time_ns != rhs->inclusive_time_ns) {
+    return lhs->inclusive_time_ns < rhs->inclusive_time_ns ? 1 : -1;
+  }
+  if (lhs->op_count != rhs->op_count) {
+    return lhs->op_count < rhs->op_count ? 1 : -1;
+  }
+  return 0;
+}
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_fprint_profile(
+    FILE* file, const iree_vm_context_t* context,
+    iree_allocator_t host_allocator) {
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_ASSERT_ARGUMENT(context);
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Gather the profiles of all bytecode modules into a single list so that the
+  // hottest functions across the whole context come first.
+  iree_host_size_t total_count = 0;
+  for (iree_host_size_t i = 0; i < iree_vm_context_module_count(context);
+       ++i) {
+    iree_vm_module_t* module = iree_vm_context_module_at(context, i);
+    if (module->destroy != iree_vm_bytecode_module_destroy) continue;
+    total_count += ((iree_vm_bytecode_module_t*)module->self)
+                       ->function_descriptor_count;
+  }
+  iree_vm_bytecode_function_profile_t* profiles = NULL;
+  if (total_count > 0) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_allocator_malloc(host_allocator,
+                                  total_count * sizeof(*profiles),
+                                  (void**)&profiles));
+  }
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t profile_count = 0;
+  for (iree_host_size_t i = 0; i < iree_vm_context_module_count(context) &&
+                               iree_status_is_ok(status);
+       ++i) {
+    iree_vm_module_t* module = iree_vm_context_module_at(context, i);
+    if (module->destroy != iree_vm_bytecode_module_destroy) continue;
+    iree_host_size_t module_profile_count = 0;
+    status = iree_vm_bytecode_module_query_profile(
+        module, context, total_count - profile_count, profiles + profile_count,
+        &module_profile_count);
+    profile_count += module_profile_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    qsort(profiles, profile_count, sizeof(*profiles),
+          iree_vm_bytecode_function_profile_compare);
+    fprintf(file, "{\"functions\": [");
+    bool is_first = true;
+    for (iree_host_size_t i = 0; i < profile_count; ++i) {
+      const iree_vm_bytecode_function_profile_t* profile = &profiles[i];
+      if (!profile->call_count) continue;
+      iree_string_view_t module_name =
+          iree_vm_module_name(profile->function.module);
+      iree_string_view_t function_name =
+          iree_vm_function_name(&profile->function);
+      fprintf(file,
+              "%s\n  {\"module\": \"%.*s\", \"function\": \"%.*s\", "
+              "\"ordinal\": %u, \"call_count\": %" PRIu64
+              ", \"op_count\": %" PRIu64 ", \"inclusive_time_ns\": %" PRId64
+              "}",
+              is_first ? "" : ",", (int)module_name.size, module_name.data,
+              (int)function_name.size, function_name.data,
+              (unsigned)profile->function.ordinal, profile->call_count,
+              profile->op_count, (int64_t)profile->inclusive_time_ns);
+      is_first = false;
+    }
+    fprintf(file, "%s]}\n", is_first ? "" : "\n");
+  }
+
+  iree_allocator_free(host_allocator, profiles);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+#else
+  return iree_make_status(
+      IREE_STATUS_UNAVAILABLE,
+      "execution profiling not available; build with "
+      "IREE_VM_EXECUTION_PROFILING_ENABLE=1");
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+}
@@ -33,6 +33,53 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
     iree_vm_module_t** out_module);
 
+//===----------------------------------------------------------------------===//
+// Execution profiling
+//===----------------------------------------------------------------------===//
+
+// Execution counters of a single bytecode function accumulated within a
+// context. Requires IREE_VM_EXECUTION_PROFILING_ENABLE.
+typedef struct {
+  // Internal function the counters are attributed to.
+  iree_vm_function_t function;
+  // Total number of times the function was entered.
+  uint64_t call_count;
+  // Total number of ops executed by the function itself (excluding callees).
+  uint64_t op_count;
+  // Total wall time spent in the function including time spent in callees.
+  iree_time_t inclusive_time_ns;
+} iree_vm_bytecode_function_profile_t;
+
+// Queries the execution profile of every internal function of the bytecode
+// |module| as registered in |context|.
+//
+// |profile_capacity| defines the number of elements available in
+// |out_profiles| and |out_profile_count| will be set to the number of internal
+// functions in the module. Returns IREE_STATUS_OUT_OF_RANGE if the capacity is
+// insufficient to hold all functions. Returns IREE_STATUS_UNAVAILABLE if the
+// runtime was built without IREE_VM_EXECUTION_PROFILING_ENABLE.
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_query_profile(
+    iree_vm_module_t* module, const iree_vm_context_t* context,
+    iree_host_size_t profile_capacity,
+    iree_vm_bytecode_function_profile_t* out_profiles,
+    iree_host_size_t* out_profile_count);
+
+// Resets the execution profile of all bytecode modules in |context|.
+// Non-bytecode modules are ignored.
+IREE_API_EXPORT iree_status_t
+iree_vm_bytecode_module_reset_profile(const iree_vm_context_t* context);
+
+// Prints the execution profile of all bytecode modules in |context| as JSON.
+// Functions that were called at least once are listed in order of descending
+// inclusive time:
+//   {"functions": [{"module": "module", "function": "main", "ordinal": 0,
+//                   "call_count": 1, "op_count": 42,
+//                   "inclusive_time_ns": 1234}, ...]}
+// |host_allocator| is used for temporary storage while sorting.
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_fprint_profile(
+    FILE* file, const iree_vm_context_t* context,
+    iree_allocator_t host_allocator);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
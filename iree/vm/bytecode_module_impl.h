@@ -98,8 +98,29 @@ typedef struct {
   // don't support variadic values (yet).
   uint16_t argument_buffer_size;
   uint16_t result_buffer_size;
+
+  // Inline cache of the callee module state and direct call target populated
+  // on the first call through the import. The callee state can only be
+  // resolved through the stack of the calling context and is stable for the
+  // lifetime of the module state that owns this import table.
+  bool is_call_target_resolved;
+  iree_vm_module_state_t* module_state;
+  iree_vm_function_call_target_t call_target;
 } iree_vm_bytecode_import_t;
 
+// Execution counters for a single internal function within a module state.
+// Only populated when IREE_VM_EXECUTION_PROFILING_ENABLE is set.
+typedef struct {
+  // Total number of times the function was entered.
+  uint64_t call_count;
+  // Total number of ops dispatched while the function was the active frame.
+  // Ops executed in callees are attributed to the callees.
+  uint64_t op_count;
+  // Total wall time between entering and leaving the function, including time
+  // spent in callees. Recursive calls are counted once per frame.
+  iree_time_t inclusive_time_ns;
+} iree_vm_bytecode_function_counters_t;
+
 // Per-instance module state.
 // This is allocated with a provided allocator as a single flat allocation.
 // This struct is a prefix to the allocation pointing into the dynamic offsets
@@ -124,10 +145,23 @@ typedef struct {
   iree_host_size_t import_count;
   iree_vm_bytecode_import_t* import_table;
 
+  // Per-function execution counters, indexed by internal function ordinal.
+  // Empty unless IREE_VM_EXECUTION_PROFILING_ENABLE is set.
+  iree_host_size_t function_counter_count;
+  iree_vm_bytecode_function_counters_t* function_counter_table;
+
   // Allocator used for the state itself and any runtime allocations needed.
   iree_allocator_t allocator;
 } iree_vm_bytecode_module_state_t;
 
+// Verifies the bytecode of all internal functions in |module|.
+// Every instruction must decode within its function, reference registers within
+// the function register counts in the bank matching their use, reference
+// types/globals/rodata/functions within the module tables, and branch to
+// instruction boundaries. The dispatcher relies on this to elide register
+// bounds masking when IREE_VM_BYTECODE_VERIFICATION_ENABLE is set.
+iree_status_t iree_vm_bytecode_module_verify(iree_vm_bytecode_module_t* module);
+
 // Begins (or resumes) execution of the current frame and continues until
 // either a yield or return. |out_result| will contain the result status for
 // continuation, if needed.
@@ -18,10 +18,181 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/schemas/bytecode_module_def_reader.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+// Compiled modules embedded here to avoid file IO:
+#include "iree/vm/test/all_bytecode_modules.h"
 
 namespace {
 
 // TODO(benvanik): bytecode_module_test.cc for flatbuffer/module implementation.
 
+class VMBytecodeModuleVerifierTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    IREE_CHECK_OK(iree_vm_register_builtin_types());
+  }
+
+  // Returns a mutable copy of the first embedded test module.
+  static std::vector<uint8_t> CopyTestModule() {
+    const struct iree_file_toc_t* module_file_toc =
+        all_bytecode_modules_c_create();
+    const auto& module_file = module_file_toc[0];
+    return std::vector<uint8_t>(
+        reinterpret_cast<const uint8_t*>(module_file.data),
+        reinterpret_cast<const uint8_t*>(module_file.data) + module_file.size);
+  }
+
+  // Returns the mutable function descriptor for |ordinal| in |data|.
+  static iree_vm_FunctionDescriptor_t* GetFunctionDescriptor(
+      std::vector<uint8_t>& data, size_t ordinal) {
+    iree_vm_BytecodeModuleDef_table_t module_def =
+        iree_vm_BytecodeModuleDef_as_root(data.data());
+    return const_cast<iree_vm_FunctionDescriptor_t*>(
+        iree_vm_FunctionDescriptor_vec_at(
+            iree_vm_BytecodeModuleDef_function_descriptors(module_def),
+            ordinal));
+  }
+
+  // Returns the mutable bytecode of the function at |ordinal| in |data|.
+  static uint8_t* GetFunctionBytecode(std::vector<uint8_t>& data,
+                                      size_t ordinal) {
+    iree_vm_BytecodeModuleDef_table_t module_def =
+        iree_vm_BytecodeModuleDef_as_root(data.data());
+    const uint8_t* bytecode_data =
+        iree_vm_BytecodeModuleDef_bytecode_data(module_def);
+    return const_cast<uint8_t*>(bytecode_data) +
+           GetFunctionDescriptor(data, ordinal)->bytecode_offset;
+  }
+
+  static iree_status_t CreateModule(const std::vector<uint8_t>& data) {
+    iree_vm_module_t* module = nullptr;
+    iree_status_t status = iree_vm_bytecode_module_create(
+        iree_const_byte_span_t{data.data(), data.size()},
+        iree_allocator_null(), iree_allocator_system(), &module);
+    iree_vm_module_release(module);
+    return status;
+  }
+};
+
+// Tests that all compiler-produced test modules pass verification.
+TEST_F(VMBytecodeModuleVerifierTest, VerifiesCompiledModules) {
+  const struct iree_file_toc_t* module_file_toc =
+      all_bytecode_modules_c_create();
+  for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+    const auto& module_file = module_file_toc[i];
+    std::vector<uint8_t> data(
+        reinterpret_cast<const uint8_t*>(module_file.data),
+        reinterpret_cast<const uint8_t*>(module_file.data) + module_file.size);
+    IREE_EXPECT_OK(CreateModule(data)) << module_file.name;
+  }
+}
+
+// Tests that reserved opcodes are rejected at load time.
+TEST_F(VMBytecodeModuleVerifierTest, RejectsReservedOpcode) {
+  auto data = CopyTestModule();
+  // 0x0C is reserved in the core opcode table.
+  GetFunctionBytecode(data, 0)[0] = 0x0C;
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        ::iree::Status(CreateModule(data)));
+}
+
+// Tests that functions whose final instruction is cut short are rejected.
+TEST_F(VMBytecodeModuleVerifierTest, RejectsTruncatedFunction) {
+  auto data = CopyTestModule();
+  --GetFunctionDescriptor(data, 0)->bytecode_length;
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT,
+                        ::iree::Status(CreateModule(data)));
+}
+
+class VMBytecodeModuleProfileTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    IREE_CHECK_OK(iree_vm_register_builtin_types());
+    IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
+
+    const struct iree_file_toc_t* module_file_toc =
+        all_bytecode_modules_c_create();
+    for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+      const auto& module_file = module_file_toc[i];
+      if (strcmp(module_file.name, "control_flow_ops.vmfb") != 0) continue;
+      IREE_CHECK_OK(iree_vm_bytecode_module_create(
+          iree_const_byte_span_t{
+              reinterpret_cast<const uint8_t*>(module_file.data),
+              module_file.size},
+          iree_allocator_null(), iree_allocator_system(), &bytecode_module_));
+    }
+    IREE_CHECK(bytecode_module_);
+
+    IREE_CHECK_OK(iree_vm_context_create_with_modules(
+        instance_, &bytecode_module_, 1, iree_allocator_system(), &context_));
+  }
+
+  virtual void TearDown() {
+    iree_vm_module_release(bytecode_module_);
+    iree_vm_context_release(context_);
+    iree_vm_instance_release(instance_);
+  }
+
+  iree_vm_function_t LookupFunction(const char* function_name) {
+    iree_vm_function_t function;
+    IREE_CHECK_OK(bytecode_module_->lookup_function(
+        bytecode_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_cstring_view(function_name), &function));
+    return function;
+  }
+
+  iree_status_t RunFunction(iree_vm_function_t function) {
+    return iree_vm_invoke(context_, function,
+                          /*policy=*/nullptr, /*inputs=*/nullptr,
+                          /*outputs=*/nullptr, iree_allocator_system());
+  }
+
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_context_t* context_ = nullptr;
+  iree_vm_module_t* bytecode_module_ = nullptr;
+};
+
+// Tests that calls and ops are counted per function and can be reset.
+TEST_F(VMBytecodeModuleProfileTest, CountsCallsAndOps) {
+  ASSERT_EQ(1, iree_vm_context_module_count(context_));
+  ASSERT_EQ(bytecode_module_, iree_vm_context_module_at(context_, 0));
+
+  iree_vm_function_t function = LookupFunction("test_return_empty");
+  IREE_ASSERT_OK(RunFunction(function));
+  IREE_ASSERT_OK(RunFunction(function));
+
+  iree_host_size_t profile_count = 0;
+  iree_status_t status = iree_vm_bytecode_module_query_profile(
+      bytecode_module_, context_, 0, nullptr, &profile_count);
+#if IREE_VM_EXECUTION_PROFILING_ENABLE
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_OUT_OF_RANGE, ::iree::Status(status));
+  std::vector<iree_vm_bytecode_function_profile_t> profiles(profile_count);
+  IREE_ASSERT_OK(iree_vm_bytecode_module_query_profile(
+      bytecode_module_, context_, profiles.size(), profiles.data(),
+      &profile_count));
+  ASSERT_LT(function.ordinal, profile_count);
+  EXPECT_EQ(2, profiles[function.ordinal].call_count);
+  // Each call executes a single vm.return.
+  EXPECT_EQ(2, profiles[function.ordinal].op_count);
+  EXPECT_GE(profiles[function.ordinal].inclusive_time_ns, 0);
+
+  IREE_ASSERT_OK(iree_vm_bytecode_module_reset_profile(context_));
+  IREE_ASSERT_OK(iree_vm_bytecode_module_query_profile(
+      bytecode_module_, context_, profiles.size(), profiles.data(),
+      &profile_count));
+  EXPECT_EQ(0, profiles[function.ordinal].call_count);
+  EXPECT_EQ(0, profiles[function.ordinal].op_count);
+#else
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_UNAVAILABLE, ::iree::Status(status));
+#endif  // IREE_VM_EXECUTION_PROFILING_ENABLE
+}
+
 }  // namespace
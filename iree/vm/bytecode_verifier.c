@@ -0,0 +1,1106 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/vm/bytecode_module_impl.h"
+#include "iree/vm/generated/bytecode_op_table.h"
+
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
+//===----------------------------------------------------------------------===//
+// Verifier state
+//===----------------------------------------------------------------------===//
+
+typedef struct {
+  // Sizes of the module tables that ordinals in the bytecode index into.
+  iree_host_size_t type_count;
+  iree_host_size_t import_count;
+  iree_host_size_t function_count;
+  iree_host_size_t global_bytes_capacity;
+  iree_host_size_t global_ref_count;
+  iree_host_size_t rodata_count;
+
+  // Function currently being verified.
+  iree_host_size_t function_ordinal;
+  const uint8_t* bytecode_data;
+  iree_host_size_t bytecode_length;
+  uint32_t i32_register_count;
+  uint32_t ref_register_count;
+
+  // Bitmaps with one bit per bytecode byte of the current function indicating
+  // where instructions begin and which offsets are targeted by branches.
+  // Sized for the largest function in the module and reused across functions.
+  uint32_t* instruction_bitmap;
+  uint32_t* branch_target_bitmap;
+} iree_vm_bytecode_verifier_t;
+
+static inline void iree_vm_bytecode_verifier_bitmap_set(uint32_t* bitmap,
+                                                        iree_host_size_t i) {
+  bitmap[i / 32] |= 1u << (i % 32);
+}
+
+static inline uint16_t iree_vm_bytecode_verifier_load_u16(const uint8_t* p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static inline uint32_t iree_vm_bytecode_verifier_load_u32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+//===----------------------------------------------------------------------===//
+// Operand verification
+//===----------------------------------------------------------------------===//
+
+// Ensures |length| bytes are available at |pc| and advances past them.
+static iree_status_t iree_vm_bytecode_verify_skip(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    iree_host_size_t length, const char* name) {
+  if (IREE_UNLIKELY(*pc + length > verifier->bytecode_length)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s (%zu bytes) extends past the end of the "
+        "function bytecode (%zu)",
+        verifier->function_ordinal, *pc, name, length,
+        verifier->bytecode_length);
+  }
+  *pc += length;
+  return iree_ok_status();
+}
+
+// Reads a 32-bit value at |pc| and advances past it.
+static iree_status_t iree_vm_bytecode_verify_read_u32(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name, uint32_t* out_value) {
+  const uint8_t* p = verifier->bytecode_data + *pc;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_skip(verifier, pc, 4, name));
+  *out_value = iree_vm_bytecode_verifier_load_u32(p);
+  return iree_ok_status();
+}
+
+// Verifies an i32/f32 (|register_width| = 1) or i64/f64 (|register_width| = 2)
+// register ordinal. Wide registers must be naturally aligned so that the
+// dispatcher can alias them directly onto the i32 register storage.
+static iree_status_t iree_vm_bytecode_verify_i32_register(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t pc, uint16_t reg,
+    uint32_t register_width, const char* name) {
+  if (IREE_UNLIKELY(reg & IREE_REF_REGISTER_TYPE_BIT)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%zu]@%zu: %s expected a primitive "
+                            "register but got ref register 0x%04X",
+                            verifier->function_ordinal, pc, name, reg);
+  }
+  if (IREE_UNLIKELY(register_width > 1 && (reg % register_width) != 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%zu]@%zu: %s register %u is not aligned "
+                            "to its %u-register width",
+                            verifier->function_ordinal, pc, name, reg,
+                            register_width);
+  }
+  if (IREE_UNLIKELY(reg + register_width > verifier->i32_register_count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s register %u out of range (i32 registers=%u)",
+        verifier->function_ordinal, pc, name, reg,
+        verifier->i32_register_count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_ref_register(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t pc, uint16_t reg,
+    const char* name) {
+  if (IREE_UNLIKELY(!(reg & IREE_REF_REGISTER_TYPE_BIT))) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%zu]@%zu: %s expected a ref register "
+                            "but got primitive register %u",
+                            verifier->function_ordinal, pc, name, reg);
+  }
+  uint16_t ordinal = reg & IREE_REF_REGISTER_MASK;
+  if (IREE_UNLIKELY(ordinal >= verifier->ref_register_count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s register %u out of range (ref registers=%u)",
+        verifier->function_ordinal, pc, name, ordinal,
+        verifier->ref_register_count);
+  }
+  return iree_ok_status();
+}
+
+// Verifies a register from a register list where the bank is indicated by the
+// register type bit. Lists do not carry the width of primitive values and the
+// consumers of them still bounds check against the frame register masks.
+static iree_status_t iree_vm_bytecode_verify_any_register(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t pc, uint16_t reg,
+    const char* name) {
+  if (reg & IREE_REF_REGISTER_TYPE_BIT) {
+    return iree_vm_bytecode_verify_ref_register(verifier, pc, reg, name);
+  }
+  return iree_vm_bytecode_verify_i32_register(verifier, pc, reg, 1, name);
+}
+
+static iree_status_t iree_vm_bytecode_verify_reg_i32(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    uint32_t register_width, const char* name) {
+  iree_host_size_t reg_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_skip(verifier, pc, sizeof(uint16_t), name));
+  return iree_vm_bytecode_verify_i32_register(
+      verifier, reg_pc,
+      iree_vm_bytecode_verifier_load_u16(verifier->bytecode_data + reg_pc),
+      register_width, name);
+}
+
+static iree_status_t iree_vm_bytecode_verify_reg_ref(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name) {
+  iree_host_size_t reg_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_skip(verifier, pc, sizeof(uint16_t), name));
+  return iree_vm_bytecode_verify_ref_register(
+      verifier, reg_pc,
+      iree_vm_bytecode_verifier_load_u16(verifier->bytecode_data + reg_pc),
+      name);
+}
+
+// Verifies a uint16_t-prefixed list of registers (iree_vm_register_list_t).
+static iree_status_t iree_vm_bytecode_verify_register_list(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name) {
+  iree_host_size_t list_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_skip(verifier, pc, sizeof(uint16_t), name));
+  uint16_t size =
+      iree_vm_bytecode_verifier_load_u16(verifier->bytecode_data + list_pc);
+  const uint8_t* registers = verifier->bytecode_data + *pc;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_skip(
+      verifier, pc, size * sizeof(uint16_t), name));
+  for (uint16_t i = 0; i < size; ++i) {
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_any_register(
+        verifier, list_pc,
+        iree_vm_bytecode_verifier_load_u16(registers + i * sizeof(uint16_t)),
+        name));
+  }
+  return iree_ok_status();
+}
+
+// Verifies a uint16_t-prefixed list of raw uint16_t values (such as the
+// segment sizes of a variadic call).
+static iree_status_t iree_vm_bytecode_verify_u16_array(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name) {
+  iree_host_size_t list_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_skip(verifier, pc, sizeof(uint16_t), name));
+  uint16_t size =
+      iree_vm_bytecode_verifier_load_u16(verifier->bytecode_data + list_pc);
+  return iree_vm_bytecode_verify_skip(verifier, pc, size * sizeof(uint16_t),
+                                      name);
+}
+
+// Verifies a branch target and its register remapping list
+// (iree_vm_register_remap_list_t). The target offset is recorded and checked
+// against the instruction boundaries once the whole function has been walked.
+static iree_status_t iree_vm_bytecode_verify_branch(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name) {
+  uint32_t block_pc = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_read_u32(verifier, pc, name, &block_pc));
+  if (IREE_UNLIKELY(block_pc >= verifier->bytecode_length)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s branch target %u out of range (length=%zu)",
+        verifier->function_ordinal, *pc, name, block_pc,
+        verifier->bytecode_length);
+  }
+  iree_vm_bytecode_verifier_bitmap_set(verifier->branch_target_bitmap,
+                                       block_pc);
+
+  iree_host_size_t list_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_skip(verifier, pc, sizeof(uint16_t), name));
+  uint16_t size =
+      iree_vm_bytecode_verifier_load_u16(verifier->bytecode_data + list_pc);
+  const uint8_t* pairs = verifier->bytecode_data + *pc;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_skip(
+      verifier, pc, size * 2 * sizeof(uint16_t), name));
+  for (uint16_t i = 0; i < size; ++i) {
+    uint16_t src_reg = iree_vm_bytecode_verifier_load_u16(pairs + i * 4 + 0);
+    uint16_t dst_reg = iree_vm_bytecode_verifier_load_u16(pairs + i * 4 + 2);
+    if (IREE_UNLIKELY((src_reg & IREE_REF_REGISTER_TYPE_BIT) !=
+                      (dst_reg & IREE_REF_REGISTER_TYPE_BIT))) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "functions[%zu]@%zu: %s remaps between register "
+                              "banks (0x%04X -> 0x%04X)",
+                              verifier->function_ordinal, list_pc, name,
+                              src_reg, dst_reg);
+    }
+    IREE_RETURN_IF_ERROR(
+        iree_vm_bytecode_verify_any_register(verifier, list_pc, src_reg, name));
+    IREE_RETURN_IF_ERROR(
+        iree_vm_bytecode_verify_any_register(verifier, list_pc, dst_reg, name));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_str_attr(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name) {
+  iree_host_size_t str_pc = *pc;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_skip(verifier, pc, sizeof(uint16_t), name));
+  uint16_t size =
+      iree_vm_bytecode_verifier_load_u16(verifier->bytecode_data + str_pc);
+  return iree_vm_bytecode_verify_skip(verifier, pc, size, name);
+}
+
+static iree_status_t iree_vm_bytecode_verify_type_attr(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name) {
+  uint32_t type_id = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_read_u32(verifier, pc, name, &type_id));
+  if (IREE_UNLIKELY(type_id >= verifier->type_count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s type %u out of range (types=%zu)",
+        verifier->function_ordinal, *pc, name, type_id,
+        verifier->type_count);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_func_attr(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    const char* name) {
+  uint32_t function_ordinal = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_read_u32(verifier, pc, name, &function_ordinal));
+  bool is_import = (function_ordinal & 0x80000000u) != 0;
+  uint32_t ordinal = function_ordinal & 0x7FFFFFFFu;
+  iree_host_size_t limit =
+      is_import ? verifier->import_count : verifier->function_count;
+  if (IREE_UNLIKELY(ordinal >= limit)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s %s ordinal %u out of range (count=%zu)",
+        verifier->function_ordinal, *pc, name,
+        is_import ? "import" : "function", ordinal, limit);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_global_attr(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    iree_host_size_t byte_width, const char* name) {
+  uint32_t byte_offset = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_read_u32(verifier, pc, name, &byte_offset));
+  if (IREE_UNLIKELY(byte_offset > verifier->global_bytes_capacity ||
+                    byte_width >
+                        verifier->global_bytes_capacity - byte_offset)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s global byte offset %u out of range "
+        "(rwdata=%zu)",
+        verifier->function_ordinal, *pc, name, byte_offset,
+        verifier->global_bytes_capacity);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_ordinal_attr(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* pc,
+    iree_host_size_t limit, const char* name) {
+  uint32_t ordinal = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_verify_read_u32(verifier, pc, name, &ordinal));
+  if (IREE_UNLIKELY(ordinal >= limit)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%zu]@%zu: %s ordinal %u out of range (count=%zu)",
+        verifier->function_ordinal, *pc, name, ordinal, limit);
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Utilities matching the bytecode dispatch decoding scheme
+//===----------------------------------------------------------------------===//
+// These utilities match the VM_Dec* macros in bytecode_dispatch_util.h 1:1 and
+// must be called in the same order the dispatcher decodes the operands of each
+// op. Each macro returns from the enclosing function on failure.
+
+#define VM_VerifyConstI8(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_skip(verifier, &pc, 1, name))
+#define VM_VerifyConstI32(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_skip(verifier, &pc, 4, name))
+#define VM_VerifyConstI64(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_skip(verifier, &pc, 8, name))
+#define VM_VerifyFuncAttr(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_func_attr(verifier, &pc, name))
+#define VM_VerifyGlobalAttr(name, byte_width)                              \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_global_attr(verifier, &pc, \
+                                                           byte_width, name))
+#define VM_VerifyGlobalRefAttr(name)                         \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_ordinal_attr( \
+      verifier, &pc, verifier->global_ref_count, name))
+#define VM_VerifyRodataAttr(name)                            \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_ordinal_attr( \
+      verifier, &pc, verifier->rodata_count, name))
+#define VM_VerifyTypeOf(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_type_attr(verifier, &pc, name))
+#define VM_VerifyIntAttr32(name) VM_VerifyConstI32(name)
+#define VM_VerifyIntAttr64(name) VM_VerifyConstI64(name)
+#define VM_VerifyFloatAttr32(name) VM_VerifyConstI32(name)
+#define VM_VerifyStrAttr(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_str_attr(verifier, &pc, name))
+#define VM_VerifyBranch(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_branch(verifier, &pc, name))
+#define VM_VerifySegmentSizes(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_u16_array(verifier, &pc, name))
+#define VM_VerifyOperandRegI32(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_reg_i32(verifier, &pc, 1, name))
+#define VM_VerifyOperandRegI64(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_reg_i32(verifier, &pc, 2, name))
+#define VM_VerifyOperandRegF32(name) VM_VerifyOperandRegI32(name)
+#define VM_VerifyOperandRegRef(name) \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_reg_ref(verifier, &pc, name))
+#define VM_VerifyVariadicOperands(name)                                     \
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_register_list(verifier, &pc, \
+                                                             name))
+#define VM_VerifyResultRegI32(name) VM_VerifyOperandRegI32(name)
+#define VM_VerifyResultRegI64(name) VM_VerifyOperandRegI64(name)
+#define VM_VerifyResultRegF32(name) VM_VerifyOperandRegF32(name)
+#define VM_VerifyResultRegRef(name) VM_VerifyOperandRegRef(name)
+#define VM_VerifyVariadicResults(name) VM_VerifyVariadicOperands(name)
+
+//===----------------------------------------------------------------------===//
+// Op verification
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_vm_bytecode_verify_unhandled_op(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t pc,
+    const char* ext_name, uint8_t opcode) {
+  return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                          "functions[%zu]@%zu: unhandled %s opcode 0x%02X",
+                          verifier->function_ordinal, pc, ext_name, opcode);
+}
+
+static iree_status_t iree_vm_bytecode_verify_ext_i64_op(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* inout_pc) {
+  iree_host_size_t pc = *inout_pc;
+  iree_host_size_t op_pc = pc;
+  VM_VerifyConstI8("opcode");
+  uint8_t opcode = verifier->bytecode_data[op_pc];
+  switch (opcode) {
+    case IREE_VM_OP_EXT_I64_GlobalLoadI64:
+      VM_VerifyGlobalAttr("global", sizeof(int64_t));
+      VM_VerifyResultRegI64("value");
+      break;
+    case IREE_VM_OP_EXT_I64_GlobalStoreI64:
+      VM_VerifyGlobalAttr("global", sizeof(int64_t));
+      VM_VerifyOperandRegI64("value");
+      break;
+    case IREE_VM_OP_EXT_I64_GlobalLoadIndirectI64:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyResultRegI64("value");
+      break;
+    case IREE_VM_OP_EXT_I64_GlobalStoreIndirectI64:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyOperandRegI64("value");
+      break;
+    case IREE_VM_OP_EXT_I64_ConstI64:
+      VM_VerifyIntAttr64("value");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_ConstI64Zero:
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_ListGetI64:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_ListSetI64:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegI64("value");
+      break;
+    case IREE_VM_OP_EXT_I64_SelectI64:
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyOperandRegI64("true_value");
+      VM_VerifyOperandRegI64("false_value");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_SwitchI64:
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyIntAttr64("default_value");
+      VM_VerifyVariadicOperands("values");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_AddI64:
+    case IREE_VM_OP_EXT_I64_SubI64:
+    case IREE_VM_OP_EXT_I64_MulI64:
+    case IREE_VM_OP_EXT_I64_DivI64S:
+    case IREE_VM_OP_EXT_I64_DivI64U:
+    case IREE_VM_OP_EXT_I64_RemI64S:
+    case IREE_VM_OP_EXT_I64_RemI64U:
+    case IREE_VM_OP_EXT_I64_AndI64:
+    case IREE_VM_OP_EXT_I64_OrI64:
+    case IREE_VM_OP_EXT_I64_XorI64:
+      VM_VerifyOperandRegI64("lhs");
+      VM_VerifyOperandRegI64("rhs");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_NotI64:
+      VM_VerifyOperandRegI64("operand");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_ShlI64:
+    case IREE_VM_OP_EXT_I64_ShrI64S:
+    case IREE_VM_OP_EXT_I64_ShrI64U:
+      VM_VerifyOperandRegI64("operand");
+      VM_VerifyConstI8("amount");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_TruncI64I32:
+      VM_VerifyOperandRegI64("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_EXT_I64_ExtI32I64S:
+    case IREE_VM_OP_EXT_I64_ExtI32I64U:
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_CmpEQI64:
+    case IREE_VM_OP_EXT_I64_CmpNEI64:
+    case IREE_VM_OP_EXT_I64_CmpLTI64S:
+    case IREE_VM_OP_EXT_I64_CmpLTI64U:
+      VM_VerifyOperandRegI64("lhs");
+      VM_VerifyOperandRegI64("rhs");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_EXT_I64_CmpNZI64:
+      VM_VerifyOperandRegI64("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_EXT_I64_BufferFillI64:
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyOperandRegI64("value");
+      break;
+    case IREE_VM_OP_EXT_I64_BufferLoadI64:
+      VM_VerifyOperandRegRef("source_buffer");
+      VM_VerifyOperandRegI32("source_offset");
+      VM_VerifyResultRegI64("result");
+      break;
+    case IREE_VM_OP_EXT_I64_BufferStoreI64:
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI64("value");
+      break;
+    default:
+      return iree_vm_bytecode_verify_unhandled_op(verifier, op_pc, "ExtI64",
+                                                  opcode);
+  }
+  *inout_pc = pc;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_verify_ext_f32_op(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* inout_pc) {
+  iree_host_size_t pc = *inout_pc;
+  iree_host_size_t op_pc = pc;
+  VM_VerifyConstI8("opcode");
+  uint8_t opcode = verifier->bytecode_data[op_pc];
+  switch (opcode) {
+    case IREE_VM_OP_EXT_F32_GlobalLoadF32:
+      VM_VerifyGlobalAttr("global", sizeof(float));
+      VM_VerifyResultRegF32("value");
+      break;
+    case IREE_VM_OP_EXT_F32_GlobalStoreF32:
+      VM_VerifyGlobalAttr("global", sizeof(float));
+      VM_VerifyOperandRegF32("value");
+      break;
+    case IREE_VM_OP_EXT_F32_GlobalLoadIndirectF32:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyResultRegF32("value");
+      break;
+    case IREE_VM_OP_EXT_F32_GlobalStoreIndirectF32:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyOperandRegF32("value");
+      break;
+    case IREE_VM_OP_EXT_F32_ConstF32:
+      VM_VerifyFloatAttr32("value");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_ConstF32Zero:
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_ListGetF32:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_ListSetF32:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegF32("value");
+      break;
+    case IREE_VM_OP_EXT_F32_SelectF32:
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyOperandRegF32("true_value");
+      VM_VerifyOperandRegF32("false_value");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_SwitchF32:
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyFloatAttr32("default_value");
+      VM_VerifyVariadicOperands("values");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_AddF32:
+    case IREE_VM_OP_EXT_F32_SubF32:
+    case IREE_VM_OP_EXT_F32_MulF32:
+    case IREE_VM_OP_EXT_F32_DivF32:
+    case IREE_VM_OP_EXT_F32_RemF32:
+    case IREE_VM_OP_EXT_F32_Atan2F32:
+    case IREE_VM_OP_EXT_F32_PowF32:
+      VM_VerifyOperandRegF32("lhs");
+      VM_VerifyOperandRegF32("rhs");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_AbsF32:
+    case IREE_VM_OP_EXT_F32_NegF32:
+    case IREE_VM_OP_EXT_F32_CeilF32:
+    case IREE_VM_OP_EXT_F32_FloorF32:
+    case IREE_VM_OP_EXT_F32_AtanF32:
+    case IREE_VM_OP_EXT_F32_CosF32:
+    case IREE_VM_OP_EXT_F32_SinF32:
+    case IREE_VM_OP_EXT_F32_ExpF32:
+    case IREE_VM_OP_EXT_F32_Exp2F32:
+    case IREE_VM_OP_EXT_F32_ExpM1F32:
+    case IREE_VM_OP_EXT_F32_LogF32:
+    case IREE_VM_OP_EXT_F32_Log10F32:
+    case IREE_VM_OP_EXT_F32_Log1pF32:
+    case IREE_VM_OP_EXT_F32_Log2F32:
+    case IREE_VM_OP_EXT_F32_RsqrtF32:
+    case IREE_VM_OP_EXT_F32_SqrtF32:
+    case IREE_VM_OP_EXT_F32_TanhF32:
+      VM_VerifyOperandRegF32("operand");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_CastSI32F32:
+    case IREE_VM_OP_EXT_F32_CastUI32F32:
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_CastF32SI32:
+    case IREE_VM_OP_EXT_F32_CastF32UI32:
+      VM_VerifyOperandRegF32("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_CmpEQF32O:
+    case IREE_VM_OP_EXT_F32_CmpEQF32U:
+    case IREE_VM_OP_EXT_F32_CmpNEF32O:
+    case IREE_VM_OP_EXT_F32_CmpNEF32U:
+    case IREE_VM_OP_EXT_F32_CmpLTF32O:
+    case IREE_VM_OP_EXT_F32_CmpLTF32U:
+    case IREE_VM_OP_EXT_F32_CmpLTEF32O:
+    case IREE_VM_OP_EXT_F32_CmpLTEF32U:
+      VM_VerifyOperandRegF32("lhs");
+      VM_VerifyOperandRegF32("rhs");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_CmpNaNF32:
+      VM_VerifyOperandRegF32("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_BufferFillF32:
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyOperandRegF32("value");
+      break;
+    case IREE_VM_OP_EXT_F32_BufferLoadF32:
+      VM_VerifyOperandRegRef("source_buffer");
+      VM_VerifyOperandRegI32("source_offset");
+      VM_VerifyResultRegF32("result");
+      break;
+    case IREE_VM_OP_EXT_F32_BufferStoreF32:
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegF32("value");
+      break;
+    default:
+      return iree_vm_bytecode_verify_unhandled_op(verifier, op_pc, "ExtF32",
+                                                  opcode);
+  }
+  *inout_pc = pc;
+  return iree_ok_status();
+}
+
+// Verifies the op at |inout_pc| and advances past it.
+// |out_is_terminator| is set if the op unconditionally ends a block.
+static iree_status_t iree_vm_bytecode_verify_op(
+    iree_vm_bytecode_verifier_t* verifier, iree_host_size_t* inout_pc,
+    bool* out_is_terminator) {
+  iree_host_size_t pc = *inout_pc;
+  iree_host_size_t op_pc = pc;
+  *out_is_terminator = false;
+  VM_VerifyConstI8("opcode");
+  uint8_t opcode = verifier->bytecode_data[op_pc];
+  switch (opcode) {
+    //===------------------------------------------------------------------===//
+    // Globals
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_GlobalLoadI32:
+      VM_VerifyGlobalAttr("global", sizeof(int32_t));
+      VM_VerifyResultRegI32("value");
+      break;
+    case IREE_VM_OP_CORE_GlobalStoreI32:
+      VM_VerifyGlobalAttr("global", sizeof(int32_t));
+      VM_VerifyOperandRegI32("value");
+      break;
+    case IREE_VM_OP_CORE_GlobalLoadIndirectI32:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyResultRegI32("value");
+      break;
+    case IREE_VM_OP_CORE_GlobalStoreIndirectI32:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyOperandRegI32("value");
+      break;
+    case IREE_VM_OP_CORE_GlobalLoadRef:
+      VM_VerifyGlobalRefAttr("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyResultRegRef("value");
+      break;
+    case IREE_VM_OP_CORE_GlobalStoreRef:
+      VM_VerifyGlobalRefAttr("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyOperandRegRef("value");
+      break;
+    case IREE_VM_OP_CORE_GlobalLoadIndirectRef:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyResultRegRef("value");
+      break;
+    case IREE_VM_OP_CORE_GlobalStoreIndirectRef:
+      VM_VerifyOperandRegI32("global");
+      VM_VerifyTypeOf("value");
+      VM_VerifyOperandRegRef("value");
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Constants
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_ConstI32:
+      VM_VerifyIntAttr32("value");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_ConstI32Zero:
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_ConstRefZero:
+      VM_VerifyResultRegRef("result");
+      break;
+    case IREE_VM_OP_CORE_ConstRefRodata:
+      VM_VerifyRodataAttr("rodata");
+      VM_VerifyResultRegRef("value");
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Buffers
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_BufferAlloc:
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegRef("result");
+      break;
+    case IREE_VM_OP_CORE_BufferClone:
+      VM_VerifyOperandRegRef("source");
+      VM_VerifyOperandRegI32("offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegRef("result");
+      break;
+    case IREE_VM_OP_CORE_BufferLength:
+      VM_VerifyOperandRegRef("buffer");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_BufferCopy:
+      VM_VerifyOperandRegRef("source_buffer");
+      VM_VerifyOperandRegI32("source_offset");
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      break;
+    case IREE_VM_OP_CORE_BufferCompare:
+      VM_VerifyOperandRegRef("lhs_buffer");
+      VM_VerifyOperandRegI32("lhs_offset");
+      VM_VerifyOperandRegRef("rhs_buffer");
+      VM_VerifyOperandRegI32("rhs_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_BufferFillI8:
+    case IREE_VM_OP_CORE_BufferFillI16:
+    case IREE_VM_OP_CORE_BufferFillI32:
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("length");
+      VM_VerifyOperandRegI32("value");
+      break;
+    case IREE_VM_OP_CORE_BufferLoadI8U:
+    case IREE_VM_OP_CORE_BufferLoadI8S:
+    case IREE_VM_OP_CORE_BufferLoadI16U:
+    case IREE_VM_OP_CORE_BufferLoadI16S:
+    case IREE_VM_OP_CORE_BufferLoadI32:
+      VM_VerifyOperandRegRef("source_buffer");
+      VM_VerifyOperandRegI32("source_offset");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_BufferStoreI8:
+    case IREE_VM_OP_CORE_BufferStoreI16:
+    case IREE_VM_OP_CORE_BufferStoreI32:
+      VM_VerifyOperandRegRef("target_buffer");
+      VM_VerifyOperandRegI32("target_offset");
+      VM_VerifyOperandRegI32("value");
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Lists
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_ListAlloc:
+      VM_VerifyTypeOf("element_type");
+      VM_VerifyOperandRegI32("initial_capacity");
+      VM_VerifyResultRegRef("result");
+      break;
+    case IREE_VM_OP_CORE_ListReserve:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("minimum_capacity");
+      break;
+    case IREE_VM_OP_CORE_ListSize:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_ListResize:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("new_size");
+      break;
+    case IREE_VM_OP_CORE_ListGetI32:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_ListSetI32:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegI32("raw_value");
+      break;
+    case IREE_VM_OP_CORE_ListGetRef:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyTypeOf("result");
+      VM_VerifyResultRegRef("result");
+      break;
+    case IREE_VM_OP_CORE_ListSetRef:
+      VM_VerifyOperandRegRef("list");
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyOperandRegRef("value");
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Conditional assignment
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_SelectI32:
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyOperandRegI32("true_value");
+      VM_VerifyOperandRegI32("false_value");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_SelectRef:
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyTypeOf("true_value");
+      VM_VerifyOperandRegRef("true_value");
+      VM_VerifyOperandRegRef("false_value");
+      VM_VerifyResultRegRef("result");
+      break;
+    case IREE_VM_OP_CORE_SwitchI32:
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyIntAttr32("default_value");
+      VM_VerifyVariadicOperands("values");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_SwitchRef:
+      VM_VerifyOperandRegI32("index");
+      VM_VerifyTypeOf("result");
+      VM_VerifyOperandRegRef("default_value");
+      VM_VerifyVariadicOperands("values");
+      VM_VerifyResultRegRef("result");
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Native integer arithmetic, casting, and comparison
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_AddI32:
+    case IREE_VM_OP_CORE_SubI32:
+    case IREE_VM_OP_CORE_MulI32:
+    case IREE_VM_OP_CORE_DivI32S:
+    case IREE_VM_OP_CORE_DivI32U:
+    case IREE_VM_OP_CORE_RemI32S:
+    case IREE_VM_OP_CORE_RemI32U:
+    case IREE_VM_OP_CORE_AndI32:
+    case IREE_VM_OP_CORE_OrI32:
+    case IREE_VM_OP_CORE_XorI32:
+    case IREE_VM_OP_CORE_CmpEQI32:
+    case IREE_VM_OP_CORE_CmpNEI32:
+    case IREE_VM_OP_CORE_CmpLTI32S:
+    case IREE_VM_OP_CORE_CmpLTI32U:
+      VM_VerifyOperandRegI32("lhs");
+      VM_VerifyOperandRegI32("rhs");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_NotI32:
+    case IREE_VM_OP_CORE_TruncI32I8:
+    case IREE_VM_OP_CORE_TruncI32I16:
+    case IREE_VM_OP_CORE_ExtI8I32S:
+    case IREE_VM_OP_CORE_ExtI8I32U:
+    case IREE_VM_OP_CORE_ExtI16I32S:
+    case IREE_VM_OP_CORE_ExtI16I32U:
+    case IREE_VM_OP_CORE_CmpNZI32:
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_ShlI32:
+    case IREE_VM_OP_CORE_ShrI32S:
+    case IREE_VM_OP_CORE_ShrI32U:
+      VM_VerifyOperandRegI32("operand");
+      VM_VerifyConstI8("amount");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_CmpEQRef:
+    case IREE_VM_OP_CORE_CmpNERef:
+      VM_VerifyOperandRegRef("lhs");
+      VM_VerifyOperandRegRef("rhs");
+      VM_VerifyResultRegI32("result");
+      break;
+    case IREE_VM_OP_CORE_CmpNZRef:
+      VM_VerifyOperandRegRef("operand");
+      VM_VerifyResultRegI32("result");
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Control flow
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_Branch:
+      VM_VerifyBranch("dest");
+      *out_is_terminator = true;
+      break;
+    case IREE_VM_OP_CORE_CondBranch:
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyBranch("true_dest");
+      VM_VerifyBranch("false_dest");
+      *out_is_terminator = true;
+      break;
+    case IREE_VM_OP_CORE_Call:
+      VM_VerifyFuncAttr("callee");
+      VM_VerifyVariadicOperands("operands");
+      VM_VerifyVariadicResults("results");
+      break;
+    case IREE_VM_OP_CORE_CallVariadic:
+      VM_VerifyFuncAttr("callee");
+      VM_VerifySegmentSizes("segment_sizes");
+      VM_VerifyVariadicOperands("operands");
+      VM_VerifyVariadicResults("results");
+      break;
+    case IREE_VM_OP_CORE_Return:
+      VM_VerifyVariadicOperands("operands");
+      *out_is_terminator = true;
+      break;
+    case IREE_VM_OP_CORE_Fail:
+      VM_VerifyOperandRegI32("status");
+      VM_VerifyStrAttr("message");
+      *out_is_terminator = true;
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Async/fiber ops
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_Yield:
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Debugging
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_Trace:
+    case IREE_VM_OP_CORE_Print:
+      VM_VerifyStrAttr("event_name");
+      VM_VerifyVariadicOperands("operands");
+      break;
+    case IREE_VM_OP_CORE_Break:
+      VM_VerifyBranch("dest");
+      *out_is_terminator = true;
+      break;
+    case IREE_VM_OP_CORE_CondBreak:
+      VM_VerifyOperandRegI32("condition");
+      VM_VerifyBranch("dest");
+      *out_is_terminator = true;
+      break;
+
+    //===------------------------------------------------------------------===//
+    // Extension trampolines
+    //===------------------------------------------------------------------===//
+
+    case IREE_VM_OP_CORE_PrefixExtI64:
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_ext_i64_op(verifier, &pc));
+      break;
+    case IREE_VM_OP_CORE_PrefixExtF32:
+      IREE_RETURN_IF_ERROR(iree_vm_bytecode_verify_ext_f32_op(verifier, &pc));
+      break;
+
+    default:
+      // NOTE: the ExtF64 extension is not implemented by the dispatcher and
+      // is rejected along with reserved opcodes.
+      return iree_vm_bytecode_verify_unhandled_op(verifier, op_pc, "core",
+                                                  opcode);
+  }
+  *inout_pc = pc;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Function verification
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_vm_bytecode_function_verify(
+    iree_vm_bytecode_verifier_t* verifier) {
+  iree_host_size_t bitmap_word_count = (verifier->bytecode_length + 31) / 32;
+  memset(verifier->instruction_bitmap, 0,
+         bitmap_word_count * sizeof(uint32_t));
+  memset(verifier->branch_target_bitmap, 0,
+         bitmap_word_count * sizeof(uint32_t));
+
+  // Walk every instruction in order; each op must decode entirely within the
+  // function bytecode and the final op must not fall through off the end.
+  iree_host_size_t pc = 0;
+  bool is_terminator = false;
+  while (pc < verifier->bytecode_length) {
+    iree_vm_bytecode_verifier_bitmap_set(verifier->instruction_bitmap, pc);
+    IREE_RETURN_IF_ERROR(
+        iree_vm_bytecode_verify_op(verifier, &pc, &is_terminator));
+  }
+  if (IREE_UNLIKELY(!is_terminator)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "functions[%zu] does not end with a terminator",
+                            verifier->function_ordinal);
+  }
+
+  // All branch targets must land on the start of an instruction.
+  for (iree_host_size_t i = 0; i < bitmap_word_count; ++i) {
+    uint32_t invalid_targets = verifier->branch_target_bitmap[i] &
+                               ~verifier->instruction_bitmap[i];
+    if (IREE_UNLIKELY(invalid_targets)) {
+      iree_host_size_t bit = 0;
+      while (!(invalid_targets & (1u << bit))) ++bit;
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "functions[%zu]: branch target %zu is not an instruction boundary",
+          verifier->function_ordinal, i * 32 + bit);
+    }
+  }
+
+  return iree_ok_status();
+}
+
+iree_status_t iree_vm_bytecode_module_verify(
+    iree_vm_bytecode_module_t* module) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_bytecode_verifier_t verifier;
+  memset(&verifier, 0, sizeof(verifier));
+  verifier.type_count = module->type_count;
+  verifier.import_count = iree_vm_ImportFunctionDef_vec_len(
+      iree_vm_BytecodeModuleDef_imported_functions(module->def));
+  verifier.function_count = module->function_descriptor_count;
+  iree_vm_ModuleStateDef_table_t module_state_def =
+      iree_vm_BytecodeModuleDef_module_state(module->def);
+  if (module_state_def) {
+    verifier.global_bytes_capacity =
+        iree_vm_ModuleStateDef_global_bytes_capacity(module_state_def);
+    verifier.global_ref_count =
+        iree_vm_ModuleStateDef_global_ref_count(module_state_def);
+  }
+  verifier.rodata_count = iree_vm_RodataSegmentDef_vec_len(
+      iree_vm_BytecodeModuleDef_rodata_segments(module->def));
+
+  // Allocate the bitmaps once for the largest function in the module.
+  iree_host_size_t max_bytecode_length = 0;
+  for (iree_host_size_t i = 0; i < module->function_descriptor_count; ++i) {
+    max_bytecode_length =
+        VMMAX(max_bytecode_length,
+              (iree_host_size_t)module->function_descriptor_table[i]
+                  .bytecode_length);
+  }
+  iree_host_size_t bitmap_word_count = (max_bytecode_length + 31) / 32;
+  uint32_t* bitmap_storage = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(
+              module->allocator,
+              VMMAX(1, 2 * bitmap_word_count) * sizeof(uint32_t),
+              (void**)&bitmap_storage));
+  verifier.instruction_bitmap = bitmap_storage;
+  verifier.branch_target_bitmap = bitmap_storage + bitmap_word_count;
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < module->function_descriptor_count; ++i) {
+    const iree_vm_FunctionDescriptor_t* function_descriptor =
+        &module->function_descriptor_table[i];
+    verifier.function_ordinal = i;
+    verifier.bytecode_data =
+        module->bytecode_data.data + function_descriptor->bytecode_offset;
+    verifier.bytecode_length = function_descriptor->bytecode_length;
+    verifier.i32_register_count = function_descriptor->i32_register_count;
+    verifier.ref_register_count = function_descriptor->ref_register_count;
+    status = iree_vm_bytecode_function_verify(&verifier);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  iree_allocator_free(module->allocator, bitmap_storage);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+#else
+
+iree_status_t iree_vm_bytecode_module_verify(
+    iree_vm_bytecode_module_t* module) {
+  // Verification disabled; the dispatcher masks all register accesses instead.
+  return iree_ok_status();
+}
+
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
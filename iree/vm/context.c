@@ -20,6 +20,7 @@
 
 #include "iree/base/internal/atomics.h"
 #include "iree/base/tracing.h"
+#include "iree/vm/startup_profiler.h"
 
 struct iree_vm_context {
   iree_atomic_ref_count_t ref_count;
@@ -159,6 +160,18 @@ static iree_status_t iree_vm_context_resolve_module_imports(
   return iree_ok_status();
 }
 
+// Attributes the time since |*phase_start_ns| to |phase| of |module| in the
+// default startup profiler and restarts the phase clock.
+static void iree_vm_context_record_startup_phase(
+    iree_vm_module_t* module, iree_vm_startup_phase_t phase,
+    iree_time_t* phase_start_ns) {
+  iree_time_t now_ns = iree_time_now();
+  iree_status_ignore(iree_vm_startup_profiler_record(
+      iree_vm_startup_profiler_default(), iree_vm_module_name(module), phase,
+      now_ns - *phase_start_ns, /*byte_length=*/0));
+  *phase_start_ns = now_ns;
+}
+
 static void iree_vm_context_release_modules(iree_vm_context_t* context,
                                             iree_host_size_t start,
                                             iree_host_size_t end) {
@@ -359,6 +372,10 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
   IREE_VM_INLINE_STACK_INITIALIZE(
       stack, iree_vm_context_state_resolver(context), context->allocator);
 
+  // Time spent in each phase is only measured when requested.
+  const bool profile_startup =
+      iree_vm_startup_profiler_is_enabled(iree_vm_startup_profiler_default());
+
   // Retain all modules and allocate their state.
   assert(context->list.capacity >= context->list.count + module_count);
   iree_host_size_t original_count = context->list.count;
@@ -372,9 +389,14 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
     iree_vm_module_retain(module);
 
     // Allocate module state.
+    iree_time_t phase_start_ns = profile_startup ? iree_time_now() : 0;
     iree_vm_module_state_t* module_state = NULL;
     status =
         module->alloc_state(module->self, context->allocator, &module_state);
+    if (profile_startup) {
+      iree_vm_context_record_startup_phase(
+          module, IREE_VM_STARTUP_PHASE_ALLOC_STATE, &phase_start_ns);
+    }
     if (!iree_status_is_ok(status)) {
       // Cleanup handled below.
       break;
@@ -384,6 +406,10 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
     // Resolve imports for the modules.
     status =
         iree_vm_context_resolve_module_imports(context, module, module_state);
+    if (profile_startup) {
+      iree_vm_context_record_startup_phase(
+          module, IREE_VM_STARTUP_PHASE_RESOLVE_IMPORTS, &phase_start_ns);
+    }
     if (!iree_status_is_ok(status)) {
       // Cleanup handled below.
       break;
@@ -396,6 +422,10 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
     // all of these after we have resolved the imports above.
     status = iree_vm_context_run_function(stack, module,
                                           iree_make_cstring_view("__init"));
+    if (profile_startup) {
+      iree_vm_context_record_startup_phase(
+          module, IREE_VM_STARTUP_PHASE_INITIALIZE, &phase_start_ns);
+    }
     if (!iree_status_is_ok(status)) {
       // Cleanup handled below.
       break;
@@ -416,6 +446,19 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
   return status;
 }
 
+IREE_API_EXPORT iree_host_size_t
+iree_vm_context_module_count(const iree_vm_context_t* context) {
+  IREE_ASSERT_ARGUMENT(context);
+  return context->list.count;
+}
+
+IREE_API_EXPORT iree_vm_module_t* iree_vm_context_module_at(
+    const iree_vm_context_t* context, iree_host_size_t index) {
+  IREE_ASSERT_ARGUMENT(context);
+  if (index >= context->list.count) return NULL;
+  return context->list.modules[index];
+}
+
 IREE_API_EXPORT iree_status_t
 iree_vm_context_freeze(iree_vm_context_t* context) {
   IREE_ASSERT_ARGUMENT(context);
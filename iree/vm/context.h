@@ -69,6 +69,15 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
     iree_vm_context_t* context, iree_vm_module_t** modules,
     iree_host_size_t module_count);
 
+// Returns the total number of modules registered with the |context|.
+IREE_API_EXPORT iree_host_size_t
+iree_vm_context_module_count(const iree_vm_context_t* context);
+
+// Returns the module registered at |index| in registration order or NULL if
+// |index| is out of range. The module is owned by the context.
+IREE_API_EXPORT iree_vm_module_t* iree_vm_context_module_at(
+    const iree_vm_context_t* context, iree_host_size_t index);
+
 // Freezes a context such that no more modules can be registered.
 // This can be used to ensure that context contents cannot be modified by other
 // code as the context is made available to other parts of the program.
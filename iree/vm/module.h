@@ -267,6 +267,27 @@ typedef struct {
   int reserved;
 } iree_vm_execution_result_t;
 
+// Directly invokes a function call target previously resolved with
+// iree_vm_module_t::resolve_call_target. |module_state| is the callee module
+// state as resolved from the calling context.
+typedef iree_status_t(IREE_API_PTR* iree_vm_function_call_target_fn_t)(
+    void* self, const void* target, iree_vm_stack_t* stack,
+    iree_vm_module_state_t* module_state, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result);
+
+// A resolved function call target that bypasses the generic begin_call
+// dispatch and module state lookup. Callers that repeatedly call the same
+// function (such as bytecode import call sites) may cache this along with the
+// callee module state for the lifetime of the calling module state.
+typedef struct {
+  // Function performing the call or NULL if the function must be called
+  // through iree_vm_module_t::begin_call.
+  iree_vm_function_call_target_fn_t fn;
+  // Module-defined values passed to |fn|.
+  void* self;
+  const void* target;
+} iree_vm_function_call_target_t;
+
 // Defines an interface that can be used to reflect and execute functions on a
 // module.
 //
@@ -344,6 +365,14 @@ typedef struct iree_vm_module {
       void* self, iree_vm_function_linkage_t linkage, iree_host_size_t ordinal,
       iree_host_size_t index, iree_string_view_t* key,
       iree_string_view_t* value);
+
+  // Optional: resolves a direct call target for |function| that can be used
+  // in place of begin_call when the caller already has the callee module
+  // state. Returns IREE_STATUS_UNAVAILABLE if the function must be called
+  // through begin_call.
+  iree_status_t(IREE_API_PTR* resolve_call_target)(
+      void* self, const iree_vm_function_t* function,
+      iree_vm_function_call_target_t* out_target);
 } iree_vm_module_t;
 
 // Initializes the interface of a module handle.
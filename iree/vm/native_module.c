@@ -125,7 +125,11 @@ static iree_status_t IREE_API_PTR iree_vm_native_module_get_import_function(
   if (out_name) {
     *out_name = import_descriptor->full_name;
   }
-  // TODO(#1979): signature queries when info is useful.
+  if (out_signature) {
+    // TODO(#1979): signature queries when info is useful. Until then the
+    // signature is left empty so that callers skip verifying it.
+    memset(out_signature, 0, sizeof(*out_signature));
+  }
   return iree_ok_status();
 }
 
@@ -273,6 +277,30 @@ static iree_status_t IREE_API_PTR iree_vm_native_module_resolve_import(
                           "native module does not support imports");
 }
 
+// Issues a call to |function_ptr| within an already entered callee frame and
+// leaves the frame upon success.
+static iree_status_t iree_vm_native_module_issue_call(
+    iree_vm_native_module_t* module, iree_vm_stack_t* stack,
+    const iree_vm_function_call_t* call,
+    const iree_vm_native_function_ptr_t* function_ptr,
+    iree_vm_module_state_t* module_state,
+    iree_vm_execution_result_t* out_result) {
+  iree_status_t status = function_ptr->shim(stack, call, function_ptr->target,
+                                            module, module_state, out_result);
+  if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+    iree_string_view_t module_name = iree_vm_native_module_name(module);
+    iree_string_view_t function_name = iree_string_view_empty();
+    iree_status_ignore(iree_vm_native_module_get_export_function(
+        module, call->function.ordinal, NULL, &function_name, NULL));
+    return iree_status_annotate_f(status,
+                                  "while invoking native function %.*s.%.*s",
+                                  (int)module_name.size, module_name.data,
+                                  (int)function_name.size, function_name.data);
+  }
+
+  return iree_vm_stack_function_leave(stack);
+}
+
 static iree_status_t IREE_API_PTR iree_vm_native_module_begin_call(
     void* self, iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
     iree_vm_execution_result_t* out_result) {
@@ -301,23 +329,45 @@ static iree_status_t IREE_API_PTR iree_vm_native_module_begin_call(
       /*frame_cleanup_fn=*/NULL, &callee_frame));
 
   // Call the target function using the shim.
-  const iree_vm_native_function_ptr_t* function_ptr =
-      &module->descriptor->functions[call->function.ordinal];
-  iree_vm_module_state_t* module_state = callee_frame->module_state;
-  iree_status_t status = function_ptr->shim(stack, call, function_ptr->target,
-                                            module, module_state, out_result);
-  if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
-    iree_string_view_t module_name = iree_vm_native_module_name(module);
-    iree_string_view_t function_name = iree_string_view_empty();
-    iree_status_ignore(iree_vm_native_module_get_export_function(
-        module, call->function.ordinal, NULL, &function_name, NULL));
-    return iree_status_annotate_f(status,
-                                  "while invoking native function %.*s.%.*s",
-                                  (int)module_name.size, module_name.data,
-                                  (int)function_name.size, function_name.data);
-  }
+  return iree_vm_native_module_issue_call(
+      module, stack, call,
+      &module->descriptor->functions[call->function.ordinal],
+      callee_frame->module_state, out_result);
+}
 
-  return iree_vm_stack_function_leave(stack);
+static iree_status_t IREE_API_PTR iree_vm_native_module_call_target(
+    void* self, const void* target, iree_vm_stack_t* stack,
+    iree_vm_module_state_t* module_state, const iree_vm_function_call_t* call,
+    iree_vm_execution_result_t* out_result) {
+  iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
+  IREE_RETURN_IF_ERROR(iree_vm_stack_function_enter_with_state(
+      stack, &call->function, module_state, IREE_VM_STACK_FRAME_NATIVE,
+      /*frame_size=*/0, /*frame_cleanup_fn=*/NULL, /*out_callee_frame=*/NULL));
+  return iree_vm_native_module_issue_call(
+      module, stack, call, (const iree_vm_native_function_ptr_t*)target,
+      module_state, out_result);
+}
+
+static iree_status_t IREE_API_PTR iree_vm_native_module_resolve_call_target(
+    void* self, const iree_vm_function_t* function,
+    iree_vm_function_call_target_t* out_target) {
+  iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
+  memset(out_target, 0, sizeof(*out_target));
+  if (module->user_interface.begin_call) {
+    // User-provided call handling must go through begin_call.
+    return iree_make_status(IREE_STATUS_UNAVAILABLE);
+  }
+  if (IREE_UNLIKELY(function->linkage != IREE_VM_FUNCTION_LINKAGE_EXPORT) ||
+      IREE_UNLIKELY(function->ordinal >= module->descriptor->export_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "function ordinal out of bounds: 0 < %u < %zu",
+                            function->ordinal,
+                            module->descriptor->export_count);
+  }
+  out_target->fn = iree_vm_native_module_call_target;
+  out_target->self = module;
+  out_target->target = &module->descriptor->functions[function->ordinal];
+  return iree_ok_status();
 }
 
 static iree_status_t IREE_API_PTR
@@ -427,6 +477,8 @@ IREE_API_EXPORT iree_status_t iree_vm_native_module_initialize(
   module->base_interface.resolve_import = iree_vm_native_module_resolve_import;
   module->base_interface.begin_call = iree_vm_native_module_begin_call;
   module->base_interface.resume_call = iree_vm_native_module_resume_call;
+  module->base_interface.resolve_call_target =
+      iree_vm_native_module_resolve_call_target;
 
   return iree_ok_status();
 }
@@ -88,6 +88,7 @@ class NativeModule {
     interface_.free_state = NativeModule::ModuleFreeState;
     interface_.resolve_import = NativeModule::ModuleResolveImport;
     interface_.begin_call = NativeModule::ModuleBeginCall;
+    interface_.resolve_call_target = NativeModule::ModuleResolveCallTarget;
   }
 
   virtual ~NativeModule() = default;
@@ -234,11 +235,55 @@ class NativeModule {
         stack, &call->function, IREE_VM_STACK_FRAME_NATIVE, frame_size,
         /*frame_cleanup_fn=*/nullptr, &callee_frame));
 
-    auto* state = FromStatePointer(callee_frame->module_state);
+    return module->IssueCall(info, callee_frame->module_state, stack, call,
+                             out_result);
+  }
+
+  static iree_status_t ModuleResolveCallTarget(
+      void* self, const iree_vm_function_t* function,
+      iree_vm_function_call_target_t* out_target) {
+    auto* module = FromModulePointer(self);
+    std::memset(out_target, 0, sizeof(*out_target));
+    if (IREE_UNLIKELY(function->linkage != IREE_VM_FUNCTION_LINKAGE_EXPORT) ||
+        IREE_UNLIKELY(function->ordinal >= module->dispatch_table_.size())) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "function ordinal out of bounds: 0 < %u < %zu",
+                              function->ordinal,
+                              module->dispatch_table_.size());
+    }
+    out_target->fn = NativeModule::ModuleCallTarget;
+    out_target->self = module;
+    out_target->target = &module->dispatch_table_[function->ordinal];
+    return iree_ok_status();
+  }
+
+  static iree_status_t ModuleCallTarget(
+      void* self, const void* target, iree_vm_stack_t* stack,
+      iree_vm_module_state_t* module_state, const iree_vm_function_call_t* call,
+      iree_vm_execution_result_t* out_result) {
+    IREE_ASSERT_ARGUMENT(out_result);
+    std::memset(out_result, 0, sizeof(*out_result));
+    auto* module = FromModulePointer(self);
+    const auto& info = *reinterpret_cast<const NativeFunction<State>*>(target);
+    IREE_RETURN_IF_ERROR(iree_vm_stack_function_enter_with_state(
+        stack, &call->function, module_state, IREE_VM_STACK_FRAME_NATIVE,
+        /*frame_size=*/0, /*frame_cleanup_fn=*/nullptr,
+        /*out_callee_frame=*/nullptr));
+    return module->IssueCall(info, module_state, stack, call, out_result);
+  }
+
+  // Calls |info| within an already entered callee frame and leaves the frame
+  // upon success.
+  iree_status_t IssueCall(const NativeFunction<State>& info,
+                          iree_vm_module_state_t* module_state,
+                          iree_vm_stack_t* stack,
+                          const iree_vm_function_call_t* call,
+                          iree_vm_execution_result_t* out_result) {
+    auto* state = FromStatePointer(module_state);
     iree_status_t status = info.call(info.ptr, state, stack, call, out_result);
     if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
       status = iree_status_annotate_f(
-          status, "while invoking C++ function %s.%.*s", module->name_,
+          status, "while invoking C++ function %s.%.*s", name_,
           (int)info.name.size, info.name.data);
       return status;
     }
@@ -26,6 +26,8 @@
 namespace iree {
 namespace {
 
+using ::iree::testing::status::StatusIs;
+
 // Test suite that uses module_a and module_b defined in native_module_test.h.
 // Both modules are put in a context and the module_b.entry function can be
 // executed with RunFunction.
@@ -94,6 +96,8 @@ class VMNativeModuleTest : public ::testing::Test {
     return ret0_value.i32;
   }
 
+  iree_vm_context_t* context() const { return context_; }
+
  private:
   iree_vm_instance_t* instance_ = nullptr;
   iree_vm_context_t* context_ = nullptr;
@@ -111,5 +115,50 @@ TEST_F(VMNativeModuleTest, Example) {
   ASSERT_EQ(v2, 8);
 }
 
+// Tests calling an export through a resolved direct call target with the
+// module state resolved up-front (as done by bytecode import call sites).
+TEST_F(VMNativeModuleTest, DirectCallTarget) {
+  iree_vm_function_t function;
+  IREE_ASSERT_OK(iree_vm_context_resolve_function(
+      context(), iree_make_cstring_view("module_a.add_1"), &function));
+  ASSERT_NE(nullptr, function.module->resolve_call_target);
+  iree_vm_function_call_target_t call_target;
+  IREE_ASSERT_OK(function.module->resolve_call_target(
+      function.module->self, &function, &call_target));
+  ASSERT_NE(nullptr, call_target.fn);
+  iree_vm_module_state_t* module_state = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_resolve_module_state(
+      context(), function.module, &module_state));
+
+  int32_t arg0 = 41;
+  int32_t ret0 = 0;
+  iree_vm_function_call_t call;
+  memset(&call, 0, sizeof(call));
+  call.function = function;
+  call.arguments = iree_make_byte_span(&arg0, sizeof(arg0));
+  call.results = iree_make_byte_span(&ret0, sizeof(ret0));
+  iree_vm_execution_result_t result;
+  IREE_VM_INLINE_STACK_INITIALIZE(stack,
+                                  iree_vm_context_state_resolver(context()),
+                                  iree_allocator_system());
+  IREE_EXPECT_OK(call_target.fn(call_target.self, call_target.target, stack,
+                                module_state, &call, &result));
+  iree_vm_stack_deinitialize(stack);
+  EXPECT_EQ(42, ret0);
+}
+
+// Tests that only exports can be resolved to direct call targets.
+TEST_F(VMNativeModuleTest, DirectCallTargetRequiresExport) {
+  iree_vm_function_t function;
+  IREE_ASSERT_OK(iree_vm_context_resolve_function(
+      context(), iree_make_cstring_view("module_a.add_1"), &function));
+  function.linkage = IREE_VM_FUNCTION_LINKAGE_IMPORT;
+  iree_vm_function_call_target_t call_target;
+  EXPECT_THAT(Status(function.module->resolve_call_target(
+                  function.module->self, &function, &call_target)),
+              StatusIs(StatusCode::kInvalidArgument));
+  EXPECT_EQ(nullptr, call_target.fn);
+}
+
 }  // namespace
 }  // namespace iree
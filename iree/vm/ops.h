@@ -19,8 +19,21 @@
 #include <stdint.h>
 
 #include "iree/base/api.h"
+#include "iree/vm/ref.h"
 #include "iree/vm/value.h"
 
+//===------------------------------------------------------------------===//
+// Refs
+//===------------------------------------------------------------------===//
+
+// Retains |ref| into |out_ref|, releasing the ref previously held by
+// |out_ref|. Unlike iree_vm_ref_retain this doesn't leak a reference when both
+// already point at the same object and is a no-op if they alias.
+static inline void vm_ref_retain(iree_vm_ref_t* ref, iree_vm_ref_t* out_ref) {
+  if (ref == out_ref) return;
+  iree_vm_ref_retain_or_move(/*is_move=*/0, ref, out_ref);
+}
+
 //===------------------------------------------------------------------===//
 // Globals
 //===------------------------------------------------------------------===//
@@ -36,6 +49,38 @@ static inline void vm_global_store_i32(uint8_t* base, uint32_t byte_offset,
   *global_ptr = value;
 }
 
+static inline int64_t vm_global_load_i64(uint8_t* base, uint32_t byte_offset) {
+  const int64_t* global_ptr = (const int64_t*)(base + byte_offset);
+  return *global_ptr;
+}
+
+static inline void vm_global_store_i64(uint8_t* base, uint32_t byte_offset,
+                                       int64_t value) {
+  int64_t* global_ptr = (int64_t*)(base + byte_offset);
+  *global_ptr = value;
+}
+
+static inline float vm_global_load_f32(uint8_t* base, uint32_t byte_offset) {
+  const float* global_ptr = (const float*)(base + byte_offset);
+  return *global_ptr;
+}
+
+static inline void vm_global_store_f32(uint8_t* base, uint32_t byte_offset,
+                                       float value) {
+  float* global_ptr = (float*)(base + byte_offset);
+  *global_ptr = value;
+}
+
+static inline void vm_global_load_ref(iree_vm_ref_t* refs, uint32_t ordinal,
+                                      iree_vm_ref_t* value) {
+  vm_ref_retain(&refs[ordinal], value);
+}
+
+static inline void vm_global_store_ref(iree_vm_ref_t* refs, uint32_t ordinal,
+                                       iree_vm_ref_t* value) {
+  vm_ref_retain(value, &refs[ordinal]);
+}
+
 //===------------------------------------------------------------------===//
 // Conditional assignment
 //===------------------------------------------------------------------===//
@@ -50,6 +95,12 @@ static inline float vm_select_f32(int32_t condition, float true_value,
   return condition ? true_value : false_value;
 }
 
+static inline void vm_select_ref(int32_t condition, iree_vm_ref_t* true_value,
+                                 iree_vm_ref_t* false_value,
+                                 iree_vm_ref_t* result) {
+  vm_ref_retain(condition ? true_value : false_value, result);
+}
+
 //===------------------------------------------------------------------===//
 // Native integer arithmetic
 //===------------------------------------------------------------------===//
@@ -204,6 +255,16 @@ static inline int32_t vm_cmp_lte_f32u(float lhs, float rhs) {
 }
 static inline int32_t vm_cmp_nan_f32(float operand) { return isnan(operand); }
 
+static inline int32_t vm_cmp_eq_ref(iree_vm_ref_t* lhs, iree_vm_ref_t* rhs) {
+  return iree_vm_ref_equal(lhs, rhs) ? 1 : 0;
+}
+static inline int32_t vm_cmp_ne_ref(iree_vm_ref_t* lhs, iree_vm_ref_t* rhs) {
+  return iree_vm_ref_equal(lhs, rhs) ? 0 : 1;
+}
+static inline int32_t vm_cmp_nz_ref(iree_vm_ref_t* operand) {
+  return (operand->ptr != NULL) ? 1 : 0;
+}
+
 //===------------------------------------------------------------------===//
 // Control flow ops
 //===------------------------------------------------------------------===//
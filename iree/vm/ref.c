@@ -18,13 +18,23 @@
 #include <string.h>
 
 #include "iree/base/internal/atomics.h"
-
-// TODO(benvanik): dynamic, if we care - otherwise keep small.
-// After a dozen or so types the linear scan will likely start to spill the
-// DCACHE and need to be reworked. I suspect at the time we have >=64 types
-// we'll want to rewrite all of this anyway (using externalized type ID storage
-// or something more complex).
-#define IREE_VM_MAX_TYPE_ID 64
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
+
+// Type descriptors are stored in fixed-size blocks so that registering new
+// types never moves existing entries: type IDs are stable for the lifetime of
+// the process and iree_vm_ref_release can resolve a descriptor with two loads
+// and no locking. The first block is statically allocated so that the builtin
+// types and most applications never hit the system allocator.
+#define IREE_VM_REF_TYPE_BLOCK_CAPACITY 64
+#define IREE_VM_REF_TYPE_MAX_BLOCKS 256
+#define IREE_VM_MAX_TYPE_ID \
+  (IREE_VM_REF_TYPE_BLOCK_CAPACITY * IREE_VM_REF_TYPE_MAX_BLOCKS)
+static_assert(IREE_VM_MAX_TYPE_ID <= IREE_VM_REF_TYPE_MAX_VALUE,
+              "type IDs must fit in the 24-bit iree_vm_ref_t::type field");
+
+// Initial capacity of the name->type ID hash index. Must be a power of two.
+#define IREE_VM_REF_TYPE_INITIAL_INDEX_CAPACITY 128
 
 static inline volatile iree_atomic_ref_count_t* iree_vm_get_raw_counter_ptr(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
@@ -59,6 +69,20 @@ IREE_API_EXPORT void iree_vm_ref_object_release(
   }
 }
 
+// Open-addressed hash index mapping type names to type IDs. A slot value of
+// IREE_VM_REF_TYPE_NULL indicates an empty slot. Kept at <= 50% load.
+//
+// Lookups probe the index without taking the registration lock. When the index
+// grows a new one is built and published and the old one is retired to the
+// |retired| chain of its replacement instead of being freed so that readers
+// still probing it never touch released memory. Retired indexes live as long
+// as the process, like the descriptor blocks.
+typedef struct iree_vm_ref_type_index_t {
+  iree_host_size_t capacity;
+  struct iree_vm_ref_type_index_t* retired;
+  iree_atomic_int32_t* slots;
+} iree_vm_ref_type_index_t;
+
 // A table of type descriptors registered at startup.
 // These provide quick dereferencing of destruction functions and type names for
 // debugging. Note that this just points to registered descriptors (or NULL) for
@@ -66,51 +90,210 @@ IREE_API_EXPORT void iree_vm_ref_object_release(
 //
 // Note that [0] is always the NULL type and has a NULL descriptor. We don't
 // allow types to be registered there.
+//
+// Registration is serialized by |mutex| while readers take no locks: a new
+// descriptor (and its block, if new) is stored before |type_count| is
+// published with release semantics and readers only dereference type IDs they
+// observe with acquire semantics to be within |type_count|.
+typedef struct {
+  // Blocks of IREE_VM_REF_TYPE_BLOCK_CAPACITY descriptors each. Blocks are
+  // allocated on demand and never freed.
+  const iree_vm_ref_type_descriptor_t** blocks[IREE_VM_REF_TYPE_MAX_BLOCKS];
+  // Number of registered types excluding the reserved NULL type 0; the valid
+  // type IDs are [1, type_count].
+  iree_atomic_intptr_t type_count;
+  // Current iree_vm_ref_type_index_t* or 0 if the statically allocated initial
+  // index is still in use.
+  iree_atomic_intptr_t index;
+  // Serializes iree_vm_ref_register_type; initialized on first registration.
+  iree_slim_mutex_t mutex;
+} iree_vm_ref_type_registry_t;
+
 static const iree_vm_ref_type_descriptor_t*
-    iree_vm_ref_type_descriptors[IREE_VM_MAX_TYPE_ID] = {0};
+    iree_vm_ref_type_descriptors_block0[IREE_VM_REF_TYPE_BLOCK_CAPACITY] = {0};
+static iree_atomic_int32_t
+    iree_vm_ref_type_index_storage[IREE_VM_REF_TYPE_INITIAL_INDEX_CAPACITY];
+static iree_vm_ref_type_index_t iree_vm_ref_type_index_initial = {
+    /*capacity=*/IREE_VM_REF_TYPE_INITIAL_INDEX_CAPACITY,
+    /*retired=*/NULL,
+    /*slots=*/iree_vm_ref_type_index_storage,
+};
+static iree_vm_ref_type_registry_t iree_vm_ref_type_registry = {
+    /*blocks=*/{iree_vm_ref_type_descriptors_block0},
+};
+static iree_once_flag iree_vm_ref_type_registry_flag_ = IREE_ONCE_FLAG_INIT;
+static void iree_vm_ref_type_registry_initialize(void) {
+  iree_slim_mutex_initialize(&iree_vm_ref_type_registry.mutex);
+}
 
 // Returns the type descriptor (or NULL) for the given type ID.
-static const iree_vm_ref_type_descriptor_t* iree_vm_ref_get_type_descriptor(
-    iree_vm_ref_type_t type) {
+static inline const iree_vm_ref_type_descriptor_t*
+iree_vm_ref_get_type_descriptor(iree_vm_ref_type_t type) {
+  iree_host_size_t type_count = (iree_host_size_t)iree_atomic_load_intptr(
+      &iree_vm_ref_type_registry.type_count, iree_memory_order_acquire);
+  if (type > type_count) return NULL;
+  return iree_vm_ref_type_registry
+      .blocks[type / IREE_VM_REF_TYPE_BLOCK_CAPACITY]
+             [type % IREE_VM_REF_TYPE_BLOCK_CAPACITY];
+}
+
+// Returns the currently published name->type ID index.
+static inline const iree_vm_ref_type_index_t* iree_vm_ref_type_index(void) {
+  const iree_vm_ref_type_index_t* index =
+      (const iree_vm_ref_type_index_t*)iree_atomic_load_intptr(
+          &iree_vm_ref_type_registry.index, iree_memory_order_acquire);
+  return index ? index : &iree_vm_ref_type_index_initial;
+}
+
+// 32-bit FNV-1a hash of the type name; names are short and this is only used
+// during registration and lookup so quality beyond that is not important.
+static uint32_t iree_vm_ref_type_name_hash(iree_string_view_t name) {
+  uint32_t hash = 0x811C9DC5u;
+  for (iree_host_size_t i = 0; i < name.size; ++i) {
+    hash ^= (uint8_t)name.data[i];
+    hash *= 0x01000193u;
+  }
+  return hash;
+}
+
+// Inserts |type| into |index| with linear probing. If a type with the same name
+// is already present the existing entry is kept so that lookups continue to
+// return the first type registered under a name. |type| must already be
+// published in the registry. Must be called with the registry mutex held.
+static void iree_vm_ref_type_index_insert(iree_vm_ref_type_index_t* index,
+                                          iree_vm_ref_type_t type) {
+  iree_string_view_t type_name =
+      iree_vm_ref_get_type_descriptor(type)->type_name;
+  iree_host_size_t mask = index->capacity - 1;
+  iree_host_size_t slot = iree_vm_ref_type_name_hash(type_name) & mask;
+  iree_vm_ref_type_t slot_type = IREE_VM_REF_TYPE_NULL;
+  while ((slot_type = (iree_vm_ref_type_t)iree_atomic_load_int32(
+              &index->slots[slot], iree_memory_order_relaxed)) !=
+         IREE_VM_REF_TYPE_NULL) {
+    if (iree_string_view_equal(
+            iree_vm_ref_get_type_descriptor(slot_type)->type_name,
+            type_name)) {
+      return;
+    }
+    slot = (slot + 1) & mask;
+  }
+  iree_atomic_store_int32(&index->slots[slot], (int32_t)type,
+                          iree_memory_order_release);
+}
+
+// Builds an index with double the capacity of the current one containing all
+// registered types and publishes it. The old index is retired and not freed as
+// concurrent lookups may still be probing it. Must be called with the registry
+// mutex held.
+static iree_status_t iree_vm_ref_type_index_grow(void) {
+  iree_vm_ref_type_registry_t* registry = &iree_vm_ref_type_registry;
+  iree_vm_ref_type_index_t* old_index =
+      (iree_vm_ref_type_index_t*)iree_vm_ref_type_index();
+  iree_host_size_t new_capacity = old_index->capacity * 2;
+  iree_vm_ref_type_index_t* new_index = NULL;
+  iree_host_size_t total_size =
+      sizeof(*new_index) + new_capacity * sizeof(new_index->slots[0]);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(iree_allocator_system(),
+                                             total_size, (void**)&new_index));
+  memset(new_index, 0, total_size);
+  new_index->capacity = new_capacity;
+  new_index->retired = old_index;
+  new_index->slots = (iree_atomic_int32_t*)(new_index + 1);
+  iree_host_size_t type_count = (iree_host_size_t)iree_atomic_load_intptr(
+      &registry->type_count, iree_memory_order_relaxed);
+  for (iree_host_size_t i = 1; i <= type_count; ++i) {
+    iree_vm_ref_type_index_insert(new_index, (iree_vm_ref_type_t)i);
+  }
+  iree_atomic_store_intptr(&registry->index, (intptr_t)new_index,
+                           iree_memory_order_release);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_ref_register_type_locked(
+    iree_vm_ref_type_descriptor_t* descriptor) {
+  iree_vm_ref_type_registry_t* registry = &iree_vm_ref_type_registry;
+
+  // Registering the same descriptor multiple times is a no-op.
+  if (descriptor->type != IREE_VM_REF_TYPE_NULL &&
+      iree_vm_ref_get_type_descriptor(descriptor->type) == descriptor) {
+    return iree_ok_status();
+  }
+
+  iree_host_size_t type_count = (iree_host_size_t)iree_atomic_load_intptr(
+      &registry->type_count, iree_memory_order_relaxed);
+  iree_host_size_t type = type_count + 1;
   if (type >= IREE_VM_MAX_TYPE_ID) {
-    return NULL;
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "too many user-defined types registered; new type "
+                            "would exceed maximum of %d",
+                            IREE_VM_MAX_TYPE_ID);
+  }
+
+  // Keep the index at <= 50% load so that probe sequences stay short.
+  if ((type + 1) * 2 > iree_vm_ref_type_index()->capacity) {
+    IREE_RETURN_IF_ERROR(iree_vm_ref_type_index_grow());
+  }
+
+  // Allocate the block the new type ID falls into if this is the first type in
+  // it. Blocks are zeroed so that unassigned IDs resolve to NULL.
+  iree_host_size_t block_ordinal = type / IREE_VM_REF_TYPE_BLOCK_CAPACITY;
+  if (!registry->blocks[block_ordinal]) {
+    iree_host_size_t block_size =
+        IREE_VM_REF_TYPE_BLOCK_CAPACITY * sizeof(*registry->blocks[0]);
+    void* block = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_allocator_malloc(iree_allocator_system(), block_size, &block));
+    memset(block, 0, block_size);
+    registry->blocks[block_ordinal] =
+        (const iree_vm_ref_type_descriptor_t**)block;
   }
-  return iree_vm_ref_type_descriptors[type];
+
+  // Store the descriptor before publishing the new count so that readers that
+  // observe the type ID also observe its descriptor.
+  registry->blocks[block_ordinal][type % IREE_VM_REF_TYPE_BLOCK_CAPACITY] =
+      descriptor;
+  descriptor->type = (iree_vm_ref_type_t)type;
+  iree_atomic_store_intptr(&registry->type_count, (intptr_t)type,
+                           iree_memory_order_release);
+  iree_vm_ref_type_index_insert(
+      (iree_vm_ref_type_index_t*)iree_vm_ref_type_index(), descriptor->type);
+  return iree_ok_status();
 }
 
 IREE_API_EXPORT iree_status_t
 iree_vm_ref_register_type(iree_vm_ref_type_descriptor_t* descriptor) {
-  for (int i = 1; i <= IREE_VM_MAX_TYPE_ID; ++i) {
-    if (!iree_vm_ref_type_descriptors[i]) {
-      iree_vm_ref_type_descriptors[i] = descriptor;
-      descriptor->type = i;
-      return iree_ok_status();
-    }
-  }
-  // Too many user-defined types registered; need to increase
-  // IREE_VM_MAX_TYPE_ID.
-  return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
-                          "too many user-defined types registered; new type "
-                          "would exceed maximum of %d",
-                          IREE_VM_MAX_TYPE_ID);
+  iree_vm_ref_type_registry_t* registry = &iree_vm_ref_type_registry;
+  iree_call_once(&iree_vm_ref_type_registry_flag_,
+                 iree_vm_ref_type_registry_initialize);
+  iree_slim_mutex_lock(&registry->mutex);
+  iree_status_t status = iree_vm_ref_register_type_locked(descriptor);
+  iree_slim_mutex_unlock(&registry->mutex);
+  return status;
 }
 
 IREE_API_EXPORT iree_string_view_t
 iree_vm_ref_type_name(iree_vm_ref_type_t type) {
-  if (type == 0 || type >= IREE_VM_MAX_TYPE_ID) {
-    return iree_string_view_empty();
-  }
-  return iree_vm_ref_type_descriptors[type]->type_name;
+  const iree_vm_ref_type_descriptor_t* type_descriptor =
+      iree_vm_ref_get_type_descriptor(type);
+  if (!type_descriptor) return iree_string_view_empty();
+  return type_descriptor->type_name;
 }
 
 IREE_API_EXPORT const iree_vm_ref_type_descriptor_t*
 iree_vm_ref_lookup_registered_type(iree_string_view_t full_name) {
-  for (int i = 1; i <= IREE_VM_MAX_TYPE_ID; ++i) {
-    if (!iree_vm_ref_type_descriptors[i]) break;
-    if (iree_string_view_compare(iree_vm_ref_type_descriptors[i]->type_name,
-                                 full_name) == 0) {
-      return iree_vm_ref_type_descriptors[i];
+  const iree_vm_ref_type_index_t* index = iree_vm_ref_type_index();
+  iree_host_size_t mask = index->capacity - 1;
+  iree_host_size_t slot = iree_vm_ref_type_name_hash(full_name) & mask;
+  iree_vm_ref_type_t slot_type = IREE_VM_REF_TYPE_NULL;
+  while ((slot_type = (iree_vm_ref_type_t)iree_atomic_load_int32(
+              &index->slots[slot], iree_memory_order_acquire)) !=
+         IREE_VM_REF_TYPE_NULL) {
+    const iree_vm_ref_type_descriptor_t* type_descriptor =
+        iree_vm_ref_get_type_descriptor(slot_type);
+    if (iree_string_view_equal(type_descriptor->type_name, full_name)) {
+      return type_descriptor;
     }
+    slot = (slot + 1) & mask;
   }
   return NULL;
 }
@@ -131,6 +131,11 @@ IREE_API_EXPORT void iree_vm_ref_object_release(
 // reference count goes to 0. NULL can be used to no-op the destruction if the
 // type is not owned by the VM.
 //
+// Type IDs are assigned in registration order and remain stable for the
+// lifetime of the process. Registering a descriptor that has already been
+// registered is a no-op. If multiple types are registered with the same name
+// then iree_vm_ref_lookup_registered_type will return the first one.
+//
 // TODO(benvanik): keep names alive for user types?
 // NOTE: the name is not retained and must be kept live by the caller. Ideally
 // it is stored in static read-only memory in the binary.
@@ -145,6 +150,7 @@ IREE_API_EXPORT iree_string_view_t
 iree_vm_ref_type_name(iree_vm_ref_type_t type);
 
 // Returns the registered type descriptor for the given type, if found.
+// Lookups are performed against a hash index and are O(1) on average.
 IREE_API_EXPORT const iree_vm_ref_type_descriptor_t*
 iree_vm_ref_lookup_registered_type(iree_string_view_t full_name);
 
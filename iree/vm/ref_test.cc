@@ -16,6 +16,9 @@
 
 #include <cstddef>
 #include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "iree/base/api.h"
 #include "iree/testing/gtest.h"
@@ -97,6 +100,75 @@ TEST(VMRefTest, TypeRegistration) {
                          iree_make_cstring_view("asodjfaoisdjfaoisdfj")));
 }
 
+// Tests that registering more types than fit in a single registry block keeps
+// all type IDs stable and resolvable by name.
+TEST(VMRefTest, TypeRegistrationGrowth) {
+  static const int kTypeCount = 200;
+  static std::string type_names[kTypeCount];
+  static iree_vm_ref_type_descriptor_t descriptors[kTypeCount];
+  for (int i = 0; i < kTypeCount; ++i) {
+    type_names[i] = "GrowthType" + std::to_string(i);
+    descriptors[i] = {0};
+    descriptors[i].type_name = iree_make_string_view(type_names[i].data(),
+                                                     type_names[i].size());
+    descriptors[i].offsetof_counter =
+        offsetof(ref_object_c_t, ref_object.counter);
+    IREE_ASSERT_OK(iree_vm_ref_register_type(&descriptors[i]));
+  }
+  for (int i = 0; i < kTypeCount; ++i) {
+    const iree_vm_ref_type_descriptor_t* descriptor =
+        iree_vm_ref_lookup_registered_type(descriptors[i].type_name);
+    ASSERT_EQ(&descriptors[i], descriptor);
+    EXPECT_TRUE(iree_string_view_equal(
+        descriptors[i].type_name, iree_vm_ref_type_name(descriptor->type)));
+  }
+
+  // Re-registering an existing descriptor must not assign a new type ID.
+  iree_vm_ref_type_t existing_type = descriptors[0].type;
+  IREE_ASSERT_OK(iree_vm_ref_register_type(&descriptors[0]));
+  EXPECT_EQ(existing_type, descriptors[0].type);
+}
+
+// Tests that lookups racing with registrations that grow the name index
+// always resolve previously registered types.
+TEST(VMRefTest, ConcurrentTypeRegistrationAndLookup) {
+  static const int kThreadCount = 4;
+  static const int kTypesPerThread = 256;
+  static std::string type_names[kThreadCount][kTypesPerThread];
+  static iree_vm_ref_type_descriptor_t
+      descriptors[kThreadCount][kTypesPerThread];
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([t]() {
+      for (int i = 0; i < kTypesPerThread; ++i) {
+        type_names[t][i] =
+            "ConcurrentType" + std::to_string(t) + "_" + std::to_string(i);
+        descriptors[t][i] = {0};
+        descriptors[t][i].type_name = iree_make_string_view(
+            type_names[t][i].data(), type_names[t][i].size());
+        descriptors[t][i].offsetof_counter =
+            offsetof(ref_object_c_t, ref_object.counter);
+        IREE_ASSERT_OK(iree_vm_ref_register_type(&descriptors[t][i]));
+        // Everything this thread registered so far must remain visible while
+        // the other threads keep growing the registry.
+        for (int j = 0; j <= i; ++j) {
+          ASSERT_EQ(&descriptors[t][j], iree_vm_ref_lookup_registered_type(
+                                            descriptors[t][j].type_name));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int t = 0; t < kThreadCount; ++t) {
+    for (int i = 0; i < kTypesPerThread; ++i) {
+      EXPECT_TRUE(iree_string_view_equal(
+          descriptors[t][i].type_name,
+          iree_vm_ref_type_name(descriptors[t][i].type)));
+    }
+  }
+}
+
 // Tests wrapping a simple C struct.
 TEST(VMRefTest, WrappingCStruct) {
   RegisterTypeC();
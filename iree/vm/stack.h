@@ -208,6 +208,17 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter(
     iree_vm_stack_frame_cleanup_fn_t frame_cleanup_fn,
     iree_vm_stack_frame_t** out_callee_frame);
 
+// Enters into the given |function| with an already-resolved |module_state|.
+// This behaves the same as iree_vm_stack_function_enter but skips the state
+// resolver query and is intended for callers that cache the callee module state
+// across calls (such as iree_vm_function_call_target_t call sites).
+IREE_API_EXPORT iree_status_t iree_vm_stack_function_enter_with_state(
+    iree_vm_stack_t* stack, const iree_vm_function_t* function,
+    iree_vm_module_state_t* module_state, iree_vm_stack_frame_type_t frame_type,
+    iree_host_size_t frame_size,
+    iree_vm_stack_frame_cleanup_fn_t frame_cleanup_fn,
+    iree_vm_stack_frame_t** out_callee_frame);
+
 // Leaves the current stack frame.
 IREE_API_EXPORT iree_status_t
 iree_vm_stack_function_leave(iree_vm_stack_t* stack);
@@ -0,0 +1,274 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/vm/startup_profiler.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+IREE_API_EXPORT iree_string_view_t
+iree_vm_startup_phase_name(iree_vm_startup_phase_t phase) {
+  switch (phase) {
+    case IREE_VM_STARTUP_PHASE_ALLOC_STATE:
+      return IREE_SV("alloc_state");
+    case IREE_VM_STARTUP_PHASE_RESOLVE_IMPORTS:
+      return IREE_SV("resolve_imports");
+    case IREE_VM_STARTUP_PHASE_INITIALIZE:
+      return IREE_SV("initialize");
+    case IREE_VM_STARTUP_PHASE_EXECUTABLE_PREPARE:
+      return IREE_SV("executable_prepare");
+    case IREE_VM_STARTUP_PHASE_CONSTANT_UPLOAD:
+      return IREE_SV("constant_upload");
+    default:
+      return IREE_SV("unknown");
+  }
+}
+
+// Aggregated time for one phase of a module.
+typedef struct {
+  uint64_t count;
+  iree_duration_t total_time_ns;
+  iree_duration_t max_time_ns;
+  uint64_t total_bytes;
+} iree_vm_startup_profile_phase_t;
+
+// Aggregated results for all contexts registering a module with the same name.
+// The name is stored immediately following the entry in the same allocation.
+typedef struct {
+  iree_string_view_t module_name;
+  iree_vm_startup_profile_phase_t phases[IREE_VM_STARTUP_PHASE_COUNT];
+} iree_vm_startup_profile_entry_t;
+
+struct iree_vm_startup_profiler_s {
+  iree_atomic_int32_t enabled;
+
+  iree_slim_mutex_t mutex;
+  iree_host_size_t entry_count IREE_GUARDED_BY(mutex);
+  iree_host_size_t entry_capacity IREE_GUARDED_BY(mutex);
+  iree_vm_startup_profile_entry_t** entries IREE_GUARDED_BY(mutex);
+};
+
+static iree_vm_startup_profiler_t iree_vm_startup_profiler_default_;
+static iree_once_flag iree_vm_startup_profiler_default_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_vm_startup_profiler_default_initialize(void) {
+  memset(&iree_vm_startup_profiler_default_, 0,
+         sizeof(iree_vm_startup_profiler_default_));
+  iree_slim_mutex_initialize(&iree_vm_startup_profiler_default_.mutex);
+}
+
+IREE_API_EXPORT iree_vm_startup_profiler_t* iree_vm_startup_profiler_default(
+    void) {
+  iree_call_once(&iree_vm_startup_profiler_default_flag_,
+                 iree_vm_startup_profiler_default_initialize);
+  return &iree_vm_startup_profiler_default_;
+}
+
+IREE_API_EXPORT void iree_vm_startup_profiler_set_enabled(
+    iree_vm_startup_profiler_t* profiler, bool enabled) {
+  iree_atomic_store_int32(&profiler->enabled, enabled ? 1 : 0,
+                          iree_memory_order_release);
+}
+
+IREE_API_EXPORT bool iree_vm_startup_profiler_is_enabled(
+    iree_vm_startup_profiler_t* profiler) {
+  return iree_atomic_load_int32(&profiler->enabled,
+                                iree_memory_order_acquire) != 0;
+}
+
+// Returns the entry for |module_name|, allocating it if it does not exist.
+// Must be called with the profiler mutex held.
+static iree_status_t iree_vm_startup_profiler_find_or_append(
+    iree_vm_startup_profiler_t* profiler, iree_string_view_t module_name,
+    iree_vm_startup_profile_entry_t** out_entry) {
+  for (iree_host_size_t i = 0; i < profiler->entry_count; ++i) {
+    if (iree_string_view_equal(profiler->entries[i]->module_name,
+                               module_name)) {
+      *out_entry = profiler->entries[i];
+      return iree_ok_status();
+    }
+  }
+
+  iree_allocator_t allocator = iree_allocator_system();
+  if (profiler->entry_count == profiler->entry_capacity) {
+    iree_host_size_t new_capacity = iree_max(8, profiler->entry_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        allocator, new_capacity * sizeof(*profiler->entries),
+        (void**)&profiler->entries));
+    profiler->entry_capacity = new_capacity;
+  }
+  iree_vm_startup_profile_entry_t* entry = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      allocator, sizeof(*entry) + module_name.size, (void**)&entry));
+  memset(entry, 0, sizeof(*entry));
+  char* name_ptr = (char*)entry + sizeof(*entry);
+  memcpy(name_ptr, module_name.data, module_name.size);
+  entry->module_name = iree_make_string_view(name_ptr, module_name.size);
+
+  profiler->entries[profiler->entry_count++] = entry;
+  *out_entry = entry;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_startup_profiler_record(
+    iree_vm_startup_profiler_t* profiler, iree_string_view_t module_name,
+    iree_vm_startup_phase_t phase, iree_duration_t duration_ns,
+    uint64_t byte_length) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  if ((unsigned)phase >= IREE_VM_STARTUP_PHASE_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid startup phase %d", (int)phase);
+  }
+  iree_slim_mutex_lock(&profiler->mutex);
+  iree_vm_startup_profile_entry_t* entry = NULL;
+  iree_status_t status =
+      iree_vm_startup_profiler_find_or_append(profiler, module_name, &entry);
+  if (iree_status_is_ok(status)) {
+    iree_vm_startup_profile_phase_t* phase_entry = &entry->phases[phase];
+    ++phase_entry->count;
+    phase_entry->total_time_ns += duration_ns;
+    phase_entry->max_time_ns = iree_max(phase_entry->max_time_ns, duration_ns);
+    phase_entry->total_bytes += byte_length;
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+  return status;
+}
+
+IREE_API_EXPORT void iree_vm_startup_profiler_reset(
+    iree_vm_startup_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  iree_slim_mutex_lock(&profiler->mutex);
+  for (iree_host_size_t i = 0; i < profiler->entry_count; ++i) {
+    iree_allocator_free(iree_allocator_system(), profiler->entries[i]);
+  }
+  iree_allocator_free(iree_allocator_system(), profiler->entries);
+  profiler->entries = NULL;
+  profiler->entry_count = 0;
+  profiler->entry_capacity = 0;
+  iree_slim_mutex_unlock(&profiler->mutex);
+}
+
+//===----------------------------------------------------------------------===//
+// Summary output
+//===----------------------------------------------------------------------===//
+
+// Writes |value| as a quoted string escaping the characters that are
+// significant in |format|.
+static void iree_vm_startup_profile_print_string(
+    iree_vm_startup_profile_format_t format, iree_string_view_t value,
+    FILE* file) {
+  fputc('"', file);
+  for (iree_host_size_t i = 0; i < value.size; ++i) {
+    char c = value.data[i];
+    if (c == '"') {
+      fputs(format == IREE_VM_STARTUP_PROFILE_FORMAT_CSV ? "\"\"" : "\\\"",
+            file);
+    } else if (c == '\\' && format == IREE_VM_STARTUP_PROFILE_FORMAT_JSON) {
+      fputs("\\\\", file);
+    } else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+static void iree_vm_startup_profile_dump_csv(
+    iree_host_size_t entry_count,
+    iree_vm_startup_profile_entry_t* const* entries, FILE* file) {
+  fprintf(file, "module,phase,count,total_ms,max_ms,bytes\n");
+  for (iree_host_size_t i = 0; i < entry_count; ++i) {
+    const iree_vm_startup_profile_entry_t* entry = entries[i];
+    for (int j = 0; j < IREE_VM_STARTUP_PHASE_COUNT; ++j) {
+      const iree_vm_startup_profile_phase_t* phase = &entry->phases[j];
+      if (!phase->count) continue;
+      iree_string_view_t phase_name =
+          iree_vm_startup_phase_name((iree_vm_startup_phase_t)j);
+      iree_vm_startup_profile_print_string(IREE_VM_STARTUP_PROFILE_FORMAT_CSV,
+                                           entry->module_name, file);
+      fprintf(file, ",%.*s,%" PRIu64 ",%.3f,%.3f,%" PRIu64 "\n",
+              (int)phase_name.size, phase_name.data, phase->count,
+              phase->total_time_ns / 1e6, phase->max_time_ns / 1e6,
+              phase->total_bytes);
+    }
+  }
+}
+
+static void iree_vm_startup_profile_dump_json(
+    iree_host_size_t entry_count,
+    iree_vm_startup_profile_entry_t* const* entries, FILE* file) {
+  fprintf(file, "[\n");
+  for (iree_host_size_t i = 0; i < entry_count; ++i) {
+    const iree_vm_startup_profile_entry_t* entry = entries[i];
+    fprintf(file, "  {\"module\": ");
+    iree_vm_startup_profile_print_string(IREE_VM_STARTUP_PROFILE_FORMAT_JSON,
+                                         entry->module_name, file);
+    fprintf(file, ", \"phases\": {");
+    bool any_phase = false;
+    for (int j = 0; j < IREE_VM_STARTUP_PHASE_COUNT; ++j) {
+      const iree_vm_startup_profile_phase_t* phase = &entry->phases[j];
+      if (!phase->count) continue;
+      iree_string_view_t phase_name =
+          iree_vm_startup_phase_name((iree_vm_startup_phase_t)j);
+      fprintf(file,
+              "%s\"%.*s\": {\"count\": %" PRIu64
+              ", \"total_ms\": %.3f, \"max_ms\": %.3f, \"bytes\": %" PRIu64
+              "}",
+              any_phase ? ", " : "", (int)phase_name.size, phase_name.data,
+              phase->count, phase->total_time_ns / 1e6,
+              phase->max_time_ns / 1e6, phase->total_bytes);
+      any_phase = true;
+    }
+    fprintf(file, "}}%s\n", i + 1 < entry_count ? "," : "");
+  }
+  fprintf(file, "]\n");
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_startup_profiler_dump(
+    iree_vm_startup_profiler_t* profiler,
+    iree_vm_startup_profile_format_t format, FILE* file) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_ASSERT_ARGUMENT(file);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->mutex);
+
+  iree_status_t status = iree_ok_status();
+  switch (format) {
+    case IREE_VM_STARTUP_PROFILE_FORMAT_CSV:
+      iree_vm_startup_profile_dump_csv(profiler->entry_count,
+                                       profiler->entries, file);
+      break;
+    case IREE_VM_STARTUP_PROFILE_FORMAT_JSON:
+      iree_vm_startup_profile_dump_json(profiler->entry_count,
+                                        profiler->entries, file);
+      break;
+    default:
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "unsupported startup profile format %d",
+                                (int)format);
+      break;
+  }
+
+  iree_slim_mutex_unlock(&profiler->mutex);
+  if (iree_status_is_ok(status) && ferror(file)) {
+    status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "failed to write startup profile");
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,101 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_VM_STARTUP_PROFILER_H_
+#define IREE_VM_STARTUP_PROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_vm_startup_profiler_t
+//===----------------------------------------------------------------------===//
+
+// A phase of context startup that time is attributed to.
+typedef enum {
+  // Module state allocation (iree_vm_module_t::alloc_state).
+  IREE_VM_STARTUP_PHASE_ALLOC_STATE = 0,
+  // Resolution of module imports against previously registered modules.
+  IREE_VM_STARTUP_PHASE_RESOLVE_IMPORTS,
+  // Module `__init` functions, including any work they perform below.
+  IREE_VM_STARTUP_PHASE_INITIALIZE,
+  // Preparation of device executables. Nested within the initialize phase of
+  // the calling module unless preparation is deferred to first use.
+  IREE_VM_STARTUP_PHASE_EXECUTABLE_PREPARE,
+  // Upload of constant buffer contents. Nested within the initialize phase.
+  IREE_VM_STARTUP_PHASE_CONSTANT_UPLOAD,
+
+  IREE_VM_STARTUP_PHASE_COUNT,
+} iree_vm_startup_phase_t;
+
+// Returns the short name of |phase| as used in reports (like `initialize`).
+IREE_API_EXPORT iree_string_view_t
+iree_vm_startup_phase_name(iree_vm_startup_phase_t phase);
+
+typedef enum {
+  // Comma-separated values with one row per module and phase and a header.
+  IREE_VM_STARTUP_PROFILE_FORMAT_CSV = 0,
+  // JSON array with one object per module containing all of its phases.
+  IREE_VM_STARTUP_PROFILE_FORMAT_JSON = 1,
+} iree_vm_startup_profile_format_t;
+
+// Process-wide breakdown of where time is spent bringing up contexts.
+// Recording is opt-in: the VM and modules check
+// iree_vm_startup_profiler_is_enabled and only query the clock when it is set.
+//
+// Time is aggregated by module name and phase so that creating many contexts
+// produces a single summary. Thread-safe.
+typedef struct iree_vm_startup_profiler_s iree_vm_startup_profiler_t;
+
+// Returns the process-wide default profiler.
+IREE_API_EXPORT iree_vm_startup_profiler_t* iree_vm_startup_profiler_default(
+    void);
+
+// Enables or disables recording.
+IREE_API_EXPORT void iree_vm_startup_profiler_set_enabled(
+    iree_vm_startup_profiler_t* profiler, bool enabled);
+
+// Returns true if recording is enabled.
+IREE_API_EXPORT bool iree_vm_startup_profiler_is_enabled(
+    iree_vm_startup_profiler_t* profiler);
+
+// Adds |duration_ns| spent in |phase| on behalf of |module_name|.
+// |byte_length| is the amount of data processed, if meaningful for the phase.
+IREE_API_EXPORT iree_status_t iree_vm_startup_profiler_record(
+    iree_vm_startup_profiler_t* profiler, iree_string_view_t module_name,
+    iree_vm_startup_phase_t phase, iree_duration_t duration_ns,
+    uint64_t byte_length);
+
+// Drops all aggregated results.
+IREE_API_EXPORT void iree_vm_startup_profiler_reset(
+    iree_vm_startup_profiler_t* profiler);
+
+// Writes the aggregated results to |file| in |format|. Modules are listed in
+// the order they were first recorded, which matches registration order.
+IREE_API_EXPORT iree_status_t iree_vm_startup_profiler_dump(
+    iree_vm_startup_profiler_t* profiler,
+    iree_vm_startup_profile_format_t format, FILE* file);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_VM_STARTUP_PROFILER_H_
@@ -0,0 +1,117 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/vm/startup_profiler.h"
+
+#include <cstdio>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+class StartupProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    profiler_ = iree_vm_startup_profiler_default();
+    iree_vm_startup_profiler_reset(profiler_);
+  }
+  void TearDown() override {
+    iree_vm_startup_profiler_set_enabled(profiler_, false);
+    iree_vm_startup_profiler_reset(profiler_);
+  }
+
+  void Record(const char* module_name, iree_vm_startup_phase_t phase,
+              iree_duration_t duration_ns, uint64_t byte_length = 0) {
+    IREE_ASSERT_OK(iree_vm_startup_profiler_record(
+        profiler_, iree_make_cstring_view(module_name), phase, duration_ns,
+        byte_length));
+  }
+
+  std::string Dump(iree_vm_startup_profile_format_t format) {
+    FILE* file = tmpfile();
+    IREE_EXPECT_OK(iree_vm_startup_profiler_dump(profiler_, format, file));
+    std::string contents(ftell(file), '\0');
+    rewind(file);
+    EXPECT_EQ(contents.size(),
+              fread(&contents[0], 1, contents.size(), file));
+    fclose(file);
+    return contents;
+  }
+
+  iree_vm_startup_profiler_t* profiler_ = nullptr;
+};
+
+TEST_F(StartupProfilerTest, Enable) {
+  EXPECT_FALSE(iree_vm_startup_profiler_is_enabled(profiler_));
+  iree_vm_startup_profiler_set_enabled(profiler_, true);
+  EXPECT_TRUE(iree_vm_startup_profiler_is_enabled(profiler_));
+  iree_vm_startup_profiler_set_enabled(profiler_, false);
+  EXPECT_FALSE(iree_vm_startup_profiler_is_enabled(profiler_));
+}
+
+TEST_F(StartupProfilerTest, EmptyCsv) {
+  EXPECT_EQ("module,phase,count,total_ms,max_ms,bytes\n",
+            Dump(IREE_VM_STARTUP_PROFILE_FORMAT_CSV));
+}
+
+TEST_F(StartupProfilerTest, AggregatesInRegistrationOrderCsv) {
+  Record("hal", IREE_VM_STARTUP_PHASE_ALLOC_STATE, 1000000);
+  Record("module", IREE_VM_STARTUP_PHASE_RESOLVE_IMPORTS, 500000);
+  Record("hal", IREE_VM_STARTUP_PHASE_EXECUTABLE_PREPARE, 2000000);
+  Record("hal", IREE_VM_STARTUP_PHASE_EXECUTABLE_PREPARE, 4000000);
+  Record("hal", IREE_VM_STARTUP_PHASE_CONSTANT_UPLOAD, 250000, 4096);
+  Record("module", IREE_VM_STARTUP_PHASE_INITIALIZE, 7000000);
+  EXPECT_EQ(
+      "module,phase,count,total_ms,max_ms,bytes\n"
+      "\"hal\",alloc_state,1,1.000,1.000,0\n"
+      "\"hal\",executable_prepare,2,6.000,4.000,0\n"
+      "\"hal\",constant_upload,1,0.250,0.250,4096\n"
+      "\"module\",resolve_imports,1,0.500,0.500,0\n"
+      "\"module\",initialize,1,7.000,7.000,0\n",
+      Dump(IREE_VM_STARTUP_PROFILE_FORMAT_CSV));
+}
+
+TEST_F(StartupProfilerTest, Json) {
+  Record("mod\"quoted", IREE_VM_STARTUP_PHASE_INITIALIZE, 3000000);
+  Record("mod\"quoted", IREE_VM_STARTUP_PHASE_ALLOC_STATE, 1000000);
+  EXPECT_EQ(
+      "[\n"
+      "  {\"module\": \"mod\\\"quoted\", \"phases\": {"
+      "\"alloc_state\": {\"count\": 1, \"total_ms\": 1.000, "
+      "\"max_ms\": 1.000, \"bytes\": 0}, "
+      "\"initialize\": {\"count\": 1, \"total_ms\": 3.000, "
+      "\"max_ms\": 3.000, \"bytes\": 0}}}\n"
+      "]\n",
+      Dump(IREE_VM_STARTUP_PROFILE_FORMAT_JSON));
+}
+
+TEST_F(StartupProfilerTest, InvalidPhase) {
+  EXPECT_THAT(iree::Status(iree_vm_startup_profiler_record(
+                  profiler_, iree_make_cstring_view("module"),
+                  IREE_VM_STARTUP_PHASE_COUNT, 1, 0)),
+              StatusIs(iree::StatusCode::kInvalidArgument));
+}
+
+TEST_F(StartupProfilerTest, Reset) {
+  Record("module", IREE_VM_STARTUP_PHASE_INITIALIZE, 1000);
+  iree_vm_startup_profiler_reset(profiler_);
+  EXPECT_EQ("[\n]\n", Dump(IREE_VM_STARTUP_PROFILE_FORMAT_JSON));
+}
+
+}  // namespace
@@ -1,4 +1,4 @@
-vm.module @assignment_ops_i64 {
+vm.module @assignment_ops_f32 {
 
   //===--------------------------------------------------------------------===//
   // ExtF32: Conditional assignment
@@ -0,0 +1,76 @@
+vm.module @call_ops {
+
+  //===--------------------------------------------------------------------===//
+  // vm.call to internal functions
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_call_i32
+  vm.func @test_call_i32() {
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c1_dno = iree.do_not_optimize(%c1) : i32
+    %actual = vm.call @add_one(%c1_dno) : (i32) -> i32
+    vm.check.eq %actual, %c2, "add_one(1) != 2" : i32
+    vm.return
+  }
+
+  vm.export @test_call_multiple_results
+  vm.func @test_call_multiple_results() {
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c1_dno = iree.do_not_optimize(%c1) : i32
+    %c2_dno = iree.do_not_optimize(%c2) : i32
+    %0:2 = vm.call @swap(%c1_dno, %c2_dno) : (i32, i32) -> (i32, i32)
+    vm.check.eq %0#0, %c2, "swap(1, 2)[0] != 2" : i32
+    vm.check.eq %0#1, %c1, "swap(1, 2)[1] != 1" : i32
+    vm.return
+  }
+
+  vm.export @test_call_ref
+  vm.func @test_call_ref() {
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %c27 = vm.const.i32 27 : i32
+    %list = vm.call @make_list(%c27) : (i32) -> !vm.list<i32>
+    %v = vm.list.get.i32 %list, %c0 : (!vm.list<i32>, i32) -> i32
+    vm.check.eq %v, %c27, "make_list(27)[0] != 27" : i32
+    %same = vm.call @identity_ref(%list) : (!vm.list<i32>) -> !vm.list<i32>
+    vm.check.eq %same, %list, "identity_ref(list) != list" : !vm.list<i32>
+    vm.return
+  }
+
+  vm.export @fail_call
+  vm.func @fail_call() {
+    vm.call @fail_always() : () -> ()
+    vm.return
+  }
+
+  vm.func @add_one(%arg0 : i32) -> i32 attributes {noinline} {
+    %c1 = vm.const.i32 1 : i32
+    %0 = vm.add.i32 %arg0, %c1 : i32
+    vm.return %0 : i32
+  }
+
+  vm.func @swap(%arg0 : i32, %arg1 : i32) -> (i32, i32) attributes {noinline} {
+    vm.return %arg1, %arg0 : i32, i32
+  }
+
+  vm.func @make_list(%arg0 : i32) -> !vm.list<i32> attributes {noinline} {
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    vm.list.resize %list, %c1 : (!vm.list<i32>, i32)
+    vm.list.set.i32 %list, %c0, %arg0 : (!vm.list<i32>, i32, i32)
+    vm.return %list : !vm.list<i32>
+  }
+
+  vm.func @identity_ref(%arg0 : !vm.list<i32>) -> !vm.list<i32> attributes {noinline} {
+    vm.return %arg0 : !vm.list<i32>
+  }
+
+  vm.func @fail_always() attributes {noinline} {
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "error!"
+  }
+
+}
@@ -0,0 +1,33 @@
+// Imports are provided by the native module defined in module_test.cc.
+vm.module @import_ops {
+
+  vm.import @native_import_module.add_1(%arg : i32) -> i32
+  vm.import @native_import_module.identity(%arg : !vm.list<i32>) -> !vm.list<i32>
+  vm.import @native_import_module.fail()
+
+  vm.export @test_call_import_i32
+  vm.func @test_call_import_i32() {
+    %c1 = vm.const.i32 1 : i32
+    %c3 = vm.const.i32 3 : i32
+    %0 = vm.call @native_import_module.add_1(%c1) : (i32) -> i32
+    %1 = vm.call @native_import_module.add_1(%0) : (i32) -> i32
+    vm.check.eq %1, %c3, "add_1(add_1(1)) != 3" : i32
+    vm.return
+  }
+
+  vm.export @test_call_import_ref
+  vm.func @test_call_import_ref() {
+    %c1 = vm.const.i32 1 : i32
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    %result = vm.call @native_import_module.identity(%list) : (!vm.list<i32>) -> !vm.list<i32>
+    vm.check.eq %result, %list, "identity(list) != list" : !vm.list<i32>
+    vm.return
+  }
+
+  vm.export @fail_call_import
+  vm.func @fail_call_import() {
+    vm.call @native_import_module.fail() : () -> ()
+    vm.return
+  }
+
+}
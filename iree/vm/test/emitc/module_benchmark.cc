@@ -0,0 +1,183 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks the exported test functions of the VM test modules compiled to C
+// against the same functions compiled to bytecode. Only modules available in
+// both forms are benchmarked.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode_module.h"
+#include "iree/vm/test/all_bytecode_modules.h"
+#include "iree/vm/test/emitc/arithmetic_ops.h"
+#include "iree/vm/test/emitc/arithmetic_ops_f32.h"
+#include "iree/vm/test/emitc/arithmetic_ops_i64.h"
+#include "iree/vm/test/emitc/assignment_ops.h"
+#include "iree/vm/test/emitc/assignment_ops_f32.h"
+#include "iree/vm/test/emitc/assignment_ops_i64.h"
+#include "iree/vm/test/emitc/call_ops.h"
+#include "iree/vm/test/emitc/comparison_ops.h"
+#include "iree/vm/test/emitc/comparison_ops_f32.h"
+#include "iree/vm/test/emitc/comparison_ops_i64.h"
+#include "iree/vm/test/emitc/control_flow_ops.h"
+#include "iree/vm/test/emitc/conversion_ops.h"
+#include "iree/vm/test/emitc/conversion_ops_f32.h"
+#include "iree/vm/test/emitc/conversion_ops_i64.h"
+#include "iree/vm/test/emitc/global_ops.h"
+#include "iree/vm/test/emitc/global_ops_f32.h"
+#include "iree/vm/test/emitc/global_ops_i64.h"
+#include "iree/vm/test/emitc/list_ops.h"
+#include "iree/vm/test/emitc/ref_ops.h"
+#include "iree/vm/test/emitc/shift_ops.h"
+#include "iree/vm/test/emitc/shift_ops_i64.h"
+
+namespace {
+
+typedef iree_status_t (*create_function_t)(iree_allocator_t,
+                                           iree_vm_module_t**);
+
+struct ModuleDescription {
+  iree_vm_native_module_descriptor_t descriptor;
+  create_function_t create_function;
+};
+
+// Creates a context holding |module| and repeatedly calls the exported
+// void(void) function |qualified_name| in it.
+void RunFunction(benchmark::State& state, iree_vm_module_t* module,
+                 const std::string& qualified_name) {
+  iree_vm_instance_t* instance = nullptr;
+  IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance));
+
+  iree_vm_context_t* context = nullptr;
+  IREE_CHECK_OK(iree_vm_context_create_with_modules(
+      instance, &module, 1, iree_allocator_system(), &context));
+
+  iree_vm_function_t function;
+  IREE_CHECK_OK(iree_vm_context_resolve_function(
+      context,
+      iree_string_view_t{qualified_name.data(), qualified_name.size()},
+      &function));
+
+  iree_vm_function_call_t call;
+  memset(&call, 0, sizeof(call));
+  call.function = function;
+
+  IREE_VM_INLINE_STACK_INITIALIZE(
+      stack, iree_vm_context_state_resolver(context), iree_allocator_system());
+  for (auto _ : state) {
+    iree_vm_execution_result_t result;
+    IREE_CHECK_OK(function.module->begin_call(function.module->self, stack,
+                                              &call, &result));
+  }
+  iree_vm_stack_deinitialize(stack);
+
+  iree_vm_context_release(context);
+  iree_vm_instance_release(instance);
+}
+
+void BM_CModule(benchmark::State& state, create_function_t create_function,
+                std::string qualified_name) {
+  iree_vm_module_t* module = nullptr;
+  IREE_CHECK_OK(create_function(iree_allocator_system(), &module));
+  RunFunction(state, module, qualified_name);
+  iree_vm_module_release(module);
+}
+
+void BM_BytecodeModule(benchmark::State& state,
+                       const struct iree_file_toc_t* module_file,
+                       std::string qualified_name) {
+  // The type table of the module is resolved on creation.
+  IREE_CHECK_OK(iree_vm_register_builtin_types());
+  iree_vm_module_t* module = nullptr;
+  IREE_CHECK_OK(iree_vm_bytecode_module_create(
+      iree_const_byte_span_t{
+          reinterpret_cast<const uint8_t*>(module_file->data),
+          module_file->size},
+      iree_allocator_null(), iree_allocator_system(), &module));
+  RunFunction(state, module, qualified_name);
+  iree_vm_module_release(module);
+}
+
+const struct iree_file_toc_t* FindBytecodeModule(
+    const std::string& module_name) {
+  std::string file_name = module_name + ".vmfb";
+  const struct iree_file_toc_t* module_files = all_bytecode_modules_c_create();
+  for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+    if (file_name == module_files[i].name) return &module_files[i];
+  }
+  return nullptr;
+}
+
+bool RegisterBenchmarks() {
+  // TODO(simon-camp): get these automatically
+  std::vector<ModuleDescription> modules = {
+      {arithmetic_ops_descriptor_, arithmetic_ops_create},
+      {arithmetic_ops_f32_descriptor_, arithmetic_ops_f32_create},
+      {arithmetic_ops_i64_descriptor_, arithmetic_ops_i64_create},
+      {assignment_ops_descriptor_, assignment_ops_create},
+      {assignment_ops_f32_descriptor_, assignment_ops_f32_create},
+      {assignment_ops_i64_descriptor_, assignment_ops_i64_create},
+      {call_ops_descriptor_, call_ops_create},
+      {comparison_ops_descriptor_, comparison_ops_create},
+      {comparison_ops_f32_descriptor_, comparison_ops_f32_create},
+      {comparison_ops_i64_descriptor_, comparison_ops_i64_create},
+      {control_flow_ops_descriptor_, control_flow_ops_create},
+      {conversion_ops_descriptor_, conversion_ops_create},
+      {conversion_ops_f32_descriptor_, conversion_ops_f32_create},
+      {conversion_ops_i64_descriptor_, conversion_ops_i64_create},
+      {global_ops_descriptor_, global_ops_create},
+      {global_ops_f32_descriptor_, global_ops_f32_create},
+      {global_ops_i64_descriptor_, global_ops_i64_create},
+      {list_ops_descriptor_, list_ops_create},
+      {ref_ops_descriptor_, ref_ops_create},
+      {shift_ops_descriptor_, shift_ops_create},
+      {shift_ops_i64_descriptor_, shift_ops_i64_create}};
+
+  for (const auto& module : modules) {
+    const iree_vm_native_module_descriptor_t& descriptor = module.descriptor;
+    std::string module_name =
+        std::string(descriptor.module_name.data, descriptor.module_name.size);
+    const struct iree_file_toc_t* module_file = FindBytecodeModule(module_name);
+    if (!module_file) continue;
+
+    for (iree_host_size_t i = 0; i < descriptor.export_count; i++) {
+      iree_string_view_t local_name = descriptor.exports[i].local_name;
+      // Functions expected to fail can't be timed in a loop.
+      if (iree_string_view_starts_with(local_name,
+                                       iree_make_cstring_view("fail_"))) {
+        continue;
+      }
+      std::string qualified_name =
+          module_name + "." + std::string(local_name.data, local_name.size);
+      benchmark::RegisterBenchmark(("BM_CModule/" + qualified_name).c_str(),
+                                   BM_CModule, module.create_function,
+                                   qualified_name);
+      benchmark::RegisterBenchmark(
+          ("BM_BytecodeModule/" + qualified_name).c_str(), BM_BytecodeModule,
+          module_file, qualified_name);
+    }
+  }
+  return true;
+}
+
+// Benchmarks are registered before main runs them.
+const bool benchmarks_registered = RegisterBenchmarks();
+
+}  // namespace
@@ -19,17 +19,25 @@
 #include "iree/testing/gtest.h"
 #include "iree/vm/api.h"
 #include "iree/vm/test/emitc/arithmetic_ops.h"
+#include "iree/vm/test/emitc/arithmetic_ops_f32.h"
 #include "iree/vm/test/emitc/arithmetic_ops_i64.h"
 #include "iree/vm/test/emitc/assignment_ops.h"
+#include "iree/vm/test/emitc/assignment_ops_f32.h"
 #include "iree/vm/test/emitc/assignment_ops_i64.h"
+#include "iree/vm/test/emitc/call_ops.h"
 #include "iree/vm/test/emitc/comparison_ops.h"
 #include "iree/vm/test/emitc/comparison_ops_f32.h"
 #include "iree/vm/test/emitc/comparison_ops_i64.h"
 #include "iree/vm/test/emitc/control_flow_ops.h"
 #include "iree/vm/test/emitc/conversion_ops.h"
+#include "iree/vm/test/emitc/conversion_ops_f32.h"
 #include "iree/vm/test/emitc/conversion_ops_i64.h"
 #include "iree/vm/test/emitc/global_ops.h"
+#include "iree/vm/test/emitc/global_ops_f32.h"
+#include "iree/vm/test/emitc/global_ops_i64.h"
+#include "iree/vm/test/emitc/import_ops.h"
 #include "iree/vm/test/emitc/list_ops.h"
+#include "iree/vm/test/emitc/ref_ops.h"
 #include "iree/vm/test/emitc/shift_ops.h"
 #include "iree/vm/test/emitc/shift_ops_i64.h"
 
@@ -49,6 +57,76 @@ struct ModuleDescription {
   create_function_t create_function;
 };
 
+// Native module providing the functions imported by import_ops.mlir.
+
+// vm.import @native_import_module.add_1(%arg : i32) -> i32
+static iree_status_t native_import_module_add_1(
+    iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_native_function_target_t target_fn, void* module,
+    void* module_state, iree_vm_execution_result_t* out_result) {
+  int32_t arg0 = *reinterpret_cast<int32_t*>(call->arguments.data);
+  *reinterpret_cast<int32_t*>(call->results.data) = arg0 + 1;
+  return iree_ok_status();
+}
+
+// vm.import @native_import_module.identity(%arg : !vm.list<i32>)
+//     -> !vm.list<i32>
+static iree_status_t native_import_module_identity(
+    iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_native_function_target_t target_fn, void* module,
+    void* module_state, iree_vm_execution_result_t* out_result) {
+  iree_vm_ref_t* arg0 = reinterpret_cast<iree_vm_ref_t*>(call->arguments.data);
+  iree_vm_ref_t* ret0 = reinterpret_cast<iree_vm_ref_t*>(call->results.data);
+  iree_vm_ref_retain(arg0, ret0);
+  return iree_ok_status();
+}
+
+// vm.import @native_import_module.fail()
+static iree_status_t native_import_module_fail(
+    iree_vm_stack_t* stack, const iree_vm_function_call_t* call,
+    iree_vm_native_function_target_t target_fn, void* module,
+    void* module_state, iree_vm_execution_result_t* out_result) {
+  return iree_make_status(IREE_STATUS_FAILED_PRECONDITION, "import failed");
+}
+
+static const iree_vm_native_export_descriptor_t
+    native_import_module_exports_[] = {
+        {iree_make_cstring_view("add_1"), iree_make_cstring_view("0i_i"), 0,
+         NULL},
+        {iree_make_cstring_view("fail"), iree_make_cstring_view("0v_v"), 0,
+         NULL},
+        {iree_make_cstring_view("identity"), iree_make_cstring_view("0r_r"), 0,
+         NULL},
+};
+static const iree_vm_native_function_ptr_t native_import_module_funcs_[] = {
+    {(iree_vm_native_function_shim_t)native_import_module_add_1, NULL},
+    {(iree_vm_native_function_shim_t)native_import_module_fail, NULL},
+    {(iree_vm_native_function_shim_t)native_import_module_identity, NULL},
+};
+static_assert(IREE_ARRAYSIZE(native_import_module_funcs_) ==
+                  IREE_ARRAYSIZE(native_import_module_exports_),
+              "function pointer table must be 1:1 with exports");
+static const iree_vm_native_module_descriptor_t
+    native_import_module_descriptor_ = {
+        iree_make_cstring_view("native_import_module"),
+        0,
+        NULL,
+        IREE_ARRAYSIZE(native_import_module_exports_),
+        native_import_module_exports_,
+        IREE_ARRAYSIZE(native_import_module_funcs_),
+        native_import_module_funcs_,
+        0,
+        NULL,
+};
+
+static iree_status_t native_import_module_create(
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
+  iree_vm_module_t interface;
+  IREE_RETURN_IF_ERROR(iree_vm_module_initialize(&interface, NULL));
+  return iree_vm_native_module_create(
+      &interface, &native_import_module_descriptor_, allocator, out_module);
+}
+
 std::ostream& operator<<(std::ostream& os, const TestParams& params) {
   std::string qualified_name = params.module_name + "." + params.local_name;
   return os << absl::StrReplaceAll(qualified_name, {{":", "_"}, {".", "_"}});
@@ -60,17 +138,25 @@ std::vector<TestParams> GetModuleTestParams() {
   // TODO(simon-camp): get these automatically
   std::vector<ModuleDescription> modules = {
       {arithmetic_ops_descriptor_, arithmetic_ops_create},
+      {arithmetic_ops_f32_descriptor_, arithmetic_ops_f32_create},
       {arithmetic_ops_i64_descriptor_, arithmetic_ops_i64_create},
       {assignment_ops_descriptor_, assignment_ops_create},
+      {assignment_ops_f32_descriptor_, assignment_ops_f32_create},
       {assignment_ops_i64_descriptor_, assignment_ops_i64_create},
+      {call_ops_descriptor_, call_ops_create},
       {comparison_ops_descriptor_, comparison_ops_create},
       {comparison_ops_f32_descriptor_, comparison_ops_f32_create},
       {comparison_ops_i64_descriptor_, comparison_ops_i64_create},
       {control_flow_ops_descriptor_, control_flow_ops_create},
       {conversion_ops_descriptor_, conversion_ops_create},
+      {conversion_ops_f32_descriptor_, conversion_ops_f32_create},
       {conversion_ops_i64_descriptor_, conversion_ops_i64_create},
       {global_ops_descriptor_, global_ops_create},
+      {global_ops_f32_descriptor_, global_ops_f32_create},
+      {global_ops_i64_descriptor_, global_ops_i64_create},
+      {import_ops_descriptor_, import_ops_create},
       {list_ops_descriptor_, list_ops_create},
+      {ref_ops_descriptor_, ref_ops_create},
       {shift_ops_descriptor_, shift_ops_create},
       {shift_ops_i64_descriptor_, shift_ops_i64_create}};
 
@@ -101,16 +187,21 @@ class VMCModuleTest : public ::testing::Test,
 
     IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
 
+    iree_vm_module_t* import_module = nullptr;
+    IREE_CHECK_OK(
+        native_import_module_create(iree_allocator_system(), &import_module));
+
     iree_vm_module_t* module_ = nullptr;
     IREE_CHECK_OK(
         test_params.create_function(iree_allocator_system(), &module_))
         << "Module failed to load";
 
-    std::vector<iree_vm_module_t*> modules = {module_};
+    std::vector<iree_vm_module_t*> modules = {import_module, module_};
     IREE_CHECK_OK(iree_vm_context_create_with_modules(
         instance_, modules.data(), modules.size(), iree_allocator_system(),
         &context_));
 
+    iree_vm_module_release(import_module);
     iree_vm_module_release(module_);
   }
 
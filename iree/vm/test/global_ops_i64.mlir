@@ -1,4 +1,4 @@
-vm.module @global_ops {
+vm.module @global_ops_i64 {
 
   //===--------------------------------------------------------------------===//
   // global.i64
@@ -76,7 +76,36 @@ vm.module @list_ops {
 
   vm.export @test_ref
   vm.func @test_ref() {
-    // TODO(benvanik): test vm.list with ref types.
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %c27 = vm.const.i32 27 : i32
+    %inner = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    vm.list.resize %inner, %c1 : (!vm.list<i32>, i32)
+    vm.list.set.i32 %inner, %c0, %c27 : (!vm.list<i32>, i32, i32)
+    %outer = vm.list.alloc %c1 : (i32) -> !vm.list<!vm.list<i32>>
+    vm.list.resize %outer, %c1 : (!vm.list<!vm.list<i32>>, i32)
+    vm.list.set.ref %outer, %c0, %inner : (!vm.list<!vm.list<i32>>, i32, !vm.list<i32>)
+    %inner_ret = vm.list.get.ref %outer, %c0 : (!vm.list<!vm.list<i32>>, i32) -> !vm.list<i32>
+    vm.check.eq %inner_ret, %inner, "list<list<i32>>.set(0, inner).get(0)=inner" : !vm.list<i32>
+    %v = vm.list.get.i32 %inner_ret, %c0 : (!vm.list<i32>, i32) -> i32
+    vm.check.eq %v, %c27, "list<list<i32>>.get(0).get(0)=27" : i32
+    vm.return
+  }
+
+  //===--------------------------------------------------------------------===//
+  // vm.list.* with F32 types
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_f32
+  vm.func @test_f32() {
+    %c1 = vm.const.i32 1 : i32
+    %c0 = vm.const.i32 0 : i32
+    %c1dot5 = vm.const.f32 1.5 : f32
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<f32>
+    vm.list.resize %list, %c1 : (!vm.list<f32>, i32)
+    vm.list.set.f32 %list, %c0, %c1dot5 : (!vm.list<f32>, i32, f32)
+    %v = vm.list.get.f32 %list, %c0 : (!vm.list<f32>, i32) -> f32
+    vm.check.eq %v, %c1dot5, "list<f32>.empty.set(0, 1.5).get(0)=1.5" : f32
     vm.return
   }
 
@@ -0,0 +1,72 @@
+vm.module @ref_ops {
+
+  //===--------------------------------------------------------------------===//
+  // global.ref
+  //===--------------------------------------------------------------------===//
+
+  vm.global.ref @g0 mutable : !vm.list<i32>
+
+  vm.export @test_global_ref
+  vm.func @test_global_ref() {
+    %c1 = vm.const.i32 1 : i32
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    vm.global.store.ref %list, @g0 : !vm.list<i32>
+    %actual = vm.global.load.ref @g0 : !vm.list<i32>
+    vm.check.eq %actual, %list, "@g0 != list" : !vm.list<i32>
+    vm.return
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Comparison and conditional assignment
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_zero_ref
+  vm.func @test_zero_ref() {
+    %c0 = vm.const.i32 0 : i32
+    %null = vm.const.ref.zero : !vm.list<i32>
+    %null_dno = iree.do_not_optimize(%null) : !vm.list<i32>
+    %nz = vm.cmp.nz.ref %null_dno : !vm.list<i32>
+    vm.check.eq %nz, %c0, "null != 0" : i32
+    vm.return
+  }
+
+  vm.export @test_select_ref
+  vm.func @test_select_ref() {
+    %c1 = vm.const.i32 1 : i32
+    %list0 = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    %list1 = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    %cond = iree.do_not_optimize(%c1) : i32
+    %result = vm.select.ref %cond, %list0, %list1 : !vm.list<i32>
+    vm.check.eq %result, %list0, "select(1, list0, list1) != list0" : !vm.list<i32>
+    vm.check.ne %result, %list1, "select(1, list0, list1) == list1" : !vm.list<i32>
+    vm.return
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Refs passed along branches
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_ref_block_args
+  vm.func @test_ref_block_args() {
+    %c0 = vm.const.i32 0 : i32
+    %c1 = vm.const.i32 1 : i32
+    %c3 = vm.const.i32 3 : i32
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    vm.list.resize %list, %c1 : (!vm.list<i32>, i32)
+    vm.list.set.i32 %list, %c0, %c0 : (!vm.list<i32>, i32, i32)
+    vm.br ^loop(%c0, %list : i32, !vm.list<i32>)
+  ^loop(%i : i32, %l : !vm.list<i32>):
+    %v = vm.list.get.i32 %l, %c0 : (!vm.list<i32>, i32) -> i32
+    %v1 = vm.add.i32 %v, %c1 : i32
+    vm.list.set.i32 %l, %c0, %v1 : (!vm.list<i32>, i32, i32)
+    %i1 = vm.add.i32 %i, %c1 : i32
+    %cmp = vm.cmp.lt.i32.s %i1, %c3 : i32
+    vm.cond_br %cmp, ^loop(%i1, %l : i32, !vm.list<i32>), ^exit(%l : !vm.list<i32>)
+  ^exit(%result : !vm.list<i32>):
+    vm.check.eq %result, %list, "list changed identity" : !vm.list<i32>
+    %r = vm.list.get.i32 %result, %c0 : (!vm.list<i32>, i32) -> i32
+    vm.check.eq %r, %c3, "list[0] != 3" : i32
+    vm.return
+  }
+
+}
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Benchmarks matmul dispatches with and without constant RHS packing.
+
+Generates a program with one matmul per requested shape whose right-hand side
+is a random (non-splat) constant, compiles it with
+`-iree-flow-export-benchmark-funcs` once as is and once with
+`-iree-flow-enable-pack-matmul-constant-rhs`, and measures every dispatch with
+`iree-benchmark-module` on the local task driver. The per-dispatch speedup of
+the packed program is reported along with the number of dispatches in each
+program: the packing happens on the constants at compile time so both programs
+must have the same dispatches (no runtime repacking).
+
+Example usage:
+  python3 ./scripts/benchmark_pack_matmul_constant_rhs.py \\
+    --shapes=384x384x512,384x128x512 \\
+    --iree_translate=build/iree/tools/iree-translate \\
+    --iree_benchmark_module=build/iree/tools/iree-benchmark-module
+"""
+
+import json
+import os
+import random
+import struct
+import subprocess
+import tempfile
+from typing import Dict, List, Tuple
+
+from absl import app
+from absl import flags
+
+FLAGS = flags.FLAGS
+flags.DEFINE_list('shapes', ['384x384x512', '384x128x512', '384x512x128'],
+                  'MxKxN matmul shapes to benchmark.')
+flags.DEFINE_integer('panel_size', 8,
+                     'Number of contiguous columns per packed RHS panel.')
+flags.DEFINE_string('iree_translate', 'iree-translate',
+                    'Path to the iree-translate binary.')
+flags.DEFINE_string('iree_benchmark_module', 'iree-benchmark-module',
+                    'Path to the iree-benchmark-module binary.')
+flags.DEFINE_string('driver', 'dylib', 'Runtime driver used for measurement.')
+flags.DEFINE_list('translate_flags', [],
+                  'Additional flags passed to iree-translate.')
+flags.DEFINE_integer('benchmark_repetitions', 3,
+                     'Repetitions per benchmark; the minimum time is used.')
+
+Shape = Tuple[int, int, int]
+
+
+def parse_shape(shape: str) -> Shape:
+  m, k, n = (int(d) for d in shape.split('x'))
+  return m, k, n
+
+
+def random_constant(rows: int, cols: int) -> str:
+  """Returns a hex encoded dense f32 constant of the given shape."""
+  data = struct.pack(f'<{rows * cols}f',
+                     *(random.uniform(-1.0, 1.0) for _ in range(rows * cols)))
+  return f'dense<"0x{data.hex().upper()}"> : tensor<{rows}x{cols}xf32>'
+
+
+def generate_program(shapes: List[Shape]) -> str:
+  functions = []
+  for m, k, n in shapes:
+    functions.append(f"""
+func @matmul_{m}x{k}x{n}(%lhs: tensor<{m}x{k}xf32>) -> tensor<{m}x{n}xf32> attributes {{ iree.module.export }} {{
+  %rhs = mhlo.constant {random_constant(k, n)}
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<{m}x{k}xf32>, tensor<{k}x{n}xf32>) -> tensor<{m}x{n}xf32>
+  return %0 : tensor<{m}x{n}xf32>
+}}
+""")
+  return ''.join(functions)
+
+
+def compile_module(input_file: str, output_file: str, pack: bool):
+  command = [
+      FLAGS.iree_translate,
+      '-iree-mlir-to-vm-bytecode-module',
+      '-iree-hal-target-backends=dylib-llvm-aot',
+      '-iree-flow-export-benchmark-funcs',
+      input_file,
+      f'-o={output_file}',
+  ] + FLAGS.translate_flags
+  if pack:
+    command += [
+        '-iree-flow-enable-pack-matmul-constant-rhs',
+        f'-iree-flow-pack-matmul-constant-rhs-panel-size={FLAGS.panel_size}',
+    ]
+  subprocess.run(command, check=True)
+
+
+def benchmark_dispatches(module_file: str) -> Dict[str, float]:
+  """Returns the minimum real time in ms of each exported dispatch."""
+  command = [
+      FLAGS.iree_benchmark_module,
+      f'--module_file={module_file}',
+      f'--driver={FLAGS.driver}',
+      '--benchmark_format=json',
+      f'--benchmark_repetitions={FLAGS.benchmark_repetitions}',
+  ]
+  output = subprocess.run(command,
+                          stdout=subprocess.PIPE,
+                          universal_newlines=True,
+                          check=True).stdout
+  scale = {'ns': 1e-6, 'us': 1e-3, 'ms': 1.0, 's': 1e3}
+  times = {}
+  for benchmark in json.loads(output)['benchmarks']:
+    if benchmark.get('run_type') == 'aggregate':
+      continue
+    # Names are of the form `BM_<dispatch>_benchmark/process_time/real_time`.
+    name = benchmark['name'].split('/')[0]
+    if not name.startswith('BM_') or not name.endswith('_benchmark'):
+      continue
+    dispatch = name[len('BM_'):-len('_benchmark')]
+    time_ms = benchmark['real_time'] * scale[benchmark['time_unit']]
+    times[dispatch] = min(times.get(dispatch, time_ms), time_ms)
+  return times
+
+
+def main(argv):
+  del argv  # Unused.
+
+  shapes = [parse_shape(shape) for shape in FLAGS.shapes]
+  for m, k, n in shapes:
+    if n % FLAGS.panel_size != 0 or n == FLAGS.panel_size:
+      raise ValueError(f'N of {m}x{k}x{n} must be a multiple of the panel '
+                       f'size {FLAGS.panel_size} to be packed')
+
+  with tempfile.TemporaryDirectory() as temp_dir:
+    input_file = os.path.join(temp_dir, 'matmuls.mlir')
+    with open(input_file, 'w') as f:
+      f.write(generate_program(shapes))
+
+    results = {}
+    for pack in (False, True):
+      module_file = os.path.join(temp_dir, f'module_{int(pack)}.vmfb')
+      compile_module(input_file, module_file, pack)
+      results[pack] = benchmark_dispatches(module_file)
+
+  baseline, packed = results[False], results[True]
+  print(f'dispatches: baseline={len(baseline)} packed={len(packed)}')
+  if len(baseline) != len(packed):
+    print('WARNING: packing changed the number of dispatches')
+  print(f'{"dispatch":<40} {"baseline_ms":>12} {"packed_ms":>12} '
+        f'{"speedup":>8}')
+  for dispatch in sorted(set(baseline) & set(packed)):
+    print(f'{dispatch:<40} {baseline[dispatch]:>12.4f} '
+          f'{packed[dispatch]:>12.4f} '
+          f'{baseline[dispatch] / packed[dispatch]:>7.2f}x')
+  total_baseline = sum(baseline.values())
+  total_packed = sum(packed.values())
+  print(f'{"total":<40} {total_baseline:>12.4f} {total_packed:>12.4f} '
+        f'{total_baseline / total_packed:>7.2f}x')
+
+
+if __name__ == '__main__':
+  app.run(main)
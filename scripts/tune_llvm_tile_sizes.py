@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Tunes LLVM CPU tile sizes per dispatch and writes a tuning database.
+
+The input program is compiled with `-iree-flow-export-benchmark-funcs` so that
+every dispatch can be benchmarked in isolation with `iree-benchmark-module`.
+Each dispatch root operation is keyed by its op name and input shapes (as
+printed by `-iree-codegen-llvm-dump-tuning-keys`). A sweep of tile size
+candidates is compiled and measured on the local task driver and the fastest
+configuration of each key is written to a JSON database that can be passed back
+to the compiler with `-iree-codegen-llvm-tuning-database=`.
+
+Example usage:
+  python3 ./scripts/tune_llvm_tile_sizes.py \\
+    --input_file=/path/to/model.mlir \\
+    --output_file=/path/to/tuning_database.json \\
+    --iree_translate=build/iree/tools/iree-translate \\
+    --iree_benchmark_module=build/iree/tools/iree-benchmark-module
+"""
+
+import itertools
+import json
+import os
+import subprocess
+import tempfile
+from typing import Dict, List, Sequence, Tuple
+
+from absl import app
+from absl import flags
+
+FLAGS = flags.FLAGS
+flags.DEFINE_string('input_file', None, 'MLIR input program to tune.')
+flags.DEFINE_string('output_file', None, 'Tuning database JSON to write.')
+flags.DEFINE_string('iree_translate', 'iree-translate',
+                    'Path to the iree-translate binary.')
+flags.DEFINE_string('iree_benchmark_module', 'iree-benchmark-module',
+                    'Path to the iree-benchmark-module binary.')
+flags.DEFINE_string('driver', 'dylib', 'Runtime driver used for measurement.')
+flags.DEFINE_list('translate_flags', [],
+                  'Additional flags passed to iree-translate.')
+flags.DEFINE_list('workgroup_sizes', ['16', '32', '64', '128'],
+                  'Candidate workgroup tile sizes.')
+flags.DEFINE_list('l1_sizes', ['8', '16', '32', '64'],
+                  'Candidate L1 tile sizes.')
+flags.DEFINE_list('vector_sizes', ['4', '8'], 'Candidate vector tile sizes.')
+flags.DEFINE_integer('benchmark_repetitions', 3,
+                     'Repetitions per benchmark; the minimum time is used.')
+flags.mark_flags_as_required(['input_file', 'output_file'])
+
+TUNING_KEY_PREFIX = 'iree-llvm-tuning-key: '
+LEVEL_KEYS = ('workgroup_tile_sizes', 'l1_tile_sizes', 'vector_tile_sizes')
+
+# (op name, input shapes) identifying a database entry.
+Key = Tuple[str, str]
+
+
+def make_key(entry: Dict) -> Key:
+  return entry['op'], json.dumps(entry['shape'])
+
+
+def compile_module(output_file: str,
+                   database_file: str = None,
+                   dump_keys: bool = False) -> List[str]:
+  """Compiles the input with benchmark functions; returns stderr lines."""
+  command = [
+      FLAGS.iree_translate,
+      '-iree-mlir-to-vm-bytecode-module',
+      '-iree-hal-target-backends=dylib-llvm-aot',
+      '-iree-flow-export-benchmark-funcs',
+      FLAGS.input_file,
+      f'-o={output_file}',
+  ] + FLAGS.translate_flags
+  if database_file:
+    command.append(f'-iree-codegen-llvm-tuning-database={database_file}')
+  if dump_keys:
+    command.append('-iree-codegen-llvm-dump-tuning-keys')
+  process = subprocess.run(command,
+                           stdout=subprocess.PIPE,
+                           stderr=subprocess.PIPE,
+                           universal_newlines=True)
+  process.check_returncode()
+  return process.stderr.splitlines()
+
+
+def benchmark_dispatches(module_file: str) -> Dict[str, float]:
+  """Returns the minimum real time in ms of each exported dispatch."""
+  command = [
+      FLAGS.iree_benchmark_module,
+      f'--module_file={module_file}',
+      f'--driver={FLAGS.driver}',
+      '--benchmark_format=json',
+      f'--benchmark_repetitions={FLAGS.benchmark_repetitions}',
+  ]
+  output = subprocess.run(command,
+                          stdout=subprocess.PIPE,
+                          universal_newlines=True,
+                          check=True).stdout
+  scale = {'ns': 1e-6, 'us': 1e-3, 'ms': 1.0, 's': 1e3}
+  times = {}
+  for benchmark in json.loads(output)['benchmarks']:
+    if benchmark.get('run_type') == 'aggregate':
+      continue
+    # Names are of the form `BM_<dispatch>_benchmark/process_time/real_time`.
+    name = benchmark['name'].split('/')[0]
+    if not name.startswith('BM_') or not name.endswith('_benchmark'):
+      continue
+    dispatch = name[len('BM_'):-len('_benchmark')]
+    time_ms = benchmark['real_time'] * scale[benchmark['time_unit']]
+    times[dispatch] = min(times.get(dispatch, time_ms), time_ms)
+  return times
+
+
+def replace_tiles(default_sizes: Sequence[int], size: int) -> List[int]:
+  # Only tiled dimensions are swept; untiled (0) and unit (batch) dimensions
+  # keep their default sizes.
+  return [size if s > 1 else s for s in default_sizes]
+
+
+def candidate_entry(default_entry: Dict, workgroup: int, l1: int,
+                    vector: int) -> Dict:
+  entry = {'op': default_entry['op'], 'shape': default_entry['shape']}
+  for level_key, size in zip(LEVEL_KEYS, (workgroup, l1, vector)):
+    entry[level_key] = replace_tiles(default_entry[level_key], size)
+  return entry
+
+
+def main(argv):
+  del argv  # Unused.
+
+  workgroup_sizes = [int(s) for s in FLAGS.workgroup_sizes]
+  l1_sizes = [int(s) for s in FLAGS.l1_sizes]
+  vector_sizes = [int(s) for s in FLAGS.vector_sizes]
+  candidates = [(wg, l1, v)
+                for wg, l1, v in itertools.product(workgroup_sizes, l1_sizes,
+                                                   vector_sizes)
+                if l1 <= wg and wg % l1 == 0 and l1 % v == 0]
+
+  with tempfile.TemporaryDirectory() as temp_dir:
+    module_file = os.path.join(temp_dir, 'module.vmfb')
+    database_file = os.path.join(temp_dir, 'candidate.json')
+
+    # Discover the key of each dispatch and measure the default configuration.
+    defaults: Dict[Key, Dict] = {}
+    dispatch_keys: Dict[str, Key] = {}
+    for line in compile_module(module_file, dump_keys=True):
+      if not line.startswith(TUNING_KEY_PREFIX):
+        continue
+      entry = json.loads(line[len(TUNING_KEY_PREFIX):])
+      key = make_key(entry)
+      defaults[key] = entry
+      dispatch_keys[entry['dispatch']] = key
+    print(f'Found {len(dispatch_keys)} dispatches with {len(defaults)} '
+          'unique tuning keys')
+
+    def measure() -> Dict[Key, float]:
+      # Dispatches sharing a key are tuned together by their total time.
+      key_times: Dict[Key, float] = {}
+      for dispatch, time_ms in benchmark_dispatches(module_file).items():
+        key = dispatch_keys.get(dispatch)
+        if key:
+          key_times[key] = key_times.get(key, 0.0) + time_ms
+      return key_times
+
+    best: Dict[Key, Tuple[float, Dict]] = {}
+    for key, time_ms in measure().items():
+      default_entry = {
+          k: v for k, v in defaults[key].items() if k != 'dispatch'
+      }
+      best[key] = (time_ms, default_entry)
+
+    # Every candidate configuration is applied to all keys at once so that the
+    # number of compilations is independent of the number of dispatches.
+    for i, (workgroup, l1, vector) in enumerate(candidates):
+      print(f'[{i + 1}/{len(candidates)}] workgroup={workgroup} l1={l1} '
+            f'vector={vector}')
+      entries = {
+          key: candidate_entry(default_entry, workgroup, l1, vector)
+          for key, default_entry in defaults.items()
+      }
+      with open(database_file, 'w') as f:
+        json.dump({'entries': list(entries.values())}, f)
+      try:
+        compile_module(module_file, database_file=database_file)
+        key_times = measure()
+      except subprocess.CalledProcessError as e:
+        print(f'  skipped: {e}')
+        continue
+      for key, time_ms in key_times.items():
+        if key not in best or time_ms < best[key][0]:
+          best[key] = (time_ms, entries[key])
+
+  database = []
+  for key, (time_ms, entry) in sorted(best.items()):
+    entry = dict(entry)
+    entry['time_ms'] = time_ms
+    database.append(entry)
+  with open(FLAGS.output_file, 'w') as f:
+    json.dump({'entries': database}, f, indent=2)
+  print(f'Wrote {len(database)} entries to {FLAGS.output_file}')
+
+
+if __name__ == '__main__':
+  app.run(main)